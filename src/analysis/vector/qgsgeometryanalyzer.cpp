@@ -26,6 +26,225 @@
 #include "qgsvectordataprovider.h"
 #include "qgsdistancearea.h"
 #include <QProgressDialog>
+#include <QThread>
+#include <QtConcurrentMap>
+
+//! number of features read before their geometries are computed in worker threads
+static const int PARALLEL_BATCH_SIZE = 256;
+
+//! buffers the geometry of a feature, called in worker threads
+class BufferGeometry
+{
+  public:
+    typedef QgsGeometry* result_type;
+
+    BufferGeometry( double bufferDistance, int bufferDistanceField )
+        : mBufferDistance( bufferDistance )
+        , mBufferDistanceField( bufferDistanceField )
+    {}
+
+    QgsGeometry* operator()( const QgsFeature& f ) const
+    {
+      if ( !f.constGeometry() )
+      {
+        return 0;
+      }
+      double distance = mBufferDistanceField == -1 ? mBufferDistance : f.attribute( mBufferDistanceField ).toDouble();
+      return f.constGeometry()->buffer( distance, 5 );
+    }
+
+  private:
+    double mBufferDistance;
+    int mBufferDistanceField;
+};
+
+//! returns the convex hull of the geometry of a feature, called in worker threads
+class ConvexHullGeometry
+{
+  public:
+    typedef QgsGeometry* result_type;
+
+    QgsGeometry* operator()( const QgsFeature& f ) const
+    {
+      return f.constGeometry() ? f.constGeometry()->convexHull() : 0;
+    }
+};
+
+//! number of spatially close geometries unioned at once in the leaves of the union tree
+static const int UNION_LEAF_SIZE = 32;
+
+//! unions a group of geometries, called in worker threads
+class UnionGeometries
+{
+  public:
+    typedef QgsGeometry* result_type;
+
+    QgsGeometry* operator()( const QList<QgsGeometry*>& geometries ) const
+    {
+      QList<QgsGeometry*> nonEmpty;
+      Q_FOREACH ( QgsGeometry* geometry, geometries )
+      {
+        if ( geometry && !geometry->isEmpty() )
+        {
+          nonEmpty << geometry;
+        }
+      }
+      return nonEmpty.isEmpty() ? 0 : QgsGeometry::unaryUnion( nonEmpty );
+    }
+};
+
+//! position of the center of a rectangle on a Z-order curve through the extent
+static quint32 zOrderCode( const QgsRectangle& rect, const QgsRectangle& extent )
+{
+  double dx = extent.width() > 0 ? ( rect.center().x() - extent.xMinimum() ) / extent.width() : 0.0;
+  double dy = extent.height() > 0 ? ( rect.center().y() - extent.yMinimum() ) / extent.height() : 0.0;
+  quint32 x = qBound( 0, ( int )( dx * 65535 ), 65535 );
+  quint32 y = qBound( 0, ( int )( dy * 65535 ), 65535 );
+
+  quint32 code = 0;
+  for ( int bit = 0; bit < 16; ++bit )
+  {
+    code |= (( x >> bit ) & 1 ) << ( 2 * bit );
+    code |= (( y >> bit ) & 1 ) << ( 2 * bit + 1 );
+  }
+  return code;
+}
+
+static bool zOrderLessThan( const QPair<quint32, QgsGeometry*>& a, const QPair<quint32, QgsGeometry*>& b )
+{
+  return a.first < b.first;
+}
+
+/** Unions geometries with a tree reduction. The geometries are sorted along a Z-order curve,
+ * unioned in groups of neighbours and the results are then unioned pairwise, level by level,
+ * so that most unions are between small, close geometries. The tree only depends on the input,
+ * which makes the result independent of running the unions of a level in worker threads.
+ * Returns 0 if there is nothing to union or if the progress dialog was canceled.
+ */
+static QgsGeometry* unionGeometries( const QList<QgsGeometry*>& geometries, bool parallel, QProgressDialog* p )
+{
+  QList< QPair<quint32, QgsGeometry*> > ordered;
+  QList<QgsRectangle> boxes;
+  QgsRectangle extent;
+  Q_FOREACH ( QgsGeometry* geometry, geometries )
+  {
+    if ( !geometry || geometry->isEmpty() )
+    {
+      continue;
+    }
+    QgsRectangle box = geometry->boundingBox();
+    if ( boxes.isEmpty() )
+    {
+      extent = box;
+    }
+    else
+    {
+      extent.combineExtentWith( &box );
+    }
+    boxes << box;
+    ordered << qMakePair( quint32( 0 ), geometry );
+  }
+  if ( ordered.isEmpty() )
+  {
+    return 0;
+  }
+  for ( int i = 0; i < ordered.size(); ++i )
+  {
+    ordered[i].first = zOrderCode( boxes.at( i ), extent );
+  }
+  qStableSort( ordered.begin(), ordered.end(), zOrderLessThan );
+
+  QList< QList<QgsGeometry*> > groups;
+  for ( int i = 0; i < ordered.size(); ++i )
+  {
+    if ( i % UNION_LEAF_SIZE == 0 )
+    {
+      groups << QList<QgsGeometry*>();
+    }
+    groups.last() << ordered.at( i ).second;
+  }
+
+  //a binary tree over the leaves has one union less than leaves in the levels above them
+  if ( p )
+  {
+    p->setMaximum( 2 * groups.size() - 1 );
+    p->setValue( 0 );
+  }
+  int chunkSize = parallel ? qMax( 1, QThread::idealThreadCount() ) * 4 : 1;
+  int nProcessed = 0;
+  QList<QgsGeometry*> previousLevel; //owned results of the level below
+  while ( true )
+  {
+    QList<QgsGeometry*> level;
+    for ( int start = 0; start < groups.size(); start += chunkSize )
+    {
+      if ( p && p->wasCanceled() )
+      {
+        qDeleteAll( level );
+        qDeleteAll( previousLevel );
+        return 0;
+      }
+      QList< QList<QgsGeometry*> > chunk = groups.mid( start, chunkSize );
+      if ( parallel )
+      {
+        level += QtConcurrent::blockingMapped<QList<QgsGeometry*> >( chunk, UnionGeometries() );
+      }
+      else
+      {
+        level << UnionGeometries()( chunk.at( 0 ) );
+      }
+      nProcessed += chunk.size();
+      if ( p )
+      {
+        p->setValue( nProcessed );
+      }
+    }
+    qDeleteAll( previousLevel );
+
+    if ( level.size() == 1 )
+    {
+      return level.at( 0 );
+    }
+    groups.clear();
+    for ( int i = 0; i < level.size(); i += 2 )
+    {
+      groups << level.mid( i, 2 );
+    }
+    previousLevel = level;
+  }
+}
+
+static QgsGeometry* unionFeatureGeometries( const QgsFeatureList& features, bool parallel, QProgressDialog* p )
+{
+  QList<QgsGeometry*> geometries;
+  Q_FOREACH ( const QgsFeature& f, features )
+  {
+    if ( f.constGeometry() )
+    {
+      geometries << new QgsGeometry( *f.constGeometry() );
+    }
+  }
+  QgsGeometry* dissolveGeometry = unionGeometries( geometries, parallel, p );
+  qDeleteAll( geometries );
+  return dissolveGeometry;
+}
+
+//! unions the geometries of a batch of features, called in worker threads
+class DissolveGeometry
+{
+  public:
+    typedef QgsGeometry* result_type;
+
+    QgsGeometry* operator()( const QgsFeatureList& features ) const
+    {
+      return unionFeatureGeometries( features, false, 0 );
+    }
+};
+
+QgsGeometryAnalyzer::QgsGeometryAnalyzer()
+    : mParallelProcessing( false )
+{
+}
 
 bool QgsGeometryAnalyzer::simplify( QgsVectorLayer* layer,
                                     const QString& shapefileName,
@@ -419,6 +638,7 @@ bool QgsGeometryAnalyzer::convexHull( QgsVectorLayer* layer, const QString& shap
   QgsVectorFileWriter vWriter( shapefileName, dp->encoding(), fields, outputType, &crs );
   QgsFeature currentFeature;
   QgsGeometry* dissolveGeometry = 0; //dissolve geometry
+  QgsFeatureList batch; //features waiting for parallel processing
   QMultiMap<QString, QgsFeatureId> map;
 
   if ( onlySelectedFeatures )
@@ -497,11 +717,26 @@ bool QgsGeometryAnalyzer::convexHull( QgsVectorLayer* layer, const QString& shap
           {
             continue;
           }
-          convexFeature( currentFeature, processedFeatures, &dissolveGeometry );
+          if ( mParallelProcessing )
+          {
+            batch << currentFeature;
+            if ( batch.size() >= PARALLEL_BATCH_SIZE )
+            {
+              convexFeatures( batch, processedFeatures + 1 - batch.size(), &dissolveGeometry );
+            }
+          }
+          else
+          {
+            convexFeature( currentFeature, processedFeatures, &dissolveGeometry );
+          }
           ++processedFeatures;
         }
         ++jt;
       }
+      if ( !batch.isEmpty() )
+      {
+        convexFeatures( batch, processedFeatures - batch.size(), &dissolveGeometry );
+      }
       QList<double> values;
       if ( !dissolveGeometry )
       {
@@ -543,10 +778,25 @@ bool QgsGeometryAnalyzer::convexHull( QgsVectorLayer* layer, const QString& shap
         {
           continue;
         }
-        convexFeature( currentFeature, processedFeatures, &dissolveGeometry );
+        if ( mParallelProcessing )
+        {
+          batch << currentFeature;
+          if ( batch.size() >= PARALLEL_BATCH_SIZE )
+          {
+            convexFeatures( batch, processedFeatures + 1 - batch.size(), &dissolveGeometry );
+          }
+        }
+        else
+        {
+          convexFeature( currentFeature, processedFeatures, &dissolveGeometry );
+        }
         ++processedFeatures;
         ++jt;
       }
+      if ( !batch.isEmpty() )
+      {
+        convexFeatures( batch, processedFeatures - batch.size(), &dissolveGeometry );
+      }
       QList<double> values;
       // QgsGeometry* tmpGeometry = 0;
       if ( !dissolveGeometry )
@@ -557,7 +807,7 @@ bool QgsGeometryAnalyzer::convexHull( QgsVectorLayer* layer, const QString& shap
       dissolveGeometry = dissolveGeometry->convexHull();
       // values = simpleMeasure( tmpGeometry );
       values = simpleMeasure( dissolveGeometry );
-      QgsAttributes attributes;
+      QgsAttributes attributes( 3 );
       attributes[0] = QVariant( currentKey );
       attributes[1] = QVariant( values[ 0 ] );
       attributes[2] = QVariant( values[ 1 ] );
@@ -578,11 +828,25 @@ void QgsGeometryAnalyzer::convexFeature( QgsFeature& f, int nProcessedFeatures,
     return;
   }
 
-  const QgsGeometry* featureGeometry = f.constGeometry();
-  QgsGeometry* tmpGeometry = 0;
-  QgsGeometry* convexGeometry = 0;
+  addConvexGeometry( f.constGeometry()->convexHull(), nProcessedFeatures, dissolveGeometry );
+}
 
-  convexGeometry = featureGeometry->convexHull();
+void QgsGeometryAnalyzer::convexFeatures( QgsFeatureList& features, int nProcessedFeatures, QgsGeometry** dissolveGeometry )
+{
+  QList<QgsGeometry*> convexGeometries = QtConcurrent::blockingMapped<QList<QgsGeometry*> >( features, ConvexHullGeometry() );
+  for ( int i = 0; i < features.size(); ++i )
+  {
+    if ( features.at( i ).constGeometry() )
+    {
+      addConvexGeometry( convexGeometries.at( i ), nProcessedFeatures + i, dissolveGeometry );
+    }
+  }
+  features.clear();
+}
+
+void QgsGeometryAnalyzer::addConvexGeometry( QgsGeometry* convexGeometry, int nProcessedFeatures, QgsGeometry** dissolveGeometry )
+{
+  QgsGeometry* tmpGeometry = 0;
 
   if ( nProcessedFeatures == 0 )
   {
@@ -649,7 +913,9 @@ bool QgsGeometryAnalyzer::dissolve( QgsVectorLayer* layer, const QString& shapef
     }
   }
 
-  QgsGeometry *dissolveGeometry = 0; //dissolve geometry
+  QList<QgsFeatureList> batches; //features of the output features waiting for parallel processing
+  QList<QgsAttributes> batchAttributes;
+  int batchedFeatures = 0;
   QMultiMap<QString, QgsFeatureId>::const_iterator jt = map.constBegin();
   QgsFeature outputFeature;
   while ( jt != map.constEnd() )
@@ -657,6 +923,7 @@ bool QgsGeometryAnalyzer::dissolve( QgsVectorLayer* layer, const QString& shapef
     QString currentKey = jt.key();
     int processedFeatures = 0;
     bool first = true;
+    QgsFeatureList batch;
     //take only selection
     if ( onlySelectedFeatures )
     {
@@ -687,7 +954,7 @@ bool QgsGeometryAnalyzer::dissolve( QgsVectorLayer* layer, const QString& shapef
             outputFeature.setAttributes( currentFeature.attributes() );
             first = false;
           }
-          dissolveFeature( currentFeature, processedFeatures, &dissolveGeometry );
+          batch << currentFeature;
           ++processedFeatures;
         }
         ++jt;
@@ -720,38 +987,64 @@ bool QgsGeometryAnalyzer::dissolve( QgsVectorLayer* layer, const QString& shapef
           outputFeature.setAttributes( currentFeature.attributes() );
           first = false;
         }
-        dissolveFeature( currentFeature, processedFeatures, &dissolveGeometry );
+        batch << currentFeature;
         ++processedFeatures;
         ++jt;
       }
     }
-    outputFeature.setGeometry( dissolveGeometry );
-    vWriter.addFeature( outputFeature );
+    if ( mParallelProcessing && batch.size() < PARALLEL_BATCH_SIZE )
+    {
+      //small groups are dissolved concurrently, one group per task
+      batches << batch;
+      batchAttributes << outputFeature.attributes();
+      batchedFeatures += batch.size();
+      if ( batchedFeatures >= PARALLEL_BATCH_SIZE )
+      {
+        dissolveFeatureBatches( batches, batchAttributes, &vWriter );
+        batchedFeatures = 0;
+      }
+    }
+    else
+    {
+      //write the waiting groups first to keep the order of the output features
+      if ( !batches.isEmpty() )
+      {
+        dissolveFeatureBatches( batches, batchAttributes, &vWriter );
+        batchedFeatures = 0;
+      }
+      QgsGeometry* dissolveGeometry = unionFeatureGeometries( batch, mParallelProcessing, p );
+      if ( !dissolveGeometry && p && p->wasCanceled() )
+      {
+        break;
+      }
+      outputFeature.setGeometry( dissolveGeometry );
+      vWriter.addFeature( outputFeature );
+    }
+    if ( p && p->wasCanceled() )
+    {
+      break;
+    }
   }
-  return true;
-}
-
-void QgsGeometryAnalyzer::dissolveFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry )
-{
-  if ( !f.constGeometry() )
+  if ( !batches.isEmpty() )
   {
-    return;
+    dissolveFeatureBatches( batches, batchAttributes, &vWriter );
   }
+  return true;
+}
 
-  const QgsGeometry* featureGeometry = f.constGeometry();
 
-  if ( nProcessedFeatures == 0 )
-  {
-    size_t geomSize = featureGeometry->wkbSize();
-    *dissolveGeometry = new QgsGeometry();
-    unsigned char* wkb = new unsigned char[geomSize];
-    memcpy( wkb, featureGeometry->asWkb(), geomSize );
-    ( *dissolveGeometry )->fromWkb( wkb, geomSize );
-  }
-  else
+void QgsGeometryAnalyzer::dissolveFeatureBatches( QList<QgsFeatureList>& batches, QList<QgsAttributes>& attributes, QgsVectorFileWriter* vfw )
+{
+  QList<QgsGeometry*> dissolveGeometries = QtConcurrent::blockingMapped<QList<QgsGeometry*> >( batches, DissolveGeometry() );
+  for ( int i = 0; i < batches.size(); ++i )
   {
-    *dissolveGeometry = ( *dissolveGeometry )->combine( featureGeometry );
+    QgsFeature outputFeature;
+    outputFeature.setAttributes( attributes.at( i ) );
+    outputFeature.setGeometry( dissolveGeometries.at( i ) );
+    vfw->addFeature( outputFeature );
   }
+  batches.clear();
+  attributes.clear();
 }
 
 bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefileName, double bufferDistance,
@@ -777,7 +1070,8 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
 
   QgsVectorFileWriter vWriter( shapefileName, dp->encoding(), layer->fields(), outputType, &crs );
   QgsFeature currentFeature;
-  QgsGeometry *dissolveGeometry = 0; //dissolve geometry (if dissolve enabled)
+  QList<QgsGeometry*> bufferGeometries; //buffers to dissolve (if dissolve enabled)
+  QgsFeatureList batch; //features waiting for parallel processing
 
   //take only selection
   if ( onlySelectedFeatures )
@@ -806,10 +1100,25 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
       {
         continue;
       }
-      bufferFeature( currentFeature, processedFeatures, &vWriter, dissolve, &dissolveGeometry, bufferDistance, bufferDistanceField );
+      if ( mParallelProcessing )
+      {
+        batch << currentFeature;
+        if ( batch.size() >= PARALLEL_BATCH_SIZE )
+        {
+          bufferFeatures( batch, &vWriter, dissolve, bufferGeometries, bufferDistance, bufferDistanceField );
+        }
+      }
+      else
+      {
+        bufferFeature( currentFeature, &vWriter, dissolve, bufferGeometries, bufferDistance, bufferDistanceField );
+      }
       ++processedFeatures;
     }
 
+    if ( !batch.isEmpty() )
+    {
+      bufferFeatures( batch, &vWriter, dissolve, bufferGeometries, bufferDistance, bufferDistanceField );
+    }
     if ( p )
     {
       p->setValue( selection.size() );
@@ -837,9 +1146,24 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
       {
         break;
       }
-      bufferFeature( currentFeature, processedFeatures, &vWriter, dissolve, &dissolveGeometry, bufferDistance, bufferDistanceField );
+      if ( mParallelProcessing )
+      {
+        batch << currentFeature;
+        if ( batch.size() >= PARALLEL_BATCH_SIZE )
+        {
+          bufferFeatures( batch, &vWriter, dissolve, bufferGeometries, bufferDistance, bufferDistanceField );
+        }
+      }
+      else
+      {
+        bufferFeature( currentFeature, &vWriter, dissolve, bufferGeometries, bufferDistance, bufferDistanceField );
+      }
       ++processedFeatures;
     }
+    if ( !batch.isEmpty() )
+    {
+      bufferFeatures( batch, &vWriter, dissolve, bufferGeometries, bufferDistance, bufferDistanceField );
+    }
     if ( p )
     {
       p->setValue( featureCount );
@@ -849,6 +1173,8 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
   if ( dissolve )
   {
     QgsFeature dissolveFeature;
+    QgsGeometry* dissolveGeometry = unionGeometries( bufferGeometries, mParallelProcessing, p );
+    qDeleteAll( bufferGeometries );
     if ( !dissolveGeometry )
     {
       QgsDebugMsg( "no dissolved geometry - should not happen" );
@@ -860,43 +1186,38 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
   return true;
 }
 
-void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, int nProcessedFeatures, QgsVectorFileWriter* vfw, bool dissolve,
-    QgsGeometry** dissolveGeometry, double bufferDistance, int bufferDistanceField )
+void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, QgsVectorFileWriter* vfw, bool dissolve, QList<QgsGeometry*>& dissolveGeometries,
+    double bufferDistance, int bufferDistanceField )
 {
   if ( !f.constGeometry() )
   {
     return;
   }
 
-  double currentBufferDistance;
-  const QgsGeometry* featureGeometry = f.constGeometry();
-  QgsGeometry* tmpGeometry = 0;
-  QgsGeometry* bufferGeometry = 0;
+  addBufferGeometry( f, BufferGeometry( bufferDistance, bufferDistanceField )( f ), vfw, dissolve, dissolveGeometries );
+}
 
-  //create buffer
-  if ( bufferDistanceField == -1 )
-  {
-    currentBufferDistance = bufferDistance;
-  }
-  else
+void QgsGeometryAnalyzer::bufferFeatures( QgsFeatureList& features, QgsVectorFileWriter* vfw, bool dissolve, QList<QgsGeometry*>& dissolveGeometries,
+    double bufferDistance, int bufferDistanceField )
+{
+  QList<QgsGeometry*> bufferGeometries = QtConcurrent::blockingMapped<QList<QgsGeometry*> >( features, BufferGeometry( bufferDistance, bufferDistanceField ) );
+  for ( int i = 0; i < features.size(); ++i )
   {
-    currentBufferDistance = f.attribute( bufferDistanceField ).toDouble();
+    if ( features.at( i ).constGeometry() )
+    {
+      addBufferGeometry( features[i], bufferGeometries.at( i ), vfw, dissolve, dissolveGeometries );
+    }
   }
-  bufferGeometry = featureGeometry->buffer( currentBufferDistance, 5 );
+  features.clear();
+}
 
+void QgsGeometryAnalyzer::addBufferGeometry( QgsFeature& f, QgsGeometry* bufferGeometry, QgsVectorFileWriter* vfw, bool dissolve,
+    QList<QgsGeometry*>& dissolveGeometries )
+{
   if ( dissolve )
   {
-    if ( nProcessedFeatures == 0 )
-    {
-      *dissolveGeometry = bufferGeometry;
-    }
-    else
-    {
-      tmpGeometry = *dissolveGeometry;
-      *dissolveGeometry = ( *dissolveGeometry )->combine( bufferGeometry );
-      delete tmpGeometry;
-      delete bufferGeometry;
-    }
+    //unioned at the end
+    dissolveGeometries << bufferGeometry;
   }
   else //dissolve
   {
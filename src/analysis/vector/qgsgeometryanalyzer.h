@@ -36,6 +36,20 @@ class ANALYSIS_EXPORT QgsGeometryAnalyzer
 {
   public:
 
+    QgsGeometryAnalyzer();
+
+    /** Sets whether buffer, convexHull and dissolve compute geometries in worker threads.
+      Features are still read and written by the calling thread and in the same order,
+      so the output does not depend on this setting. Disabled by default.
+      @note added in QGIS 2.12
+      */
+    void setParallelProcessing( bool enabled ) { mParallelProcessing = enabled; }
+
+    /** Returns true if geometries are computed in worker threads
+      @note added in QGIS 2.12
+      */
+    bool parallelProcessing() const { return mParallelProcessing; }
+
     /** Simplify vector layer using (a modified) Douglas-Peucker algorithm
      and write it to a new shape file
       @param layer input vector layer
@@ -134,13 +148,24 @@ class ANALYSIS_EXPORT QgsGeometryAnalyzer
     void simplifyFeature( QgsFeature& f, QgsVectorFileWriter* vfw, double tolerance );
     /** Helper function to get the cetroid of an individual feature*/
     void centroidFeature( QgsFeature& f, QgsVectorFileWriter* vfw );
-    /** Helper function to buffer an individual feature*/
-    void bufferFeature( QgsFeature& f, int nProcessedFeatures, QgsVectorFileWriter* vfw, bool dissolve, QgsGeometry** dissolveGeometry,
+    /** Helper function to buffer an individual feature. With dissolve, the buffer is appended to dissolveGeometries.*/
+    void bufferFeature( QgsFeature& f, QgsVectorFileWriter* vfw, bool dissolve, QList<QgsGeometry*>& dissolveGeometries,
                         double bufferDistance, int bufferDistanceField );
+    /** Helper function to buffer a batch of features in worker threads. The batch is cleared.*/
+    void bufferFeatures( QgsFeatureList& features, QgsVectorFileWriter* vfw, bool dissolve, QList<QgsGeometry*>& dissolveGeometries,
+                         double bufferDistance, int bufferDistanceField );
+    /** Helper function to collect a buffer for dissolving or to write it with the attributes of its feature*/
+    void addBufferGeometry( QgsFeature& f, QgsGeometry* bufferGeometry, QgsVectorFileWriter* vfw, bool dissolve,
+                            QList<QgsGeometry*>& dissolveGeometries );
     /** Helper function to get the convex hull of feature(s)*/
     void convexFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry );
-    /** Helper function to dissolve feature(s)*/
-    void dissolveFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry );
+    /** Helper function to get the convex hulls of a batch of features in worker threads. The batch is cleared.*/
+    void convexFeatures( QgsFeatureList& features, int nProcessedFeatures, QgsGeometry** dissolveGeometry );
+    /** Helper function to add a convex hull to the dissolve geometry*/
+    void addConvexGeometry( QgsGeometry* convexGeometry, int nProcessedFeatures, QgsGeometry** dissolveGeometry );
+    /** Helper function to dissolve batches of features in worker threads, one output feature with the given
+      attributes per batch. The output features are written in order and the lists are cleared.*/
+    void dissolveFeatureBatches( QList<QgsFeatureList>& batches, QList<QgsAttributes>& attributes, QgsVectorFileWriter* vfw );
 
     //helper functions for event layer
     void addEventLayerFeature( QgsFeature& feature, QgsGeometry* geom, QgsGeometry* lineGeom, QgsVectorFileWriter* fileWriter, QgsFeatureList& memoryFeatures, int offsetField = -1, double offsetScale = 1.0,
@@ -155,5 +180,7 @@ class ANALYSIS_EXPORT QgsGeometryAnalyzer
     const unsigned char* locateAlongWkbString( const unsigned char* ptr, QgsMultiPoint& result, double measure );
     static bool clipSegmentByRange( double x1, double y1, double m1, double x2, double y2, double m2, double range1, double range2, QgsPoint& pt1, QgsPoint& pt2, bool& secondPointClipped );
     static void locateAlongSegment( double x1, double y1, double m1, double x2, double y2, double m2, double measure, bool& pt1Ok, QgsPoint& pt1, bool& pt2Ok, QgsPoint& pt2 );
+
+    bool mParallelProcessing;
 };
 #endif //QGSVECTORANALYZER
@@ -823,17 +823,44 @@ void QgsAttributeTableDialog::setFilterExpression( QString filterString )
   }
   QgsFeatureIterator featIt = mLayer->getFeatures( request );
 
+  // evaluate the filter for blocks of features at once
+  const int blockSize = 1024;
+  QgsFeatureList block;
+  block.reserve( blockSize );
   QgsFeature f;
 
-  while ( featIt.nextFeature( f ) )
+  for ( ;; )
   {
-    context.setFeature( f );
-    if ( filterExpression.evaluate( &context ).toInt() != 0 )
-      filteredFeatures << f.id();
+    block.clear();
+    while ( block.count() < blockSize && featIt.nextFeature( f ) )
+      block << f;
+
+    if ( block.isEmpty() )
+      break;
+
+    QVariantList results = filterExpression.evaluateBlock( block, &context );
 
     // check if there were errors during evaluating
     if ( filterExpression.hasEvalError() )
+    {
+      // evaluate the block feature by feature to stop at the failing feature
+      Q_FOREACH ( const QgsFeature& feature, block )
+      {
+        context.setFeature( feature );
+        if ( filterExpression.evaluate( &context ).toInt() != 0 )
+          filteredFeatures << feature.id();
+
+        if ( filterExpression.hasEvalError() )
+          break;
+      }
       break;
+    }
+
+    for ( int i = 0; i < block.count(); ++i )
+    {
+      if ( results.at( i ).toInt() != 0 )
+        filteredFeatures << block.at( i ).id();
+    }
   }
 
   featIt.close();
@@ -29,6 +29,8 @@ email                : morb at ozemail dot com dot au
 #include "qgsmessagelog.h"
 #include "qgspoint.h"
 #include "qgsrectangle.h"
+#include "qgswkbgeometryview.h"
+#include "qgswkbptr.h"
 
 #include "qgsmaplayerregistry.h"
 #include "qgsvectorlayer.h"
@@ -44,23 +46,242 @@ email                : morb at ozemail dot com dot au
 #include "qgspolygonv2.h"
 #include "qgslinestringv2.h"
 
+#include <QCache>
+#include <QMutex>
+#include <QPair>
+#include <QThreadStorage>
+
 #ifndef Q_WS_WIN
 #include <netinet/in.h>
 #else
 #include <winsock.h>
 #endif
 
+//! returns a new number identifying the content of a geometry
+static int nextGeometrySerial()
+{
+  static QAtomicInt sNextSerial( 1 );
+  return sNextSerial.fetchAndAddRelaxed( 1 );
+}
+
+//! number of mutexes serializing the lazy evaluations of shared geometries
+static const int LAZY_GEOMETRY_MUTEXES = 16;
+
+//! returns the mutex serializing the lazy evaluations of a geometry's shared data
+static QMutex* lazyGeometryMutex( const void* d )
+{
+  static QMutex sMutexes[LAZY_GEOMETRY_MUTEXES];
+  return &sMutexes[( reinterpret_cast<quintptr>( d ) >> 4 ) % LAZY_GEOMETRY_MUTEXES];
+}
+
 struct QgsGeometryPrivate
 {
-  QgsGeometryPrivate(): ref( 1 ), geometry( 0 ), mWkb( 0 ), mWkbSize( 0 ), mGeos( 0 ) {}
-  ~QgsGeometryPrivate() { delete geometry; delete[] mWkb; GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), mGeos ); }
+  QgsGeometryPrivate(): ref( 1 ), mGeometry( 0 ), mWkb( 0 ), mWkbSize( 0 ), mGeos( 0 ), mLazy( 0 ), mHasBoundingBox( 0 ), mSerial( nextGeometrySerial() ) {}
+  ~QgsGeometryPrivate() { clear(); }
+
+  /** Returns the geometry object tree. Geometries set from provider WKB are only parsed
+   * when the tree is needed for the first time. Copies of the geometry share the data,
+   * possibly in several threads, so the WKB is parsed under a lock and the flag is only
+   * cleared once the tree is complete. */
+  QgsAbstractGeometryV2*& geometry() const
+  {
+    if ( mLazy )
+    {
+      QMutexLocker locker( lazyGeometryMutex( this ) );
+      if ( mLazy )
+      {
+        mGeometry = QgsGeometryFactory::geomFromWkb( mWkb );
+        mLazy.fetchAndStoreRelease( 0 );
+      }
+    }
+    return mGeometry;
+  }
+
+  //! true if there is a geometry tree or WKB which has not been parsed yet
+  bool hasGeometry() const { return mLazy || mGeometry; }
+
+  //! returns the bounding box of WKB which has not been parsed yet, computed on first use
+  QgsRectangle lazyBoundingBox() const
+  {
+    if ( !mHasBoundingBox )
+    {
+      QMutexLocker locker( lazyGeometryMutex( this ) );
+      if ( !mHasBoundingBox )
+      {
+        mBoundingBox = QgsWkbGeometryView( mWkb, mWkbSize ).boundingBox();
+        mHasBoundingBox.fetchAndStoreRelease( 1 );
+      }
+    }
+    return mBoundingBox;
+  }
+
+  //! deletes the geometry tree, WKB and GEOS geometry without parsing the WKB
+  void clear()
+  {
+    mSerial = nextGeometrySerial();
+    delete mGeometry;
+    mGeometry = 0;
+    delete[] mWkb;
+    mWkb = 0;
+    mWkbSize = 0;
+    GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), mGeos );
+    mGeos = 0;
+    mLazy = QAtomicInt( 0 );
+    mHasBoundingBox = QAtomicInt( 0 );
+  }
+
   QAtomicInt ref;
-  QgsAbstractGeometryV2* geometry;
+  mutable QgsAbstractGeometryV2* mGeometry;
   mutable const unsigned char* mWkb; //store wkb pointer for backward compatibility
   mutable int mWkbSize;
   mutable GEOSGeometry* mGeos;
+  //! mWkb is valid and has not been parsed into mGeometry yet
+  mutable QAtomicInt mLazy;
+  //! bounding box computed from the WKB while it has not been parsed
+  mutable QgsRectangle mBoundingBox;
+  mutable QAtomicInt mHasBoundingBox;
+  //! changes whenever the geometry is edited, identifies prepared geometries together with the address
+  int mSerial;
 };
 
+//! a geometry which took part in this many relation tests keeps a prepared engine for further tests
+static const int PREPARE_AFTER_RELATION_TESTS = 2;
+
+//! number of recently tested geometries per thread whose relation tests are counted
+static const int PREPARED_GEOMETRIES_PER_THREAD = 16;
+
+//! relation tests of a geometry in one thread and its prepared engine
+struct PreparedGeometry
+{
+  PreparedGeometry() : relationTests( 0 ), engine( 0 ) {}
+  ~PreparedGeometry() { delete engine; }
+
+  int relationTests;
+  QgsGeometryEngine* engine;
+};
+
+typedef QPair<const QgsGeometryPrivate*, int> PreparedGeometryKey;
+typedef QCache<PreparedGeometryKey, PreparedGeometry> PreparedGeometryCache;
+
+// Implicitly shared geometries may be tested from several threads at the same time and a
+// prepared GEOS geometry must not be used by several threads. So the shared data is left
+// untouched, every thread keeps its own prepared engines of the geometries it tested recently.
+static QThreadStorage<PreparedGeometryCache*> sPreparedGeometries;
+
+//! returns the relation tests and the prepared engine of a geometry in the current thread
+static PreparedGeometry* preparedGeometry( const QgsGeometryPrivate* d )
+{
+  if ( !sPreparedGeometries.hasLocalData() )
+  {
+    sPreparedGeometries.setLocalData( new PreparedGeometryCache( PREPARED_GEOMETRIES_PER_THREAD ) );
+  }
+  PreparedGeometryCache* cache = sPreparedGeometries.localData();
+
+  PreparedGeometryKey key( d, d->mSerial );
+  PreparedGeometry* prepared = cache->object( key );
+  if ( !prepared )
+  {
+    prepared = new PreparedGeometry;
+    cache->insert( key, prepared );
+  }
+  return prepared;
+}
+
+enum GeometryRelation
+{
+  Intersects,
+  Touches,
+  Crosses,
+  Within,
+  Overlaps,
+  Contains,
+  Disjoint
+};
+
+static bool engineRelation( const QgsGeometryEngine* engine, const QgsAbstractGeometryV2& other, GeometryRelation relation )
+{
+  switch ( relation )
+  {
+    case Intersects:
+      return engine->intersects( other );
+    case Touches:
+      return engine->touches( other );
+    case Crosses:
+      return engine->crosses( other );
+    case Within:
+      return engine->within( other );
+    case Overlaps:
+      return engine->overlaps( other );
+    case Contains:
+      return engine->contains( other );
+    case Disjoint:
+      return engine->disjoint( other );
+  }
+  return false;
+}
+
+//! tests a relation of a geometry to another one, using the prepared engine of the geometry if it is tested repeatedly
+static bool geometryRelation( const QgsGeometryPrivate* d, PreparedGeometry* prepared, const QgsAbstractGeometryV2& other, GeometryRelation relation )
+{
+  if ( !prepared->engine && prepared->relationTests >= PREPARE_AFTER_RELATION_TESTS )
+  {
+    prepared->engine = QgsGeometry::createGeometryEngine( d->geometry() );
+    prepared->engine->prepareGeometry();
+  }
+
+  if ( prepared->engine )
+  {
+    return engineRelation( prepared->engine, other, relation );
+  }
+
+  QgsGeos geos( d->geometry() );
+  return engineRelation( &geos, other, relation );
+}
+
+//! tests a relation of a geometry to a temporary one, which does not count as a test of the geometry
+static bool geometryRelation( const QgsGeometryPrivate* d, const QgsAbstractGeometryV2& other, GeometryRelation relation )
+{
+  return geometryRelation( d, preparedGeometry( d ), other, relation );
+}
+
+/** Tests a relation between two geometries. The test is done from the side of the geometry
+ * which took part in more tests, e.g. a filter polygon tested against many features, so that
+ * it is converted to GEOS and prepared only once. All relations are symmetric except for
+ * contains and within, which are the converse of each other.
+ */
+static bool geometryRelation( const QgsGeometryPrivate* a, const QgsGeometryPrivate* b, GeometryRelation relation )
+{
+  // the entry of a was used last, so it is not dropped from the cache when b is added
+  PreparedGeometry* preparedA = preparedGeometry( a );
+  ++preparedA->relationTests;
+  PreparedGeometry* preparedB = preparedGeometry( b );
+  if ( b != a )
+    ++preparedB->relationTests;
+
+  const QgsGeometryPrivate* tested = a;
+  const QgsGeometryPrivate* other = b;
+  PreparedGeometry* preparedTested = preparedA;
+  PreparedGeometry* preparedOther = preparedB;
+  if ( preparedB->relationTests > preparedA->relationTests )
+  {
+    tested = b;
+    other = a;
+    preparedTested = preparedB;
+    preparedOther = preparedA;
+    relation = relation == Contains ? Within : relation == Within ? Contains : relation;
+  }
+
+  bool result = geometryRelation( tested, preparedTested, *other->geometry(), relation );
+
+  // Tests against a prepared geometry do not count for the other one, so that features
+  // tested against several filters do not end up with a prepared engine.
+  if ( preparedTested->engine && other != tested )
+  {
+    preparedOther->relationTests = 0;
+  }
+  return result;
+}
+
 QgsGeometry::QgsGeometry(): d( new QgsGeometryPrivate() )
 {
 }
@@ -78,7 +299,7 @@ QgsGeometry::~QgsGeometry()
 
 QgsGeometry::QgsGeometry( QgsAbstractGeometryV2* geom ): d( new QgsGeometryPrivate() )
 {
-  d->geometry = geom;
+  d->geometry() = geom;
   d->ref = QAtomicInt( 1 );
 }
 
@@ -110,20 +331,30 @@ void QgsGeometry::detach( bool cloneGeom )
   if ( d->ref > 1 )
   {
     ( void )d->ref.deref();
-    QgsAbstractGeometryV2* cGeom = 0;
+    QgsGeometryPrivate* old = d;
+    d = new QgsGeometryPrivate();
 
-    if ( d->geometry && cloneGeom )
+    if ( cloneGeom && old->mLazy )
     {
-      cGeom = d->geometry->clone();
+      // copying the bytes is cheaper than cloning a geometry tree which has not been built yet
+      unsigned char* wkb = new unsigned char[old->mWkbSize];
+      memcpy( wkb, old->mWkb, old->mWkbSize );
+      d->mWkb = wkb;
+      d->mWkbSize = old->mWkbSize;
+      d->mLazy = QAtomicInt( 1 );
+    }
+    else if ( cloneGeom && old->geometry() )
+    {
+      d->geometry() = old->geometry()->clone();
     }
-
-    d = new QgsGeometryPrivate();
-    d->geometry = cGeom;
   }
 }
 
 void QgsGeometry::removeWkbGeos()
 {
+  // the tree is about to be modified, so it has to exist before the WKB is dropped
+  d->geometry();
+  d->mSerial = nextGeometrySerial();
   delete[] d->mWkb;
   d->mWkb = 0;
   d->mWkbSize = 0;
@@ -140,25 +371,19 @@ QgsAbstractGeometryV2* QgsGeometry::geometry() const
   {
     return 0;
   }
-  return d->geometry;
+  return d->geometry();
 }
 
 void QgsGeometry::setGeometry( QgsAbstractGeometryV2* geometry )
 {
   detach( false );
-  if ( d->geometry )
-  {
-    delete d->geometry;
-    d->geometry = 0;
-  }
-  removeWkbGeos();
-
-  d->geometry = geometry;
+  d->clear();
+  d->geometry() = geometry;
 }
 
 bool QgsGeometry::isEmpty() const
 {
-  return !d || !d->geometry;
+  return !d || !d->hasGeometry();
 }
 
 QgsGeometry* QgsGeometry::fromWkt( QString wkt )
@@ -248,62 +473,70 @@ QgsGeometry* QgsGeometry::fromRect( const QgsRectangle& rect )
 
 void QgsGeometry::fromWkb( unsigned char *wkb, size_t length )
 {
-  Q_UNUSED( length );
   if ( !d )
   {
     return;
   }
 
   detach( false );
+  d->clear();
+  d->mWkb = wkb;
+  d->mWkbSize = length;
 
-  if ( d->geometry )
+  // Well formed linear geometries are kept as WKB until the geometry tree is needed, so that
+  // features which are only drawn or written never build it. Curves need the tree for
+  // segmentizing anyway, and the factory reads the type in native byte order only.
+  QgsWkbGeometryView view( wkb, length );
+  if ( view.isValid() && view.isNativeByteOrder() && !view.hasCurvedSegments() )
   {
-    delete d->geometry;
-    removeWkbGeos();
+    d->mLazy = QAtomicInt( 1 );
+  }
+  else
+  {
+    d->geometry() = QgsGeometryFactory::geomFromWkb( wkb );
   }
-  d->geometry = QgsGeometryFactory::geomFromWkb( wkb );
-  d->mWkb = wkb;
-  d->mWkbSize = length;
 }
 
 const unsigned char *QgsGeometry::asWkb() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->hasGeometry() )
   {
     return 0;
   }
 
   if ( !d->mWkb )
   {
-    d->mWkb = d->geometry->asWkb( d->mWkbSize );
+    d->mWkb = d->geometry()->asWkb( d->mWkbSize );
   }
   return d->mWkb;
 }
 
 size_t QgsGeometry::wkbSize() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->hasGeometry() )
   {
     return 0;
   }
 
   if ( !d->mWkb )
   {
-    d->mWkb = d->geometry->asWkb( d->mWkbSize );
+    d->mWkb = d->geometry()->asWkb( d->mWkbSize );
   }
   return d->mWkbSize;
 }
 
 const GEOSGeometry* QgsGeometry::asGeos() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
+  // shared geometries, e.g. cached for rendering, may be converted from several threads
+  QMutexLocker locker( lazyGeometryMutex( d ) );
   if ( !d->mGeos )
   {
-    d->mGeos = QgsGeos::asGeos( d->geometry );
+    d->mGeos = QgsGeos::asGeos( d->geometry() );
   }
   return d->mGeos;
 }
@@ -311,33 +544,37 @@ const GEOSGeometry* QgsGeometry::asGeos() const
 
 QGis::WkbType QgsGeometry::wkbType() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->hasGeometry() )
   {
     return QGis::WKBUnknown;
   }
+  else if ( d->mLazy )
+  {
+    return ( QGis::WkbType )QgsConstWkbPtr( d->mWkb ).readHeader();
+  }
   else
   {
-    return ( QGis::WkbType )d->geometry->wkbType();
+    return ( QGis::WkbType )d->geometry()->wkbType();
   }
 }
 
 
 QGis::GeometryType QgsGeometry::type() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->hasGeometry() )
   {
     return QGis::UnknownGeometry;
   }
-  return ( QGis::GeometryType )( QgsWKBTypes::geometryType( d->geometry->wkbType() ) );
+  return ( QGis::GeometryType )( QgsWKBTypes::geometryType(( QgsWKBTypes::Type )wkbType() ) );
 }
 
 bool QgsGeometry::isMultipart() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->hasGeometry() )
   {
     return false;
   }
-  return QgsWKBTypes::isMultiType( d->geometry->wkbType() );
+  return QgsWKBTypes::isMultiType(( QgsWKBTypes::Type )wkbType() );
 }
 
 void QgsGeometry::fromGeos( GEOSGeometry *geos )
@@ -345,22 +582,22 @@ void QgsGeometry::fromGeos( GEOSGeometry *geos )
   if ( d )
   {
     detach( false );
-    delete d->geometry;
-    d->geometry = QgsGeos::fromGeos( geos );
+    d->clear();
+    d->geometry() = QgsGeos::fromGeos( geos );
     d->mGeos = geos;
   }
 }
 
 QgsPoint QgsGeometry::closestVertex( const QgsPoint& point, int& atVertex, int& beforeVertex, int& afterVertex, double& sqrDist ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return QgsPoint( 0, 0 );
   }
   QgsPointV2 pt( point.x(), point.y() );
   QgsVertexId id;
 
-  QgsPointV2 vp = QgsGeometryUtils::closestVertex( *( d->geometry ), pt, id );
+  QgsPointV2 vp = QgsGeometryUtils::closestVertex( *( d->geometry() ), pt, id );
   if ( !id.isValid() )
   {
     sqrDist = -1;
@@ -375,7 +612,7 @@ QgsPoint QgsGeometry::closestVertex( const QgsPoint& point, int& atVertex, int&
 
 void QgsGeometry::adjacentVertices( int atVertex, int& beforeVertex, int& afterVertex ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return;
   }
@@ -388,14 +625,14 @@ void QgsGeometry::adjacentVertices( int atVertex, int& beforeVertex, int& afterV
   }
 
   QgsVertexId beforeVertexId, afterVertexId;
-  QgsGeometryUtils::adjacentVertices( *( d->geometry ), id, beforeVertexId, afterVertexId );
+  QgsGeometryUtils::adjacentVertices( *( d->geometry() ), id, beforeVertexId, afterVertexId );
   beforeVertex = vertexNrFromVertexId( beforeVertexId );
   afterVertex = vertexNrFromVertexId( afterVertexId );
 }
 
 bool QgsGeometry::moveVertex( double x, double y, int atVertex )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
@@ -409,12 +646,12 @@ bool QgsGeometry::moveVertex( double x, double y, int atVertex )
   detach( true );
 
   removeWkbGeos();
-  return d->geometry->moveVertex( id, QgsPointV2( x, y ) );
+  return d->geometry()->moveVertex( id, QgsPointV2( x, y ) );
 }
 
 bool QgsGeometry::moveVertex( const QgsPointV2& p, int atVertex )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
@@ -428,32 +665,32 @@ bool QgsGeometry::moveVertex( const QgsPointV2& p, int atVertex )
   detach( true );
 
   removeWkbGeos();
-  return d->geometry->moveVertex( id, p );
+  return d->geometry()->moveVertex( id, p );
 }
 
 bool QgsGeometry::deleteVertex( int atVertex )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
   //maintain compatibility with < 2.10 API
-  if ( d->geometry->geometryType() == "MultiPoint" )
+  if ( d->geometry()->geometryType() == "MultiPoint" )
   {
     detach( true );
     removeWkbGeos();
     //delete geometry instead of point
-    return static_cast< QgsGeometryCollectionV2* >( d->geometry )->removeGeometry( atVertex );
+    return static_cast< QgsGeometryCollectionV2* >( d->geometry() )->removeGeometry( atVertex );
   }
 
   //if it is a point, set the geometry to NULL
-  if ( QgsWKBTypes::flatType( d->geometry->wkbType() ) == QgsWKBTypes::Point )
+  if ( QgsWKBTypes::flatType( d->geometry()->wkbType() ) == QgsWKBTypes::Point )
   {
     detach( false );
-    delete d->geometry;
+    delete d->geometry();
     removeWkbGeos();
-    d->geometry = 0;
+    d->geometry() = 0;
     return true;
   }
 
@@ -466,23 +703,23 @@ bool QgsGeometry::deleteVertex( int atVertex )
   detach( true );
 
   removeWkbGeos();
-  return d->geometry->deleteVertex( id );
+  return d->geometry()->deleteVertex( id );
 }
 
 bool QgsGeometry::insertVertex( double x, double y, int beforeVertex )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
   //maintain compatibility with < 2.10 API
-  if ( d->geometry->geometryType() == "MultiPoint" )
+  if ( d->geometry()->geometryType() == "MultiPoint" )
   {
     detach( true );
     removeWkbGeos();
     //insert geometry instead of point
-    return static_cast< QgsGeometryCollectionV2* >( d->geometry )->insertGeometry( new QgsPointV2( x, y ), beforeVertex );
+    return static_cast< QgsGeometryCollectionV2* >( d->geometry() )->insertGeometry( new QgsPointV2( x, y ), beforeVertex );
   }
 
   QgsVertexId id;
@@ -495,12 +732,12 @@ bool QgsGeometry::insertVertex( double x, double y, int beforeVertex )
 
   removeWkbGeos();
 
-  return d->geometry->insertVertex( id, QgsPointV2( x, y ) );
+  return d->geometry()->insertVertex( id, QgsPointV2( x, y ) );
 }
 
 QgsPoint QgsGeometry::vertexAt( int atVertex ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return QgsPoint( 0, 0 );
   }
@@ -511,7 +748,7 @@ QgsPoint QgsGeometry::vertexAt( int atVertex ) const
   {
     return QgsPoint( 0, 0 );
   }
-  QgsPointV2 pt = d->geometry->vertexAt( vId );
+  QgsPointV2 pt = d->geometry()->vertexAt( vId );
   return QgsPoint( pt.x(), pt.y() );
 }
 
@@ -523,14 +760,14 @@ double QgsGeometry::sqrDistToVertexAt( QgsPoint& point, int atVertex ) const
 
 double QgsGeometry::closestVertexWithContext( const QgsPoint& point, int& atVertex ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0.0;
   }
 
   QgsVertexId vId;
   QgsPointV2 pt( point.x(), point.y() );
-  QgsPointV2 closestPoint = QgsGeometryUtils::closestVertex( *( d->geometry ), pt, vId );
+  QgsPointV2 closestPoint = QgsGeometryUtils::closestVertex( *( d->geometry() ), pt, vId );
   atVertex = vertexNrFromVertexId( vId );
   return QgsGeometryUtils::sqrDistance2D( closestPoint, pt );
 }
@@ -542,7 +779,7 @@ double QgsGeometry::closestSegmentWithContext(
   double *leftOf,
   double epsilon ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
@@ -551,7 +788,7 @@ double QgsGeometry::closestSegmentWithContext(
   QgsVertexId vertexAfter;
   bool leftOfBool;
 
-  double sqrDist = d->geometry->closestSegment( QgsPointV2( point.x(), point.y() ), segmentPt,  vertexAfter, &leftOfBool, epsilon );
+  double sqrDist = d->geometry()->closestSegment( QgsPointV2( point.x(), point.y() ), segmentPt,  vertexAfter, &leftOfBool, epsilon );
 
   minDistPoint.setX( segmentPt.x() );
   minDistPoint.setY( segmentPt.y() );
@@ -577,7 +814,7 @@ int QgsGeometry::addRing( const QList<QgsPoint>& ring )
 
 int QgsGeometry::addRing( QgsCurveV2* ring )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     delete ring;
     return 1;
@@ -586,7 +823,7 @@ int QgsGeometry::addRing( QgsCurveV2* ring )
   detach( true );
 
   removeWkbGeos();
-  return QgsGeometryEditUtils::addRing( d->geometry, ring );
+  return QgsGeometryEditUtils::addRing( d->geometry(), ring );
 }
 
 int QgsGeometry::addPart( const QList<QgsPoint> &points, QGis::GeometryType geomType )
@@ -596,19 +833,19 @@ int QgsGeometry::addPart( const QList<QgsPoint> &points, QGis::GeometryType geom
     return 1;
   }
 
-  if ( !d->geometry )
+  if ( !d->geometry() )
   {
     detach( false );
     switch ( geomType )
     {
       case QGis::Point:
-        d->geometry = new QgsMultiPointV2();
+        d->geometry() = new QgsMultiPointV2();
         break;
       case QGis::Line:
-        d->geometry = new QgsMultiLineStringV2();
+        d->geometry() = new QgsMultiLineStringV2();
         break;
       case QGis::Polygon:
-        d->geometry = new QgsMultiPolygonV2();
+        d->geometry() = new QgsMultiPolygonV2();
         break;
       default:
         return 1;
@@ -637,22 +874,22 @@ int QgsGeometry::addPart( QgsAbstractGeometryV2* part )
 {
   detach( true );
   removeWkbGeos();
-  return QgsGeometryEditUtils::addPart( d->geometry, part );
+  return QgsGeometryEditUtils::addPart( d->geometry(), part );
 }
 
 int QgsGeometry::addPart( const QgsGeometry *newPart )
 {
-  if ( !d || !d->geometry || !newPart || !newPart->d || !newPart->d->geometry )
+  if ( !d || !d->geometry() || !newPart || !newPart->d || !newPart->d->geometry() )
   {
     return 1;
   }
 
-  return addPart( newPart->d->geometry->clone() );
+  return addPart( newPart->d->geometry()->clone() );
 }
 
 int QgsGeometry::addPart( GEOSGeometry *newPart )
 {
-  if ( !d || !d->geometry || !newPart )
+  if ( !d || !d->geometry() || !newPart )
   {
     return 1;
   }
@@ -661,26 +898,26 @@ int QgsGeometry::addPart( GEOSGeometry *newPart )
 
   QgsAbstractGeometryV2* geom = QgsGeos::fromGeos( newPart );
   removeWkbGeos();
-  return QgsGeometryEditUtils::addPart( d->geometry, geom );
+  return QgsGeometryEditUtils::addPart( d->geometry(), geom );
 }
 
 int QgsGeometry::translate( double dx, double dy )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 1;
   }
 
   detach( true );
 
-  d->geometry->transform( QTransform::fromTranslate( dx, dy ) );
+  d->geometry()->transform( QTransform::fromTranslate( dx, dy ) );
   removeWkbGeos();
   return 0;
 }
 
 int QgsGeometry::rotate( double rotation, const QgsPoint& center )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 1;
   }
@@ -690,14 +927,14 @@ int QgsGeometry::rotate( double rotation, const QgsPoint& center )
   QTransform t = QTransform::fromTranslate( center.x(), center.y() );
   t.rotate( -rotation );
   t.translate( -center.x(), -center.y() );
-  d->geometry->transform( t );
+  d->geometry()->transform( t );
   removeWkbGeos();
   return 0;
 }
 
 int QgsGeometry::splitGeometry( const QList<QgsPoint>& splitLine, QList<QgsGeometry*>& newGeometries, bool topological, QList<QgsPoint> &topologyTestPoints )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
@@ -709,13 +946,13 @@ int QgsGeometry::splitGeometry( const QList<QgsPoint>& splitLine, QList<QgsGeome
   splitLineString.setPoints( splitLinePointsV2 );
   QList<QgsPointV2> tp;
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   int result = geos.splitGeometry( splitLineString, newGeoms, topological, tp );
 
   if ( result == 0 )
   {
     detach( false );
-    d->geometry = newGeoms.at( 0 );
+    d->geometry() = newGeoms.at( 0 );
 
     newGeometries.clear();
     for ( int i = 1; i < newGeoms.size(); ++i )
@@ -732,7 +969,7 @@ int QgsGeometry::splitGeometry( const QList<QgsPoint>& splitLine, QList<QgsGeome
 /** Replaces a part of this geometry with another line*/
 int QgsGeometry::reshapeGeometry( const QList<QgsPoint>& reshapeWithLine )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
@@ -742,14 +979,15 @@ int QgsGeometry::reshapeGeometry( const QList<QgsPoint>& reshapeWithLine )
   QgsLineStringV2 reshapeLineString;
   reshapeLineString.setPoints( reshapeLine );
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   int errorCode = 0;
   QgsAbstractGeometryV2* geom = geos.reshapeGeometry( reshapeLineString, &errorCode );
   if ( errorCode == 0 && geom )
   {
     detach( false );
-    delete d->geometry;
-    d->geometry = geom;
+    delete d->geometry();
+    d->geometry() = geom;
+    removeWkbGeos();
     return 0;
   }
   removeWkbGeos();
@@ -758,12 +996,12 @@ int QgsGeometry::reshapeGeometry( const QList<QgsPoint>& reshapeWithLine )
 
 int QgsGeometry::makeDifference( const QgsGeometry* other )
 {
-  if ( !d || !d->geometry || !other->d || !other->d->geometry )
+  if ( !d || !d->geometry() || !other->d || !other->d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
   QgsAbstractGeometryV2* diffGeom = geos.intersection( *( other->geometry() ) );
   if ( !diffGeom )
@@ -773,145 +1011,160 @@ int QgsGeometry::makeDifference( const QgsGeometry* other )
 
   detach( false );
 
-  delete d->geometry;
-  d->geometry = diffGeom;
+  delete d->geometry();
+  d->geometry() = diffGeom;
   removeWkbGeos();
   return 0;
 }
 
 QgsRectangle QgsGeometry::boundingBox() const
 {
-  if ( d && d->geometry )
+  if ( d && d->mLazy )
   {
-    return d->geometry->boundingBox();
+    return d->lazyBoundingBox();
+  }
+  if ( d && d->geometry() )
+  {
+    return d->geometry()->boundingBox();
   }
   return QgsRectangle();
 }
 
 bool QgsGeometry::intersects( const QgsRectangle& r ) const
 {
+  if ( !d || !d->hasGeometry() )
+  {
+    return false;
+  }
+
+  // most geometries tested against a filter rectangle are completely inside or outside of it
+  QgsRectangle bbox = boundingBox();
+  if ( !bbox.intersects( r ) )
+  {
+    return false;
+  }
+  if ( !bbox.isNull() && !r.isEmpty() && r.contains( bbox ) )
+  {
+    return true;
+  }
+
+  // the rectangle is used only once, so the test does not count towards preparing this geometry
   QgsGeometry* g = fromRect( r );
-  bool res = intersects( g );
+  bool res = geometryRelation( d, *g->d->geometry(), Intersects );
   delete g;
   return res;
 }
 
 bool QgsGeometry::intersects( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.intersects( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Intersects );
 }
 
 bool QgsGeometry::contains( const QgsPoint* p ) const
 {
-  if ( !d || !d->geometry || !p )
+  if ( !d || !d->geometry() || !p )
   {
     return false;
   }
 
   QgsPointV2 pt( p->x(), p->y() );
-  QgsGeos geos( d->geometry );
-  return geos.contains( pt );
+  PreparedGeometry* prepared = preparedGeometry( d );
+  ++prepared->relationTests;
+  return geometryRelation( d, prepared, pt, Contains );
 }
 
 bool QgsGeometry::contains( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.contains( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Contains );
 }
 
 bool QgsGeometry::disjoint( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.disjoint( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Disjoint );
 }
 
 bool QgsGeometry::equals( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.isEqual( *( geometry->d->geometry ) );
+  QgsGeos geos( d->geometry() );
+  return geos.isEqual( *( geometry->d->geometry() ) );
 }
 
 bool QgsGeometry::touches( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.touches( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Touches );
 }
 
 bool QgsGeometry::overlaps( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.overlaps( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Overlaps );
 }
 
 bool QgsGeometry::within( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.within( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Within );
 }
 
 bool QgsGeometry::crosses( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry || !geometry->d || !geometry->d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.crosses( *( geometry->d->geometry ) );
+  return geometryRelation( d, geometry->d, Crosses );
 }
 
 QString QgsGeometry::exportToWkt( const int &precision ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return QString();
   }
-  return d->geometry->asWkt( precision );
+  return d->geometry()->asWkt( precision );
 }
 
 QString QgsGeometry::exportToGeoJSON( const int &precision ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return QString();
   }
-  return d->geometry->asJSON( precision );
+  return d->geometry()->asJSON( precision );
 }
 
 QgsGeometry* QgsGeometry::convertToType( QGis::GeometryType destType, bool destMultipart ) const
@@ -934,7 +1187,7 @@ QgsGeometry* QgsGeometry::convertToType( QGis::GeometryType destType, bool destM
 
 bool QgsGeometry::convertToMultiType()
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
@@ -945,26 +1198,26 @@ bool QgsGeometry::convertToMultiType()
   }
 
   QgsGeometryCollectionV2* multiGeom = dynamic_cast<QgsGeometryCollectionV2*>
-                                       ( QgsGeometryFactory::geomFromWkbType( QgsWKBTypes::multiType( d->geometry->wkbType() ) ) );
+                                       ( QgsGeometryFactory::geomFromWkbType( QgsWKBTypes::multiType( d->geometry()->wkbType() ) ) );
   if ( !multiGeom )
   {
     return false;
   }
 
   detach( true );
-  multiGeom->addGeometry( d->geometry );
-  d->geometry = multiGeom;
+  multiGeom->addGeometry( d->geometry() );
+  d->geometry() = multiGeom;
   removeWkbGeos();
   return true;
 }
 
 QgsPoint QgsGeometry::asPoint() const
 {
-  if ( !d || !d->geometry || d->geometry->geometryType() != "Point" )
+  if ( !d || !d->geometry() || d->geometry()->geometryType() != "Point" )
   {
     return QgsPoint();
   }
-  QgsPointV2* pt = dynamic_cast<QgsPointV2*>( d->geometry );
+  QgsPointV2* pt = dynamic_cast<QgsPointV2*>( d->geometry() );
   if ( !pt )
   {
     return QgsPoint();
@@ -976,16 +1229,16 @@ QgsPoint QgsGeometry::asPoint() const
 QgsPolyline QgsGeometry::asPolyline() const
 {
   QgsPolyline polyLine;
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return polyLine;
   }
 
-  bool doSegmentation = ( d->geometry->geometryType() == "CompoundCurve" || d->geometry->geometryType() == "CircularString" );
+  bool doSegmentation = ( d->geometry()->geometryType() == "CompoundCurve" || d->geometry()->geometryType() == "CircularString" );
   QgsLineStringV2* line = 0;
   if ( doSegmentation )
   {
-    QgsCurveV2* curve = dynamic_cast<QgsCurveV2*>( d->geometry );
+    QgsCurveV2* curve = dynamic_cast<QgsCurveV2*>( d->geometry() );
     if ( !curve )
     {
       return polyLine;
@@ -994,7 +1247,7 @@ QgsPolyline QgsGeometry::asPolyline() const
   }
   else
   {
-    line = dynamic_cast<QgsLineStringV2*>( d->geometry );
+    line = dynamic_cast<QgsLineStringV2*>( d->geometry() );
     if ( !line )
     {
       return polyLine;
@@ -1020,12 +1273,12 @@ QgsPolyline QgsGeometry::asPolyline() const
 
 QgsPolygon QgsGeometry::asPolygon() const
 {
-  bool doSegmentation = ( d->geometry->geometryType() == "CurvePolygon" );
+  bool doSegmentation = ( d->geometry()->geometryType() == "CurvePolygon" );
 
   QgsPolygonV2* p = 0;
   if ( doSegmentation )
   {
-    QgsCurvePolygonV2* curvePoly = dynamic_cast<QgsCurvePolygonV2*>( d->geometry );
+    QgsCurvePolygonV2* curvePoly = dynamic_cast<QgsCurvePolygonV2*>( d->geometry() );
     if ( !curvePoly )
     {
       return QgsPolygon();
@@ -1034,7 +1287,7 @@ QgsPolygon QgsGeometry::asPolygon() const
   }
   else
   {
-    p = dynamic_cast<QgsPolygonV2*>( d->geometry );
+    p = dynamic_cast<QgsPolygonV2*>( d->geometry() );
   }
 
   if ( !p )
@@ -1054,12 +1307,12 @@ QgsPolygon QgsGeometry::asPolygon() const
 
 QgsMultiPoint QgsGeometry::asMultiPoint() const
 {
-  if ( !d || !d->geometry || d->geometry->geometryType() != "MultiPoint" )
+  if ( !d || !d->geometry() || d->geometry()->geometryType() != "MultiPoint" )
   {
     return QgsMultiPoint();
   }
 
-  const QgsMultiPointV2* mp = dynamic_cast<QgsMultiPointV2*>( d->geometry );
+  const QgsMultiPointV2* mp = dynamic_cast<QgsMultiPointV2*>( d->geometry() );
   if ( !mp )
   {
     return QgsMultiPoint();
@@ -1078,12 +1331,12 @@ QgsMultiPoint QgsGeometry::asMultiPoint() const
 
 QgsMultiPolyline QgsGeometry::asMultiPolyline() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return QgsMultiPolyline();
   }
 
-  QgsGeometryCollectionV2* geomCollection = dynamic_cast<QgsGeometryCollectionV2*>( d->geometry );
+  QgsGeometryCollectionV2* geomCollection = dynamic_cast<QgsGeometryCollectionV2*>( d->geometry() );
   if ( !geomCollection )
   {
     return QgsMultiPolyline();
@@ -1127,12 +1380,12 @@ QgsMultiPolyline QgsGeometry::asMultiPolyline() const
 
 QgsMultiPolygon QgsGeometry::asMultiPolygon() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return QgsMultiPolygon();
   }
 
-  QgsGeometryCollectionV2* geomCollection = dynamic_cast<QgsGeometryCollectionV2*>( d->geometry );
+  QgsGeometryCollectionV2* geomCollection = dynamic_cast<QgsGeometryCollectionV2*>( d->geometry() );
   if ( !geomCollection )
   {
     return QgsMultiPolygon();
@@ -1170,17 +1423,17 @@ QgsMultiPolygon QgsGeometry::asMultiPolygon() const
 
 double QgsGeometry::area() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return -1.0;
   }
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
 
 #if 0
   //debug: compare geos area with calculation in QGIS
   double geosArea = g.area();
   double qgisArea = 0;
-  QgsSurfaceV2* surface = dynamic_cast<QgsSurfaceV2*>( d->geometry );
+  QgsSurfaceV2* surface = dynamic_cast<QgsSurfaceV2*>( d->geometry() );
   if ( surface )
   {
     qgisArea = surface->area();
@@ -1192,33 +1445,33 @@ double QgsGeometry::area() const
 
 double QgsGeometry::length() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return -1.0;
   }
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   return g.length();
 }
 
 double QgsGeometry::distance( const QgsGeometry& geom ) const
 {
-  if ( !d || !d->geometry || !geom.d || !geom.d->geometry )
+  if ( !d || !d->geometry() || !geom.d || !geom.d->geometry() )
   {
     return -1.0;
   }
 
-  QgsGeos g( d->geometry );
-  return g.distance( *( geom.d->geometry ) );
+  QgsGeos g( d->geometry() );
+  return g.distance( *( geom.d->geometry() ) );
 }
 
 QgsGeometry* QgsGeometry::buffer( double distance, int segments ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   QgsAbstractGeometryV2* geom = g.buffer( distance, segments );
   if ( !geom )
   {
@@ -1229,12 +1482,12 @@ QgsGeometry* QgsGeometry::buffer( double distance, int segments ) const
 
 QgsGeometry* QgsGeometry::buffer( double distance, int segments, int endCapStyle, int joinStyle, double mitreLimit ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos g( d->geometry );
+  QgsGeos g( d->geometry() );
   QgsAbstractGeometryV2* geom = g.buffer( distance, segments, endCapStyle, joinStyle, mitreLimit );
   if ( !geom )
   {
@@ -1245,12 +1498,12 @@ QgsGeometry* QgsGeometry::buffer( double distance, int segments, int endCapStyle
 
 QgsGeometry* QgsGeometry::offsetCurve( double distance, int segments, int joinStyle, double mitreLimit ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsAbstractGeometryV2* offsetGeom = geos.offsetCurve( distance, segments, joinStyle, mitreLimit );
   if ( !offsetGeom )
   {
@@ -1261,12 +1514,12 @@ QgsGeometry* QgsGeometry::offsetCurve( double distance, int segments, int joinSt
 
 QgsGeometry* QgsGeometry::simplify( double tolerance ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsAbstractGeometryV2* simplifiedGeom = geos.simplify( tolerance );
   if ( !simplifiedGeom )
   {
@@ -1277,12 +1530,12 @@ QgsGeometry* QgsGeometry::simplify( double tolerance ) const
 
 QgsGeometry* QgsGeometry::centroid() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsPointV2 centroid;
   bool ok = geos.centroid( centroid );
   if ( !ok )
@@ -1294,12 +1547,12 @@ QgsGeometry* QgsGeometry::centroid() const
 
 QgsGeometry* QgsGeometry::pointOnSurface() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsPointV2 pt;
   bool ok = geos.pointOnSurface( pt );
   if ( !ok )
@@ -1311,11 +1564,11 @@ QgsGeometry* QgsGeometry::pointOnSurface() const
 
 QgsGeometry* QgsGeometry::convexHull() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsAbstractGeometryV2* cHull = geos.convexHull();
   if ( !cHull )
   {
@@ -1326,11 +1579,11 @@ QgsGeometry* QgsGeometry::convexHull() const
 
 QgsGeometry* QgsGeometry::interpolate( double distance ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 0;
   }
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   QgsAbstractGeometryV2* result = geos.interpolate( distance );
   if ( !result )
   {
@@ -1341,27 +1594,27 @@ QgsGeometry* QgsGeometry::interpolate( double distance ) const
 
 QgsGeometry* QgsGeometry::intersection( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry->d || !geometry->d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
-  QgsAbstractGeometryV2* resultGeom = geos.intersection( *( geometry->d->geometry ) );
+  QgsAbstractGeometryV2* resultGeom = geos.intersection( *( geometry->d->geometry() ) );
   return new QgsGeometry( resultGeom );
 }
 
 QgsGeometry* QgsGeometry::combine( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry->d || !geometry->d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
-  QgsAbstractGeometryV2* resultGeom = geos.combine( *( geometry->d->geometry ) );
+  QgsAbstractGeometryV2* resultGeom = geos.combine( *( geometry->d->geometry() ) );
   if ( !resultGeom )
   {
     return 0;
@@ -1371,14 +1624,14 @@ QgsGeometry* QgsGeometry::combine( const QgsGeometry* geometry ) const
 
 QgsGeometry* QgsGeometry::difference( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry->d || !geometry->d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
-  QgsAbstractGeometryV2* resultGeom = geos.difference( *( geometry->d->geometry ) );
+  QgsAbstractGeometryV2* resultGeom = geos.difference( *( geometry->d->geometry() ) );
   if ( !resultGeom )
   {
     return 0;
@@ -1388,14 +1641,14 @@ QgsGeometry* QgsGeometry::difference( const QgsGeometry* geometry ) const
 
 QgsGeometry* QgsGeometry::symDifference( const QgsGeometry* geometry ) const
 {
-  if ( !d || !d->geometry || !geometry->d || !geometry->d->geometry )
+  if ( !d || !d->geometry() || !geometry->d || !geometry->d->geometry() )
   {
     return 0;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
 
-  QgsAbstractGeometryV2* resultGeom = geos.symDifference( *( geometry->d->geometry ) );
+  QgsAbstractGeometryV2* resultGeom = geos.symDifference( *( geometry->d->geometry() ) );
   if ( !resultGeom )
   {
     return 0;
@@ -1406,12 +1659,12 @@ QgsGeometry* QgsGeometry::symDifference( const QgsGeometry* geometry ) const
 QList<QgsGeometry*> QgsGeometry::asGeometryCollection() const
 {
   QList<QgsGeometry*> geometryList;
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return geometryList;
   }
 
-  QgsGeometryCollectionV2* gc = dynamic_cast<QgsGeometryCollectionV2*>( d->geometry );
+  QgsGeometryCollectionV2* gc = dynamic_cast<QgsGeometryCollectionV2*>( d->geometry() );
   if ( gc )
   {
     int numGeom = gc->numGeometries();
@@ -1422,7 +1675,7 @@ QList<QgsGeometry*> QgsGeometry::asGeometryCollection() const
   }
   else //a singlepart geometry
   {
-    geometryList.append( new QgsGeometry( d->geometry->clone() ) );
+    geometryList.append( new QgsGeometry( d->geometry()->clone() ) );
   }
 
   return geometryList;
@@ -1465,19 +1718,20 @@ QPolygonF QgsGeometry::asQPolygonF() const
 
 bool QgsGeometry::deleteRing( int ringNum, int partNum )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
   detach( true );
-
-  return QgsGeometryEditUtils::deleteRing( d->geometry, ringNum, partNum );
+  bool ok = QgsGeometryEditUtils::deleteRing( d->geometry(), ringNum, partNum );
+  removeWkbGeos();
+  return ok;
 }
 
 bool QgsGeometry::deletePart( int partNum )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
@@ -1489,23 +1743,23 @@ bool QgsGeometry::deletePart( int partNum )
   }
 
   detach( true );
-  bool ok = QgsGeometryEditUtils::deletePart( d->geometry, partNum );
+  bool ok = QgsGeometryEditUtils::deletePart( d->geometry(), partNum );
   removeWkbGeos();
   return ok;
 }
 
 int QgsGeometry::avoidIntersections( QMap<QgsVectorLayer*, QSet< QgsFeatureId > > ignoreFeatures )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 1;
   }
 
-  QgsAbstractGeometryV2* diffGeom = QgsGeometryEditUtils::avoidIntersections( *( d->geometry ), ignoreFeatures );
+  QgsAbstractGeometryV2* diffGeom = QgsGeometryEditUtils::avoidIntersections( *( d->geometry() ), ignoreFeatures );
   if ( diffGeom )
   {
     detach( false );
-    d->geometry = diffGeom;
+    d->geometry() = diffGeom;
     removeWkbGeos();
   }
   return 0;
@@ -1518,34 +1772,34 @@ void QgsGeometry::validateGeometry( QList<Error> &errors )
 
 bool QgsGeometry::isGeosValid() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   return geos.isValid();
 }
 
 bool QgsGeometry::isGeosEqual( const QgsGeometry& g ) const
 {
-  if ( !d || !d->geometry || !g.d || !g.d->geometry )
+  if ( !d || !d->geometry() || !g.d || !g.d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
-  return geos.isEqual( *( g.d->geometry ) );
+  QgsGeos geos( d->geometry() );
+  return geos.isEqual( *( g.d->geometry() ) );
 }
 
 bool QgsGeometry::isGeosEmpty() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
-  QgsGeos geos( d->geometry );
+  QgsGeos geos( d->geometry() );
   return geos.isEmpty();
 }
 
@@ -1569,70 +1823,71 @@ QgsGeometry *QgsGeometry::unaryUnion( const QList<QgsGeometry*> &geometryList )
 
 void QgsGeometry::convertToStraightSegment()
 {
-  if ( !d || !d->geometry || !requiresConversionToStraightSegments() )
+  if ( !d || !d->geometry() || !requiresConversionToStraightSegments() )
   {
     return;
   }
 
-  QgsAbstractGeometryV2* straightGeom = d->geometry->segmentize();
+  QgsAbstractGeometryV2* straightGeom = d->geometry()->segmentize();
   detach( false );
 
-  d->geometry = straightGeom;
+  d->geometry() = straightGeom;
   removeWkbGeos();
 }
 
 bool QgsGeometry::requiresConversionToStraightSegments() const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
-  return d->geometry->hasCurvedSegments();
+  return d->geometry()->hasCurvedSegments();
 }
 
 int QgsGeometry::transform( const QgsCoordinateTransform& ct )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 1;
   }
 
   detach();
-  d->geometry->transform( ct );
+  d->geometry()->transform( ct );
   removeWkbGeos();
   return 0;
 }
 
 int QgsGeometry::transform( const QTransform& ct )
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return 1;
   }
 
   detach();
-  d->geometry->transform( ct );
+  d->geometry()->transform( ct );
   removeWkbGeos();
   return 0;
 }
 
 void QgsGeometry::mapToPixel( const QgsMapToPixel& mtp )
 {
-  if ( d && d->geometry )
+  if ( d && d->geometry() )
   {
     detach();
-    d->geometry->transform( mtp.transform() );
+    d->geometry()->transform( mtp.transform() );
+    removeWkbGeos();
   }
 }
 
 #if 0
 void QgsGeometry::clip( const QgsRectangle& rect )
 {
-  if ( d && d->geometry )
+  if ( d && d->geometry() )
   {
     detach();
-    d->geometry->clip( rect );
+    d->geometry()->clip( rect );
     removeWkbGeos();
   }
 }
@@ -1640,21 +1895,21 @@ void QgsGeometry::clip( const QgsRectangle& rect )
 
 void QgsGeometry::draw( QPainter& p ) const
 {
-  if ( d && d->geometry )
+  if ( d && d->geometry() )
   {
-    d->geometry->draw( p );
+    d->geometry()->draw( p );
   }
 }
 
 bool QgsGeometry::vertexIdFromVertexNr( int nr, QgsVertexId& id ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
   QList< QList< QList< QgsPointV2 > > > coords;
-  d->geometry->coordinateSequence( coords );
+  d->geometry()->coordinateSequence( coords );
 
   int vertexCount = 0;
   for ( int part = 0; part < coords.size(); ++part )
@@ -1681,13 +1936,13 @@ bool QgsGeometry::vertexIdFromVertexNr( int nr, QgsVertexId& id ) const
 
 int QgsGeometry::vertexNrFromVertexId( const QgsVertexId& id ) const
 {
-  if ( !d || !d->geometry )
+  if ( !d || !d->geometry() )
   {
     return false;
   }
 
   QList< QList< QList< QgsPointV2 > > > coords;
-  d->geometry->coordinateSequence( coords );
+  d->geometry()->coordinateSequence( coords );
 
   int vertexCount = 0;
   for ( int part = 0; part < coords.size(); ++part )
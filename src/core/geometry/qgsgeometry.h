@@ -96,7 +96,8 @@ class CORE_EXPORT QgsGeometry
     //! Destructor
     ~QgsGeometry();
 
-    /** Returns the underlying geometry store.
+    /** Returns the underlying geometry store. Geometries set from WKB are parsed into
+     * the geometry store on the first call.
      * @note added in QGIS 2.10
      * @see setGeometry
      */
@@ -140,7 +141,8 @@ class CORE_EXPORT QgsGeometry
     void fromGeos( GEOSGeometry* geos );
     /**
       Set the geometry, feeding in the buffer containing OGC Well-Known Binary and the buffer's length.
-      This class will take ownership of the buffer.
+      This class will take ownership of the buffer. Linear geometries are kept as WKB until an
+      operation needs the geometry store; their type, bounding box and WKB are read from the buffer.
      */
     void fromWkb( unsigned char * wkb, size_t length );
 
@@ -643,7 +645,8 @@ class CORE_EXPORT QgsGeometry
      */
     int vertexNrFromVertexId( const QgsVertexId& i ) const;
 
-    /** Return GEOS context handle
+    /** Return GEOS context handle of the calling thread. The handle must not be passed to
+     * other threads, GEOS geometries may be.
      * @note added in 2.6
      * @note not available in Python
      */
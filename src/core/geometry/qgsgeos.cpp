@@ -28,6 +28,7 @@ email                : marco.hugentobler at sourcepole dot com
 #include <limits>
 #include <cstdio>
 #include <QtCore/qmath.h>
+#include <QThreadStorage>
 
 #define DEFAULT_QUADRANT_SEGMENTS 8
 
@@ -95,18 +96,29 @@ class GEOSInit
     }
 };
 
-static GEOSInit geosinit;
+// A GEOS context handle must not be used by several threads at the same time, so every
+// thread gets its own. Geometries do not belong to a context and may be passed between threads.
+static QThreadStorage<GEOSInit*> sGeosInit;
+
+static inline GEOSContextHandle_t geosContext()
+{
+  if ( !sGeosInit.hasLocalData() )
+  {
+    sGeosInit.setLocalData( new GEOSInit() );
+  }
+  return sGeosInit.localData()->ctxt;
+}
 
 class GEOSGeomScopedPtr
 {
   public:
     explicit GEOSGeomScopedPtr( GEOSGeometry* geom = 0 ) : mGeom( geom ) {}
-    ~GEOSGeomScopedPtr() { GEOSGeom_destroy_r( geosinit.ctxt, mGeom ); }
+    ~GEOSGeomScopedPtr() { GEOSGeom_destroy_r( geosContext(), mGeom ); }
     GEOSGeometry* get() const { return mGeom; }
     operator bool() const { return mGeom != 0; }
     void reset( GEOSGeometry* geom )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, mGeom );
+      GEOSGeom_destroy_r( geosContext(), mGeom );
       mGeom = geom;
     }
 
@@ -129,8 +141,8 @@ QgsGeos::QgsGeos( const QgsAbstractGeometryV2* geometry, int precision ) : QgsGe
 QgsGeos::~QgsGeos()
 {
 #if defined(HAVE_GEOS_CPP) || defined(HAVE_GEOS_CAPI_PRECISION_MODEL)
-  GEOSGeom_destroy_r( geosinit.ctxt, mGeos );
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, mGeosPrepared );
+  GEOSGeom_destroy_r( geosContext(), mGeos );
+  GEOSPreparedGeom_destroy_r( geosContext(), mGeosPrepared );
   GEOSGeometryPrecisionReducer_destroy( mPrecisionReducer );
   GEOSPrecisionModel_destroy( mPrecisionModel );
 #endif
@@ -141,7 +153,7 @@ inline GEOSGeometry* QgsGeos::getReducedGeometry( GEOSGeometry* geom ) const
 #if defined(HAVE_GEOS_CPP) || defined(HAVE_GEOS_CAPI_PRECISION_MODEL)
   //reduce precision
   GEOSGeometry* reduced = GEOSGeometryPrecisionReducer_reduce( mPrecisionReducer, geom );
-  GEOSGeom_destroy_r( geosinit.ctxt, geom );
+  GEOSGeom_destroy_r( geosContext(), geom );
   return reduced;
 #else
   return geom;
@@ -150,20 +162,20 @@ inline GEOSGeometry* QgsGeos::getReducedGeometry( GEOSGeometry* geom ) const
 
 void QgsGeos::geometryChanged()
 {
-  GEOSGeom_destroy_r( geosinit.ctxt, mGeos );
+  GEOSGeom_destroy_r( geosContext(), mGeos );
   mGeos = 0;
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, mGeosPrepared );
+  GEOSPreparedGeom_destroy_r( geosContext(), mGeosPrepared );
   mGeosPrepared = 0;
   cacheGeos();
 }
 
 void QgsGeos::prepareGeometry()
 {
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, mGeosPrepared );
+  GEOSPreparedGeom_destroy_r( geosContext(), mGeosPrepared );
   mGeosPrepared = 0;
   if ( mGeos )
   {
-    mGeosPrepared = GEOSPrepare_r( geosinit.ctxt, mGeos );
+    mGeosPrepared = GEOSPrepare_r( geosContext(), mGeos );
   }
 }
 
@@ -179,7 +191,7 @@ void QgsGeos::cacheGeos() const
   if ( g )
   {
     mGeos = GEOSGeometryPrecisionReducer_reduce( mPrecisionReducer, g );
-    GEOSGeom_destroy_r( geosinit.ctxt, g );
+    GEOSGeom_destroy_r( geosContext(), g );
   }
 #else
   mGeos = g;
@@ -215,13 +227,13 @@ QgsAbstractGeometryV2* QgsGeos::combine( const QList< const QgsAbstractGeometryV
   try
   {
     GEOSGeometry* geomCollection =  createGeosCollection( GEOS_GEOMETRYCOLLECTION, geosGeometries );
-    geomUnion = GEOSUnaryUnion_r( geosinit.ctxt, geomCollection );
-    GEOSGeom_destroy_r( geosinit.ctxt, geomCollection );
+    geomUnion = GEOSUnaryUnion_r( geosContext(), geomCollection );
+    GEOSGeom_destroy_r( geosContext(), geomCollection );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 )
 
   QgsAbstractGeometryV2* result = fromGeos( geomUnion );
-  GEOSGeom_destroy_r( geosinit.ctxt, geomUnion );
+  GEOSGeom_destroy_r( geosContext(), geomUnion );
   return result;
 }
 
@@ -246,7 +258,7 @@ double QgsGeos::distance( const QgsAbstractGeometryV2& geom, QString* errorMsg )
 
   try
   {
-    GEOSDistance_r( geosinit.ctxt, mGeos, otherGeosGeom, &distance );
+    GEOSDistance_r( geosContext(), mGeos, otherGeosGeom, &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -298,7 +310,7 @@ double QgsGeos::area( QString* errorMsg ) const
 
   try
   {
-    if ( GEOSArea_r( geosinit.ctxt, mGeos, &area ) != 1 )
+    if ( GEOSArea_r( geosContext(), mGeos, &area ) != 1 )
       return -1.0;
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 );
@@ -314,7 +326,7 @@ double QgsGeos::length( QString* errorMsg ) const
   }
   try
   {
-    if ( GEOSLength_r( geosinit.ctxt, mGeos, &length ) != 1 )
+    if ( GEOSLength_r( geosContext(), mGeos, &length ) != 1 )
       return -1.0;
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
@@ -340,7 +352,7 @@ int QgsGeos::splitGeometry( const QgsLineStringV2& splitLine,
     return 1; //cannot split points
   }
 
-  if ( !GEOSisValid_r( geosinit.ctxt, mGeos ) )
+  if ( !GEOSisValid_r( geosContext(), mGeos ) )
     return 7;
 
   //make sure splitLine is valid
@@ -367,9 +379,9 @@ int QgsGeos::splitGeometry( const QgsLineStringV2& splitLine,
       return 1;
     }
 
-    if ( !GEOSisValid_r( geosinit.ctxt, splitLineGeos ) || !GEOSisSimple_r( geosinit.ctxt, splitLineGeos ) )
+    if ( !GEOSisValid_r( geosContext(), splitLineGeos ) || !GEOSisSimple_r( geosContext(), splitLineGeos ) )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, splitLineGeos );
+      GEOSGeom_destroy_r( geosContext(), splitLineGeos );
       return 1;
     }
 
@@ -384,12 +396,12 @@ int QgsGeos::splitGeometry( const QgsLineStringV2& splitLine,
     if ( mGeometry->dimension() == 1 )
     {
       returnCode = splitLinearGeometry( splitLineGeos, newGeometries );
-      GEOSGeom_destroy_r( geosinit.ctxt, splitLineGeos );
+      GEOSGeom_destroy_r( geosContext(), splitLineGeos );
     }
     else if ( mGeometry->dimension() == 2 )
     {
       returnCode = splitPolygonGeometry( splitLineGeos, newGeometries );
-      GEOSGeom_destroy_r( geosinit.ctxt, splitLineGeos );
+      GEOSGeom_destroy_r( geosContext(), splitLineGeos );
     }
     else
     {
@@ -417,18 +429,18 @@ int QgsGeos::topologicalTestPointsSplit( const GEOSGeometry* splitLine, QList<Qg
   try
   {
     testPoints.clear();
-    GEOSGeometry* intersectionGeom = GEOSIntersection_r( geosinit.ctxt, mGeos, splitLine );
+    GEOSGeometry* intersectionGeom = GEOSIntersection_r( geosContext(), mGeos, splitLine );
     if ( !intersectionGeom )
       return 1;
 
     bool simple = false;
     int nIntersectGeoms = 1;
-    if ( GEOSGeomTypeId_r( geosinit.ctxt, intersectionGeom ) == GEOS_LINESTRING
-         || GEOSGeomTypeId_r( geosinit.ctxt, intersectionGeom ) == GEOS_POINT )
+    if ( GEOSGeomTypeId_r( geosContext(), intersectionGeom ) == GEOS_LINESTRING
+         || GEOSGeomTypeId_r( geosContext(), intersectionGeom ) == GEOS_POINT )
       simple = true;
 
     if ( !simple )
-      nIntersectGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, intersectionGeom );
+      nIntersectGeoms = GEOSGetNumGeometries_r( geosContext(), intersectionGeom );
 
     for ( int i = 0; i < nIntersectGeoms; ++i )
     {
@@ -436,18 +448,18 @@ int QgsGeos::topologicalTestPointsSplit( const GEOSGeometry* splitLine, QList<Qg
       if ( simple )
         currentIntersectGeom = intersectionGeom;
       else
-        currentIntersectGeom = GEOSGetGeometryN_r( geosinit.ctxt, intersectionGeom, i );
+        currentIntersectGeom = GEOSGetGeometryN_r( geosContext(), intersectionGeom, i );
 
-      const GEOSCoordSequence* lineSequence = GEOSGeom_getCoordSeq_r( geosinit.ctxt, currentIntersectGeom );
+      const GEOSCoordSequence* lineSequence = GEOSGeom_getCoordSeq_r( geosContext(), currentIntersectGeom );
       unsigned int sequenceSize = 0;
       double x, y;
-      if ( GEOSCoordSeq_getSize_r( geosinit.ctxt, lineSequence, &sequenceSize ) != 0 )
+      if ( GEOSCoordSeq_getSize_r( geosContext(), lineSequence, &sequenceSize ) != 0 )
       {
         for ( unsigned int i = 0; i < sequenceSize; ++i )
         {
-          if ( GEOSCoordSeq_getX_r( geosinit.ctxt, lineSequence, i, &x ) != 0 )
+          if ( GEOSCoordSeq_getX_r( geosContext(), lineSequence, i, &x ) != 0 )
           {
-            if ( GEOSCoordSeq_getY_r( geosinit.ctxt, lineSequence, i, &y ) != 0 )
+            if ( GEOSCoordSeq_getY_r( geosContext(), lineSequence, i, &y ) != 0 )
             {
               testPoints.push_back( QgsPointV2( x, y ) );
             }
@@ -455,7 +467,7 @@ int QgsGeos::topologicalTestPointsSplit( const GEOSGeometry* splitLine, QList<Qg
         }
       }
     }
-    GEOSGeom_destroy_r( geosinit.ctxt, intersectionGeom );
+    GEOSGeom_destroy_r( geosContext(), intersectionGeom );
   }
   CATCH_GEOS_WITH_ERRMSG( 1 )
 
@@ -464,7 +476,7 @@ int QgsGeos::topologicalTestPointsSplit( const GEOSGeometry* splitLine, QList<Qg
 
 GEOSGeometry* QgsGeos::linePointDifference( GEOSGeometry* GEOSsplitPoint ) const
 {
-  int type = GEOSGeomTypeId_r( geosinit.ctxt, mGeos );
+  int type = GEOSGeomTypeId_r( geosContext(), mGeos );
 
   QgsMultiCurveV2* multiCurve = 0;
   if ( type == GEOS_MULTILINESTRING )
@@ -536,15 +548,15 @@ int QgsGeos::splitLinearGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeom
     return 5;
 
   //first test if linestring intersects geometry. If not, return straight away
-  if ( !GEOSIntersects_r( geosinit.ctxt, splitLine, mGeos ) )
+  if ( !GEOSIntersects_r( geosContext(), splitLine, mGeos ) )
     return 1;
 
   //check that split line has no linear intersection
-  int linearIntersect = GEOSRelatePattern_r( geosinit.ctxt, mGeos, splitLine, "1********" );
+  int linearIntersect = GEOSRelatePattern_r( geosContext(), mGeos, splitLine, "1********" );
   if ( linearIntersect > 0 )
     return 3;
 
-  int splitGeomType = GEOSGeomTypeId_r( geosinit.ctxt, splitLine );
+  int splitGeomType = GEOSGeomTypeId_r( geosContext(), splitLine );
 
   GEOSGeometry* splitGeom;
   if ( splitGeomType == GEOS_POINT )
@@ -553,21 +565,21 @@ int QgsGeos::splitLinearGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeom
   }
   else
   {
-    splitGeom = GEOSDifference_r( geosinit.ctxt, mGeos, splitLine );
+    splitGeom = GEOSDifference_r( geosContext(), mGeos, splitLine );
   }
   QVector<GEOSGeometry*> lineGeoms;
 
-  int splitType = GEOSGeomTypeId_r( geosinit.ctxt, splitGeom );
+  int splitType = GEOSGeomTypeId_r( geosContext(), splitGeom );
   if ( splitType == GEOS_MULTILINESTRING )
   {
-    int nGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, splitGeom );
+    int nGeoms = GEOSGetNumGeometries_r( geosContext(), splitGeom );
     for ( int i = 0; i < nGeoms; ++i )
-      lineGeoms << GEOSGeom_clone_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, splitGeom, i ) );
+      lineGeoms << GEOSGeom_clone_r( geosContext(), GEOSGetGeometryN_r( geosContext(), splitGeom, i ) );
 
   }
   else
   {
-    lineGeoms << GEOSGeom_clone_r( geosinit.ctxt, splitGeom );
+    lineGeoms << GEOSGeom_clone_r( geosContext(), splitGeom );
   }
 
   mergeGeometriesMultiTypeSplit( lineGeoms );
@@ -577,7 +589,7 @@ int QgsGeos::splitLinearGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeom
     newGeometries << fromGeos( lineGeoms[i] );
   }
 
-  GEOSGeom_destroy_r( geosinit.ctxt, splitGeom );
+  GEOSGeom_destroy_r( geosContext(), splitGeom );
   return 0;
 }
 
@@ -590,7 +602,7 @@ int QgsGeos::splitPolygonGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeo
     return 5;
 
   //first test if linestring intersects geometry. If not, return straight away
-  if ( !GEOSIntersects_r( geosinit.ctxt, splitLine, mGeos ) )
+  if ( !GEOSIntersects_r( geosContext(), splitLine, mGeos ) )
     return 1;
 
   //first union all the polygon rings together (to get them noded, see JTS developer guide)
@@ -598,18 +610,18 @@ int QgsGeos::splitPolygonGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeo
   if ( !nodedGeometry )
     return 2; //an error occured during noding
 
-  GEOSGeometry *polygons = GEOSPolygonize_r( geosinit.ctxt, &nodedGeometry, 1 );
+  GEOSGeometry *polygons = GEOSPolygonize_r( geosContext(), &nodedGeometry, 1 );
   if ( !polygons || numberOfGeometries( polygons ) == 0 )
   {
     if ( polygons )
-      GEOSGeom_destroy_r( geosinit.ctxt, polygons );
+      GEOSGeom_destroy_r( geosContext(), polygons );
 
-    GEOSGeom_destroy_r( geosinit.ctxt, nodedGeometry );
+    GEOSGeom_destroy_r( geosContext(), nodedGeometry );
 
     return 4;
   }
 
-  GEOSGeom_destroy_r( geosinit.ctxt, nodedGeometry );
+  GEOSGeom_destroy_r( geosContext(), nodedGeometry );
 
   //test every polygon if contained in original geometry
   //include in result if yes
@@ -621,8 +633,8 @@ int QgsGeos::splitPolygonGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeo
 
   for ( int i = 0; i < numberOfGeometries( polygons ); i++ )
   {
-    const GEOSGeometry *polygon = GEOSGetGeometryN_r( geosinit.ctxt, polygons, i );
-    intersectGeometry = GEOSIntersection_r( geosinit.ctxt, mGeos, polygon );
+    const GEOSGeometry *polygon = GEOSGetGeometryN_r( geosContext(), polygons, i );
+    intersectGeometry = GEOSIntersection_r( geosContext(), mGeos, polygon );
     if ( !intersectGeometry )
     {
       QgsDebugMsg( "intersectGeometry is NULL" );
@@ -630,16 +642,16 @@ int QgsGeos::splitPolygonGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeo
     }
 
     double intersectionArea;
-    GEOSArea_r( geosinit.ctxt, intersectGeometry, &intersectionArea );
+    GEOSArea_r( geosContext(), intersectGeometry, &intersectionArea );
 
     double polygonArea;
-    GEOSArea_r( geosinit.ctxt, polygon, &polygonArea );
+    GEOSArea_r( geosContext(), polygon, &polygonArea );
 
     const double areaRatio = intersectionArea / polygonArea;
     if ( areaRatio > 0.99 && areaRatio < 1.01 )
-      testedGeometries << GEOSGeom_clone_r( geosinit.ctxt, polygon );
+      testedGeometries << GEOSGeom_clone_r( geosContext(), polygon );
 
-    GEOSGeom_destroy_r( geosinit.ctxt, intersectGeometry );
+    GEOSGeom_destroy_r( geosContext(), intersectGeometry );
   }
 
   bool splitDone = true;
@@ -656,19 +668,19 @@ int QgsGeos::splitPolygonGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeo
   {
     for ( int i = 0; i < testedGeometries.size(); ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+      GEOSGeom_destroy_r( geosContext(), testedGeometries[i] );
     }
     return 1;
   }
 
   int i;
-  for ( i = 0; i < testedGeometries.size() && GEOSisValid_r( geosinit.ctxt, testedGeometries[i] ); ++i )
+  for ( i = 0; i < testedGeometries.size() && GEOSisValid_r( geosContext(), testedGeometries[i] ); ++i )
     ;
 
   if ( i < testedGeometries.size() )
   {
     for ( i = 0; i < testedGeometries.size(); ++i )
-      GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+      GEOSGeom_destroy_r( geosContext(), testedGeometries[i] );
 
     return 3;
   }
@@ -676,7 +688,7 @@ int QgsGeos::splitPolygonGeometry( GEOSGeometry* splitLine, QList<QgsAbstractGeo
   for ( i = 0; i < testedGeometries.size(); ++i )
     newGeometries << fromGeos( testedGeometries[i] );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, polygons );
+  GEOSGeom_destroy_r( geosContext(), polygons );
   return 0;
 }
 
@@ -686,16 +698,16 @@ GEOSGeometry* QgsGeos::nodeGeometries( const GEOSGeometry *splitLine, const GEOS
     return 0;
 
   GEOSGeometry *geometryBoundary = 0;
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, geom ) == GEOS_POLYGON || GEOSGeomTypeId_r( geosinit.ctxt, geom ) == GEOS_MULTIPOLYGON )
-    geometryBoundary = GEOSBoundary_r( geosinit.ctxt, geom );
+  if ( GEOSGeomTypeId_r( geosContext(), geom ) == GEOS_POLYGON || GEOSGeomTypeId_r( geosContext(), geom ) == GEOS_MULTIPOLYGON )
+    geometryBoundary = GEOSBoundary_r( geosContext(), geom );
   else
-    geometryBoundary = GEOSGeom_clone_r( geosinit.ctxt, geom );
+    geometryBoundary = GEOSGeom_clone_r( geosContext(), geom );
 
-  GEOSGeometry *splitLineClone = GEOSGeom_clone_r( geosinit.ctxt, splitLine );
-  GEOSGeometry *unionGeometry = GEOSUnion_r( geosinit.ctxt, splitLineClone, geometryBoundary );
-  GEOSGeom_destroy_r( geosinit.ctxt, splitLineClone );
+  GEOSGeometry *splitLineClone = GEOSGeom_clone_r( geosContext(), splitLine );
+  GEOSGeometry *unionGeometry = GEOSUnion_r( geosContext(), splitLineClone, geometryBoundary );
+  GEOSGeom_destroy_r( geosContext(), splitLineClone );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, geometryBoundary );
+  GEOSGeom_destroy_r( geosContext(), geometryBoundary );
   return unionGeometry;
 }
 
@@ -705,7 +717,7 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry*>& splitResult
     return 1;
 
   //convert mGeos to geometry collection
-  int type = GEOSGeomTypeId_r( geosinit.ctxt, mGeos );
+  int type = GEOSGeomTypeId_r( geosContext(), mGeos );
   if ( type != GEOS_GEOMETRYCOLLECTION &&
        type != GEOS_MULTILINESTRING &&
        type != GEOS_MULTIPOLYGON &&
@@ -722,9 +734,9 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry*>& splitResult
   {
     //is this geometry a part of the original multitype?
     bool isPart = false;
-    for ( int j = 0; j < GEOSGetNumGeometries_r( geosinit.ctxt, mGeos ); j++ )
+    for ( int j = 0; j < GEOSGetNumGeometries_r( geosContext(), mGeos ); j++ )
     {
-      if ( GEOSEquals_r( geosinit.ctxt, copyList[i], GEOSGetGeometryN_r( geosinit.ctxt, mGeos, j ) ) )
+      if ( GEOSEquals_r( geosContext(), copyList[i], GEOSGetGeometryN_r( geosContext(), mGeos, j ) ) )
       {
         isPart = true;
         break;
@@ -745,7 +757,7 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry*>& splitResult
       else if ( type == GEOS_MULTIPOLYGON )
         splitResult << createGeosCollection( GEOS_MULTIPOLYGON, geomVector );
       else
-        GEOSGeom_destroy_r( geosinit.ctxt, copyList[i] );
+        GEOSGeom_destroy_r( geosContext(), copyList[i] );
     }
   }
 
@@ -790,7 +802,7 @@ GEOSGeometry* QgsGeos::createGeosCollection( int typeId, const QVector<GEOSGeome
 
   try
   {
-    geom = GEOSGeom_createCollection_r( geosinit.ctxt, typeId, geomarr, nNotNullGeoms );
+    geom = GEOSGeom_createCollection_r( geosContext(), typeId, geomarr, nNotNullGeoms );
   }
   catch ( GEOSException &e )
   {
@@ -809,16 +821,16 @@ QgsAbstractGeometryV2* QgsGeos::fromGeos( const GEOSGeometry* geos )
     return 0;
   }
 
-  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit.ctxt, geos );
-  int nDims = GEOSGeom_getDimensions_r( geosinit.ctxt, geos );
+  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosContext(), geos );
+  int nDims = GEOSGeom_getDimensions_r( geosContext(), geos );
   bool hasZ = ( nCoordDims == 3 );
   bool hasM = (( nDims - nCoordDims ) == 1 );
 
-  switch ( GEOSGeomTypeId_r( geosinit.ctxt, geos ) )
+  switch ( GEOSGeomTypeId_r( geosContext(), geos ) )
   {
     case GEOS_POINT:                 // a point
     {
-      const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, geos );
+      const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r( geosContext(), geos );
       return ( coordSeqPoint( cs, 0, hasZ, hasM ).clone() );
     }
     case GEOS_LINESTRING:
@@ -832,10 +844,10 @@ QgsAbstractGeometryV2* QgsGeos::fromGeos( const GEOSGeometry* geos )
     case GEOS_MULTIPOINT:
     {
       QgsMultiPointV2* multiPoint = new QgsMultiPointV2();
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosContext(), geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r( geosContext(), GEOSGetGeometryN_r( geosContext(), geos, i ) );
         if ( cs )
         {
           multiPoint->addGeometry( coordSeqPoint( cs, 0, hasZ, hasM ).clone() );
@@ -846,10 +858,10 @@ QgsAbstractGeometryV2* QgsGeos::fromGeos( const GEOSGeometry* geos )
     case GEOS_MULTILINESTRING:
     {
       QgsMultiLineStringV2* multiLineString = new QgsMultiLineStringV2();
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosContext(), geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        QgsLineStringV2* line = sequenceToLinestring( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ), hasZ, hasM );
+        QgsLineStringV2* line = sequenceToLinestring( GEOSGetGeometryN_r( geosContext(), geos, i ), hasZ, hasM );
         if ( line )
         {
           multiLineString->addGeometry( line );
@@ -861,10 +873,10 @@ QgsAbstractGeometryV2* QgsGeos::fromGeos( const GEOSGeometry* geos )
     {
       QgsMultiPolygonV2* multiPolygon = new QgsMultiPolygonV2();
 
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosContext(), geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        QgsPolygonV2* poly = fromGeosPolygon( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        QgsPolygonV2* poly = fromGeosPolygon( GEOSGetGeometryN_r( geosContext(), geos, i ) );
         if ( poly )
         {
           multiPolygon->addGeometry( poly );
@@ -875,10 +887,10 @@ QgsAbstractGeometryV2* QgsGeos::fromGeos( const GEOSGeometry* geos )
     case GEOS_GEOMETRYCOLLECTION:
     {
       QgsGeometryCollectionV2* geomCollection = new QgsGeometryCollectionV2();
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosContext(), geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        QgsAbstractGeometryV2* geom = fromGeos( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        QgsAbstractGeometryV2* geom = fromGeos( GEOSGetGeometryN_r( geosContext(), geos, i ) );
         if ( geom )
         {
           geomCollection->addGeometry( geom );
@@ -892,28 +904,28 @@ QgsAbstractGeometryV2* QgsGeos::fromGeos( const GEOSGeometry* geos )
 
 QgsPolygonV2* QgsGeos::fromGeosPolygon( const GEOSGeometry* geos )
 {
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, geos ) != GEOS_POLYGON )
+  if ( GEOSGeomTypeId_r( geosContext(), geos ) != GEOS_POLYGON )
   {
     return 0;
   }
 
-  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit.ctxt, geos );
-  int nDims = GEOSGeom_getDimensions_r( geosinit.ctxt, geos );
+  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosContext(), geos );
+  int nDims = GEOSGeom_getDimensions_r( geosContext(), geos );
   bool hasZ = ( nCoordDims == 3 );
   bool hasM = (( nDims - nCoordDims ) == 1 );
 
   QgsPolygonV2* polygon = new QgsPolygonV2();
 
-  const GEOSGeometry* ring = GEOSGetExteriorRing_r( geosinit.ctxt, geos );
+  const GEOSGeometry* ring = GEOSGetExteriorRing_r( geosContext(), geos );
   if ( ring )
   {
     polygon->setExteriorRing( sequenceToLinestring( ring, hasZ, hasM ) );
   }
 
   QList<QgsCurveV2*> interiorRings;
-  for ( int i = 0; i < GEOSGetNumInteriorRings_r( geosinit.ctxt, geos ); ++i )
+  for ( int i = 0; i < GEOSGetNumInteriorRings_r( geosContext(), geos ); ++i )
   {
-    ring = GEOSGetInteriorRingN_r( geosinit.ctxt, geos, i );
+    ring = GEOSGetInteriorRingN_r( geosContext(), geos, i );
     if ( ring )
     {
       interiorRings.push_back( sequenceToLinestring( ring, hasZ, hasM ) );
@@ -927,9 +939,9 @@ QgsPolygonV2* QgsGeos::fromGeosPolygon( const GEOSGeometry* geos )
 QgsLineStringV2* QgsGeos::sequenceToLinestring( const GEOSGeometry* geos, bool hasZ, bool hasM )
 {
   QList<QgsPointV2> pts;
-  const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, geos );
+  const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r( geosContext(), geos );
   unsigned int nPoints;
-  GEOSCoordSeq_getSize_r( geosinit.ctxt, cs, &nPoints );
+  GEOSCoordSeq_getSize_r( geosContext(), cs, &nPoints );
   for ( unsigned int i = 0; i < nPoints; ++i )
   {
     pts.push_back( coordSeqPoint( cs, i, hasZ, hasM ) );
@@ -944,13 +956,13 @@ int QgsGeos::numberOfGeometries( GEOSGeometry* g )
   if ( !g )
     return 0;
 
-  int geometryType = GEOSGeomTypeId_r( geosinit.ctxt, g );
+  int geometryType = GEOSGeomTypeId_r( geosContext(), g );
   if ( geometryType == GEOS_POINT || geometryType == GEOS_LINESTRING || geometryType == GEOS_LINEARRING
        || geometryType == GEOS_POLYGON )
     return 1;
 
   //calling GEOSGetNumGeometries is save for multi types and collections also in geos2
-  return GEOSGetNumGeometries_r( geosinit.ctxt, g );
+  return GEOSGetNumGeometries_r( geosContext(), g );
 }
 
 QgsPointV2 QgsGeos::coordSeqPoint( const GEOSCoordSequence* cs, int i, bool hasZ, bool hasM )
@@ -963,15 +975,15 @@ QgsPointV2 QgsGeos::coordSeqPoint( const GEOSCoordSequence* cs, int i, bool hasZ
   double x, y;
   double z = 0;
   double m = 0;
-  GEOSCoordSeq_getX_r( geosinit.ctxt, cs, i, &x );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, cs, i, &y );
+  GEOSCoordSeq_getX_r( geosContext(), cs, i, &x );
+  GEOSCoordSeq_getY_r( geosContext(), cs, i, &y );
   if ( hasZ )
   {
-    GEOSCoordSeq_getZ_r( geosinit.ctxt, cs, i, &z );
+    GEOSCoordSeq_getZ_r( geosContext(), cs, i, &z );
   }
   if ( hasM )
   {
-    GEOSCoordSeq_getOrdinate_r( geosinit.ctxt, cs, i, 3, &m );
+    GEOSCoordSeq_getOrdinate_r( geosContext(), cs, i, 3, &m );
   }
 
   QgsWKBTypes::Type t = QgsWKBTypes::Point;
@@ -1075,16 +1087,16 @@ QgsAbstractGeometryV2* QgsGeos::overlay( const QgsAbstractGeometryV2& geom, Over
     switch ( op )
     {
       case INTERSECTION:
-        opGeom.reset( GEOSIntersection_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSIntersection_r( geosContext(), mGeos, geosGeom.get() ) );
         break;
       case DIFFERENCE:
-        opGeom.reset( GEOSDifference_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSDifference_r( geosContext(), mGeos, geosGeom.get() ) );
         break;
       case UNION:
-        opGeom.reset( GEOSUnion_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSUnion_r( geosContext(), mGeos, geosGeom.get() ) );
         break;
       case SYMDIFFERENCE:
-        opGeom.reset( GEOSSymDifference_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSSymDifference_r( geosContext(), mGeos, geosGeom.get() ) );
         break;
       default:    //unknown op
         return 0;
@@ -1123,25 +1135,25 @@ bool QgsGeos::relation( const QgsAbstractGeometryV2& geom, Relation r, QString*
       switch ( r )
       {
         case INTERSECTS:
-          result = ( GEOSPreparedIntersects_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedIntersects_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case TOUCHES:
-          result = ( GEOSPreparedTouches_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedTouches_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case CROSSES:
-          result = ( GEOSPreparedCrosses_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedCrosses_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case WITHIN:
-          result = ( GEOSPreparedWithin_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedWithin_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case CONTAINS:
-          result = ( GEOSPreparedContains_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedContains_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case DISJOINT:
-          result = ( GEOSPreparedDisjoint_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedDisjoint_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case OVERLAPS:
-          result = ( GEOSPreparedOverlaps_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedOverlaps_r( geosContext(), mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         default:
           return false;
@@ -1152,25 +1164,25 @@ bool QgsGeos::relation( const QgsAbstractGeometryV2& geom, Relation r, QString*
     switch ( r )
     {
       case INTERSECTS:
-        result = ( GEOSIntersects_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSIntersects_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       case TOUCHES:
-        result = ( GEOSTouches_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSTouches_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       case CROSSES:
-        result = ( GEOSCrosses_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSCrosses_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       case WITHIN:
-        result = ( GEOSWithin_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSWithin_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       case CONTAINS:
-        result = ( GEOSContains_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSContains_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       case DISJOINT:
-        result = ( GEOSDisjoint_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSDisjoint_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       case OVERLAPS:
-        result = ( GEOSOverlaps_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSOverlaps_r( geosContext(), mGeos, geosGeom.get() ) == 1 );
         break;
       default:
         return false;
@@ -1198,7 +1210,7 @@ QgsAbstractGeometryV2* QgsGeos::buffer( double distance, int segments, QString*
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSBuffer_r( geosinit.ctxt, mGeos, distance, segments );
+    geos = GEOSBuffer_r( geosContext(), mGeos, distance, segments );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 );
   return fromGeos( geos );
@@ -1217,7 +1229,7 @@ QgsAbstractGeometryV2 *QgsGeos::buffer( double distance, int segments, int endCa
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSBufferWithStyle_r( geosinit.ctxt, mGeos, distance, segments, endCapStyle, joinStyle, mitreLimit );
+    geos = GEOSBufferWithStyle_r( geosContext(), mGeos, distance, segments, endCapStyle, joinStyle, mitreLimit );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 );
   return fromGeos( geos );
@@ -1235,7 +1247,7 @@ QgsAbstractGeometryV2* QgsGeos::simplify( double tolerance, QString* errorMsg )
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSTopologyPreserveSimplify_r( geosinit.ctxt, mGeos, tolerance );
+    geos = GEOSTopologyPreserveSimplify_r( geosContext(), mGeos, tolerance );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 );
   return fromGeos( geos );
@@ -1250,7 +1262,7 @@ QgsAbstractGeometryV2* QgsGeos::interpolate( double distance, QString* errorMsg
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSInterpolate_r( geosinit.ctxt, mGeos, distance );
+    geos = GEOSInterpolate_r( geosContext(), mGeos, distance );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 );
   return fromGeos( geos );
@@ -1266,7 +1278,7 @@ bool QgsGeos::centroid( QgsPointV2& pt, QString* errorMsg ) const
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSGetCentroid_r( geosinit.ctxt,  mGeos );
+    geos = GEOSGetCentroid_r( geosContext(),  mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 
@@ -1276,8 +1288,8 @@ bool QgsGeos::centroid( QgsPointV2& pt, QString* errorMsg ) const
   }
 
   double x, y;
-  GEOSGeomGetX_r( geosinit.ctxt, geos, &x );
-  GEOSGeomGetY_r( geosinit.ctxt, geos, &y );
+  GEOSGeomGetX_r( geosContext(), geos, &x );
+  GEOSGeomGetY_r( geosContext(), geos, &y );
   pt.setX( x ); pt.setY( y );
   return true;
 }
@@ -1291,7 +1303,7 @@ QgsAbstractGeometryV2* QgsGeos::envelope( QString* errorMsg ) const
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSEnvelope_r( geosinit.ctxt, mGeos );
+    geos = GEOSEnvelope_r( geosContext(), mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 );
   return fromGeos( geos );
@@ -1307,7 +1319,7 @@ bool QgsGeos::pointOnSurface( QgsPointV2& pt, QString* errorMsg ) const
   GEOSGeometry* geos = 0;
   try
   {
-    geos = GEOSPointOnSurface_r( geosinit.ctxt, mGeos );
+    geos = GEOSPointOnSurface_r( geosContext(), mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 
@@ -1317,8 +1329,8 @@ bool QgsGeos::pointOnSurface( QgsPointV2& pt, QString* errorMsg ) const
   }
 
   double x, y;
-  GEOSGeomGetX_r( geosinit.ctxt, geos, &x );
-  GEOSGeomGetY_r( geosinit.ctxt, geos, &y );
+  GEOSGeomGetX_r( geosContext(), geos, &x );
+  GEOSGeomGetY_r( geosContext(), geos, &y );
 
   pt.setX( x );
   pt.setY( y );
@@ -1335,9 +1347,9 @@ QgsAbstractGeometryV2* QgsGeos::convexHull( QString* errorMsg ) const
 
   try
   {
-    GEOSGeometry* cHull = GEOSConvexHull_r( geosinit.ctxt, mGeos );
+    GEOSGeometry* cHull = GEOSConvexHull_r( geosContext(), mGeos );
     QgsAbstractGeometryV2* cHullGeom = fromGeos( cHull );
-    GEOSGeom_destroy_r( geosinit.ctxt, cHull );
+    GEOSGeom_destroy_r( geosContext(), cHull );
     return cHullGeom;
   }
   CATCH_GEOS_WITH_ERRMSG( 0 );
@@ -1352,7 +1364,7 @@ bool QgsGeos::isValid( QString* errorMsg ) const
 
   try
   {
-    return GEOSisValid_r( geosinit.ctxt, mGeos );
+    return GEOSisValid_r( geosContext(), mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1371,7 +1383,7 @@ bool QgsGeos::isEqual( const QgsAbstractGeometryV2& geom, QString* errorMsg ) co
     {
       return false;
     }
-    bool equal = GEOSEquals_r( geosinit.ctxt, mGeos, geosGeom.get() );
+    bool equal = GEOSEquals_r( geosContext(), mGeos, geosGeom.get() );
     return equal;
   }
   CATCH_GEOS_WITH_ERRMSG( false );
@@ -1386,7 +1398,7 @@ bool QgsGeos::isEmpty( QString* errorMsg ) const
 
   try
   {
-    return GEOSisEmpty_r( geosinit.ctxt, mGeos );
+    return GEOSisEmpty_r( geosContext(), mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1423,19 +1435,19 @@ GEOSCoordSequence* QgsGeos::createCoordinateSequence( const QgsCurveV2* curve )
   GEOSCoordSequence* coordSeq = 0;
   try
   {
-    coordSeq = GEOSCoordSeq_create_r( geosinit.ctxt, numPoints, coordDims );
+    coordSeq = GEOSCoordSeq_create_r( geosContext(), numPoints, coordDims );
     for ( int i = 0; i < numPoints; ++i )
     {
       QgsPointV2 pt = line->pointN( i ); //todo: create method to get const point reference
-      GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, i, pt.x() );
-      GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, i, pt.y() );
+      GEOSCoordSeq_setX_r( geosContext(), coordSeq, i, pt.x() );
+      GEOSCoordSeq_setY_r( geosContext(), coordSeq, i, pt.y() );
       if ( hasZ )
       {
-        GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 2, pt.z() );
+        GEOSCoordSeq_setOrdinate_r( geosContext(), coordSeq, i, 2, pt.z() );
       }
       if ( hasM )
       {
-        GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 3, pt.m() );
+        GEOSCoordSeq_setOrdinate_r( geosContext(), coordSeq, i, 3, pt.m() );
       }
     }
   }
@@ -1458,18 +1470,18 @@ GEOSGeometry* QgsGeos::createGeosPoint( const QgsAbstractGeometryV2* point, int
 
   try
   {
-    GEOSCoordSequence* coordSeq = GEOSCoordSeq_create_r( geosinit.ctxt, 1, coordDims );
-    GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, 0, pt->x() );
-    GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, 0, pt->y() );
+    GEOSCoordSequence* coordSeq = GEOSCoordSeq_create_r( geosContext(), 1, coordDims );
+    GEOSCoordSeq_setX_r( geosContext(), coordSeq, 0, pt->x() );
+    GEOSCoordSeq_setY_r( geosContext(), coordSeq, 0, pt->y() );
     if ( pt->is3D() )
     {
-      GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 2, pt->z() );
+      GEOSCoordSeq_setOrdinate_r( geosContext(), coordSeq, 0, 2, pt->z() );
     }
     if ( 0 /*pt->isMeasure()*/ ) //disabled until geos supports m-coordinates
     {
-      GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 3, pt->m() );
+      GEOSCoordSeq_setOrdinate_r( geosContext(), coordSeq, 0, 3, pt->m() );
     }
-    geosPoint = GEOSGeom_createPoint_r( geosinit.ctxt, coordSeq );
+    geosPoint = GEOSGeom_createPoint_r( geosContext(), coordSeq );
   }
   CATCH_GEOS( 0 )
   return geosPoint;
@@ -1488,7 +1500,7 @@ GEOSGeometry* QgsGeos::createGeosLinestring( const QgsAbstractGeometryV2* curve
   GEOSGeometry* geosGeom = 0;
   try
   {
-    geosGeom = GEOSGeom_createLineString_r( geosinit.ctxt, coordSeq );
+    geosGeom = GEOSGeom_createLineString_r( geosContext(), coordSeq );
   }
   CATCH_GEOS( 0 )
   return geosGeom;
@@ -1509,7 +1521,7 @@ GEOSGeometry* QgsGeos::createGeosPolygon( const QgsAbstractGeometryV2* poly )
   GEOSGeometry* geosPolygon = 0;
   try
   {
-    GEOSGeometry* exteriorRingGeos = GEOSGeom_createLinearRing_r( geosinit.ctxt, createCoordinateSequence( exteriorRing ) );
+    GEOSGeometry* exteriorRingGeos = GEOSGeom_createLinearRing_r( geosContext(), createCoordinateSequence( exteriorRing ) );
 
 
     int nHoles = polygon->numInteriorRings();
@@ -1522,9 +1534,9 @@ GEOSGeometry* QgsGeos::createGeosPolygon( const QgsAbstractGeometryV2* poly )
     for ( int i = 0; i < nHoles; ++i )
     {
       const QgsCurveV2* interiorRing = polygon->interiorRing( i );
-      holes[i] = GEOSGeom_createLinearRing_r( geosinit.ctxt, createCoordinateSequence( interiorRing ) );
+      holes[i] = GEOSGeom_createLinearRing_r( geosContext(), createCoordinateSequence( interiorRing ) );
     }
-    geosPolygon = GEOSGeom_createPolygon_r( geosinit.ctxt, exteriorRingGeos, holes, nHoles );
+    geosPolygon = GEOSGeom_createPolygon_r( geosContext(), exteriorRingGeos, holes, nHoles );
     delete[] holes;
   }
   CATCH_GEOS( 0 )
@@ -1540,11 +1552,11 @@ QgsAbstractGeometryV2* QgsGeos::offsetCurve( double distance, int segments, int
   GEOSGeometry* offset = 0;
   try
   {
-    offset = GEOSOffsetCurve_r( geosinit.ctxt, mGeos, distance, segments, joinStyle, mitreLimit );
+    offset = GEOSOffsetCurve_r( geosContext(), mGeos, distance, segments, joinStyle, mitreLimit );
   }
   CATCH_GEOS_WITH_ERRMSG( 0 )
   QgsAbstractGeometryV2* offsetGeom = fromGeos( offset );
-  GEOSGeom_destroy_r( geosinit.ctxt, offset );
+  GEOSGeom_destroy_r( geosContext(), offset );
   return offsetGeom;
 }
 
@@ -1559,7 +1571,7 @@ QgsAbstractGeometryV2* QgsGeos::reshapeGeometry( const QgsLineStringV2& reshapeW
   GEOSGeometry* reshapeLineGeos = createGeosLinestring( &reshapeWithLine );
 
   //single or multi?
-  int numGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, mGeos );
+  int numGeoms = GEOSGetNumGeometries_r( geosContext(), mGeos );
   if ( numGeoms == -1 )
   {
     if ( errorCode ) { *errorCode = 1; }
@@ -1567,7 +1579,7 @@ QgsAbstractGeometryV2* QgsGeos::reshapeGeometry( const QgsLineStringV2& reshapeW
   }
 
   bool isMultiGeom = false;
-  int geosTypeId = GEOSGeomTypeId_r( geosinit.ctxt, mGeos );
+  int geosTypeId = GEOSGeomTypeId_r( geosContext(), mGeos );
   if ( geosTypeId == GEOS_MULTILINESTRING || geosTypeId == GEOS_MULTIPOLYGON )
     isMultiGeom = true;
 
@@ -1587,7 +1599,7 @@ QgsAbstractGeometryV2* QgsGeos::reshapeGeometry( const QgsLineStringV2& reshapeW
 
     if ( errorCode ) { *errorCode = 0; }
     QgsAbstractGeometryV2* reshapeResult = fromGeos( reshapedGeometry );
-    GEOSGeom_destroy_r( geosinit.ctxt, reshapedGeometry );
+    GEOSGeom_destroy_r( geosContext(), reshapedGeometry );
     return reshapeResult;
   }
   else
@@ -1603,9 +1615,9 @@ QgsAbstractGeometryV2* QgsGeos::reshapeGeometry( const QgsLineStringV2& reshapeW
       for ( int i = 0; i < numGeoms; ++i )
       {
         if ( isLine )
-          currentReshapeGeometry = reshapeLine( GEOSGetGeometryN_r( geosinit.ctxt, mGeos, i ), reshapeLineGeos );
+          currentReshapeGeometry = reshapeLine( GEOSGetGeometryN_r( geosContext(), mGeos, i ), reshapeLineGeos );
         else
-          currentReshapeGeometry = reshapePolygon( GEOSGetGeometryN_r( geosinit.ctxt, mGeos, i ), reshapeLineGeos );
+          currentReshapeGeometry = reshapePolygon( GEOSGetGeometryN_r( geosContext(), mGeos, i ), reshapeLineGeos );
 
         if ( currentReshapeGeometry )
         {
@@ -1614,19 +1626,19 @@ QgsAbstractGeometryV2* QgsGeos::reshapeGeometry( const QgsLineStringV2& reshapeW
         }
         else
         {
-          newGeoms[i] = GEOSGeom_clone_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, mGeos, i ) );
+          newGeoms[i] = GEOSGeom_clone_r( geosContext(), GEOSGetGeometryN_r( geosContext(), mGeos, i ) );
         }
       }
-      GEOSGeom_destroy_r( geosinit.ctxt, reshapeLineGeos );
+      GEOSGeom_destroy_r( geosContext(), reshapeLineGeos );
 
       GEOSGeometry* newMultiGeom = 0;
       if ( isLine )
       {
-        newMultiGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, newGeoms, numGeoms );
+        newMultiGeom = GEOSGeom_createCollection_r( geosContext(), GEOS_MULTILINESTRING, newGeoms, numGeoms );
       }
       else //multipolygon
       {
-        newMultiGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTIPOLYGON, newGeoms, numGeoms );
+        newMultiGeom = GEOSGeom_createCollection_r( geosContext(), GEOS_MULTIPOLYGON, newGeoms, numGeoms );
       }
 
       delete[] newGeoms;
@@ -1640,12 +1652,12 @@ QgsAbstractGeometryV2* QgsGeos::reshapeGeometry( const QgsLineStringV2& reshapeW
       {
         if ( errorCode ) { *errorCode = 0; }
         QgsAbstractGeometryV2* reshapedMultiGeom = fromGeos( newMultiGeom );
-        GEOSGeom_destroy_r( geosinit.ctxt, newMultiGeom );
+        GEOSGeom_destroy_r( geosContext(), newMultiGeom );
         return reshapedMultiGeom;
       }
       else
       {
-        GEOSGeom_destroy_r( geosinit.ctxt, newMultiGeom );
+        GEOSGeom_destroy_r( geosContext(), newMultiGeom );
         if ( errorCode ) { *errorCode = 1; }
         return 0;
       }
@@ -1664,12 +1676,12 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
   try
   {
     //make sure there are at least two intersection between line and reshape geometry
-    GEOSGeometry* intersectGeom = GEOSIntersection_r( geosinit.ctxt, line, reshapeLineGeos );
+    GEOSGeometry* intersectGeom = GEOSIntersection_r( geosContext(), line, reshapeLineGeos );
     if ( intersectGeom )
     {
-      atLeastTwoIntersections = ( GEOSGeomTypeId_r( geosinit.ctxt, intersectGeom ) == GEOS_MULTIPOINT
-                                  && GEOSGetNumGeometries_r( geosinit.ctxt, intersectGeom ) > 1 );
-      GEOSGeom_destroy_r( geosinit.ctxt, intersectGeom );
+      atLeastTwoIntersections = ( GEOSGeomTypeId_r( geosContext(), intersectGeom ) == GEOS_MULTIPOINT
+                                  && GEOSGetNumGeometries_r( geosContext(), intersectGeom ) > 1 );
+      GEOSGeom_destroy_r( geosContext(), intersectGeom );
     }
   }
   catch ( GEOSException &e )
@@ -1682,12 +1694,12 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
     return 0;
 
   //begin and end point of original line
-  const GEOSCoordSequence* lineCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, line );
+  const GEOSCoordSequence* lineCoordSeq = GEOSGeom_getCoordSeq_r( geosContext(), line );
   if ( !lineCoordSeq )
     return 0;
 
   unsigned int lineCoordSeqSize;
-  if ( GEOSCoordSeq_getSize_r( geosinit.ctxt, lineCoordSeq, &lineCoordSeqSize ) == 0 )
+  if ( GEOSCoordSeq_getSize_r( geosContext(), lineCoordSeq, &lineCoordSeqSize ) == 0 )
     return 0;
 
   if ( lineCoordSeqSize < 2 )
@@ -1695,46 +1707,46 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
 
   //first and last vertex of line
   double x1, y1, x2, y2;
-  GEOSCoordSeq_getX_r( geosinit.ctxt, lineCoordSeq, 0, &x1 );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, lineCoordSeq, 0, &y1 );
-  GEOSCoordSeq_getX_r( geosinit.ctxt, lineCoordSeq, lineCoordSeqSize - 1, &x2 );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, lineCoordSeq, lineCoordSeqSize - 1, &y2 );
+  GEOSCoordSeq_getX_r( geosContext(), lineCoordSeq, 0, &x1 );
+  GEOSCoordSeq_getY_r( geosContext(), lineCoordSeq, 0, &y1 );
+  GEOSCoordSeq_getX_r( geosContext(), lineCoordSeq, lineCoordSeqSize - 1, &x2 );
+  GEOSCoordSeq_getY_r( geosContext(), lineCoordSeq, lineCoordSeqSize - 1, &y2 );
   QgsPointV2 beginPoint( x1, y1 );
   GEOSGeometry* beginLineVertex = createGeosPoint( &beginPoint, 2 );
   QgsPointV2 endPoint( x2, y2 );
   GEOSGeometry* endLineVertex = createGeosPoint( &endPoint, 2 );
 
   bool isRing = false;
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, line ) == GEOS_LINEARRING
-       || GEOSEquals_r( geosinit.ctxt, beginLineVertex, endLineVertex ) == 1 )
+  if ( GEOSGeomTypeId_r( geosContext(), line ) == GEOS_LINEARRING
+       || GEOSEquals_r( geosContext(), beginLineVertex, endLineVertex ) == 1 )
     isRing = true;
 
   //node line and reshape line
   GEOSGeometry* nodedGeometry = nodeGeometries( reshapeLineGeos, line );
   if ( !nodedGeometry )
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
+    GEOSGeom_destroy_r( geosContext(), beginLineVertex );
+    GEOSGeom_destroy_r( geosContext(), endLineVertex );
     return 0;
   }
 
   //and merge them together
-  GEOSGeometry *mergedLines = GEOSLineMerge_r( geosinit.ctxt, nodedGeometry );
-  GEOSGeom_destroy_r( geosinit.ctxt, nodedGeometry );
+  GEOSGeometry *mergedLines = GEOSLineMerge_r( geosContext(), nodedGeometry );
+  GEOSGeom_destroy_r( geosContext(), nodedGeometry );
   if ( !mergedLines )
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
+    GEOSGeom_destroy_r( geosContext(), beginLineVertex );
+    GEOSGeom_destroy_r( geosContext(), endLineVertex );
     return 0;
   }
 
-  int numMergedLines = GEOSGetNumGeometries_r( geosinit.ctxt, mergedLines );
+  int numMergedLines = GEOSGetNumGeometries_r( geosContext(), mergedLines );
   if ( numMergedLines < 2 ) //some special cases. Normally it is >2
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
+    GEOSGeom_destroy_r( geosContext(), beginLineVertex );
+    GEOSGeom_destroy_r( geosContext(), endLineVertex );
     if ( numMergedLines == 1 ) //reshape line is from begin to endpoint. So we keep the reshapeline
-      return GEOSGeom_clone_r( geosinit.ctxt, reshapeLineGeos );
+      return GEOSGeom_clone_r( geosContext(), reshapeLineGeos );
     else
       return 0;
   }
@@ -1746,19 +1758,19 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
   {
     const GEOSGeometry* currentGeom;
 
-    currentGeom = GEOSGetGeometryN_r( geosinit.ctxt, mergedLines, i );
-    const GEOSCoordSequence* currentCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, currentGeom );
+    currentGeom = GEOSGetGeometryN_r( geosContext(), mergedLines, i );
+    const GEOSCoordSequence* currentCoordSeq = GEOSGeom_getCoordSeq_r( geosContext(), currentGeom );
     unsigned int currentCoordSeqSize;
-    GEOSCoordSeq_getSize_r( geosinit.ctxt, currentCoordSeq, &currentCoordSeqSize );
+    GEOSCoordSeq_getSize_r( geosContext(), currentCoordSeq, &currentCoordSeqSize );
     if ( currentCoordSeqSize < 2 )
       continue;
 
     //get the two endpoints of the current line merge result
     double xBegin, xEnd, yBegin, yEnd;
-    GEOSCoordSeq_getX_r( geosinit.ctxt, currentCoordSeq, 0, &xBegin );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, currentCoordSeq, 0, &yBegin );
-    GEOSCoordSeq_getX_r( geosinit.ctxt, currentCoordSeq, currentCoordSeqSize - 1, &xEnd );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, currentCoordSeq, currentCoordSeqSize - 1, &yEnd );
+    GEOSCoordSeq_getX_r( geosContext(), currentCoordSeq, 0, &xBegin );
+    GEOSCoordSeq_getY_r( geosContext(), currentCoordSeq, 0, &yBegin );
+    GEOSCoordSeq_getX_r( geosContext(), currentCoordSeq, currentCoordSeqSize - 1, &xEnd );
+    GEOSCoordSeq_getY_r( geosContext(), currentCoordSeq, currentCoordSeqSize - 1, &yEnd );
     QgsPointV2 beginPoint( xBegin, yBegin );
     GEOSGeometry* beginCurrentGeomVertex = createGeosPoint( &beginPoint, 2 );
     QgsPointV2 endPoint( xEnd, yEnd );
@@ -1774,12 +1786,12 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
 
     //check how many endpoints equal the endpoints of the original line
     int nEndpointsSameAsOriginalLine = 0;
-    if ( GEOSEquals_r( geosinit.ctxt, beginCurrentGeomVertex, beginLineVertex ) == 1
-         || GEOSEquals_r( geosinit.ctxt, beginCurrentGeomVertex, endLineVertex ) == 1 )
+    if ( GEOSEquals_r( geosContext(), beginCurrentGeomVertex, beginLineVertex ) == 1
+         || GEOSEquals_r( geosContext(), beginCurrentGeomVertex, endLineVertex ) == 1 )
       nEndpointsSameAsOriginalLine += 1;
 
-    if ( GEOSEquals_r( geosinit.ctxt, endCurrentGeomVertex, beginLineVertex ) == 1
-         || GEOSEquals_r( geosinit.ctxt, endCurrentGeomVertex, endLineVertex ) == 1 )
+    if ( GEOSEquals_r( geosContext(), endCurrentGeomVertex, beginLineVertex ) == 1
+         || GEOSEquals_r( geosContext(), endCurrentGeomVertex, endLineVertex ) == 1 )
       nEndpointsSameAsOriginalLine += 1;
 
     //check if the current geometry overlaps the original geometry (GEOSOverlap does not seem to work with linestrings)
@@ -1794,28 +1806,28 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
     //logic to decide if this part belongs to the result
     if ( nEndpointsSameAsOriginalLine == 1 && nEndpointsOnOriginalLine == 2 && currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosContext(), currentGeom ) );
     }
     //for closed rings, we take one segment from the candidate list
     else if ( isRing && nEndpointsOnOriginalLine == 2 && currentGeomOverlapsOriginalGeom )
     {
-      probableParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      probableParts.push_back( GEOSGeom_clone_r( geosContext(), currentGeom ) );
     }
     else if ( nEndpointsOnOriginalLine == 2 && !currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosContext(), currentGeom ) );
     }
     else if ( nEndpointsSameAsOriginalLine == 2 && !currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosContext(), currentGeom ) );
     }
     else if ( currentGeomOverlapsOriginalGeom && currentGeomOverlapsReshapeLine )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosContext(), currentGeom ) );
     }
 
-    GEOSGeom_destroy_r( geosinit.ctxt, beginCurrentGeomVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endCurrentGeomVertex );
+    GEOSGeom_destroy_r( geosContext(), beginCurrentGeomVertex );
+    GEOSGeom_destroy_r( geosContext(), endCurrentGeomVertex );
   }
 
   //add the longest segment from the probable list for rings (only used for polygon rings)
@@ -1828,24 +1840,24 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
     for ( int i = 0; i < probableParts.size(); ++i )
     {
       currentGeom = probableParts.at( i );
-      GEOSLength_r( geosinit.ctxt, currentGeom, &currentLength );
+      GEOSLength_r( geosContext(), currentGeom, &currentLength );
       if ( currentLength > maxLength )
       {
         maxLength = currentLength;
-        GEOSGeom_destroy_r( geosinit.ctxt, maxGeom );
+        GEOSGeom_destroy_r( geosContext(), maxGeom );
         maxGeom = currentGeom;
       }
       else
       {
-        GEOSGeom_destroy_r( geosinit.ctxt, currentGeom );
+        GEOSGeom_destroy_r( geosContext(), currentGeom );
       }
     }
     resultLineParts.push_back( maxGeom );
   }
 
-  GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-  GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
-  GEOSGeom_destroy_r( geosinit.ctxt, mergedLines );
+  GEOSGeom_destroy_r( geosContext(), beginLineVertex );
+  GEOSGeom_destroy_r( geosContext(), endLineVertex );
+  GEOSGeom_destroy_r( geosContext(), mergedLines );
 
   GEOSGeometry* result = 0;
   if ( resultLineParts.size() < 1 )
@@ -1864,18 +1876,18 @@ GEOSGeometry* QgsGeos::reshapeLine( const GEOSGeometry* line, const GEOSGeometry
     }
 
     //create multiline from resultLineParts
-    GEOSGeometry* multiLineGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, lineArray, resultLineParts.size() );
+    GEOSGeometry* multiLineGeom = GEOSGeom_createCollection_r( geosContext(), GEOS_MULTILINESTRING, lineArray, resultLineParts.size() );
     delete [] lineArray;
 
     //then do a linemerge with the newly combined partstrings
-    result = GEOSLineMerge_r( geosinit.ctxt, multiLineGeom );
-    GEOSGeom_destroy_r( geosinit.ctxt, multiLineGeom );
+    result = GEOSLineMerge_r( geosContext(), multiLineGeom );
+    GEOSGeom_destroy_r( geosContext(), multiLineGeom );
   }
 
   //now test if the result is a linestring. Otherwise something went wrong
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, result ) != GEOS_LINESTRING )
+  if ( GEOSGeomTypeId_r( geosContext(), result ) != GEOS_LINESTRING )
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, result );
+    GEOSGeom_destroy_r( geosContext(), result );
     return 0;
   }
 
@@ -1889,13 +1901,13 @@ GEOSGeometry* QgsGeos::reshapePolygon( const GEOSGeometry* polygon, const GEOSGe
   int lastIntersectingRing = -2;
   const GEOSGeometry* lastIntersectingGeom = 0;
 
-  int nRings = GEOSGetNumInteriorRings_r( geosinit.ctxt, polygon );
+  int nRings = GEOSGetNumInteriorRings_r( geosContext(), polygon );
   if ( nRings < 0 )
     return 0;
 
   //does outer ring intersect?
-  const GEOSGeometry* outerRing = GEOSGetExteriorRing_r( geosinit.ctxt, polygon );
-  if ( GEOSIntersects_r( geosinit.ctxt, outerRing, reshapeLineGeos ) == 1 )
+  const GEOSGeometry* outerRing = GEOSGetExteriorRing_r( geosContext(), polygon );
+  if ( GEOSIntersects_r( geosContext(), outerRing, reshapeLineGeos ) == 1 )
   {
     ++nIntersections;
     lastIntersectingRing = -1;
@@ -1909,8 +1921,8 @@ GEOSGeometry* QgsGeos::reshapePolygon( const GEOSGeometry* polygon, const GEOSGe
   {
     for ( int i = 0; i < nRings; ++i )
     {
-      innerRings[i] = GEOSGetInteriorRingN_r( geosinit.ctxt, polygon, i );
-      if ( GEOSIntersects_r( geosinit.ctxt, innerRings[i], reshapeLineGeos ) == 1 )
+      innerRings[i] = GEOSGetInteriorRingN_r( geosContext(), polygon, i );
+      if ( GEOSIntersects_r( geosContext(), innerRings[i], reshapeLineGeos ) == 1 )
       {
         ++nIntersections;
         lastIntersectingRing = i;
@@ -1940,12 +1952,12 @@ GEOSGeometry* QgsGeos::reshapePolygon( const GEOSGeometry* polygon, const GEOSGe
 
   //if reshaping took place, we need to reassemble the polygon and its rings
   GEOSGeometry* newRing = 0;
-  const GEOSCoordSequence* reshapeSequence = GEOSGeom_getCoordSeq_r( geosinit.ctxt, reshapeResult );
-  GEOSCoordSequence* newCoordSequence = GEOSCoordSeq_clone_r( geosinit.ctxt, reshapeSequence );
+  const GEOSCoordSequence* reshapeSequence = GEOSGeom_getCoordSeq_r( geosContext(), reshapeResult );
+  GEOSCoordSequence* newCoordSequence = GEOSCoordSeq_clone_r( geosContext(), reshapeSequence );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, reshapeResult );
+  GEOSGeom_destroy_r( geosContext(), reshapeResult );
 
-  newRing = GEOSGeom_createLinearRing_r( geosinit.ctxt, newCoordSequence );
+  newRing = GEOSGeom_createLinearRing_r( geosContext(), newCoordSequence );
   if ( !newRing )
   {
     delete [] innerRings;
@@ -1956,13 +1968,13 @@ GEOSGeometry* QgsGeos::reshapePolygon( const GEOSGeometry* polygon, const GEOSGe
   if ( lastIntersectingRing == -1 )
     newOuterRing = newRing;
   else
-    newOuterRing = GEOSGeom_clone_r( geosinit.ctxt, outerRing );
+    newOuterRing = GEOSGeom_clone_r( geosContext(), outerRing );
 
   //check if all the rings are still inside the outer boundary
   QList<GEOSGeometry*> ringList;
   if ( nRings > 0 )
   {
-    GEOSGeometry* outerRingPoly = GEOSGeom_createPolygon_r( geosinit.ctxt, GEOSGeom_clone_r( geosinit.ctxt, newOuterRing ), 0, 0 );
+    GEOSGeometry* outerRingPoly = GEOSGeom_createPolygon_r( geosContext(), GEOSGeom_clone_r( geosContext(), newOuterRing ), 0, 0 );
     if ( outerRingPoly )
     {
       GEOSGeometry* currentRing = 0;
@@ -1971,16 +1983,16 @@ GEOSGeometry* QgsGeos::reshapePolygon( const GEOSGeometry* polygon, const GEOSGe
         if ( lastIntersectingRing == i )
           currentRing = newRing;
         else
-          currentRing = GEOSGeom_clone_r( geosinit.ctxt, innerRings[i] );
+          currentRing = GEOSGeom_clone_r( geosContext(), innerRings[i] );
 
         //possibly a ring is no longer contained in the result polygon after reshape
-        if ( GEOSContains_r( geosinit.ctxt, outerRingPoly, currentRing ) == 1 )
+        if ( GEOSContains_r( geosContext(), outerRingPoly, currentRing ) == 1 )
           ringList.push_back( currentRing );
         else
-          GEOSGeom_destroy_r( geosinit.ctxt, currentRing );
+          GEOSGeom_destroy_r( geosContext(), currentRing );
       }
     }
-    GEOSGeom_destroy_r( geosinit.ctxt, outerRingPoly );
+    GEOSGeom_destroy_r( geosContext(), outerRingPoly );
   }
 
   GEOSGeometry** newInnerRings = new GEOSGeometry*[ringList.size()];
@@ -1989,7 +2001,7 @@ GEOSGeometry* QgsGeos::reshapePolygon( const GEOSGeometry* polygon, const GEOSGe
 
   delete [] innerRings;
 
-  GEOSGeometry* reshapedPolygon = GEOSGeom_createPolygon_r( geosinit.ctxt, newOuterRing, newInnerRings, ringList.size() );
+  GEOSGeometry* reshapedPolygon = GEOSGeom_createPolygon_r( geosContext(), newOuterRing, newInnerRings, ringList.size() );
   delete[] newInnerRings;
 
   return reshapedPolygon;
@@ -2004,21 +2016,21 @@ int QgsGeos::lineContainedInLine( const GEOSGeometry* line1, const GEOSGeometry*
 
   double bufferDistance = pow( 10.0L, geomDigits( line2 ) - 11 );
 
-  GEOSGeometry* bufferGeom = GEOSBuffer_r( geosinit.ctxt, line2, bufferDistance, DEFAULT_QUADRANT_SEGMENTS );
+  GEOSGeometry* bufferGeom = GEOSBuffer_r( geosContext(), line2, bufferDistance, DEFAULT_QUADRANT_SEGMENTS );
   if ( !bufferGeom )
     return -2;
 
-  GEOSGeometry* intersectionGeom = GEOSIntersection_r( geosinit.ctxt, bufferGeom, line1 );
+  GEOSGeometry* intersectionGeom = GEOSIntersection_r( geosContext(), bufferGeom, line1 );
 
   //compare ratio between line1Length and intersectGeomLength (usually close to 1 if line1 is contained in line2)
   double intersectGeomLength;
   double line1Length;
 
-  GEOSLength_r( geosinit.ctxt, intersectionGeom, &intersectGeomLength );
-  GEOSLength_r( geosinit.ctxt, line1, &line1Length );
+  GEOSLength_r( geosContext(), intersectionGeom, &intersectGeomLength );
+  GEOSLength_r( geosContext(), line1, &line1Length );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, bufferGeom );
-  GEOSGeom_destroy_r( geosinit.ctxt, intersectionGeom );
+  GEOSGeom_destroy_r( geosContext(), bufferGeom );
+  GEOSGeom_destroy_r( geosContext(), intersectionGeom );
 
   double intersectRatio = line1Length / intersectGeomLength;
   if ( intersectRatio > 0.9 && intersectRatio < 1.1 )
@@ -2034,49 +2046,49 @@ int QgsGeos::pointContainedInLine( const GEOSGeometry* point, const GEOSGeometry
 
   double bufferDistance = pow( 10.0L, geomDigits( line ) - 11 );
 
-  GEOSGeometry* lineBuffer = GEOSBuffer_r( geosinit.ctxt, line, bufferDistance, 8 );
+  GEOSGeometry* lineBuffer = GEOSBuffer_r( geosContext(), line, bufferDistance, 8 );
   if ( !lineBuffer )
     return -2;
 
   bool contained = false;
-  if ( GEOSContains_r( geosinit.ctxt, lineBuffer, point ) == 1 )
+  if ( GEOSContains_r( geosContext(), lineBuffer, point ) == 1 )
     contained = true;
 
-  GEOSGeom_destroy_r( geosinit.ctxt, lineBuffer );
+  GEOSGeom_destroy_r( geosContext(), lineBuffer );
   return contained;
 }
 
 int QgsGeos::geomDigits( const GEOSGeometry* geom )
 {
-  GEOSGeometry* bbox = GEOSEnvelope_r( geosinit.ctxt, geom );
+  GEOSGeometry* bbox = GEOSEnvelope_r( geosContext(), geom );
   if ( !bbox )
     return -1;
 
-  const GEOSGeometry* bBoxRing = GEOSGetExteriorRing_r( geosinit.ctxt, bbox );
+  const GEOSGeometry* bBoxRing = GEOSGetExteriorRing_r( geosContext(), bbox );
   if ( !bBoxRing )
     return -1;
 
-  const GEOSCoordSequence* bBoxCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, bBoxRing );
+  const GEOSCoordSequence* bBoxCoordSeq = GEOSGeom_getCoordSeq_r( geosContext(), bBoxRing );
 
   if ( !bBoxCoordSeq )
     return -1;
 
   unsigned int nCoords = 0;
-  if ( !GEOSCoordSeq_getSize_r( geosinit.ctxt, bBoxCoordSeq, &nCoords ) )
+  if ( !GEOSCoordSeq_getSize_r( geosContext(), bBoxCoordSeq, &nCoords ) )
     return -1;
 
   int maxDigits = -1;
   for ( unsigned int i = 0; i < nCoords - 1; ++i )
   {
     double t;
-    GEOSCoordSeq_getX_r( geosinit.ctxt, bBoxCoordSeq, i, &t );
+    GEOSCoordSeq_getX_r( geosContext(), bBoxCoordSeq, i, &t );
 
     int digits;
     digits = ceil( log10( fabs( t ) ) );
     if ( digits > maxDigits )
       maxDigits = digits;
 
-    GEOSCoordSeq_getY_r( geosinit.ctxt, bBoxCoordSeq, i, &t );
+    GEOSCoordSeq_getY_r( geosContext(), bBoxCoordSeq, i, &t );
     digits = ceil( log10( fabs( t ) ) );
     if ( digits > maxDigits )
       maxDigits = digits;
@@ -2087,5 +2099,5 @@ int QgsGeos::geomDigits( const GEOSGeometry* geom )
 
 GEOSContextHandle_t QgsGeos::getGEOSHandler()
 {
-  return geosinit.ctxt;
+  return geosContext();
 }
@@ -87,6 +87,9 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static GEOSGeometry* asGeos( const QgsAbstractGeometryV2* geom );
     static QgsPointV2 coordSeqPoint( const GEOSCoordSequence* cs, int i, bool hasZ, bool hasM );
 
+    /** Returns the GEOS context handle of the calling thread. Every thread has its own handle,
+     * so GEOS operations may run concurrently as long as each thread uses its own handle.
+     */
     static GEOSContextHandle_t getGEOSHandler();
 
   private:
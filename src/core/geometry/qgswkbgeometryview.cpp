@@ -0,0 +1,365 @@
+/***************************************************************************
+    qgswkbgeometryview.cpp
+    ----------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgsapplication.h"
+#include "qgspointv2.h"
+
+#include <cstring>
+#include <limits>
+
+static bool readUInt( const unsigned char*& p, const unsigned char* end, bool swap, unsigned int& value )
+{
+  if ( end - p < ( int )sizeof( value ) )
+    return false;
+
+  memcpy( &value, p, sizeof( value ) );
+  p += sizeof( value );
+  if ( swap )
+    QgsApplication::endian_swap( value );
+  return true;
+}
+
+static bool readHeader( const unsigned char*& p, const unsigned char* end, bool& swap, QgsWKBTypes::Type& type )
+{
+  if ( end - p < 1 || ( *p != QgsApplication::XDR && *p != QgsApplication::NDR ) )
+    return false;
+
+  swap = *p != QgsApplication::endian();
+  ++p;
+  unsigned int value;
+  if ( !readUInt( p, end, swap, value ) )
+    return false;
+  type = ( QgsWKBTypes::Type ) value;
+  return true;
+}
+
+static int pointSize( QgsWKBTypes::Type type )
+{
+  return ( 2 + QgsWKBTypes::hasZ( type ) + QgsWKBTypes::hasM( type ) ) * sizeof( double );
+}
+
+static bool skipPoints( const unsigned char*& p, const unsigned char* end, unsigned int count, QgsWKBTypes::Type type, int& vertexCount )
+{
+  unsigned int size = pointSize( type );
+  if ( count > ( unsigned int )( end - p ) / size )
+    return false;
+
+  p += count * size;
+  vertexCount += count;
+  return true;
+}
+
+//! checks that a geometry is well formed and moves p behind it
+static bool skipGeometry( const unsigned char*& p, const unsigned char* end, int depth, bool& curved, int& vertexCount )
+{
+  bool swap;
+  QgsWKBTypes::Type type;
+  if ( depth >= QgsWkbGeometryView::MaxNesting || !readHeader( p, end, swap, type ) )
+    return false;
+
+  unsigned int count;
+  switch ( QgsWKBTypes::flatType( type ) )
+  {
+    case QgsWKBTypes::Point:
+      return skipPoints( p, end, 1, type, vertexCount );
+
+    case QgsWKBTypes::CircularString:
+      curved = true;
+      // fall through
+    case QgsWKBTypes::LineString:
+      return readUInt( p, end, swap, count ) && skipPoints( p, end, count, type, vertexCount );
+
+    case QgsWKBTypes::Polygon:
+    {
+      if ( !readUInt( p, end, swap, count ) )
+        return false;
+      for ( unsigned int i = 0; i < count; ++i )
+      {
+        unsigned int nPoints;
+        if ( !readUInt( p, end, swap, nPoints ) || !skipPoints( p, end, nPoints, type, vertexCount ) )
+          return false;
+      }
+      return true;
+    }
+
+    case QgsWKBTypes::CompoundCurve:
+    case QgsWKBTypes::CurvePolygon:
+    case QgsWKBTypes::MultiPoint:
+    case QgsWKBTypes::MultiLineString:
+    case QgsWKBTypes::MultiPolygon:
+    case QgsWKBTypes::MultiCurve:
+    case QgsWKBTypes::MultiSurface:
+    case QgsWKBTypes::GeometryCollection:
+    {
+      if ( !readUInt( p, end, swap, count ) )
+        return false;
+      for ( unsigned int i = 0; i < count; ++i )
+      {
+        if ( !skipGeometry( p, end, depth + 1, curved, vertexCount ) )
+          return false;
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+QgsWkbGeometryView::QgsWkbGeometryView()
+    : mWkb( 0 )
+    , mSize( 0 )
+    , mType( QgsWKBTypes::Unknown )
+    , mCurved( false )
+    , mVertexCount( 0 )
+{
+}
+
+QgsWkbGeometryView::QgsWkbGeometryView( const unsigned char* wkb, int size )
+    : mWkb( wkb )
+    , mSize( 0 )
+    , mType( QgsWKBTypes::Unknown )
+    , mCurved( false )
+    , mVertexCount( 0 )
+{
+  if ( !wkb || size <= 0 )
+    return;
+
+  const unsigned char* p = wkb;
+  if ( !skipGeometry( p, wkb + size, 0, mCurved, mVertexCount ) )
+  {
+    mCurved = false;
+    mVertexCount = 0;
+    return;
+  }
+
+  mSize = p - wkb;
+  memcpy( &mType, wkb + 1, sizeof( int ) );
+  if ( !isNativeByteOrder() )
+    QgsApplication::endian_swap( mType );
+}
+
+bool QgsWkbGeometryView::isNativeByteOrder() const
+{
+  return mWkb && *mWkb == QgsApplication::endian();
+}
+
+int QgsWkbGeometryView::partCount() const
+{
+  if ( !isValid() )
+    return 0;
+
+  switch ( QgsWKBTypes::flatType( mType ) )
+  {
+    case QgsWKBTypes::MultiPoint:
+    case QgsWKBTypes::MultiLineString:
+    case QgsWKBTypes::MultiPolygon:
+    case QgsWKBTypes::MultiCurve:
+    case QgsWKBTypes::MultiSurface:
+    case QgsWKBTypes::GeometryCollection:
+    {
+      const unsigned char* p = mWkb + 1 + sizeof( int );
+      unsigned int count = 0;
+      readUInt( p, mWkb + mSize, !isNativeByteOrder(), count );
+      return count;
+    }
+
+    default:
+      return 1;
+  }
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox() const
+{
+  if ( mVertexCount == 0 )
+    return QgsRectangle();
+
+  double xMin = std::numeric_limits<double>::max();
+  double yMin = std::numeric_limits<double>::max();
+  double xMax = -std::numeric_limits<double>::max();
+  double yMax = -std::numeric_limits<double>::max();
+
+  QgsPointV2 point;
+  VertexIterator it = vertices();
+  while ( it.next( point ) )
+  {
+    xMin = qMin( xMin, point.x() );
+    yMin = qMin( yMin, point.y() );
+    xMax = qMax( xMax, point.x() );
+    yMax = qMax( yMax, point.y() );
+  }
+  return QgsRectangle( xMin, yMin, xMax, yMax );
+}
+
+
+QgsWkbGeometryView::VertexIterator::VertexIterator( const QgsWkbGeometryView& view )
+    : mP( view.wkb() )
+    , mDepth( 0 )
+    , mPointsLeft( 0 )
+    , mPointType( QgsWKBTypes::Point )
+    , mHasZ( false )
+    , mHasM( false )
+    , mSwap( false )
+    , mPart( 0 )
+    , mRing( 0 )
+    , mVertex( -1 )
+{
+  if ( view.isValid() )
+    enterGeometry();
+}
+
+unsigned int QgsWkbGeometryView::VertexIterator::readCount( bool swap )
+{
+  unsigned int count;
+  memcpy( &count, mP, sizeof( count ) );
+  mP += sizeof( count );
+  if ( swap )
+    QgsApplication::endian_swap( count );
+  return count;
+}
+
+void QgsWkbGeometryView::VertexIterator::startPoints( QgsWKBTypes::Type type, bool swap, unsigned int count )
+{
+  mPointsLeft = count;
+  mHasZ = QgsWKBTypes::hasZ( type );
+  mHasM = QgsWKBTypes::hasM( type );
+  mSwap = swap;
+  if (( unsigned int ) type >= ( unsigned int ) QgsWKBTypes::Point25D )
+    mPointType = QgsWKBTypes::Point25D;
+  else if ( mHasZ )
+    mPointType = mHasM ? QgsWKBTypes::PointZM : QgsWKBTypes::PointZ;
+  else
+    mPointType = mHasM ? QgsWKBTypes::PointM : QgsWKBTypes::Point;
+}
+
+void QgsWkbGeometryView::VertexIterator::enterGeometry()
+{
+  // the structure has been validated by the view, no bounds checks needed
+  bool swap = *mP != QgsApplication::endian();
+  ++mP;
+  QgsWKBTypes::Type type = ( QgsWKBTypes::Type ) readCount( swap );
+
+  Frame frame;
+  frame.swap = swap;
+  frame.type = type;
+
+  switch ( QgsWKBTypes::flatType( type ) )
+  {
+    case QgsWKBTypes::Point:
+    case QgsWKBTypes::LineString:
+    case QgsWKBTypes::CircularString:
+      startPoints( type, swap, QgsWKBTypes::flatType( type ) == QgsWKBTypes::Point ? 1 : readCount( swap ) );
+      return;
+
+    case QgsWKBTypes::Polygon:
+      frame.kind = Rings;
+      mRing = -1;
+      break;
+
+    case QgsWKBTypes::CurvePolygon:
+      frame.kind = CurveRings;
+      mRing = -1;
+      break;
+
+    case QgsWKBTypes::MultiPoint:
+    case QgsWKBTypes::MultiLineString:
+    case QgsWKBTypes::MultiPolygon:
+    case QgsWKBTypes::MultiCurve:
+    case QgsWKBTypes::MultiSurface:
+    case QgsWKBTypes::GeometryCollection:
+      frame.kind = mDepth == 0 ? Parts : Curves;
+      if ( mDepth == 0 )
+        mPart = -1;
+      break;
+
+    default:
+      frame.kind = Curves;
+      break;
+  }
+
+  frame.remaining = readCount( swap );
+  mStack[mDepth++] = frame;
+}
+
+bool QgsWkbGeometryView::VertexIterator::next( QgsPointV2& point )
+{
+  while ( mPointsLeft == 0 )
+  {
+    if ( mDepth == 0 )
+      return false;
+
+    Frame& frame = mStack[mDepth - 1];
+    if ( frame.remaining == 0 )
+    {
+      --mDepth;
+      continue;
+    }
+    --frame.remaining;
+
+    switch ( frame.kind )
+    {
+      case Rings:
+        // linear rings are plain point sequences without a header
+        startPoints( frame.type, frame.swap, readCount( frame.swap ) );
+        ++mRing;
+        mVertex = -1;
+        break;
+
+      case Parts:
+        ++mPart;
+        mRing = 0;
+        mVertex = -1;
+        enterGeometry();
+        break;
+
+      case CurveRings:
+        ++mRing;
+        mVertex = -1;
+        enterGeometry();
+        break;
+
+      case Curves:
+        enterGeometry();
+        break;
+    }
+  }
+
+  double x, y, z = 0.0, m = 0.0;
+  memcpy( &x, mP, sizeof( double ) );
+  memcpy( &y, mP + sizeof( double ), sizeof( double ) );
+  mP += 2 * sizeof( double );
+  if ( mHasZ )
+  {
+    memcpy( &z, mP, sizeof( double ) );
+    mP += sizeof( double );
+  }
+  if ( mHasM )
+  {
+    memcpy( &m, mP, sizeof( double ) );
+    mP += sizeof( double );
+  }
+  if ( mSwap )
+  {
+    QgsApplication::endian_swap( x );
+    QgsApplication::endian_swap( y );
+    QgsApplication::endian_swap( z );
+    QgsApplication::endian_swap( m );
+  }
+
+  point = QgsPointV2( mPointType, x, y, z, m );
+  --mPointsLeft;
+  ++mVertex;
+  return true;
+}
@@ -0,0 +1,153 @@
+/***************************************************************************
+    qgswkbgeometryview.h
+    --------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#include "qgsrectangle.h"
+#include "qgswkbtypes.h"
+
+class QgsPointV2;
+
+/** \ingroup core
+ * \class QgsWkbGeometryView
+ * \brief Read-only access to a geometry stored as WKB, without building a geometry object tree.
+ *
+ * The view does not copy or own the WKB. It checks on construction that the WKB is well
+ * formed and fits into the given size, so that reading it later never leaves the buffer.
+ * Type, vertex count, bounding box and the vertices themselves are read directly from the
+ * bytes. Curves are exposed as the points stored in the WKB, i.e. the bounding box of a
+ * circular string is the box of its control points, not of the arcs.
+ *
+ * The WKB must stay valid and unchanged as long as the view is used.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    //! Maximum depth of nested geometries accepted by the view
+    static const int MaxNesting = 8;
+
+    /** Iterates over the vertices of a view in the order in which they are stored */
+    class CORE_EXPORT VertexIterator
+    {
+      public:
+        explicit VertexIterator( const QgsWkbGeometryView& view );
+
+        /** Reads the next vertex.
+         * @returns false if there are no more vertices
+         */
+        bool next( QgsPointV2& point );
+
+        /** Returns the part of the current vertex. Single geometries have one part. */
+        int part() const { return mPart; }
+
+        /** Returns the ring of the current vertex, 0 for the exterior ring and for geometries without rings */
+        int ring() const { return mRing; }
+
+        /** Returns the index of the current vertex in its ring or part. Vertices of
+         * the curves of a compound curve are counted as one sequence.
+         */
+        int vertex() const { return mVertex; }
+
+      private:
+
+        //! what the remaining items of a nested geometry are
+        enum FrameKind
+        {
+          Parts, //!< parts of a top-level collection
+          Rings, //!< point sequences of a polygon
+          CurveRings, //!< curves of a curve polygon
+          Curves //!< curves of a compound curve or members of a nested collection
+        };
+
+        struct Frame
+        {
+          FrameKind kind;
+          unsigned int remaining;
+          bool swap;
+          QgsWKBTypes::Type type;
+        };
+
+        void enterGeometry();
+        void startPoints( QgsWKBTypes::Type type, bool swap, unsigned int count );
+        unsigned int readCount( bool swap );
+
+        const unsigned char* mP;
+        Frame mStack[MaxNesting];
+        int mDepth;
+
+        //! point sequence being read
+        unsigned int mPointsLeft;
+        QgsWKBTypes::Type mPointType;
+        bool mHasZ;
+        bool mHasM;
+        bool mSwap;
+
+        int mPart;
+        int mRing;
+        int mVertex;
+    };
+
+    //! Constructor for an invalid view
+    QgsWkbGeometryView();
+
+    /** Creates a view on WKB.
+     * @param wkb geometry in WKB format, in either byte order
+     * @param size size of the buffer. The geometry may be shorter than the buffer.
+     */
+    QgsWkbGeometryView( const unsigned char* wkb, int size );
+
+    /** Returns true if the WKB is a well formed geometry */
+    bool isValid() const { return mSize > 0; }
+
+    /** Returns the viewed WKB */
+    const unsigned char* wkb() const { return mWkb; }
+
+    /** Returns the size of the geometry in bytes, 0 for an invalid view */
+    int wkbSize() const { return mSize; }
+
+    /** Returns the type of the geometry */
+    QgsWKBTypes::Type wkbType() const { return mType; }
+
+    /** Returns true if the WKB is in the byte order of this machine */
+    bool isNativeByteOrder() const;
+
+    /** Returns true if the geometry contains circular strings */
+    bool hasCurvedSegments() const { return mCurved; }
+
+    /** Returns the number of parts, 1 for single geometries */
+    int partCount() const;
+
+    /** Returns the number of stored vertices */
+    int vertexCount() const { return mVertexCount; }
+
+    /** Returns the bounding box of the stored vertices */
+    QgsRectangle boundingBox() const;
+
+    /** Returns an iterator positioned before the first vertex */
+    VertexIterator vertices() const { return VertexIterator( *this ); }
+
+  private:
+
+    const unsigned char* mWkb;
+    int mSize;
+    QgsWKBTypes::Type mType;
+    bool mCurved;
+    int mVertexCount;
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
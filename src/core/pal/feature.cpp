@@ -1215,7 +1215,7 @@ namespace pal
 
   int FeaturePart::setPosition( QList< LabelPosition*>& lPos,
                                 double bbox_min[2], double bbox_max[2],
-                                PointSet *mapShape, RTree<LabelPosition*, double, 2, double> *candidates )
+                                PointSet *mapShape )
   {
     double bbox[4];
 
@@ -1285,10 +1285,6 @@ namespace pal
         i.remove();
         delete pos;
       }
-      else   // this one is OK
-      {
-        pos->insertIntoIndex( candidates );
-      }
     }
 
     qSort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
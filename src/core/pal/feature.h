@@ -149,10 +149,11 @@ namespace pal
        * \param bbox_min min values of the map extent
        * \param bbox_max max values of the map extent
        * \param mapShape generate candidates for this spatial entity
-       * \param candidates index for candidates
        * \return the number of candidates in *lPos
+       * \note candidates are not added to any index, so that several feature parts can be
+       * processed at the same time
        */
-      int setPosition( QList<LabelPosition *> &lPos, double bbox_min[2], double bbox_max[2], PointSet *mapShape, RTree<LabelPosition*, double, 2, double>*candidates );
+      int setPosition( QList<LabelPosition *> &lPos, double bbox_min[2], double bbox_max[2], PointSet *mapShape );
 
       /** Returns the unique ID of the feature.
        */
@@ -37,6 +37,7 @@
 #include "labelposition.h"
 #include "qgsgeos.h"
 #include "qgsmessagelog.h"
+#include <QVector>
 #include <iostream>
 #include <fstream>
 #include <cmath>
@@ -65,6 +66,7 @@ namespace pal
       , quadrant( quadrant )
       , mCost( cost )
       , mHasObstacleConflict( false )
+      , mPreviousPosition( false )
   {
     type = GEOS_POLYGON;
     nbPoints = 4;
@@ -188,6 +190,8 @@ namespace pal
     reversed = other.reversed;
     quadrant = other.quadrant;
     mHasObstacleConflict = other.mHasObstacleConflict;
+    mPreviousPosition = other.mPreviousPosition;
+    mConflicts = other.mConflicts;
   }
 
   bool LabelPosition::isIn( double *bbox )
@@ -264,6 +268,19 @@ namespace pal
       return isInConflictMultiPart( lp );
   }
 
+  void LabelPosition::createSharedGeosGeom() const
+  {
+    GEOSContextHandle_t geosctxt = geosContext();
+    for ( const LabelPosition* part = this; part; part = part->nextPart )
+    {
+      if ( !part->mGeos )
+        part->createGeosGeom();
+
+      // GEOS computes the envelope of a geometry on first use, which must not happen concurrently
+      GEOSGeom_destroy_r( geosctxt, GEOSEnvelope_r( geosctxt, part->mGeos ) );
+    }
+  }
+
   bool LabelPosition::isInConflictSinglePart( LabelPosition* lp )
   {
     if ( !mGeos )
@@ -439,6 +456,25 @@ namespace pal
   }
 
 
+  void LabelPosition::loadIndex( RTree<LabelPosition*, double, 2, double> *index, const QList<LabelPosition*>& positions )
+  {
+    QVector<double> mins;
+    QVector<double> maxs;
+    mins.reserve( 2 * positions.size() );
+    maxs.reserve( 2 * positions.size() );
+    Q_FOREACH ( LabelPosition* position, positions )
+    {
+      double amin[2];
+      double amax[2];
+      position->getBoundingBox( amin, amax );
+      mins << amin[0] << amin[1];
+      maxs << amax[0] << amax[1];
+    }
+    QVector<LabelPosition*> data = positions.toVector();
+    index->BulkLoad( mins.constData(), maxs.constData(), data.constData(), data.size() );
+  }
+
+
   //////////
 
   bool LabelPosition::pruneCallback( LabelPosition *lp, void *ctx )
@@ -470,6 +506,19 @@ namespace pal
     return true;
   }
 
+  bool LabelPosition::countConflictsCallback( LabelPosition *lp, void *ctx )
+  {
+    LabelPosition *lp2 = ( LabelPosition* ) ctx;
+
+    if ( lp2->isInConflict( lp ) )
+    {
+      lp2->nbOverlap++;
+      lp2->mConflicts.append( lp );
+    }
+
+    return true;
+  }
+
   bool LabelPosition::countFullOverlapCallback( LabelPosition *lp, void *ctx )
   {
     LabelPosition *lp2 = (( CountContext* ) ctx )->lp;
@@ -33,6 +33,7 @@
 #include "pointset.h"
 #include "rtree.hpp"
 #include <fstream>
+#include <QVector>
 
 namespace pal
 {
@@ -121,6 +122,12 @@ namespace pal
        */
       bool isInConflict( LabelPosition *ls );
 
+      /** Creates the GEOS geometries of the candidate and all its parts, so that
+       * other threads can test the candidate for conflicts afterwards.
+       * \note added in QGIS 2.12
+       */
+      void createSharedGeosGeom() const;
+
       /** Return bounding box - amin: xmin,ymin - amax: xmax,ymax */
       void getBoundingBox( double amin[2], double amax[2] ) const;
 
@@ -155,6 +162,12 @@ namespace pal
       double getNumOverlaps() const { return nbOverlap; }
       void resetNumOverlaps() { nbOverlap = 0; } // called from problem.cpp, pal.cpp
 
+      /** Returns the candidates of the problem which conflict with this one, as
+       * recorded by countConflictsCallback
+       * \note added in QGIS 2.12
+       */
+      const QVector<LabelPosition*>& conflicts() const { return mConflicts; }
+
       int getProblemFeatureId() const { return probFeat; }
       /** Set problem feature ID and assigned label candidate ID.
        *  called from pal.cpp during extraction */
@@ -187,6 +200,19 @@ namespace pal
        */
       bool conflictsWithObstacle() const { return mHasObstacleConflict; }
 
+      /** Sets whether the candidate is where the label of its feature was placed by a previous run.
+       * Such candidates are placed first when the initial solution is built.
+       * \note added in QGIS 2.12
+       * @see isPreviousPosition
+       */
+      void setPreviousPosition( bool previous ) { mPreviousPosition = previous; }
+
+      /** Returns whether the candidate is where the label was placed by a previous run.
+       * \note added in QGIS 2.12
+       * @see setPreviousPosition
+       */
+      bool isPreviousPosition() const { return mPreviousPosition; }
+
       /** Make sure the cost is less than 1 */
       void validateCost();
 
@@ -227,6 +253,12 @@ namespace pal
       void removeFromIndex( RTree<LabelPosition*, double, 2, double> *index );
       void insertIntoIndex( RTree<LabelPosition*, double, 2, double> *index );
 
+      /** Replaces the contents of an index by label positions, added all at once.
+       * The index only depends on the positions and their order.
+       * \note added in QGIS 2.12
+       */
+      static void loadIndex( RTree<LabelPosition*, double, 2, double> *index, const QList<LabelPosition*>& positions );
+
       typedef struct
       {
         Pal* pal;
@@ -255,6 +287,11 @@ namespace pal
        */
       static bool countOverlapCallback( LabelPosition *lp, void *ctx );
 
+      /*
+       * count overlap and record the conflicting candidate, ctx = p_lp
+       */
+      static bool countConflictsCallback( LabelPosition *lp, void *ctx );
+
       static bool countFullOverlapCallback( LabelPosition *lp, void *ctx );
 
       static bool removeOverlapCallback( LabelPosition *lp, void *ctx );
@@ -295,6 +332,8 @@ namespace pal
     private:
       double mCost;
       bool mHasObstacleConflict;
+      bool mPreviousPosition;
+      QVector<LabelPosition*> mConflicts;
 
       /** Calculates the total number of parts for this label position
        */
@@ -46,6 +46,7 @@
 #include "internalexception.h"
 #include "util.h"
 #include <QTime>
+#include <QtConcurrentMap>
 #include <cstdarg>
 #include <iostream>
 #include <fstream>
@@ -86,6 +87,9 @@ namespace pal
 
     showPartial = true;
 
+    mMultithreaded = true;
+    mPartitioned = true;
+
     std::cout.precision( 12 );
     std::cerr.precision( 12 );
 
@@ -134,11 +138,8 @@ namespace pal
   typedef struct _featCbackCtx
   {
     Layer *layer;
-    QLinkedList<Feats*>* fFeats;
+    QList<FeaturePart*>* featureParts;
     RTree<FeaturePart*, double, 2, double> *obstacles;
-    RTree<LabelPosition*, double, 2, double> *candidates;
-    double bbox_min[2];
-    double bbox_max[2];
   } FeatCallBackCtx;
 
 
@@ -189,26 +190,76 @@ namespace pal
       }
     }
 
-    // generate candidates for the feature part
-    QList< LabelPosition* > lPos;
-    if ( ft_ptr->setPosition( lPos, context->bbox_min, context->bbox_max, ft_ptr, context->candidates ) )
+    // candidates are generated for all extracted feature parts at once
+    context->featureParts->append( ft_ptr );
+
+    return true;
+  }
+
+  /*
+   * Generates the candidates of a feature part. Feature parts are independent from
+   * each other, so several of them are processed at the same time.
+   */
+  struct GenerateCandidates
+  {
+    typedef Feats* result_type;
+
+    GenerateCandidates( const double bboxMin[2], const double bboxMax[2] )
+    {
+      mBboxMin[0] = bboxMin[0];
+      mBboxMin[1] = bboxMin[1];
+      mBboxMax[0] = bboxMax[0];
+      mBboxMax[1] = bboxMax[1];
+    }
+
+    Feats* operator()( FeaturePart* featurePart ) const
     {
-      // valid features are added to fFeats
+      double bboxMin[2] = { mBboxMin[0], mBboxMin[1] };
+      double bboxMax[2] = { mBboxMax[0], mBboxMax[1] };
+
+      QList< LabelPosition* > lPos;
+      if ( !featurePart->setPosition( lPos, bboxMin, bboxMax, featurePart ) )
+      {
+        qDeleteAll( lPos );
+        return 0;
+      }
+
+      Q_FOREACH ( LabelPosition* lp, lPos )
+      {
+        lp->createSharedGeosGeom();
+      }
+
       Feats *ft = new Feats();
-      ft->feature = ft_ptr;
+      ft->feature = featurePart;
       ft->shape = NULL;
       ft->lPos = lPos;
-      ft->priority = ft_ptr->calculatePriority();
-      context->fFeats->append( ft );
+      ft->priority = featurePart->calculatePriority();
+      return ft;
     }
-    else
+
+    double mBboxMin[2];
+    double mBboxMax[2];
+  };
+
+  /*
+   * Counts the overlaps of a candidate and records the conflicting candidates. Only
+   * the candidate itself is modified, so the candidates are processed at the same time.
+   */
+  struct CountOverlaps
+  {
+    explicit CountOverlaps( RTree<LabelPosition*, double, 2, double> *candidates )
+        : mCandidates( candidates )
+    {}
+
+    void operator()( LabelPosition* lp ) const
     {
-      // Others are deleted
-      qDeleteAll( lPos );
+      double amin[2], amax[2];
+      lp->getBoundingBox( amin, amax );
+      mCandidates->Search( amin, amax, LabelPosition::countConflictsCallback, ( void* ) lp );
     }
 
-    return true;
-  }
+    RTree<LabelPosition*, double, 2, double> *mCandidates;
+  };
 
 
 
@@ -239,6 +290,44 @@ namespace pal
     return true;
   }
 
+  /*
+   * Marks the candidate of a feature part nearest to a label placed by a previous run.
+   * Candidates further away than half their size do not match, e.g. after the scale changed a lot.
+   */
+  static void markPreviousPosition( const Pal::PreviousPositions& previousPositions, Feats* feat )
+  {
+    QgsAbstractLabelProvider* provider = feat->feature->layer()->provider();
+    if ( !provider || feat->lPos.isEmpty() )
+      return;
+
+    Pal::PreviousPositions::const_iterator it = previousPositions.constFind( qMakePair( provider->layerId(), feat->feature->featureId() ) );
+    if ( it == previousPositions.constEnd() )
+      return;
+
+    LabelPosition* nearest = 0;
+    double nearestDist = DBL_MAX;
+    double amin[2], amax[2];
+    Q_FOREACH ( LabelPosition* lp, feat->lPos )
+    {
+      lp->getBoundingBox( amin, amax );
+      double x = ( amin[0] + amax[0] ) / 2.0;
+      double y = ( amin[1] + amax[1] ) / 2.0;
+      double tolerance = qMin( amax[0] - amin[0], amax[1] - amin[1] ) / 2.0;
+      Q_FOREACH ( const QgsRectangle& previous, it.value() )
+      {
+        double dist = sqrt( dist_euc2d_sq( x, y, previous.center().x(), previous.center().y() ) );
+        if ( dist <= tolerance && dist < nearestDist )
+        {
+          nearest = lp;
+          nearestDist = dist;
+        }
+      }
+    }
+
+    if ( nearest )
+      nearest->setPreviousPosition( true );
+  }
+
   Problem* Pal::extract( double lambda_min, double phi_min, double lambda_max, double phi_max )
   {
     // to store obstacles
@@ -267,21 +356,14 @@ namespace pal
 
     QLinkedList<Feats*> *fFeats = new QLinkedList<Feats*>;
 
+    QList<FeaturePart*> featureParts;
+
     FeatCallBackCtx *context = new FeatCallBackCtx();
-    context->fFeats = fFeats;
+    context->featureParts = &featureParts;
     context->obstacles = obstacles;
-    context->candidates = prob->candidates;
-
-    context->bbox_min[0] = amin[0];
-    context->bbox_min[1] = amin[1];
-
-    context->bbox_max[0] = amax[0];
-    context->bbox_max[1] = amax[1];
 
     // first step : extract features from layers
 
-    int previousFeatureCount = 0;
-
     QStringList layersWithFeaturesInBBox;
 
     mMutex.lock();
@@ -308,16 +390,47 @@ namespace pal
       context->layer->mMutex.lock();
       context->layer->rtree->Search( amin, amax, extractFeatCallback, ( void* ) context );
       context->layer->mMutex.unlock();
+    }
+    delete context;
 
-      if ( context->fFeats->size() - previousFeatureCount > 0 )
+    // generate candidates of all feature parts, in parallel but kept in extraction order
+    QList<Feats*> generatedFeats;
+    GenerateCandidates generateCandidates( amin, amax );
+    if ( mMultithreaded )
+    {
+      generatedFeats = QtConcurrent::blockingMapped<QList<Feats*> >( featureParts, generateCandidates );
+    }
+    else
+    {
+      Q_FOREACH ( FeaturePart* featurePart, featureParts )
       {
-        layersWithFeaturesInBBox << layer->name();
+        generatedFeats << generateCandidates( featurePart );
       }
-      previousFeatureCount = context->fFeats->size();
     }
-    delete context;
     mMutex.unlock();
 
+    Layer* previousLayer = 0;
+    Q_FOREACH ( Feats* feat, generatedFeats )
+    {
+      if ( !feat )
+        continue;
+
+      fFeats->append( feat );
+      if ( feat->feature->layer() != previousLayer )
+      {
+        previousLayer = feat->feature->layer();
+        layersWithFeaturesInBBox << previousLayer->name();
+      }
+    }
+
+    // index all candidates at once, the tree only depends on the order of the candidates
+    QList<LabelPosition*> allCandidates;
+    Q_FOREACH ( Feats* feat, *fFeats )
+    {
+      allCandidates.append( feat->lPos );
+    }
+    LabelPosition::loadIndex( prob->candidates, allCandidates );
+
     prob->nbLabelledLayers = layersWithFeaturesInBBox.size();
     prob->labelledLayersName = layersWithFeaturesInBBox;
 
@@ -399,6 +512,9 @@ namespace pal
         delete feat->lPos.takeLast();
       }
 
+      if ( !mPreviousPositions.isEmpty() )
+        markPreviousPosition( mPreviousPositions, feat );
+
       // update problem's # candidate
       prob->featNbLp[i] = feat->lPos.count();
       prob->nblp += feat->lPos.count();
@@ -413,25 +529,24 @@ namespace pal
       fFeats->append( feat );
     }
 
-    int nbOverlaps = 0;
-
-    while ( fFeats->size() > 0 ) // foreach feature
+    if ( isCancelled() )
     {
-      if ( isCancelled() )
+      Q_FOREACH ( Feats* feat, *fFeats )
       {
-        Q_FOREACH ( Feats* feat, *fFeats )
-        {
-          qDeleteAll( feat->lPos );
-          feat->lPos.clear();
-        }
-
-        qDeleteAll( *fFeats );
-        delete fFeats;
-        delete prob;
-        delete obstacles;
-        return 0;
+        qDeleteAll( feat->lPos );
+        feat->lPos.clear();
       }
 
+      qDeleteAll( *fFeats );
+      delete fFeats;
+      delete prob;
+      delete obstacles;
+      return 0;
+    }
+
+    QList<LabelPosition*> problemCandidates;
+    while ( fFeats->size() > 0 ) // foreach feature
+    {
       feat = fFeats->takeFirst();
       while ( !feat->lPos.isEmpty() ) // foreach label candidate
       {
@@ -443,18 +558,32 @@ namespace pal
 
         prob->addCandidatePosition( lp );
         //prob->feat[idlp] = j;
-
-        lp->getBoundingBox( amin, amax );
-
-        // lookup for overlapping candidate
-        prob->candidates->Search( amin, amax, LabelPosition::countOverlapCallback, ( void* ) lp );
-
-        nbOverlaps += lp->getNumOverlaps();
+        problemCandidates << lp;
       }
       delete feat;
     }
     delete fFeats;
 
+    // lookup for overlapping candidates
+    CountOverlaps countOverlaps( prob->candidates );
+    if ( mMultithreaded )
+    {
+      QtConcurrent::blockingMap( problemCandidates, countOverlaps );
+    }
+    else
+    {
+      Q_FOREACH ( LabelPosition* candidate, problemCandidates )
+      {
+        countOverlaps( candidate );
+      }
+    }
+
+    int nbOverlaps = 0;
+    Q_FOREACH ( LabelPosition* candidate, problemCandidates )
+    {
+      nbOverlaps += candidate->getNumOverlaps();
+    }
+
     //delete candidates;
     delete obstacles;
 
@@ -533,12 +662,7 @@ namespace pal
 #endif
 
     // search a solution
-    if ( searchMethod == FALP )
-      prob->init_sol_falp();
-    else if ( searchMethod == CHAIN )
-      prob->chain_search();
-    else
-      prob->popmusic();
+    prob->solve();
 
     std::cout << "PAL SEARCH (" << searchMethod << "): " << t.elapsed() / 1000.0 << " s" << std::endl;
     t.restart();
@@ -589,12 +713,7 @@ namespace pal
 
     try
     {
-      if ( searchMethod == FALP )
-        prob->init_sol_falp();
-      else if ( searchMethod == CHAIN )
-        prob->chain_search();
-      else
-        prob->popmusic();
+      prob->solve();
     }
     catch ( InternalException::Empty )
     {
@@ -31,7 +31,10 @@
 #define _PAL_H
 
 #include "qgsgeometry.h"
+#include "qgsfeature.h"
+#include <QHash>
 #include <QList>
+#include <QPair>
 #include <iostream>
 #include <ctime>
 #include <QMutex>
@@ -174,6 +177,17 @@ namespace pal
 
       std::list<LabelPosition*>* solveProblem( Problem* prob, bool displayAll );
 
+      //! Bounding boxes of labels placed by a previous run, by layer ID of the provider and feature ID
+      typedef QHash< QPair<QString, QgsFeatureId>, QList<QgsRectangle> > PreviousPositions;
+
+      /** Sets the labels placed by a previous run in the same coordinates, to keep the labels stable.
+       * The candidate of a feature nearest to one of its previous labels is placed first when the
+       * initial solution is built, so labels keep their positions unless they collide with each other.
+       * The candidates themselves are generated again.
+       * \note added in QGIS 2.12
+       */
+      void setPreviousPositions( const PreviousPositions& positions ) { mPreviousPositions = positions; }
+
       /**
        *\brief Set flag show partial label
        *
@@ -188,6 +202,29 @@ namespace pal
        */
       bool getShowPartial();
 
+      /** Sets whether the candidates are generated and their conflicts counted by
+       * several threads. Both ways build the same problem.
+       * \note added in QGIS 2.12
+       */
+      void setMultithreaded( bool enabled ) { mMultithreaded = enabled; }
+
+      /** Returns whether the candidates are generated by several threads
+       * \note added in QGIS 2.12
+       */
+      bool isMultithreaded() const { return mMultithreaded; }
+
+      /** Sets whether large problems are split into independent parts, which are
+       * searched separately. The parts are searched by several threads if the pal
+       * is multithreaded.
+       * \note added in QGIS 2.12
+       */
+      void setPartitioned( bool enabled ) { mPartitioned = enabled; }
+
+      /** Returns whether large problems are split into independent parts
+       * \note added in QGIS 2.12
+       */
+      bool isPartitioned() const { return mPartitioned; }
+
       /**
        * \brief set # candidates to generate for points features
        * Higher the value is, longer Pal::labeller will spend time
@@ -248,6 +285,12 @@ namespace pal
 
       QHash< QgsAbstractLabelProvider*, Layer* > mLayers;
 
+      PreviousPositions mPreviousPositions;
+
+      bool mMultithreaded;
+
+      bool mPartitioned;
+
       QMutex mMutex;
 
       /**
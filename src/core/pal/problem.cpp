@@ -46,6 +46,8 @@
 #include <ctime>
 #include <list>
 #include <limits.h> //for INT_MAX
+#include <QMap>
+#include <QtConcurrentMap>
 
 namespace pal
 {
@@ -339,6 +341,15 @@ namespace pal
         }
       }
 
+    // labels placed by a previous run go first, as long as nothing placed before collides with them
+    QList<int> previousLabels;
+    for ( i = 0; i < nbft; i++ )
+      for ( j = 0; j < featNbLp[i]; j++ )
+      {
+        if ( mLabelPositions.at( featStartId[i] + j )->isPreviousPosition() )
+          previousLabels << featStartId[i] + j;
+      }
+
     while ( list->getSize() > 0 ) // O (log size)
     {
       if ( pal->isCancelled() )
@@ -348,7 +359,18 @@ namespace pal
         return;
       }
 
-      label = list->getBest();   // O (log size)
+      label = -1;
+      while ( label == -1 && !previousLabels.isEmpty() )
+      {
+        int previousLabel = previousLabels.takeFirst();
+        if ( list->isIn( previousLabel ) )
+        {
+          label = previousLabel;
+          list->remove( label );
+        }
+      }
+      if ( label == -1 )
+        label = list->getBest();   // O (log size)
 
 
       lp = mLabelPositions.at( label );
@@ -2611,6 +2633,205 @@ namespace pal
     return;
   }
 
+  // maximum number of features of independent components solved together as one part
+  static const int PART_SIZE = 256;
+
+  static int componentRoot( QVector<int>& parents, int feature )
+  {
+    while ( parents[feature] != feature )
+    {
+      parents[feature] = parents[parents[feature]];
+      feature = parents[feature];
+    }
+    return feature;
+  }
+
+  void Problem::solve()
+  {
+    if ( !pal->isPartitioned() || nbft <= PART_SIZE )
+    {
+      search();
+      return;
+    }
+
+    // connected components of the conflict graph, candidates removed by reduce() are left out
+    QVector<int> parents( nbft );
+    for ( int i = 0; i < nbft; i++ )
+      parents[i] = i;
+
+    for ( int i = 0; i < nbft; i++ )
+    {
+      for ( int j = 0; j < featNbLp[i]; j++ )
+      {
+        Q_FOREACH ( LabelPosition* lp, mLabelPositions.at( featStartId[i] + j )->conflicts() )
+        {
+          int feature = lp->getProblemFeatureId();
+          if ( lp->getId() - featStartId[feature] >= featNbLp[feature] )
+            continue;
+
+          int root1 = componentRoot( parents, i );
+          int root2 = componentRoot( parents, feature );
+          parents[qMax( root1, root2 )] = qMin( root1, root2 );
+        }
+      }
+    }
+
+    QMap<int, int> rootComponent;
+    QList< QVector<int> > components;
+    for ( int i = 0; i < nbft; i++ )
+    {
+      int root = componentRoot( parents, i );
+      if ( !rootComponent.contains( root ) )
+      {
+        rootComponent.insert( root, components.size() );
+        components << QVector<int>();
+      }
+      components[rootComponent[root]] << i;
+    }
+
+    if ( components.size() == 1 )
+    {
+      search();
+      return;
+    }
+
+    // small components are grouped in order of their first feature. Parts do not depend on
+    // the number of threads, so the solution does not either
+    QList< QVector<int> > partFeatures;
+    Q_FOREACH ( const QVector<int>& component, components )
+    {
+      if ( partFeatures.isEmpty() || partFeatures.last().size() + component.size() > PART_SIZE )
+        partFeatures << component;
+      else
+        partFeatures.last() << component;
+    }
+
+    QList<Problem*> parts;
+    QList< QVector<int> > partLabels;
+    for ( int i = 0; i < partFeatures.size(); i++ )
+    {
+      qSort( partFeatures[i] );
+      partLabels << QVector<int>();
+      parts << independentPart( partFeatures[i], partLabels[i] );
+    }
+
+    QList<bool> searched;
+    if ( pal->isMultithreaded() )
+    {
+      searched = QtConcurrent::blockingMapped< QList<bool> >( parts, searchPart );
+    }
+    else
+    {
+      Q_FOREACH ( Problem* part, parts )
+      {
+        searched << searchPart( part );
+      }
+    }
+
+    // merge the solutions of the parts, the candidates get their ids in this problem back
+    init_sol_empty();
+    sol->cost = 0.0;
+    nbActive = 0;
+    bool complete = true;
+    for ( int i = 0; i < parts.size(); i++ )
+    {
+      Problem *part = parts[i];
+      const QVector<int>& features = partFeatures[i];
+      const QVector<int>& labels = partLabels[i];
+
+      if ( searched[i] )
+      {
+        for ( int j = 0; j < part->nbft; j++ )
+        {
+          if ( part->sol->s[j] >= 0 )
+          {
+            sol->s[features[j]] = labels[part->sol->s[j]];
+            mLabelPositions.at( sol->s[features[j]] )->insertIntoIndex( candidates_sol );
+          }
+        }
+        sol->cost += part->sol->cost;
+        nbActive += part->nbActive;
+      }
+      else
+      {
+        complete = false;
+      }
+
+      for ( int j = 0; j < part->mLabelPositions.size(); j++ )
+      {
+        LabelPosition *lp = part->mLabelPositions.at( j );
+        lp->setProblemIds( features[lp->getProblemFeatureId()], labels[j] );
+      }
+
+      // the candidates are owned by this problem
+      part->mLabelPositions.clear();
+      delete part;
+    }
+
+    if ( !complete )
+      throw InternalException::Empty();
+  }
+
+  void Problem::search()
+  {
+    SearchMethod searchMethod = pal->searchMethod;
+    if ( searchMethod == FALP )
+      init_sol_falp();
+    else if ( searchMethod == CHAIN )
+      chain_search();
+    else
+      popmusic();
+  }
+
+  bool Problem::searchPart( Problem *part )
+  {
+    try
+    {
+      part->search();
+    }
+    catch ( InternalException::Empty )
+    {
+      return false;
+    }
+    return true;
+  }
+
+  Problem* Problem::independentPart( const QVector<int>& features, QVector<int>& labels )
+  {
+    Problem *part = new Problem();
+    part->pal = pal;
+    part->displayAll = displayAll;
+    for ( int i = 0; i < 4; i++ )
+      part->bbox[i] = bbox[i];
+
+    part->nbft = features.size();
+    part->featStartId = new int[part->nbft];
+    part->featNbLp = new int[part->nbft];
+    part->inactiveCost = new double[part->nbft];
+
+    for ( int i = 0; i < part->nbft; i++ )
+    {
+      int feature = features[i];
+      part->featStartId[i] = labels.size();
+      part->featNbLp[i] = featNbLp[feature];
+      part->inactiveCost[i] = inactiveCost[feature];
+
+      // candidates removed by reduce() are left out
+      for ( int j = 0; j < featNbLp[feature]; j++ )
+      {
+        LabelPosition *lp = mLabelPositions.at( featStartId[feature] + j );
+        lp->setProblemIds( i, labels.size() );
+        part->mLabelPositions.append( lp );
+        labels << featStartId[feature] + j;
+      }
+    }
+
+    part->nblp = labels.size();
+    part->all_nblp = labels.size();
+    LabelPosition::loadIndex( part->candidates, part->mLabelPositions );
+    return part;
+  }
+
   bool Problem::compareLabelArea( pal::LabelPosition* l1, pal::LabelPosition* l2 )
   {
     return l1->getWidth() * l1->getHeight() > l2->getWidth() * l2->getHeight();
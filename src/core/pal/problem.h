@@ -34,6 +34,7 @@
 #include "rtree.hpp"
 #include <list>
 #include <QList>
+#include <QVector>
 
 namespace pal
 {
@@ -130,6 +131,13 @@ namespace pal
        */
       void chain_search();
 
+      /** Searches a solution with the search method of pal. Large problems are split into
+       * independent parts if pal is partitioned, which are solved at the same time if pal is
+       * multithreaded. No candidate of a part conflicts with a candidate of another part.
+       * \note added in QGIS 2.12
+       */
+      void solve();
+
       std::list<LabelPosition*> * getSolution( bool returnInactive );
 
       PalStat * getStats();
@@ -230,6 +238,17 @@ namespace pal
 
       Pal *pal;
 
+      //! Searches a solution of the whole problem with the search method of pal
+      void search();
+
+      /** Creates a problem of some features. The candidates of the features get the ids
+       * of the part, the ids of the candidates in this problem are appended to labels.
+       */
+      Problem* independentPart( const QVector<int>& features, QVector<int>& labels );
+
+      //! Searches a solution of a part, returns false if the search failed
+      static bool searchPart( Problem* part );
+
       void solution_cost();
       void check_solution();
   };
@@ -27,6 +27,8 @@
 #include <cmath>
 #include <cassert>
 #include <cstdlib>
+#include <algorithm>
+#include <vector>
 #include <QtGlobal>
 
 #define ASSERT assert // RTree uses ASSERT( condition )
@@ -109,6 +111,15 @@ namespace pal
       /// \return Returns the number of entries found
       int Search( const ELEMTYPE a_min[NUMDIMS], const ELEMTYPE a_max[NUMDIMS], bool a_resultCallback( DATATYPE a_data, void* a_context ), void* a_context );
 
+      /// Replace all entries of the tree, packing the nodes with the sort-tile-recursive algorithm.
+      /// Much faster than inserting the entries one by one, and the nodes overlap less.
+      /// The resulting tree only depends on the entries and their order.
+      /// \param a_min Min of the bounding rects, NUMDIMS values per entry
+      /// \param a_max Max of the bounding rects, NUMDIMS values per entry
+      /// \param a_dataIds Ids of the data
+      /// \param a_count Number of entries
+      void BulkLoad( const ELEMTYPE* a_min, const ELEMTYPE* a_max, const DATATYPE* a_dataIds, int a_count );
+
       /// Remove all entries from tree
       void RemoveAll();
 
@@ -295,6 +306,18 @@ namespace pal
         Branch m_branch[MAXNODES];                    ///< Branch
       };
 
+      /// Orders branches by the center of their rect along an axis
+      struct BranchCenterLess
+      {
+        int m_axis;
+
+        bool operator()( const Branch& a_branchA, const Branch& a_branchB ) const
+        {
+          return a_branchA.m_rect.m_min[m_axis] + a_branchA.m_rect.m_max[m_axis]
+                 < a_branchB.m_rect.m_min[m_axis] + a_branchB.m_rect.m_max[m_axis];
+        }
+      };
+
       /// A link list of nodes for reinsertion after a delete operation
       struct ListNode
       {
@@ -348,6 +371,7 @@ namespace pal
       void ReInsert( Node* a_node, ListNode** a_listNode );
       bool Search( Node* a_node, Rect* a_rect, int& a_foundCount, bool a_resultCallback( DATATYPE a_data, void* a_context ), void* a_context );
       void RemoveAllRec( Node* a_node );
+      void SortTile( Branch* a_branches, int a_count, int a_axis );
       void Reset();
       void CountRec( Node* a_node, int& a_count );
 
@@ -761,6 +785,79 @@ namespace pal
   }
 
 
+  RTREE_TEMPLATE
+  void RTREE_QUAL::BulkLoad( const ELEMTYPE* a_min, const ELEMTYPE* a_max, const DATATYPE* a_dataIds, int a_count )
+  {
+    RemoveAll();
+    if ( a_count <= 0 )
+      return;
+
+    std::vector<Branch> branches( a_count );
+    for ( int index = 0; index < a_count; ++index )
+    {
+      for ( int axis = 0; axis < NUMDIMS; ++axis )
+      {
+        branches[index].m_rect.m_min[axis] = a_min[index * NUMDIMS + axis];
+        branches[index].m_rect.m_max[axis] = a_max[index * NUMDIMS + axis];
+      }
+      branches[index].m_data = a_dataIds[index];
+    }
+
+    // pack the branches of a level into full nodes, which become the branches of the level above
+    for ( int level = 0; ; ++level )
+    {
+      SortTile( &branches[0], ( int )branches.size(), 0 );
+
+      std::vector<Branch> parents;
+      parents.reserve( branches.size() / MAXNODES + 1 );
+      for ( int first = 0; first < ( int )branches.size(); first += MAXNODES )
+      {
+        Node* node = AllocNode();
+        node->m_level = level;
+        node->m_count = qMin( ( int )MAXNODES, ( int )branches.size() - first );
+        for ( int index = 0; index < node->m_count; ++index )
+        {
+          node->m_branch[index] = branches[first + index];
+        }
+
+        Branch parent;
+        parent.m_rect = NodeCover( node );
+        parent.m_child = node;
+        parents.push_back( parent );
+      }
+
+      if ( parents.size() == 1 )
+      {
+        FreeNode( m_root );
+        m_root = parents[0].m_child;
+        return;
+      }
+      branches.swap( parents );
+    }
+  }
+
+
+  // Sort branches into tiles: slices along the first axis, each sorted along the remaining axes
+  RTREE_TEMPLATE
+  void RTREE_QUAL::SortTile( Branch* a_branches, int a_count, int a_axis )
+  {
+    BranchCenterLess less;
+    less.m_axis = a_axis;
+    std::stable_sort( a_branches, a_branches + a_count, less );
+
+    if ( a_axis == NUMDIMS - 1 )
+      return;
+
+    int nodeCount = ( a_count + MAXNODES - 1 ) / MAXNODES;
+    int sliceCount = ( int )ceil( pow(( double )nodeCount, 1.0 / ( NUMDIMS - a_axis ) ) );
+    int sliceSize = (( nodeCount + sliceCount - 1 ) / sliceCount ) * MAXNODES;
+    for ( int first = 0; first < a_count; first += sliceSize )
+    {
+      SortTile( a_branches + first, qMin( sliceSize, a_count - first ), a_axis + 1 );
+    }
+  }
+
+
   RTREE_TEMPLATE
   void RTREE_QUAL::RemoveAll()
   {
@@ -22,6 +22,7 @@
 #include "qgis.h"
 #include "qgspoint.h"
 #include "qgsrectangle.h"
+#include "qgsrenderarena.h"
 
 #include <QVector>
 #include <QPolygonF>
@@ -177,7 +178,8 @@ inline void QgsClipper::trimFeature( QVector<double>& x,
 
 inline void QgsClipper::trimPolygon( QPolygonF& pts, const QgsRectangle& clipRect )
 {
-  QPolygonF tmpPts;
+  QgsRenderArena* arena = QgsRenderArena::instance();
+  QPolygonF tmpPts = arena->takePolygon();
   tmpPts.reserve( pts.size() );
 
   trimPolygonToBoundary( pts, tmpPts, clipRect, XMax, clipRect.xMaximum() );
@@ -187,6 +189,7 @@ inline void QgsClipper::trimPolygon( QPolygonF& pts, const QgsRectangle& clipRec
   trimPolygonToBoundary( pts, tmpPts, clipRect, XMin, clipRect.xMinimum() );
   pts.resize( 0 );
   trimPolygonToBoundary( tmpPts, pts, clipRect, YMin, clipRect.yMinimum() );
+  arena->recyclePolygon( tmpPts );
 }
 
 // An auxilary function that is part of the polygon trimming
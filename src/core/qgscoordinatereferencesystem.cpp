@@ -35,6 +35,7 @@
 #include "qgsmessagelog.h"
 #include "qgis.h" //const vals declared here
 #include "qgslocalec.h"
+#include "qgssrsdbindex.h"
 
 #include <sqlite3.h>
 #include <proj_api.h>
@@ -224,7 +225,7 @@ bool QgsCoordinateReferenceSystem::createFromOgcWmsCrs( QString theCrs )
     }
   }
 
-  if ( loadFromDb( QgsApplication::srsDbFilePath(), "lower(auth_name||':'||auth_id)", theCrs.toLower() ) )
+  if ( loadFromSrsDb( QgsSrsDbIndex::AuthId, theCrs, "lower(auth_name||':'||auth_id)" ) )
     return true;
 
   // NAD27
@@ -308,14 +309,46 @@ void QgsCoordinateReferenceSystem::validate()
 
 bool QgsCoordinateReferenceSystem::createFromSrid( long id )
 {
-  return loadFromDb( QgsApplication::srsDbFilePath(), "srid", QString::number( id ) );
+  return loadFromSrsDb( QgsSrsDbIndex::Srid, QString::number( id ), "srid" );
 }
 
 bool QgsCoordinateReferenceSystem::createFromSrsId( long id )
 {
-  return loadFromDb( id < USER_CRS_START_ID ? QgsApplication::srsDbFilePath() :
-                     QgsApplication::qgisUserDbFilePath(),
-                     "srs_id", QString::number( id ) );
+  if ( id < USER_CRS_START_ID )
+    return loadFromSrsDb( QgsSrsDbIndex::SrsId, QString::number( id ), "srs_id" );
+
+  return loadFromDb( QgsApplication::qgisUserDbFilePath(), "srs_id", QString::number( id ) );
+}
+
+bool QgsCoordinateReferenceSystem::loadFromSrsDb( QgsSrsDbIndex::Key key, const QString& value, const QString& expression )
+{
+  const QgsSrsDbIndex* index = QgsSrsDbIndex::instance();
+  if ( !index->isValid() )
+  {
+    return loadFromDb( QgsApplication::srsDbFilePath(), expression, key == QgsSrsDbIndex::AuthId ? value.toLower() : value );
+  }
+
+  QgsDebugMsgLevel( "load CRS from srs.db index where " + expression + " is " + value, 3 );
+  mIsValidFlag = false;
+  mWkt.clear();
+
+  QgsSrsDbIndex::Record record;
+  if ( !index->find( key, value, record ) )
+  {
+    QgsDebugMsg( "failed : no " + expression + " " + value + " in srs.db index" );
+    return mIsValidFlag;
+  }
+
+  mSrsId = record.srsId;
+  mDescription = record.description;
+  mProjectionAcronym = record.projectionAcronym;
+  mEllipsoidAcronym = record.ellipsoidAcronym;
+  mProj4 = record.parameters;
+  mSRID = record.srid;
+  mAuthId = record.authId;
+  mGeoFlag = record.geographic;
+  initialiseFromRecord();
+  return mIsValidFlag;
 }
 
 bool QgsCoordinateReferenceSystem::loadFromDb( QString db, QString expression, QString value )
@@ -374,24 +407,7 @@ bool QgsCoordinateReferenceSystem::loadFromDb( QString db, QString expression, Q
     mSRID = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 5 ) ).toLong();
     mAuthId = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 6 ) );
     mGeoFlag = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 7 ) ).toInt() != 0;
-    mAxisInverted = -1;
-
-    if ( mSrsId >= USER_CRS_START_ID && mAuthId.isEmpty() )
-    {
-      mAuthId = QString( "USER:%1" ).arg( mSrsId );
-    }
-    else if ( mAuthId.startsWith( "EPSG:", Qt::CaseInsensitive ) )
-    {
-      OSRDestroySpatialReference( mCRS );
-      mCRS = OSRNewSpatialReference( NULL );
-      mIsValidFlag = OSRSetFromUserInput( mCRS, mAuthId.toLower().toAscii() ) == OGRERR_NONE;
-      setMapUnits();
-    }
-
-    if ( !mIsValidFlag )
-    {
-      setProj4String( mProj4 );
-    }
+    initialiseFromRecord();
   }
   else
   {
@@ -402,6 +418,28 @@ bool QgsCoordinateReferenceSystem::loadFromDb( QString db, QString expression, Q
   return mIsValidFlag;
 }
 
+void QgsCoordinateReferenceSystem::initialiseFromRecord()
+{
+  mAxisInverted = -1;
+
+  if ( mSrsId >= USER_CRS_START_ID && mAuthId.isEmpty() )
+  {
+    mAuthId = QString( "USER:%1" ).arg( mSrsId );
+  }
+  else if ( mAuthId.startsWith( "EPSG:", Qt::CaseInsensitive ) )
+  {
+    OSRDestroySpatialReference( mCRS );
+    mCRS = OSRNewSpatialReference( NULL );
+    mIsValidFlag = OSRSetFromUserInput( mCRS, mAuthId.toLower().toAscii() ) == OGRERR_NONE;
+    setMapUnits();
+  }
+
+  if ( !mIsValidFlag )
+  {
+    setProj4String( mProj4 );
+  }
+}
+
 bool QgsCoordinateReferenceSystem::axisInverted() const
 {
   if ( mAxisInverted == -1 )
@@ -568,7 +606,8 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
    * - if the above does not match perform a whole text search on proj4 string (if not null)
    */
   // QgsDebugMsg( "wholetext match on name failed, trying proj4string match" );
-  myRecord = getRecord( "select * from tbl_srs where parameters=" + quotedValue( myProj4String ) + " order by deprecated" );
+  myRecord = getRecord( "select * from tbl_srs where parameters=" + quotedValue( myProj4String ) + " order by deprecated",
+                        QgsSrsDbIndex::Parameters, myProj4String );
   if ( myRecord.empty() )
   {
     // Ticket #722 - aaronr
@@ -603,7 +642,8 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
       myStart2 = myLat2RegExp.indexIn( theProj4String, myStart2 );
       theProj4StringModified.replace( myStart2 + LAT_PREFIX_LEN, myLength2 - LAT_PREFIX_LEN, lat1Str );
       QgsDebugMsg( "trying proj4string match with swapped lat_1,lat_2" );
-      myRecord = getRecord( "select * from tbl_srs where parameters=" + quotedValue( theProj4StringModified.trimmed() ) + " order by deprecated" );
+      myRecord = getRecord( "select * from tbl_srs where parameters=" + quotedValue( theProj4StringModified.trimmed() ) + " order by deprecated",
+                            QgsSrsDbIndex::Parameters, theProj4StringModified.trimmed() );
     }
   }
 
@@ -617,6 +657,7 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
     QString sql = "SELECT * FROM tbl_srs WHERE ";
     QString delim = "";
     QString datum;
+    QString datumParam;
 
     // split on spaces followed by a plus sign (+) to deal
     // also with parameters containing spaces (e.g. +nadgrids)
@@ -628,6 +669,7 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
       if ( param.startsWith( "+datum=" ) )
       {
         datum = arg;
+        datumParam = param.trimmed();
       }
       else
       {
@@ -639,13 +681,13 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
 
     if ( !datum.isEmpty() )
     {
-      myRecord = getRecord( sql + delim + datum + " order by deprecated" );
+      myRecord = getRecord( sql + delim + datum + " order by deprecated", QgsSrsDbIndex::ParameterSet, myProj4String, datumParam );
     }
 
     if ( myRecord.empty() )
     {
       // datum might have disappeared in definition - retry without it
-      myRecord = getRecord( sql + " order by deprecated" );
+      myRecord = getRecord( sql + " order by deprecated", QgsSrsDbIndex::ParameterSet, myProj4String );
     }
 
     if ( !myRecord.empty() )
@@ -708,7 +750,86 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
 //private method meant for internal use by this class only
 QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecord( QString theSql )
 {
-  QString myDatabaseFileName;
+  QgsDebugMsg( "running query: " + theSql );
+  // Get the full path name to the sqlite3 spatial reference database.
+  QString myDatabaseFileName = QgsApplication::srsDbFilePath();
+  QFileInfo myInfo( myDatabaseFileName );
+  if ( !myInfo.exists() )
+  {
+    QgsDebugMsg( "failed : " + myDatabaseFileName + " does not exist!" );
+    return RecordMap();
+  }
+
+  QgsDebugMsg( "trying system srs.db" );
+  RecordMap myMap = getRecordFromDb( myDatabaseFileName, theSql );
+  if ( myMap.empty() )
+  {
+    QgsDebugMsg( "trying user qgis.db" );
+    myMap = getRecordFromDb( QgsApplication::qgisUserDbFilePath(), theSql );
+  }
+
+#ifdef QGISDEBUG
+  QgsDebugMsg( "retrieved:  " + theSql );
+  RecordMap::Iterator it;
+  for ( it = myMap.begin(); it != myMap.end(); ++it )
+  {
+    QgsDebugMsgLevel( it.key() + " => " + it.value(), 2 );
+  }
+#endif
+
+  return myMap;
+}
+
+QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecord( QString theSql, QgsSrsDbIndex::Key key, const QString& value, const QString& requiredParam )
+{
+  const QgsSrsDbIndex* index = QgsSrsDbIndex::instance();
+  if ( !index->isValid() )
+  {
+    return getRecord( theSql );
+  }
+
+  QList<QgsSrsDbIndex::Record> records;
+  Q_FOREACH ( const QgsSrsDbIndex::Record& record, index->records( key, value ) )
+  {
+    if ( requiredParam.isEmpty() || ( " " + record.parameters + " " ).contains( " " + requiredParam + " " ) )
+      records << record;
+  }
+
+  RecordMap myMap;
+  if ( records.size() == 1 )
+  {
+    const QgsSrsDbIndex::Record& record = records.first();
+    myMap["srs_id"] = QString::number( record.srsId );
+    myMap["description"] = record.description;
+    myMap["projection_acronym"] = record.projectionAcronym;
+    myMap["ellipsoid_acronym"] = record.ellipsoidAcronym;
+    myMap["parameters"] = record.parameters;
+    myMap["srid"] = QString::number( record.srid );
+    myMap["auth_name"] = record.authId.section( ':', 0, 0 );
+    myMap["auth_id"] = record.authId.section( ':', 1 );
+    myMap["is_geo"] = record.geographic ? "1" : "0";
+    myMap["deprecated"] = record.deprecated ? "1" : "0";
+  }
+  else if ( records.isEmpty() && key == QgsSrsDbIndex::ParameterSet )
+  {
+    // the index only has definitions with the same set of parameters, while the query
+    // also finds definitions with more parameters (like +towgs84 in GDAL)
+    QgsDebugMsg( "no parameter set match in srs.db index, querying srs.db" );
+    return getRecord( theSql );
+  }
+  else
+  {
+    if ( records.size() > 1 )
+      QgsDebugMsg( "Multiple records found in srs.db index" );
+
+    QgsDebugMsg( "trying user qgis.db" );
+    myMap = getRecordFromDb( QgsApplication::qgisUserDbFilePath(), theSql );
+  }
+  return myMap;
+}
+
+QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecordFromDb( const QString& db, const QString& theSql )
+{
   QgsCoordinateReferenceSystem::RecordMap myMap;
   QString myFieldName;
   QString myFieldValue;
@@ -717,18 +838,15 @@ QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecord(
   sqlite3_stmt *myPreparedStatement;
   int           myResult;
 
-  QgsDebugMsg( "running query: " + theSql );
-  // Get the full path name to the sqlite3 spatial reference database.
-  myDatabaseFileName = QgsApplication::srsDbFilePath();
-  QFileInfo myInfo( myDatabaseFileName );
-  if ( !myInfo.exists() )
+  QFileInfo myFileInfo( db );
+  if ( !myFileInfo.exists() )
   {
-    QgsDebugMsg( "failed : " + myDatabaseFileName + " does not exist!" );
+    QgsDebugMsg( db + " not found" );
     return myMap;
   }
 
   //check the db is available
-  myResult = openDb( myDatabaseFileName, &myDatabase );
+  myResult = openDb( db, &myDatabase );
   if ( myResult != SQLITE_OK )
   {
     return myMap;
@@ -738,18 +856,18 @@ QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecord(
   // XXX Need to free memory from the error msg if one is set
   if ( myResult == SQLITE_OK && sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
   {
-    QgsDebugMsg( "trying system srs.db" );
     int myColumnCount = sqlite3_column_count( myPreparedStatement );
-    //loop through each column in the record adding its expression name and value to the map
+    //loop through each column in the record adding its field name and value to the map
     for ( int myColNo = 0; myColNo < myColumnCount; myColNo++ )
     {
       myFieldName = QString::fromUtf8(( char * )sqlite3_column_name( myPreparedStatement, myColNo ) );
       myFieldValue = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, myColNo ) );
       myMap[myFieldName] = myFieldValue;
     }
+
     if ( sqlite3_step( myPreparedStatement ) != SQLITE_DONE )
     {
-      QgsDebugMsg( "Multiple records found in srs.db" );
+      QgsDebugMsg( "Multiple records found in " + db );
       myMap.clear();
     }
   }
@@ -757,65 +875,8 @@ QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecord(
   {
     QgsDebugMsg( "failed :  " + theSql );
   }
-
-  if ( myMap.empty() )
-  {
-    QgsDebugMsg( "trying user qgis.db" );
-    sqlite3_finalize( myPreparedStatement );
-    sqlite3_close( myDatabase );
-
-    myDatabaseFileName = QgsApplication::qgisUserDbFilePath();
-    QFileInfo myFileInfo;
-    myFileInfo.setFile( myDatabaseFileName );
-    if ( !myFileInfo.exists() )
-    {
-      QgsDebugMsg( "user qgis.db not found" );
-      return myMap;
-    }
-
-    //check the db is available
-    myResult = openDb( myDatabaseFileName, &myDatabase );
-    if ( myResult != SQLITE_OK )
-    {
-      return myMap;
-    }
-
-    myResult = sqlite3_prepare( myDatabase, theSql.toUtf8(), theSql.toUtf8().length(), &myPreparedStatement, &myTail );
-    // XXX Need to free memory from the error msg if one is set
-    if ( myResult == SQLITE_OK && sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
-    {
-      int myColumnCount = sqlite3_column_count( myPreparedStatement );
-      //loop through each column in the record adding its field name and value to the map
-      for ( int myColNo = 0; myColNo < myColumnCount; myColNo++ )
-      {
-        myFieldName = QString::fromUtf8(( char * )sqlite3_column_name( myPreparedStatement, myColNo ) );
-        myFieldValue = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, myColNo ) );
-        myMap[myFieldName] = myFieldValue;
-      }
-
-      if ( sqlite3_step( myPreparedStatement ) != SQLITE_DONE )
-      {
-        QgsDebugMsg( "Multiple records found in srs.db" );
-        myMap.clear();
-      }
-    }
-    else
-    {
-      QgsDebugMsg( "failed :  " + theSql );
-    }
-  }
   sqlite3_finalize( myPreparedStatement );
   sqlite3_close( myDatabase );
-
-#ifdef QGISDEBUG
-  QgsDebugMsg( "retrieved:  " + theSql );
-  RecordMap::Iterator it;
-  for ( it = myMap.begin(); it != myMap.end(); ++it )
-  {
-    QgsDebugMsgLevel( it.key() + " => " + it.value(), 2 );
-  }
-#endif
-
   return myMap;
 }
 
@@ -1041,48 +1102,66 @@ long QgsCoordinateReferenceSystem::findMatchingProj()
                            "projection_acronym=%1 and ellipsoid_acronym=%2 order by deprecated" )
                   .arg( quotedValue( mProjectionAcronym ) )
                   .arg( quotedValue( mEllipsoidAcronym ) );
-  // Get the full path name to the sqlite3 spatial reference database.
-  QString myDatabaseFileName = QgsApplication::srsDbFilePath();
-
-  //check the db is available
-  myResult = openDb( myDatabaseFileName, &myDatabase );
-  if ( myResult != SQLITE_OK )
+  // the srs.db index looks up the definition directly instead of comparing all
+  // definitions with the same projection and ellipsoid
+  const QgsSrsDbIndex* index = QgsSrsDbIndex::instance();
+  if ( index->isValid() )
   {
-    return 0;
+    Q_FOREACH ( const QgsSrsDbIndex::Record& record, index->records( QgsSrsDbIndex::Parameters, toProj4() ) )
+    {
+      if ( record.projectionAcronym == mProjectionAcronym && record.ellipsoidAcronym == mEllipsoidAcronym )
+      {
+        QgsDebugMsg( "-------> MATCH FOUND in srs.db index srsid: " + QString::number( record.srsId ) );
+        return record.srsId;
+      }
+    }
+    QgsDebugMsg( "no match found in srs.db index, trying user db now!" );
   }
-
-  myResult = sqlite3_prepare( myDatabase, mySql.toUtf8(), mySql.toUtf8().length(), &myPreparedStatement, &myTail );
-// XXX Need to free memory from the error msg if one is set
-  if ( myResult == SQLITE_OK )
+  else
   {
+    // Get the full path name to the sqlite3 spatial reference database.
+    QString myDatabaseFileName = QgsApplication::srsDbFilePath();
 
-    while ( sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
+    //check the db is available
+    myResult = openDb( myDatabaseFileName, &myDatabase );
+    if ( myResult != SQLITE_OK )
     {
-      QString mySrsId = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 0 ) );
-      QString myProj4String = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 1 ) );
-      if ( toProj4() == myProj4String.trimmed() )
-      {
-        QgsDebugMsg( "-------> MATCH FOUND in srs.db srsid: " + mySrsId );
-        // close the sqlite3 statement
-        sqlite3_finalize( myPreparedStatement );
-        sqlite3_close( myDatabase );
-        return mySrsId.toLong();
-      }
-      else
+      return 0;
+    }
+
+    myResult = sqlite3_prepare( myDatabase, mySql.toUtf8(), mySql.toUtf8().length(), &myPreparedStatement, &myTail );
+// XXX Need to free memory from the error msg if one is set
+    if ( myResult == SQLITE_OK )
+    {
+
+      while ( sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
       {
+        QString mySrsId = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 0 ) );
+        QString myProj4String = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 1 ) );
+        if ( toProj4() == myProj4String.trimmed() )
+        {
+          QgsDebugMsg( "-------> MATCH FOUND in srs.db srsid: " + mySrsId );
+          // close the sqlite3 statement
+          sqlite3_finalize( myPreparedStatement );
+          sqlite3_close( myDatabase );
+          return mySrsId.toLong();
+        }
+        else
+        {
 // QgsDebugMsg(QString(" Not matched : %1").arg(myProj4String));
+        }
       }
     }
+    QgsDebugMsg( "no match found in srs.db, trying user db now!" );
+    // close the sqlite3 statement
+    sqlite3_finalize( myPreparedStatement );
+    sqlite3_close( myDatabase );
   }
-  QgsDebugMsg( "no match found in srs.db, trying user db now!" );
-  // close the sqlite3 statement
-  sqlite3_finalize( myPreparedStatement );
-  sqlite3_close( myDatabase );
   //
   // Try the users db now
   //
 
-  myDatabaseFileName = QgsApplication::qgisUserDbFilePath();
+  QString myDatabaseFileName = QgsApplication::qgisUserDbFilePath();
   //check the db is available
   myResult = openDb( myDatabaseFileName, &myDatabase );
   if ( myResult != SQLITE_OK )
@@ -34,6 +34,7 @@ typedef struct sqlite3 sqlite3;
 
 //qgis includes
 #include "qgis.h"
+#include "qgssrsdbindex.h"
 
 #ifdef DEBUG
 typedef struct OGRSpatialReferenceHS *OGRSpatialReferenceH;
@@ -428,6 +429,21 @@ class CORE_EXPORT QgsCoordinateReferenceSystem
      */
     RecordMap getRecord( QString theSql );
 
+    /** Get a record from the srs.db index or the users qgis.db.
+     * Falls back to getRecord( theSql ) if there is no valid srs.db index, or if a
+     * ParameterSet lookup finds no record, as the query may match definitions with more parameters.
+     * @note only returns a record if a single one matches, like getRecord( theSql )
+     * @param theSql The sql query to execute on qgis.db
+     * @param key The lookup table of the srs.db index
+     * @param value The value to look up in the srs.db index
+     * @param requiredParam A proj4 parameter the srs.db definition has to contain, ignored if empty
+     * @return An associative array of field name <-> value pairs
+     */
+    RecordMap getRecord( QString theSql, QgsSrsDbIndex::Key key, const QString& value, const QString& requiredParam = QString() );
+
+    //! Runs a query returning a single record on a database
+    static RecordMap getRecordFromDb( const QString& db, const QString& theSql );
+
     // Open SQLite db and show message if cannot be opened
     // returns the same code as sqlite3_open
     static int openDb( QString path, sqlite3 **db, bool readonly = true );
@@ -464,6 +480,16 @@ class CORE_EXPORT QgsCoordinateReferenceSystem
 
     bool loadFromDb( QString db, QString expression, QString value );
 
+    /** Initialise from the system srs.db, using its index if available.
+     * @param key lookup table of the index
+     * @param value value to look up
+     * @param expression column expression to use with loadFromDb() if there is no index
+     */
+    bool loadFromSrsDb( QgsSrsDbIndex::Key key, const QString& value, const QString& expression );
+
+    //! Completes the initialisation after a database record was read into the members
+    void initialiseFromRecord();
+
     QString mValidationHint;
     mutable QString mWkt;
     mutable QString mProj4;
@@ -26,8 +26,11 @@
 #include <QApplication>
 #include <QPolygonF>
 #include <QStringList>
+#include <QThread>
 #include <QVector>
 
+#include <algorithm>
+
 extern "C"
 {
 #include <proj_api.h>
@@ -37,6 +40,192 @@ extern "C"
 // if defined shows all information about transform to stdout
 // #define COORDINATE_TRANSFORM_VERBOSE
 
+/** Interpolation grid of the approximate mode of QgsCoordinateTransform. Contains the
+ * destination coordinates of the intersections of grid lines in the source CRS.
+ * The grid is not modified after it has been built, so it may be shared between
+ * transforms used by different threads. Not a part of public API. */
+class QgsCoordinateTransformGrid
+{
+  public:
+
+    //! Builds the grid, returns false if the tolerance cannot be met within the maximum size
+    bool build( const QgsCoordinateTransform* ct, const QgsRectangle& extent, double tolerance, int maxSize );
+
+    //! Replaces the point by its interpolated transform, returns false if it is outside the grid
+    inline bool interpolate( double& x, double& y ) const;
+
+    //! positions of the grid columns and rows in the source CRS, ascending
+    QVector<double> mXs;
+    QVector<double> mYs;
+    //! destination coordinates of the grid points, row by row
+    QVector<double> mDestX;
+    QVector<double> mDestY;
+
+  private:
+
+    //! position checked against the exact transform, col/row is the cell it lies in or -1 if on a grid line
+    struct CheckPoint
+    {
+      CheckPoint() : x( 0 ), y( 0 ), col( -1 ), row( -1 ) {}
+      CheckPoint( double px, double py, int c, int r ) : x( px ), y( py ), col( c ), row( r ) {}
+      double x;
+      double y;
+      int col;
+      int row;
+    };
+
+    //! transforms the grid points
+    bool transformGrid( const QgsCoordinateTransform* ct );
+};
+
+//! initial number of grid lines in each direction
+static const int APPROXIMATION_GRID_INITIAL_SIZE = 9;
+
+static inline int _gridCell( const QVector<double>& lines, double value )
+{
+  int i = std::upper_bound( lines.constBegin(), lines.constEnd(), value ) - lines.constBegin() - 1;
+  return qBound( 0, i, lines.size() - 2 );
+}
+
+inline bool QgsCoordinateTransformGrid::interpolate( double& x, double& y ) const
+{
+  if ( x < mXs.first() || x > mXs.last() || y < mYs.first() || y > mYs.last() )
+    return false;
+
+  int col = _gridCell( mXs, x );
+  int row = _gridCell( mYs, y );
+  double tx = ( x - mXs[col] ) / ( mXs[col + 1] - mXs[col] );
+  double ty = ( y - mYs[row] ) / ( mYs[row + 1] - mYs[row] );
+
+  int cols = mXs.size();
+  int i00 = row * cols + col;
+  int i10 = i00 + cols;
+  double w00 = ( 1 - tx ) * ( 1 - ty );
+  double w01 = tx * ( 1 - ty );
+  double w10 = ( 1 - tx ) * ty;
+  double w11 = tx * ty;
+  x = w00 * mDestX[i00] + w01 * mDestX[i00 + 1] + w10 * mDestX[i10] + w11 * mDestX[i10 + 1];
+  y = w00 * mDestY[i00] + w01 * mDestY[i00 + 1] + w10 * mDestY[i10] + w11 * mDestY[i10 + 1];
+  return true;
+}
+
+bool QgsCoordinateTransformGrid::transformGrid( const QgsCoordinateTransform* ct )
+{
+  int cols = mXs.size();
+  int rows = mYs.size();
+  mDestX.resize( rows * cols );
+  mDestY.resize( rows * cols );
+  QVector<double> z( rows * cols, 0.0 );
+  for ( int row = 0; row < rows; ++row )
+  {
+    for ( int col = 0; col < cols; ++col )
+    {
+      mDestX[row * cols + col] = mXs[col];
+      mDestY[row * cols + col] = mYs[row];
+    }
+  }
+  ct->transformCoords( rows * cols, mDestX.data(), mDestY.data(), z.data() );
+
+  for ( int i = 0; i < rows * cols; ++i )
+  {
+    if ( !qIsFinite( mDestX[i] ) || !qIsFinite( mDestY[i] ) )
+      return false;
+  }
+  return true;
+}
+
+bool QgsCoordinateTransformGrid::build( const QgsCoordinateTransform* ct, const QgsRectangle& extent, double tolerance, int maxSize )
+{
+  mXs.clear();
+  mYs.clear();
+  for ( int i = 0; i < APPROXIMATION_GRID_INITIAL_SIZE; ++i )
+  {
+    mXs << extent.xMinimum() + extent.width() * i / ( APPROXIMATION_GRID_INITIAL_SIZE - 1 );
+    mYs << extent.yMinimum() + extent.height() * i / ( APPROXIMATION_GRID_INITIAL_SIZE - 1 );
+  }
+
+  double sqrTolerance = tolerance * tolerance;
+  Q_FOREVER
+  {
+    if ( !transformGrid( ct ) )
+      return false;
+
+    // check the midpoints of the cell edges and the cell centers, a failing point
+    // splits the columns and/or rows it lies between
+    int cols = mXs.size();
+    int rows = mYs.size();
+    QVector<CheckPoint> checks;
+    for ( int row = 0; row < rows; ++row )
+    {
+      for ( int col = 0; col < cols; ++col )
+      {
+        bool lastCol = col + 1 == cols;
+        bool lastRow = row + 1 == rows;
+        double xm = lastCol ? 0 : ( mXs[col] + mXs[col + 1] ) / 2;
+        double ym = lastRow ? 0 : ( mYs[row] + mYs[row + 1] ) / 2;
+        if ( !lastCol )
+          checks << CheckPoint( xm, mYs[row], col, -1 );
+        if ( !lastRow )
+          checks << CheckPoint( mXs[col], ym, -1, row );
+        if ( !lastCol && !lastRow )
+          checks << CheckPoint( xm, ym, col, row );
+      }
+    }
+
+    int checkCount = checks.size();
+    QVector<double> exactX( checkCount ), exactY( checkCount ), z( checkCount, 0.0 );
+    for ( int i = 0; i < checkCount; ++i )
+    {
+      exactX[i] = checks[i].x;
+      exactY[i] = checks[i].y;
+    }
+    ct->transformCoords( checkCount, exactX.data(), exactY.data(), z.data() );
+
+    QVector<bool> splitCol( cols, false );
+    QVector<bool> splitRow( rows, false );
+    bool split = false;
+    for ( int i = 0; i < checkCount; ++i )
+    {
+      const CheckPoint& check = checks[i];
+      double x = check.x;
+      double y = check.y;
+      interpolate( x, y );
+      double dx = x - exactX[i];
+      double dy = y - exactY[i];
+      if ( !( dx * dx + dy * dy <= sqrTolerance ) ) // also true for NaN
+      {
+        if ( check.col >= 0 )
+          splitCol[check.col] = true;
+        if ( check.row >= 0 )
+          splitRow[check.row] = true;
+        split = true;
+      }
+    }
+
+    if ( !split )
+      return true;
+
+    QVector<double> xs, ys;
+    for ( int col = 0; col < cols; ++col )
+    {
+      xs << mXs[col];
+      if ( splitCol[col] )
+        xs << ( mXs[col] + mXs[col + 1] ) / 2;
+    }
+    for ( int row = 0; row < rows; ++row )
+    {
+      ys << mYs[row];
+      if ( splitRow[row] )
+        ys << ( mYs[row] + mYs[row + 1] ) / 2;
+    }
+    if ( xs.size() > maxSize || ys.size() > maxSize )
+      return false;
+
+    mXs = xs;
+    mYs = ys;
+  }
+}
+
 QgsCoordinateTransform::QgsCoordinateTransform()
     : QObject()
     , mShortCircuit( false )
@@ -45,6 +234,7 @@ QgsCoordinateTransform::QgsCoordinateTransform()
     , mDestinationProjection( 0 )
     , mSourceDatumTransform( -1 )
     , mDestinationDatumTransform( -1 )
+    , mProjectionThread( 0 )
 {
   setFinder();
 }
@@ -57,6 +247,7 @@ QgsCoordinateTransform::QgsCoordinateTransform( const QgsCoordinateReferenceSyst
     , mDestinationProjection( 0 )
     , mSourceDatumTransform( -1 )
     , mDestinationDatumTransform( -1 )
+    , mProjectionThread( 0 )
 {
   setFinder();
   mSourceCRS = source;
@@ -73,6 +264,7 @@ QgsCoordinateTransform::QgsCoordinateTransform( long theSourceSrsId, long theDes
     , mDestinationProjection( 0 )
     , mSourceDatumTransform( -1 )
     , mDestinationDatumTransform( -1 )
+    , mProjectionThread( 0 )
 {
   initialise();
 }
@@ -84,6 +276,7 @@ QgsCoordinateTransform::QgsCoordinateTransform( QString theSourceCRS, QString th
     , mDestinationProjection( 0 )
     , mSourceDatumTransform( -1 )
     , mDestinationDatumTransform( -1 )
+    , mProjectionThread( 0 )
 {
   setFinder();
   mSourceCRS.createFromWkt( theSourceCRS );
@@ -104,6 +297,7 @@ QgsCoordinateTransform::QgsCoordinateTransform( long theSourceSrid,
     , mDestinationProjection( 0 )
     , mSourceDatumTransform( -1 )
     , mDestinationDatumTransform( -1 )
+    , mProjectionThread( 0 )
 {
   setFinder();
 
@@ -118,15 +312,8 @@ QgsCoordinateTransform::QgsCoordinateTransform( long theSourceSrid,
 
 QgsCoordinateTransform::~QgsCoordinateTransform()
 {
-  // free the proj objects
-  if ( mSourceProjection )
-  {
-    pj_free( mSourceProjection );
-  }
-  if ( mDestinationProjection )
-  {
-    pj_free( mDestinationProjection );
-  }
+  // give the proj objects back to the cache
+  releaseProjections();
 }
 
 QgsCoordinateTransform* QgsCoordinateTransform::clone() const
@@ -135,6 +322,7 @@ QgsCoordinateTransform* QgsCoordinateTransform::clone() const
   tr->setSourceDatumTransform( sourceDatumTransform() );
   tr->setDestinationDatumTransform( destinationDatumTransform() );
   tr->initialise();
+  tr->mApproximation = mApproximation;
   return tr;
 }
 
@@ -160,6 +348,9 @@ void QgsCoordinateTransform::setDestCRSID( long theCRSID )
 // And probably shouldn't be a void
 void QgsCoordinateTransform::initialise()
 {
+  // the approximation is only valid for the previous CRS
+  mApproximation.clear();
+
   // XXX Warning - multiple return paths in this block!!
   if ( !mSourceCRS.isValid() )
   {
@@ -182,7 +373,7 @@ void QgsCoordinateTransform::initialise()
 
   // init the projections (destination and source)
 
-  pj_free( mSourceProjection );
+  releaseProjections();
   QString sourceProjString = mSourceCRS.toProj4();
   if ( !useDefaultDatumTransform )
   {
@@ -193,7 +384,6 @@ void QgsCoordinateTransform::initialise()
     sourceProjString += ( " " + datumTransformString( mSourceDatumTransform ) );
   }
 
-  pj_free( mDestinationProjection );
   QString destProjString = mDestCRS.toProj4();
   if ( !useDefaultDatumTransform )
   {
@@ -209,8 +399,12 @@ void QgsCoordinateTransform::initialise()
     addNullGridShifts( sourceProjString, destProjString );
   }
 
-  mSourceProjection = pj_init_plus( sourceProjString.toUtf8() );
-  mDestinationProjection = pj_init_plus( destProjString.toUtf8() );
+  // projections are shared with other transforms through the projection cache
+  mSourceProjString = sourceProjString;
+  mDestProjString = destProjString;
+  mSourceProjection = QgsProjectionCache::instance()->acquire( sourceProjString );
+  mDestinationProjection = QgsProjectionCache::instance()->acquire( destProjString );
+  mProjectionThread = QThread::currentThread();
 
 #ifdef COORDINATE_TRANSFORM_VERBOSE
   QgsDebugMsg( "From proj : " + mSourceCRS.toProj4() );
@@ -626,6 +820,46 @@ QgsRectangle QgsCoordinateTransform::transformBoundingBox( const QgsRectangle &r
 }
 
 void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, double *y, double *z, TransformDirection direction ) const
+{
+  if ( direction == ReverseTransform || !mApproximation )
+  {
+    transformCoordsExact( numPoints, x, y, z, direction );
+    return;
+  }
+
+  // interpolate the points within the grid, the remaining ones are transformed exactly
+  QVector<int> outside;
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    if ( !mApproximation->interpolate( x[i], y[i] ) )
+      outside << i;
+  }
+
+  if ( outside.size() == numPoints )
+  {
+    transformCoordsExact( numPoints, x, y, z, direction );
+  }
+  else if ( !outside.isEmpty() )
+  {
+    int count = outside.size();
+    QVector<double> ox( count ), oy( count ), oz( count );
+    for ( int i = 0; i < count; ++i )
+    {
+      ox[i] = x[outside[i]];
+      oy[i] = y[outside[i]];
+      oz[i] = z[outside[i]];
+    }
+    transformCoordsExact( count, ox.data(), oy.data(), oz.data(), direction );
+    for ( int i = 0; i < count; ++i )
+    {
+      x[outside[i]] = ox[i];
+      y[outside[i]] = oy[i];
+      z[outside[i]] = oz[i];
+    }
+  }
+}
+
+void QgsCoordinateTransform::transformCoordsExact( const int& numPoints, double *x, double *y, double *z, TransformDirection direction ) const
 {
   // Refuse to transform the points if the srs's are invalid
   if ( !mSourceCRS.isValid() )
@@ -648,12 +882,23 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
   QgsDebugMsg( QString( "[[[[[[ Number of points to transform: %1 ]]]]]]" ).arg( numPoints ) );
 #endif
 
-  // use proj4 to do the transform
+  // use proj4 to do the transform, with the projections of the calling thread
+  projPJ sourceProjection;
+  projPJ destinationProjection;
+  threadProjections( sourceProjection, destinationProjection );
+  if ( !sourceProjection || !destinationProjection )
+  {
+    QString msg = tr( "Projections for the transform from %1 to %2 could not be created" )
+                  .arg( mSourceProjString ).arg( mDestProjString );
+    QgsDebugMsg( "throwing exception: " + msg );
+    throw QgsCsException( msg );
+  }
+
   QString dir;
   // if the source/destination projection is lat/long, convert the points to radians
   // prior to transforming
-  if (( pj_is_latlong( mDestinationProjection ) && ( direction == ReverseTransform ) )
-      || ( pj_is_latlong( mSourceProjection ) && ( direction == ForwardTransform ) ) )
+  if (( pj_is_latlong( destinationProjection ) && ( direction == ReverseTransform ) )
+      || ( pj_is_latlong( sourceProjection ) && ( direction == ForwardTransform ) ) )
   {
     for ( int i = 0; i < numPoints; ++i )
     {
@@ -666,13 +911,13 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
   int projResult;
   if ( direction == ReverseTransform )
   {
-    projResult = pj_transform( mDestinationProjection, mSourceProjection, numPoints, 0, x, y, z );
+    projResult = pj_transform( destinationProjection, sourceProjection, numPoints, 0, x, y, z );
   }
   else
   {
-    Q_ASSERT( mSourceProjection != 0 );
-    Q_ASSERT( mDestinationProjection != 0 );
-    projResult = pj_transform( mSourceProjection, mDestinationProjection, numPoints, 0, x, y, z );
+    Q_ASSERT( sourceProjection != 0 );
+    Q_ASSERT( destinationProjection != 0 );
+    projResult = pj_transform( sourceProjection, destinationProjection, numPoints, 0, x, y, z );
   }
 
   if ( projResult != 0 )
@@ -694,8 +939,8 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
 
     dir = ( direction == ForwardTransform ) ? tr( "forward transform" ) : tr( "inverse transform" );
 
-    char *srcdef = pj_get_def( mSourceProjection, 0 );
-    char *dstdef = pj_get_def( mDestinationProjection, 0 );
+    char *srcdef = pj_get_def( sourceProjection, 0 );
+    char *dstdef = pj_get_def( destinationProjection, 0 );
 
     QString msg = tr( "%1 of\n"
                       "%2"
@@ -720,8 +965,8 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
 
   // if the result is lat/long, convert the results from radians back
   // to degrees
-  if (( pj_is_latlong( mDestinationProjection ) && ( direction == ForwardTransform ) )
-      || ( pj_is_latlong( mSourceProjection ) && ( direction == ReverseTransform ) ) )
+  if (( pj_is_latlong( destinationProjection ) && ( direction == ForwardTransform ) )
+      || ( pj_is_latlong( sourceProjection ) && ( direction == ReverseTransform ) ) )
   {
     for ( int i = 0; i < numPoints; ++i )
     {
@@ -737,6 +982,75 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
 #endif
 }
 
+bool QgsCoordinateTransform::setApproximation( const QgsRectangle& sourceExtent, double tolerance, int maxGridSize )
+{
+  mApproximation.clear();
+  if ( mShortCircuit || !mInitialisedFlag || !sourceExtent.isFinite() || sourceExtent.isEmpty() || tolerance <= 0 )
+    return false;
+
+  QgsCoordinateTransformGrid* grid = new QgsCoordinateTransformGrid();
+  try
+  {
+    if ( grid->build( this, sourceExtent, tolerance, maxGridSize ) )
+    {
+      QgsDebugMsg( QString( "approximation grid of %1 x %2 points" ).arg( grid->mXs.size() ).arg( grid->mYs.size() ) );
+      mApproximation = QSharedPointer<const QgsCoordinateTransformGrid>( grid );
+      return true;
+    }
+  }
+  catch ( QgsCsException &cse )
+  {
+    Q_UNUSED( cse );
+    QgsDebugMsg( "approximation grid cannot be transformed: " + cse.what() );
+  }
+  delete grid;
+  return false;
+}
+
+void QgsCoordinateTransform::clearApproximation()
+{
+  mApproximation.clear();
+}
+
+void QgsCoordinateTransform::threadProjections( projPJ& source, projPJ& destination ) const
+{
+  QThread* thread = QThread::currentThread();
+  if ( thread == mProjectionThread )
+  {
+    source = mSourceProjection;
+    destination = mDestinationProjection;
+    return;
+  }
+
+  QMutexLocker locker( &mThreadProjectionsMutex );
+  QHash< QThread*, QPair< projPJ, projPJ > >::const_iterator it = mThreadProjections.constFind( thread );
+  if ( it == mThreadProjections.constEnd() )
+  {
+    QgsProjectionCache* cache = QgsProjectionCache::instance();
+    it = mThreadProjections.insert( thread, qMakePair( cache->acquire( mSourceProjString ), cache->acquire( mDestProjString ) ) );
+  }
+  source = it.value().first;
+  destination = it.value().second;
+}
+
+void QgsCoordinateTransform::releaseProjections()
+{
+  QgsProjectionCache* cache = QgsProjectionCache::instance();
+  cache->release( mSourceProjection );
+  cache->release( mDestinationProjection );
+  mSourceProjection = 0;
+  mDestinationProjection = 0;
+
+  QMutexLocker locker( &mThreadProjectionsMutex );
+  QHash< QThread*, QPair< projPJ, projPJ > >::const_iterator it = mThreadProjections.constBegin();
+  for ( ; it != mThreadProjections.constEnd(); ++it )
+  {
+    cache->release( it.value().first );
+    cache->release( it.value().second );
+  }
+  mThreadProjections.clear();
+}
+
 bool QgsCoordinateTransform::readXML( QDomNode & theNode )
 {
 
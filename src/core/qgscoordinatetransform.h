@@ -19,6 +19,10 @@
 
 //qt includes
 #include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSharedPointer>
 
 //qgis includes
 #include "qgspoint.h"
@@ -28,6 +32,8 @@
 class QDomNode;
 class QDomDocument;
 class QPolygonF;
+class QThread;
+class QgsCoordinateTransformGrid;
 
 //non qt includes
 #include <iostream>
@@ -201,7 +207,32 @@ class CORE_EXPORT QgsCoordinateTransform : public QObject
     /** See if the transform short circuits because src and dest are equivalent
      * @return bool True if it short circuits
      */
-    bool isShortCircuited() {return mShortCircuit;}
+    bool isShortCircuited() const {return mShortCircuit;}
+
+    /** Enables the approximate mode for forward transforms of points within an extent of the
+     * source CRS. An interpolation grid is built over the extent and its rows and columns are
+     * refined until bilinear interpolation within the grid differs by less than the tolerance
+     * from the exact transform. Forward transforms of points within the extent then interpolate
+     * the grid instead of calling PROJ.4. Other points and reverse transforms are not affected.
+     * @param sourceExtent extent in the source CRS
+     * @param tolerance maximum error in units of the destination CRS
+     * @param maxGridSize maximum number of rows and columns of the grid
+     * @returns true if a grid within the tolerance could be built. Otherwise the
+     * approximate mode is disabled.
+     * @note z coordinates are not changed by interpolated transforms
+     * @note added in QGIS 2.12
+     */
+    bool setApproximation( const QgsRectangle& sourceExtent, double tolerance, int maxGridSize = 65 );
+
+    /** Disables the approximate mode
+     * @note added in QGIS 2.12
+     */
+    void clearApproximation();
+
+    /** Returns true if forward transforms are approximated by an interpolation grid
+     * @note added in QGIS 2.12
+     */
+    bool hasApproximation() const { return !mApproximation.isNull(); }
 
     /** Change the destination coordinate system by passing it a qgis srsid
     * A QGIS srsid is a unique key value to an entry on the tbl_srs in the
@@ -285,6 +316,29 @@ class CORE_EXPORT QgsCoordinateTransform : public QObject
     int mSourceDatumTransform;
     int mDestinationDatumTransform;
 
+    /** Proj4 definitions of the source and destination projections, including datum transformations */
+    QString mSourceProjString;
+    QString mDestProjString;
+
+    /** Thread the projections above have been created for */
+    QThread* mProjectionThread;
+
+    /** Projections used by other threads, PROJ.4 projections must not be used by several threads at the same time */
+    mutable QHash< QThread*, QPair< projPJ, projPJ > > mThreadProjections;
+    mutable QMutex mThreadProjectionsMutex;
+
+    /** Interpolation grid of the approximate mode, shared by clones */
+    QSharedPointer<const QgsCoordinateTransformGrid> mApproximation;
+
+    /** Transforms coordinates with PROJ.4, ignoring the approximate mode */
+    void transformCoordsExact( const int &numPoint, double *x, double *y, double *z, TransformDirection direction ) const;
+
+    /** Returns the source and destination projections for the calling thread */
+    void threadProjections( projPJ& source, projPJ& destination ) const;
+
+    /** Releases all projections to QgsProjectionCache */
+    void releaseProjections();
+
     /*!
      * Finder for PROJ grid files.
      */
@@ -17,6 +17,18 @@
 
 #include "qgscrscache.h"
 #include "qgscoordinatetransform.h"
+#include "qgslogger.h"
+
+#include <QSet>
+#include <QThread>
+
+extern "C"
+{
+#include <proj_api.h>
+}
+
+//! number of unused projections kept in the projection cache
+static const int MAX_UNUSED_PROJECTIONS = 100;
 
 
 QgsCoordinateTransformCache* QgsCoordinateTransformCache::instance()
@@ -36,6 +48,8 @@ QgsCoordinateTransformCache::~QgsCoordinateTransformCache()
 
 const QgsCoordinateTransform* QgsCoordinateTransformCache::transform( const QString& srcAuthId, const QString& destAuthId, int srcDatumTransform, int destDatumTransform )
 {
+  QMutexLocker locker( &mMutex );
+
   QList< QgsCoordinateTransform* > values =
     mTransforms.values( qMakePair( srcAuthId, destAuthId ) );
 
@@ -63,6 +77,8 @@ const QgsCoordinateTransform* QgsCoordinateTransformCache::transform( const QStr
 
 void QgsCoordinateTransformCache::invalidateCrs( const QString& crsAuthId )
 {
+  QMutexLocker locker( &mMutex );
+
   //get keys to remove first
   QHash< QPair< QString, QString >, QgsCoordinateTransform* >::const_iterator it = mTransforms.constBegin();
   QList< QPair< QString, QString > > updateList;
@@ -84,6 +100,157 @@ void QgsCoordinateTransformCache::invalidateCrs( const QString& crsAuthId )
 }
 
 
+QgsProjectionCache* QgsProjectionCache::instance()
+{
+  // never destroyed: transforms owned by other static objects release their projections on exit
+  static QgsProjectionCache* sInstance = new QgsProjectionCache();
+  return sInstance;
+}
+
+QgsProjectionCache::QgsProjectionCache()
+    : mUnused( 0 )
+    , mHits( 0 )
+    , mMisses( 0 )
+{
+}
+
+QgsProjectionCache::~QgsProjectionCache()
+{
+  QHash< Key, Entry >::const_iterator it = mProjections.constBegin();
+  for ( ; it != mProjections.constEnd(); ++it )
+  {
+    pj_free( it.value().projection );
+  }
+#if PJ_VERSION >= 480
+  Q_FOREACH ( void* context, mContexts )
+  {
+    pj_ctx_free( context );
+  }
+#endif
+}
+
+projPJ QgsProjectionCache::acquire( const QString& proj4 )
+{
+  QMutexLocker locker( &mMutex );
+
+  QThread* thread = QThread::currentThread();
+  Key key( thread, proj4 );
+  QHash< Key, Entry >::iterator it = mProjections.find( key );
+  if ( it != mProjections.end() )
+  {
+    ++mHits;
+    if ( it.value().refs++ == 0 )
+      --mUnused;
+    return it.value().projection;
+  }
+
+  ++mMisses;
+#if PJ_VERSION >= 480
+  void* context = mContexts.value( thread );
+  if ( !context )
+  {
+    context = pj_ctx_alloc();
+    mContexts.insert( thread, context );
+  }
+  projPJ projection = pj_init_plus_ctx( context, proj4.toUtf8() );
+#else
+  projPJ projection = pj_init_plus( proj4.toUtf8() );
+#endif
+  if ( !projection )
+  {
+    QgsDebugMsg( "Could not initialise projection " + proj4 );
+    return 0;
+  }
+
+  Entry entry;
+  entry.projection = projection;
+  entry.refs = 1;
+  mProjections.insert( key, entry );
+  mKeys.insert( projection, key );
+  return projection;
+}
+
+void QgsProjectionCache::release( projPJ projection )
+{
+  if ( !projection )
+    return;
+
+  QMutexLocker locker( &mMutex );
+
+  QHash< projPJ, Key >::const_iterator keyIt = mKeys.constFind( projection );
+  if ( keyIt == mKeys.constEnd() )
+  {
+    QgsDebugMsg( "Released projection is not in the cache" );
+    return;
+  }
+
+  Entry& entry = mProjections[ keyIt.value()];
+  if ( --entry.refs == 0 && ++mUnused > MAX_UNUSED_PROJECTIONS )
+  {
+    clearUnused();
+  }
+}
+
+int QgsProjectionCache::hits() const
+{
+  QMutexLocker locker( &mMutex );
+  return mHits;
+}
+
+int QgsProjectionCache::misses() const
+{
+  QMutexLocker locker( &mMutex );
+  return mMisses;
+}
+
+int QgsProjectionCache::count() const
+{
+  QMutexLocker locker( &mMutex );
+  return mProjections.size();
+}
+
+void QgsProjectionCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  clearUnused();
+}
+
+void QgsProjectionCache::clearUnused()
+{
+  QSet< QThread* > usedThreads;
+  QHash< Key, Entry >::iterator it = mProjections.begin();
+  while ( it != mProjections.end() )
+  {
+    if ( it.value().refs > 0 )
+    {
+      usedThreads.insert( it.key().first );
+      ++it;
+      continue;
+    }
+
+    pj_free( it.value().projection );
+    mKeys.remove( it.value().projection );
+    it = mProjections.erase( it );
+  }
+  mUnused = 0;
+
+#if PJ_VERSION >= 480
+  // contexts of threads without projections (threads may have finished)
+  QHash< QThread*, void* >::iterator contextIt = mContexts.begin();
+  while ( contextIt != mContexts.end() )
+  {
+    if ( usedThreads.contains( contextIt.key() ) )
+    {
+      ++contextIt;
+      continue;
+    }
+    pj_ctx_free( contextIt.value() );
+    contextIt = mContexts.erase( contextIt );
+  }
+#endif
+}
+
+
 QgsCRSCache* QgsCRSCache::instance()
 {
   static QgsCRSCache mInstance;
@@ -20,8 +20,12 @@
 
 #include "qgscoordinatereferencesystem.h"
 #include <QHash>
+#include <QMutex>
 
 class QgsCoordinateTransform;
+class QThread;
+
+typedef void* projPJ;
 
 /** Cache coordinate transform by authid of source/dest transformation to avoid the
 overhead of initialisation for each redraw*/
@@ -43,6 +47,70 @@ class CORE_EXPORT QgsCoordinateTransformCache
   private:
     static QgsCoordinateTransformCache* mInstance;
     QMultiHash< QPair< QString, QString >, QgsCoordinateTransform* > mTransforms; //same auth_id pairs might have different datum transformations
+    QMutex mMutex;
+};
+
+/** \ingroup core
+ * Thread-safe cache of initialised PROJ.4 projections, shared by all coordinate transforms.
+ *
+ * Projections are keyed by the calling thread and the proj4 definition, which includes the
+ * datum transformation. Every thread gets projections created in its own PROJ context, so
+ * transforms may be used from several threads at the same time. Projections are reference
+ * counted and kept after their last release, so that creating a transform for a pair of
+ * CRS which was used before does not initialise the projections again.
+ * \note added in QGIS 2.12
+ */
+class CORE_EXPORT QgsProjectionCache
+{
+  public:
+    static QgsProjectionCache* instance();
+    ~QgsProjectionCache();
+
+    /** Returns the projection for a proj4 definition to be used in the calling thread
+     * and increases its reference count. Returns 0 if the definition is invalid.
+     * @note not available in python bindings
+     */
+    projPJ acquire( const QString& proj4 );
+
+    /** Decreases the reference count of a projection returned by acquire()
+     * @note not available in python bindings
+     */
+    void release( projPJ projection );
+
+    /** Returns the number of acquire() calls which returned a cached projection */
+    int hits() const;
+
+    /** Returns the number of acquire() calls which had to initialise a projection */
+    int misses() const;
+
+    /** Returns the number of cached projections, including the ones currently in use */
+    int count() const;
+
+    /** Frees all projections which are not in use */
+    void clear();
+
+  protected:
+    QgsProjectionCache();
+
+  private:
+    //! frees all unused projections, the mutex has to be locked
+    void clearUnused();
+
+    struct Entry
+    {
+      projPJ projection;
+      int refs;
+    };
+
+    typedef QPair< QThread*, QString > Key;
+    QHash< Key, Entry > mProjections;
+    QHash< projPJ, Key > mKeys;
+    //! PROJ context of every thread, contexts are kept as long as their projections
+    QHash< QThread*, void* > mContexts;
+    int mUnused;
+    int mHits;
+    int mMisses;
+    mutable QMutex mMutex;
 };
 
 class CORE_EXPORT QgsCRSCache
@@ -16,10 +16,12 @@
 #include "qgsexpression.h"
 
 #include <QtDebug>
+#include <QCache>
 #include <QDomDocument>
 #include <QDate>
 #include <QRegExp>
 #include <QColor>
+#include <QThreadStorage>
 #include <QUuid>
 
 #include <math.h>
@@ -36,6 +38,7 @@
 #include "qgsvectorcolorrampv2.h"
 #include "qgsstylev2.h"
 #include "qgsexpressioncontext.h"
+#include "qgsexpressionprogram.h"
 #include "qgsproject.h"
 #include "qgsstringutils.h"
 #include "qgsgeometrycollectionv2.h"
@@ -1361,21 +1364,56 @@ static QVariant fcnGeometry( const QVariantList&, const QgsExpressionContext* co
   else
     return QVariant();
 }
+//! number of geometries kept per thread by geom_from_wkt and geom_from_gml
+static const int GEOMETRY_LITERAL_CACHE_SIZE = 16;
+
+struct GeometryLiteralCache
+{
+  GeometryLiteralCache() : wkt( GEOMETRY_LITERAL_CACHE_SIZE ), gml( GEOMETRY_LITERAL_CACHE_SIZE ) {}
+  QCache<QString, QgsGeometry> wkt;
+  QCache<QString, QgsGeometry> gml;
+};
+
+static QThreadStorage<GeometryLiteralCache*> sGeometryLiteralCaches;
+
+/** Returns the geometries parsed by the calling thread before. A filter like
+ * intersects( $geometry, geom_from_wkt( '...' ) ) then tests every feature against the same
+ * geometry, which keeps its prepared GEOS geometry between the tests.
+ */
+static GeometryLiteralCache* geometryLiteralCache()
+{
+  if ( !sGeometryLiteralCaches.hasLocalData() )
+    sGeometryLiteralCaches.setLocalData( new GeometryLiteralCache );
+  return sGeometryLiteralCaches.localData();
+}
+
 static QVariant fcnGeomFromWKT( const QVariantList& values, const QgsExpressionContext*, QgsExpression* parent )
 {
   QString wkt = getStringValue( values.at( 0 ), parent );
-  QgsGeometry* geom = QgsGeometry::fromWkt( wkt );
-  QVariant result = geom ? QVariant::fromValue( *geom ) : QVariant();
-  delete geom;
-  return result;
+  QCache<QString, QgsGeometry>& cache = geometryLiteralCache()->wkt;
+  QgsGeometry* geom = cache.object( wkt );
+  if ( !geom )
+  {
+    geom = QgsGeometry::fromWkt( wkt );
+    if ( !geom )
+      return QVariant();
+    cache.insert( wkt, geom );
+  }
+  return QVariant::fromValue( *geom );
 }
 static QVariant fcnGeomFromGML( const QVariantList& values, const QgsExpressionContext*, QgsExpression* parent )
 {
   QString gml = getStringValue( values.at( 0 ), parent );
-  QgsGeometry* geom = QgsOgcUtils::geometryFromGML( gml );
-  QVariant result = geom ? QVariant::fromValue( *geom ) : QVariant();
-  delete geom;
-  return result;
+  QCache<QString, QgsGeometry>& cache = geometryLiteralCache()->gml;
+  QgsGeometry* geom = cache.object( gml );
+  if ( !geom )
+  {
+    geom = QgsOgcUtils::geometryFromGML( gml );
+    if ( !geom )
+      return QVariant();
+    cache.insert( gml, geom );
+  }
+  return QVariant::fromValue( *geom );
 }
 
 static QVariant fcnGeomArea( const QVariantList&, const QgsExpressionContext* context, QgsExpression* parent )
@@ -2470,6 +2508,8 @@ QgsExpression::QgsExpression( const QString& expr )
     , mScale( 0 )
     , mExp( expr )
     , mCalc( 0 )
+    , mProgram( 0 )
+    , mCompilationEnabled( true )
 {
   mRootNode = ::parseExpression( expr, mParserErrorString );
 
@@ -2479,6 +2519,7 @@ QgsExpression::QgsExpression( const QString& expr )
 
 QgsExpression::~QgsExpression()
 {
+  delete mProgram;
   delete mCalc;
   delete mRootNode;
 }
@@ -2530,6 +2571,13 @@ void QgsExpression::setGeomCalculator( const QgsDistanceArea &calc )
   mCalc = new QgsDistanceArea( calc );
 }
 
+void QgsExpression::setCompilationEnabled( bool enabled )
+{
+  mCompilationEnabled = enabled;
+  delete mProgram;
+  mProgram = 0;
+}
+
 bool QgsExpression::prepare( const QgsFields& fields )
 {
   QgsExpressionContext fc = QgsExpressionContextUtils::createFeatureBasedContext( 0, fields );
@@ -2539,6 +2587,9 @@ bool QgsExpression::prepare( const QgsFields& fields )
 bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   mEvalErrorString = QString();
+  delete mProgram;
+  mProgram = 0;
+
   if ( !mRootNode )
   {
     //re-parse expression. Creation of QgsExpressionContexts may have added extra
@@ -2553,7 +2604,27 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
     return false;
   }
 
-  return mRootNode->prepare( this, context );
+  if ( !mRootNode->prepare( this, context ) )
+    return false;
+
+  // column indexes are known now, so the tree can be lowered to a flat program
+  if ( mCompilationEnabled )
+    mProgram = QgsExpressionProgram::compile( this, mRootNode, context );
+
+  return true;
+}
+
+QgsExpression::CompilationStatistics QgsExpression::compilationStatistics() const
+{
+  CompilationStatistics statistics;
+  if ( mProgram )
+  {
+    statistics.nodeCount = mProgram->nodeCount();
+    statistics.foldedNodeCount = mProgram->foldedNodeCount();
+    statistics.sharedNodeCount = mProgram->sharedNodeCount();
+    statistics.instructionCount = mProgram->instructionCount();
+  }
+  return statistics;
 }
 
 QVariant QgsExpression::evaluate( const QgsFeature* f )
@@ -2566,6 +2637,8 @@ QVariant QgsExpression::evaluate( const QgsFeature* f )
   }
 
   QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f ? *f : QgsFeature(), QgsFields() );
+  if ( mProgram )
+    return mProgram->run( this, &context );
   return mRootNode->eval( this, &context );
 }
 
@@ -2604,6 +2677,8 @@ QVariant QgsExpression::evaluate()
     return QVariant();
   }
 
+  if ( mProgram )
+    return mProgram->run( this, ( QgsExpressionContext* )0 );
   return mRootNode->eval( this, ( QgsExpressionContext* )0 );
 }
 
@@ -2616,9 +2691,46 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
     return QVariant();
   }
 
+  if ( mProgram )
+    return mProgram->run( this, context );
   return mRootNode->eval( this, context );
 }
 
+QVariantList QgsExpression::evaluateBlock( const QgsFeatureList& features, QgsExpressionContext* context )
+{
+  mEvalErrorString = QString();
+  if ( !mRootNode )
+  {
+    mEvalErrorString = tr( "No root node! Parsing failed?" );
+    return QVariantList();
+  }
+
+  if ( mProgram && mProgram->isColumnar() )
+    return mProgram->runBlock( this, features );
+
+  QgsExpressionContext localContext;
+  if ( !context )
+    context = &localContext;
+
+  QVariantList results;
+  results.reserve( features.count() );
+  QString firstError;
+  Q_FOREACH ( const QgsFeature& feature, features )
+  {
+    context->setFeature( feature );
+    QVariant result = evaluate( context );
+    if ( hasEvalError() )
+    {
+      if ( firstError.isNull() )
+        firstError = mEvalErrorString;
+      result = QVariant();
+    }
+    results << result;
+  }
+  mEvalErrorString = firstError;
+  return results;
+}
+
 QString QgsExpression::dump() const
 {
   if ( !mRootNode )
@@ -2765,6 +2877,11 @@ QVariant QgsExpression::NodeUnaryOperator::eval( QgsExpression *parent, const Qg
   QVariant val = mOperand->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return compute( parent, val );
+}
+
+QVariant QgsExpression::NodeUnaryOperator::compute( QgsExpression *parent, const QVariant &val )
+{
   switch ( mOp )
   {
     case uoNot:
@@ -2807,6 +2924,11 @@ QVariant QgsExpression::NodeBinaryOperator::eval( QgsExpression *parent, const Q
   QVariant vR = mOpRight->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return compute( parent, vL, vR );
+}
+
+QVariant QgsExpression::NodeBinaryOperator::compute( QgsExpression *parent, const QVariant &vL, const QVariant &vR )
+{
   switch ( mOp )
   {
     case boPlus:
@@ -3155,6 +3277,23 @@ QString QgsExpression::NodeBinaryOperator::dump() const
 
 //
 
+// compares a non-null value against an item of an IN list
+static bool inListItemEqual( const QVariant& v1, const QVariant& v2, QgsExpression* parent )
+{
+  if ( isDoubleSafe( v1 ) && isDoubleSafe( v2 ) )
+  {
+    double f1 = getDoubleValue( v1, parent );
+    double f2 = getDoubleValue( v2, parent );
+    return f1 == f2;
+  }
+  else
+  {
+    QString s1 = getStringValue( v1, parent );
+    QString s2 = getStringValue( v2, parent );
+    return QString::compare( s1, s2 ) == 0;
+  }
+}
+
 QVariant QgsExpression::NodeInOperator::eval( QgsExpression *parent, const QgsExpressionContext *context )
 {
   if ( mList->count() == 0 )
@@ -3174,20 +3313,39 @@ QVariant QgsExpression::NodeInOperator::eval( QgsExpression *parent, const QgsEx
       listHasNull = true;
     else
     {
-      bool equal = false;
       // check whether they are equal
-      if ( isDoubleSafe( v1 ) && isDoubleSafe( v2 ) )
-      {
-        double f1 = getDoubleValue( v1, parent ); ENSURE_NO_EVAL_ERROR;
-        double f2 = getDoubleValue( v2, parent ); ENSURE_NO_EVAL_ERROR;
-        equal = f1 == f2;
-      }
-      else
-      {
-        QString s1 = getStringValue( v1, parent ); ENSURE_NO_EVAL_ERROR;
-        QString s2 = getStringValue( v2, parent ); ENSURE_NO_EVAL_ERROR;
-        equal = QString::compare( s1, s2 ) == 0;
-      }
+      bool equal = inListItemEqual( v1, v2, parent );
+      ENSURE_NO_EVAL_ERROR;
+
+      if ( equal ) // we know the result
+        return mNotIn ? TVL_False : TVL_True;
+    }
+  }
+
+  // item not found
+  if ( listHasNull )
+    return TVL_Unknown;
+  else
+    return mNotIn ? TVL_True : TVL_False;
+}
+
+QVariant QgsExpression::NodeInOperator::compute( QgsExpression *parent, const QVariant &value, const QVariantList &listValues )
+{
+  if ( listValues.isEmpty() )
+    return mNotIn ? TVL_True : TVL_False;
+  if ( isNull( value ) )
+    return TVL_Unknown;
+
+  bool listHasNull = false;
+
+  Q_FOREACH ( const QVariant& v2, listValues )
+  {
+    if ( isNull( v2 ) )
+      listHasNull = true;
+    else
+    {
+      bool equal = inListItemEqual( value, v2, parent );
+      ENSURE_NO_EVAL_ERROR;
 
       if ( equal ) // we know the result
         return mNotIn ? TVL_False : TVL_True;
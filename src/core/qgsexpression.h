@@ -24,8 +24,8 @@
 #include <QCoreApplication>
 
 #include "qgis.h"
+#include "qgsfeature.h"
 
-class QgsFeature;
 class QgsGeometry;
 class QgsOgcUtils;
 class QgsVectorLayer;
@@ -35,6 +35,7 @@ class QgsFields;
 class QgsDistanceArea;
 class QDomElement;
 class QgsExpressionContext;
+class QgsExpressionProgram;
 
 /**
 Class for parsing and evaluation of expressions (formerly called "search strings").
@@ -126,6 +127,65 @@ class CORE_EXPORT QgsExpression
     //! Returns true if the expression uses feature geometry for some computation
     bool needsGeometry() const;
 
+    /** Sets whether prepare() should compile the expression into a flat program which
+     * is then used by evaluate() instead of walking the node tree. Compilation is enabled
+     * by default. Changing the setting discards any existing compiled program, so prepare()
+     * must be called again for it to take effect.
+     * @param enabled set to true to compile prepared expressions
+     * @see compilationEnabled()
+     * @see isCompiled()
+     * @note added in QGIS 2.12
+     */
+    void setCompilationEnabled( bool enabled );
+
+    /** Returns whether prepare() compiles the expression into a flat program.
+     * @see setCompilationEnabled()
+     * @note added in QGIS 2.12
+     */
+    bool compilationEnabled() const { return mCompilationEnabled; }
+
+    /** Returns true if the expression has been compiled by prepare() and evaluate()
+     * will run the compiled program rather than the node tree.
+     * @see setCompilationEnabled()
+     * @note added in QGIS 2.12
+     */
+    bool isCompiled() const { return mProgram != 0; }
+
+    /** Statistics about the optimizations applied by prepare() when compiling an expression.
+     * @see compilationStatistics()
+     * @note added in QGIS 2.12
+     */
+    struct CompilationStatistics
+    {
+      CompilationStatistics() : nodeCount( 0 ), foldedNodeCount( 0 ), sharedNodeCount( 0 ), instructionCount( 0 ) {}
+
+      //! Adds the statistics of another expression, e.g. to sum up all expressions of a style
+      CompilationStatistics& operator+=( const CompilationStatistics& other )
+      {
+        nodeCount += other.nodeCount;
+        foldedNodeCount += other.foldedNodeCount;
+        sharedNodeCount += other.sharedNodeCount;
+        instructionCount += other.instructionCount;
+        return *this;
+      }
+
+      //! Number of nodes in the expression
+      int nodeCount;
+      //! Number of nodes which were replaced by constants because their value does not depend on the feature
+      int foldedNodeCount;
+      //! Number of nodes which reuse the result of an identical subtree
+      int sharedNodeCount;
+      //! Number of instructions in the compiled program
+      int instructionCount;
+    };
+
+    /** Returns statistics about the optimizations applied when the expression was compiled.
+     * All counts are zero if the expression is not compiled.
+     * @see isCompiled()
+     * @note added in QGIS 2.12
+     */
+    CompilationStatistics compilationStatistics() const;
+
     // evaluation
 
     //! Evaluate the feature and return the result
@@ -159,6 +219,20 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext* context );
 
+    /** Evaluates the expression for a block of features. The result for every feature is
+     * the same as calling evaluate() with that feature set in the context, but compiled
+     * expressions consisting only of field references and operators are evaluated one
+     * operator at a time for the whole block, which is considerably faster.
+     * @param features features to evaluate the expression for
+     * @param context context for evaluating expression. The context feature is changed by
+     * this method and is left in an unspecified state.
+     * @returns one result per feature. If evaluation fails for a feature its result is null,
+     * and hasEvalError() and evalErrorString() report the error of the first failing feature.
+     * @note prepare() should be called before calling this method.
+     * @note added in QGIS 2.12
+     */
+    QVariantList evaluateBlock( const QgsFeatureList& features, QgsExpressionContext* context );
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const { return !mEvalErrorString.isNull(); }
     //! Returns evaluation error
@@ -708,6 +782,12 @@ class CORE_EXPORT QgsExpression
         virtual QVariant eval( QgsExpression* parent, const QgsExpressionContext* context ) override;
         virtual QString dump() const override;
 
+        /** Applies the operator to an already evaluated operand value.
+         * Errors are reported to the parent
+         * @note added in QGIS 2.12
+         */
+        QVariant compute( QgsExpression* parent, const QVariant& value );
+
         virtual QStringList referencedColumns() const override { return mOperand->referencedColumns(); }
         virtual bool needsGeometry() const override { return mOperand->needsGeometry(); }
         virtual void accept( Visitor& v ) const override { v.visit( *this ); }
@@ -732,6 +812,12 @@ class CORE_EXPORT QgsExpression
         virtual QVariant eval( QgsExpression* parent, const QgsExpressionContext* context ) override;
         virtual QString dump() const override;
 
+        /** Applies the operator to already evaluated left and right operand values.
+         * Errors are reported to the parent
+         * @note added in QGIS 2.12
+         */
+        QVariant compute( QgsExpression* parent, const QVariant& vL, const QVariant& vR );
+
         virtual QStringList referencedColumns() const override { return mOpLeft->referencedColumns() + mOpRight->referencedColumns(); }
         virtual bool needsGeometry() const override { return mOpLeft->needsGeometry() || mOpRight->needsGeometry(); }
         virtual void accept( Visitor& v ) const override { v.visit( *this ); }
@@ -765,6 +851,12 @@ class CORE_EXPORT QgsExpression
         virtual QVariant eval( QgsExpression* parent, const QgsExpressionContext* context ) override;
         virtual QString dump() const override;
 
+        /** Tests an already evaluated value against already evaluated list values.
+         * Errors are reported to the parent
+         * @note added in QGIS 2.12
+         */
+        QVariant compute( QgsExpression* parent, const QVariant& value, const QVariantList& listValues );
+
         virtual QStringList referencedColumns() const override { QStringList lst( mNode->referencedColumns() ); Q_FOREACH ( Node* n, mList->list() ) lst.append( n->referencedColumns() ); return lst; }
         virtual bool needsGeometry() const override { bool needs = false; Q_FOREACH ( Node* n, mList->list() ) needs |= n->needsGeometry(); return needs; }
         virtual void accept( Visitor& v ) const override { v.visit( *this ); }
@@ -831,6 +923,12 @@ class CORE_EXPORT QgsExpression
 
         QString name() const { return mName; }
 
+        /** Returns the index of the referenced field, or -1 if the node has not been prepared
+         * or the field was not found
+         * @note added in QGIS 2.12
+         */
+        int index() const { return mIndex; }
+
         virtual NodeType nodeType() const override { return ntColumnRef; }
         virtual bool prepare( QgsExpression* parent, const QgsExpressionContext* context ) override;
         virtual QVariant eval( QgsExpression* parent, const QgsExpressionContext* context ) override;
@@ -864,6 +962,15 @@ class CORE_EXPORT QgsExpression
         NodeCondition( WhenThenList* conditions, Node* elseExp = NULL ) : mConditions( *conditions ), mElseExp( elseExp ) { delete conditions; }
         ~NodeCondition() { delete mElseExp; qDeleteAll( mConditions ); }
 
+        /** Returns the list of WHEN ... THEN ... clauses
+         * @note added in QGIS 2.12
+         */
+        WhenThenList conditions() const { return mConditions; }
+        /** Returns the ELSE expression, or null if there is none
+         * @note added in QGIS 2.12
+         */
+        Node* elseExp() const { return mElseExp; }
+
         virtual NodeType nodeType() const override { return ntCondition; }
         virtual QVariant eval( QgsExpression* parent, const QgsExpressionContext* context ) override;
         virtual bool prepare( QgsExpression* parent, const QgsExpressionContext* context ) override;
@@ -922,7 +1029,7 @@ class CORE_EXPORT QgsExpression
     /**
      * Used by QgsOgcUtils to create an empty
      */
-    QgsExpression() : mRootNode( 0 ), mRowNumber( 0 ), mScale( 0.0 ), mCalc( 0 ) {}
+    QgsExpression() : mRootNode( 0 ), mRowNumber( 0 ), mScale( 0.0 ), mCalc( 0 ), mProgram( 0 ), mCompilationEnabled( true ) {}
 
     void initGeomCalculator();
 
@@ -937,6 +1044,10 @@ class CORE_EXPORT QgsExpression
 
     QgsDistanceArea *mCalc;
 
+    //! compiled form of the prepared node tree, or null if evaluation walks the tree
+    QgsExpressionProgram* mProgram;
+    bool mCompilationEnabled;
+
     static QMap<QString, QVariant> gmSpecialColumns;
     static QMap<QString, QString> gmSpecialColumnGroups;
 
@@ -84,8 +84,10 @@ class CORE_EXPORT QgsExpressionContextScope
        * @param name variable name (should be unique within the QgsExpressionContextScope)
        * @param value intial variable value
        * @param readOnly true if variable should not be editable by users
+       * @param isStatic true if the variable keeps its value while a layer or map is rendered
        */
-      StaticVariable( const QString& name = QString(), const QVariant& value = QVariant(), bool readOnly = false ) : name( name ), value( value ), readOnly( readOnly ) {}
+      StaticVariable( const QString& name = QString(), const QVariant& value = QVariant(), bool readOnly = false, bool isStatic = false )
+          : name( name ), value( value ), readOnly( readOnly ), isStatic( isStatic ) {}
 
       /** Variable name */
       QString name;
@@ -95,6 +97,12 @@ class CORE_EXPORT QgsExpressionContextScope
 
       /** True if variable should not be editable by users */
       bool readOnly;
+
+      /** True if the variable does not change while a layer or map is rendered, which allows
+       * expressions to be optimised for the variable's value when they are prepared.
+       * @note added in QGIS 2.12
+       */
+      bool isStatic;
     };
 
     /** Constructor for QgsExpressionContextScope
@@ -173,6 +181,14 @@ class CORE_EXPORT QgsExpressionContextScope
      */
     bool isReadOnly( const QString& name ) const;
 
+    /** Tests whether the specified variable is static, i.e. keeps its value while
+     * a layer or map is rendered.
+     * @param name variable name
+     * @returns true if variable is static
+     * @note added in QGIS 2.12
+     */
+    bool isStatic( const QString& name ) const;
+
     /** Returns the count of variables contained within the scope.
      */
     int variableCount() const { return mVariables.count(); }
@@ -345,6 +361,15 @@ class CORE_EXPORT QgsExpressionContext
      */
     bool isReadOnly( const QString& name ) const;
 
+    /** Returns whether a variable is static, i.e. keeps its value while a layer or map is
+     * rendered. Prepared expressions may replace static variables by their value.
+     * @param name variable name
+     * @returns true if variable is static. Static status will be taken from the last
+     * matching scope which contains a matching variable.
+     * @note added in QGIS 2.12
+     */
+    bool isStatic( const QString& name ) const;
+
     /** Checks whether a specified function is contained in the context.
      * @param name function name
      * @returns true if context provides a matching function
@@ -0,0 +1,1527 @@
+/***************************************************************************
+                               qgsexpressionprogram.cpp
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram.h"
+
+#include "qgsexpressioncontext.h"
+#include "qgsfeature.h"
+
+#include <QtAlgorithms>
+#include <qmath.h>
+
+#include <math.h>
+
+
+void QgsExpressionProgram::Register::setVariant( const QVariant& value )
+{
+  if ( value.isNull() )
+  {
+    // keep the original value, the type of a null value still matters for some operators
+    kind = Null;
+    v = value;
+  }
+  else if ( value.type() == QVariant::Int )
+  {
+    kind = Int;
+    i = value.toInt();
+  }
+  else if ( value.type() == QVariant::Double )
+  {
+    kind = Double;
+    d = value.toDouble();
+  }
+  else
+  {
+    kind = Variant;
+    v = value;
+  }
+}
+
+QVariant QgsExpressionProgram::Register::toVariant() const
+{
+  switch ( kind )
+  {
+    case Int:
+      return QVariant( i );
+    case Double:
+      return QVariant( d );
+    case Null:
+    case Variant:
+    default:
+      return v;
+  }
+}
+
+
+void QgsExpressionProgram::Column::value( int row, Register& out ) const
+{
+  switch ( layout )
+  {
+    case Scalar:
+      out = scalar;
+      break;
+    case Ints:
+      out.setInt( intValues[row] );
+      break;
+    case Doubles:
+      out.setDouble( doubleValues[row] );
+      break;
+    case Rows:
+      out = rows[row];
+      break;
+  }
+}
+
+QVariant QgsExpressionProgram::Column::variant( int row ) const
+{
+  switch ( layout )
+  {
+    case Scalar:
+      return scalar.toVariant();
+    case Ints:
+      return QVariant( intValues[row] );
+    case Doubles:
+      return QVariant( doubleValues[row] );
+    case Rows:
+    default:
+      return rows[row].toVariant();
+  }
+}
+
+bool QgsExpressionProgram::Column::isNumberColumn() const
+{
+  switch ( layout )
+  {
+    case Ints:
+    case Doubles:
+      return true;
+    case Scalar:
+      return scalar.kind == Register::Int || ( scalar.kind == Register::Double && qIsFinite( scalar.d ) );
+    case Rows:
+    default:
+      return false;
+  }
+}
+
+const double* QgsExpressionProgram::Column::doubles( QVector<double>& buffer, int count ) const
+{
+  if ( layout == Doubles )
+    return doubleValues.constData();
+
+  buffer.resize( count );
+  double* out = buffer.data();
+  if ( layout == Ints )
+  {
+    const int* in = intValues.constData();
+    for ( int i = 0; i < count; ++i )
+      out[i] = in[i];
+  }
+  else
+  {
+    const double value = scalar.toDouble();
+    for ( int i = 0; i < count; ++i )
+      out[i] = value;
+  }
+  return buffer.constData();
+}
+
+const int* QgsExpressionProgram::Column::ints( QVector<int>& buffer, int count ) const
+{
+  if ( layout == Ints )
+    return intValues.constData();
+
+  buffer.fill( scalar.i, count );
+  return buffer.constData();
+}
+
+void QgsExpressionProgram::Column::setRows( int count )
+{
+  layout = Rows;
+  rows.fill( Register(), count );
+}
+
+void QgsExpressionProgram::Column::checkFinite()
+{
+  const int count = doubleValues.count();
+  const double* values = doubleValues.constData();
+  bool finite = true;
+  for ( int i = 0; i < count && finite; ++i )
+    finite = qIsFinite( values[i] );
+  if ( finite )
+    return;
+
+  // operators report non-finite operands as conversion errors, which needs the row by row path
+  rows.resize( count );
+  for ( int i = 0; i < count; ++i )
+    rows[i].setDouble( values[i] );
+  layout = Rows;
+}
+
+bool QgsExpressionProgram::BlockErrors::take( QgsExpression* parent, int row )
+{
+  if ( !parent->hasEvalError() )
+    return false;
+
+  failed[row] = 1;
+  messages.insert( row, parent->evalErrorString() );
+  parent->setEvalErrorString( QString() );
+  return true;
+}
+
+
+QgsExpressionProgram::QgsExpressionProgram()
+    : mResultRegister( -1 )
+    , mColumnar( false )
+    , mNodeCount( 0 )
+    , mFoldedNodeCount( 0 )
+    , mSharedNodeCount( 0 )
+    , mParent( 0 )
+    , mContext( 0 )
+{
+}
+
+QgsExpressionProgram* QgsExpressionProgram::compile( QgsExpression* parent, QgsExpression::Node* root, const QgsExpressionContext* context )
+{
+  if ( !root )
+    return 0;
+
+  QgsExpressionProgram* program = new QgsExpressionProgram();
+  program->mParent = parent;
+  program->mContext = context;
+  program->mNodeCount = countNodes( root );
+  program->mResultRegister = program->compileNode( root );
+  program->mParent = 0;
+  program->mContext = 0;
+  program->mSharedRegisters.clear();
+
+  program->mColumnar = true;
+  Q_FOREACH ( const Instruction& instruction, program->mCode )
+  {
+    if ( instruction.op != opColumnRef && instruction.op != opUnary && instruction.op != opBinary && instruction.op != opIn )
+    {
+      program->mColumnar = false;
+      break;
+    }
+  }
+  return program;
+}
+
+int QgsExpressionProgram::treeFallbackCount() const
+{
+  int count = 0;
+  Q_FOREACH ( const Instruction& instruction, mCode )
+  {
+    if ( instruction.op == opEvalNode )
+      ++count;
+  }
+  return count;
+}
+
+int QgsExpressionProgram::addRegister()
+{
+  mRegisters.append( Register() );
+  return mRegisters.count() - 1;
+}
+
+int QgsExpressionProgram::addInstruction( const Instruction& instruction )
+{
+  mCode.append( instruction );
+  return mCode.count() - 1;
+}
+
+int QgsExpressionProgram::compileNode( QgsExpression::Node* node )
+{
+  if ( node->nodeType() == QgsExpression::ntLiteral )
+    return compileOperation( node );
+
+  // subtrees which give the same result for every feature are evaluated right away
+  if ( isConstant( node ) )
+  {
+    int reg = compileConstant( node );
+    if ( reg >= 0 )
+      return reg;
+  }
+
+  // identical subtrees are only evaluated once
+  QString key;
+  bool shareable = sharingKey( node, key );
+  if ( shareable && mSharedRegisters.contains( key ) )
+  {
+    mSharedNodeCount += countNodes( node );
+    return mSharedRegisters.value( key );
+  }
+
+  int reg = compileOperation( node );
+  if ( shareable )
+    mSharedRegisters.insert( key, reg );
+  return reg;
+}
+
+int QgsExpressionProgram::compileConstant( QgsExpression::Node* node )
+{
+  QVariant value = node->eval( mParent, mContext );
+  if ( mParent->hasEvalError() )
+  {
+    // keep evaluating the subtree for every feature, so that the error is reported when evaluating
+    mParent->setEvalErrorString( QString() );
+    return -1;
+  }
+
+  mFoldedNodeCount += countNodes( node );
+  int reg = addRegister();
+  mRegisters[reg].setVariant( value );
+  return reg;
+}
+
+int QgsExpressionProgram::compileOperation( QgsExpression::Node* node )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+    {
+      QgsExpression::NodeLiteral* n = dynamic_cast<QgsExpression::NodeLiteral*>( node );
+      if ( !n )
+        return compileFallback( node );
+
+      // literals live in registers which are never written by any instruction
+      int reg = addRegister();
+      mRegisters[reg].setVariant( n->value() );
+      return reg;
+    }
+
+    case QgsExpression::ntColumnRef:
+    {
+      QgsExpression::NodeColumnRef* n = dynamic_cast<QgsExpression::NodeColumnRef*>( node );
+      if ( !n )
+        return compileFallback( node );
+
+      int reg = addRegister();
+      Instruction instruction( opColumnRef, reg, node );
+      instruction.a = n->index();
+      addInstruction( instruction );
+      return reg;
+    }
+
+    case QgsExpression::ntUnaryOperator:
+    {
+      QgsExpression::NodeUnaryOperator* n = dynamic_cast<QgsExpression::NodeUnaryOperator*>( node );
+      if ( !n )
+        return compileFallback( node );
+
+      int operand = compileNode( n->operand() );
+      int reg = addRegister();
+      Instruction instruction( opUnary, reg, node );
+      instruction.a = operand;
+      instruction.c = n->op();
+      addInstruction( instruction );
+      return reg;
+    }
+
+    case QgsExpression::ntBinaryOperator:
+    {
+      QgsExpression::NodeBinaryOperator* n = dynamic_cast<QgsExpression::NodeBinaryOperator*>( node );
+      if ( !n )
+        return compileFallback( node );
+
+      int left = compileNode( n->opLeft() );
+      int right = compileNode( n->opRight() );
+      int reg = addRegister();
+      Instruction instruction( opBinary, reg, node );
+      instruction.a = left;
+      instruction.b = right;
+      instruction.c = n->op();
+      addInstruction( instruction );
+      return reg;
+    }
+
+    case QgsExpression::ntInOperator:
+    {
+      QgsExpression::NodeInOperator* n = dynamic_cast<QgsExpression::NodeInOperator*>( node );
+      if ( !n )
+        return compileFallback( node );
+      return compileIn( n );
+    }
+
+    case QgsExpression::ntFunction:
+    {
+      QgsExpression::NodeFunction* n = dynamic_cast<QgsExpression::NodeFunction*>( node );
+      if ( !n )
+        return compileFallback( node );
+      return compileFunction( n );
+    }
+
+    case QgsExpression::ntCondition:
+    {
+      QgsExpression::NodeCondition* n = dynamic_cast<QgsExpression::NodeCondition*>( node );
+      if ( !n )
+        return compileFallback( node );
+      return compileCondition( n );
+    }
+  }
+
+  return compileFallback( node );
+}
+
+int QgsExpressionProgram::compileFallback( QgsExpression::Node* node )
+{
+  int reg = addRegister();
+  addInstruction( Instruction( opEvalNode, reg, node ) );
+  return reg;
+}
+
+int QgsExpressionProgram::compileFunction( QgsExpression::NodeFunction* node )
+{
+  int slotIndex = mCallSlots.count();
+  CallSlot slot;
+  slot.fnIndex = node->fnIndex();
+  mCallSlots.append( slot );
+
+  int reg = addRegister();
+
+  // the function is resolved when the program runs, as the context may override it
+  Instruction begin( opCallBegin, reg, node );
+  begin.a = slotIndex;
+  QList<int> exitJumps;
+  exitJumps << addInstruction( begin );
+
+  // arguments are checked for nulls one by one, exactly like the node tree does
+  // arguments may be skipped, so results computed for them can not be shared with later nodes
+  const QHash<QString, int> sharedRegisters = mSharedRegisters;
+
+  QVector<int> argRegisters;
+  if ( node->args() )
+  {
+    Q_FOREACH ( QgsExpression::Node* arg, node->args()->list() )
+    {
+      int argReg = compileNode( arg );
+      mSharedRegisters = sharedRegisters;
+      Instruction check( opCallArgCheck, reg );
+      check.a = slotIndex;
+      check.b = argReg;
+      exitJumps << addInstruction( check );
+      argRegisters << argReg;
+    }
+  }
+
+  CallSlot& compiledSlot = mCallSlots[slotIndex];
+  compiledSlot.argRegisters = argRegisters;
+  for ( int i = 0; i < argRegisters.count(); ++i )
+    compiledSlot.argValues << QVariant();
+
+  Instruction call( opCall, reg, node );
+  call.a = slotIndex;
+  addInstruction( call );
+
+  Q_FOREACH ( int jump, exitJumps )
+    patchJump( jump );
+
+  return reg;
+}
+
+int QgsExpressionProgram::compileIn( QgsExpression::NodeInOperator* node )
+{
+  QgsExpression::NodeList* list = node->list();
+  if ( !list || list->count() == 0 )
+    return compileFallback( node );
+
+  // only literal lists are compiled, the tree stops evaluating list items at the first match
+  InList inList;
+  Q_FOREACH ( QgsExpression::Node* item, list->list() )
+  {
+    QgsExpression::NodeLiteral* literal = dynamic_cast<QgsExpression::NodeLiteral*>( item );
+    if ( !literal )
+      return compileFallback( node );
+
+    QVariant value = literal->value();
+    inList.values << value;
+    if ( value.isNull() || ( value.type() != QVariant::Int && value.type() != QVariant::Double ) || !qIsFinite( value.toDouble() ) )
+      inList.numeric = false;
+    else
+      inList.numbers << value.toDouble();
+  }
+  qSort( inList.numbers );
+
+  int valueReg = compileNode( node->node() );
+  mInLists.append( inList );
+
+  int reg = addRegister();
+  Instruction instruction( opIn, reg, node );
+  instruction.a = valueReg;
+  instruction.b = mInLists.count() - 1;
+  addInstruction( instruction );
+  return reg;
+}
+
+int QgsExpressionProgram::compileCondition( QgsExpression::NodeCondition* node )
+{
+  int reg = addRegister();
+  QList<int> endJumps;
+
+  // whether a part of the condition is evaluated depends on the previous parts, so results
+  // computed inside a part can not be shared with other parts or with later nodes
+  const QHash<QString, int> sharedRegisters = mSharedRegisters;
+
+  Q_FOREACH ( QgsExpression::WhenThen* cond, node->conditions() )
+  {
+    int whenReg = compileNode( cond->mWhenExp );
+    mSharedRegisters = sharedRegisters;
+    Instruction test( opJumpIfNotTrue );
+    test.a = whenReg;
+    int testJump = addInstruction( test );
+
+    int thenReg = compileNode( cond->mThenExp );
+    mSharedRegisters = sharedRegisters;
+    Instruction move( opMove, reg );
+    move.a = thenReg;
+    addInstruction( move );
+    endJumps << addInstruction( Instruction( opJump ) );
+
+    patchJump( testJump );
+  }
+
+  // without ELSE the result is NULL, which is what a fresh register holds
+  int elseReg = node->elseExp() ? compileNode( node->elseExp() ) : addRegister();
+  mSharedRegisters = sharedRegisters;
+  Instruction move( opMove, reg );
+  move.a = elseReg;
+  addInstruction( move );
+
+  Q_FOREACH ( int jump, endJumps )
+    patchJump( jump );
+
+  return reg;
+}
+
+QgsExpression::Function* QgsExpressionProgram::staticFunction( int fnIndex ) const
+{
+  if ( fnIndex < 0 || fnIndex >= QgsExpression::Functions().count() )
+    return 0;
+
+  QgsExpression::Function* fd = QgsExpression::Functions()[fnIndex];
+  // functions provided by the context are resolved when the program runs
+  if ( mContext && mContext->hasFunction( fd->name() ) )
+    return 0;
+  return fd;
+}
+
+bool QgsExpressionProgram::isConstant( QgsExpression::Node* node ) const
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+      return true;
+
+    case QgsExpression::ntColumnRef:
+      return false;
+
+    case QgsExpression::ntFunction:
+    {
+      QgsExpression::NodeFunction* n = dynamic_cast<QgsExpression::NodeFunction*>( node );
+      QgsExpression::Function* fd = n ? staticFunction( n->fnIndex() ) : 0;
+      if ( !fd )
+        return false;
+
+      if ( fd->name() == "var" )
+      {
+        // only variables which do not change while rendering can be folded
+        QgsExpression::NodeLiteral* name = n->args() && n->args()->count() == 1 ? dynamic_cast<QgsExpression::NodeLiteral*>( n->args()->list().at( 0 ) ) : 0;
+        return name && mContext && mContext->isStatic( name->value().toString() );
+      }
+      if ( !isPureFunction( fd ) )
+        return false;
+      break;
+    }
+
+    case QgsExpression::ntUnaryOperator:
+    case QgsExpression::ntBinaryOperator:
+    case QgsExpression::ntInOperator:
+    case QgsExpression::ntCondition:
+      break;
+  }
+
+  QList<QgsExpression::Node*> nodes = children( node );
+  if ( nodes.isEmpty() && node->nodeType() != QgsExpression::ntFunction )
+    return false; // unknown node class
+
+  Q_FOREACH ( QgsExpression::Node* child, nodes )
+  {
+    if ( !isConstant( child ) )
+      return false;
+  }
+  return true;
+}
+
+bool QgsExpressionProgram::sharingKey( QgsExpression::Node* node, QString& key ) const
+{
+  QString prefix;
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+    {
+      QgsExpression::NodeLiteral* n = dynamic_cast<QgsExpression::NodeLiteral*>( node );
+      if ( !n )
+        return false;
+
+      const QVariant& value = n->value();
+      QString text = value.isNull() ? QString() : ( value.type() == QVariant::Double ? QString::number( value.toDouble(), 'g', 17 ) : value.toString() );
+      key = QString( "L%1%2:%3:%4" ).arg( value.type() ).arg( value.isNull() ? "n" : "" ).arg( text.length() ).arg( text );
+      return true;
+    }
+
+    case QgsExpression::ntColumnRef:
+    {
+      QgsExpression::NodeColumnRef* n = dynamic_cast<QgsExpression::NodeColumnRef*>( node );
+      if ( !n )
+        return false;
+      key = QString( "C%1:%2" ).arg( n->name().length() ).arg( n->name() );
+      return true;
+    }
+
+    case QgsExpression::ntUnaryOperator:
+    {
+      QgsExpression::NodeUnaryOperator* n = dynamic_cast<QgsExpression::NodeUnaryOperator*>( node );
+      if ( !n )
+        return false;
+      prefix = QString( "U%1" ).arg( n->op() );
+      break;
+    }
+
+    case QgsExpression::ntBinaryOperator:
+    {
+      QgsExpression::NodeBinaryOperator* n = dynamic_cast<QgsExpression::NodeBinaryOperator*>( node );
+      if ( !n )
+        return false;
+      prefix = QString( "B%1" ).arg( n->op() );
+      break;
+    }
+
+    case QgsExpression::ntInOperator:
+    {
+      QgsExpression::NodeInOperator* n = dynamic_cast<QgsExpression::NodeInOperator*>( node );
+      if ( !n )
+        return false;
+      prefix = n->isNotIn() ? "N" : "I";
+      break;
+    }
+
+    case QgsExpression::ntFunction:
+    {
+      QgsExpression::NodeFunction* n = dynamic_cast<QgsExpression::NodeFunction*>( node );
+      QgsExpression::Function* fd = n ? staticFunction( n->fnIndex() ) : 0;
+      // variables may change between features, but not while a feature is evaluated
+      if ( !fd || ( fd->name() != "var" && !isPureFunction( fd ) ) )
+        return false;
+      prefix = QString( "F%1" ).arg( n->fnIndex() );
+      break;
+    }
+
+    case QgsExpression::ntCondition:
+    {
+      if ( !dynamic_cast<QgsExpression::NodeCondition*>( node ) )
+        return false;
+      prefix = "W";
+      break;
+    }
+  }
+
+  if ( prefix.isEmpty() )
+    return false;
+
+  QStringList parts;
+  Q_FOREACH ( QgsExpression::Node* child, children( node ) )
+  {
+    QString childKey;
+    if ( !child || !sharingKey( child, childKey ) )
+      return false;
+    parts << childKey;
+  }
+  key = prefix + '(' + parts.join( "," ) + ')';
+  return true;
+}
+
+QList<QgsExpression::Node*> QgsExpressionProgram::children( QgsExpression::Node* node )
+{
+  QList<QgsExpression::Node*> nodes;
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+    case QgsExpression::ntColumnRef:
+      break;
+
+    case QgsExpression::ntUnaryOperator:
+    {
+      QgsExpression::NodeUnaryOperator* n = dynamic_cast<QgsExpression::NodeUnaryOperator*>( node );
+      if ( n )
+        nodes << n->operand();
+      break;
+    }
+
+    case QgsExpression::ntBinaryOperator:
+    {
+      QgsExpression::NodeBinaryOperator* n = dynamic_cast<QgsExpression::NodeBinaryOperator*>( node );
+      if ( n )
+        nodes << n->opLeft() << n->opRight();
+      break;
+    }
+
+    case QgsExpression::ntInOperator:
+    {
+      QgsExpression::NodeInOperator* n = dynamic_cast<QgsExpression::NodeInOperator*>( node );
+      if ( n )
+      {
+        nodes << n->node();
+        if ( n->list() )
+          nodes << n->list()->list();
+      }
+      break;
+    }
+
+    case QgsExpression::ntFunction:
+    {
+      QgsExpression::NodeFunction* n = dynamic_cast<QgsExpression::NodeFunction*>( node );
+      if ( n && n->args() )
+        nodes << n->args()->list();
+      break;
+    }
+
+    case QgsExpression::ntCondition:
+    {
+      QgsExpression::NodeCondition* n = dynamic_cast<QgsExpression::NodeCondition*>( node );
+      if ( n )
+      {
+        Q_FOREACH ( QgsExpression::WhenThen* cond, n->conditions() )
+          nodes << cond->mWhenExp << cond->mThenExp;
+        if ( n->elseExp() )
+          nodes << n->elseExp();
+      }
+      break;
+    }
+  }
+  return nodes;
+}
+
+int QgsExpressionProgram::countNodes( QgsExpression::Node* node )
+{
+  int count = 1;
+  Q_FOREACH ( QgsExpression::Node* child, children( node ) )
+    count += countNodes( child );
+  return count;
+}
+
+bool QgsExpressionProgram::isPureFunction( QgsExpression::Function* function )
+{
+  // built-in functions which only depend on their arguments
+  static QStringList pureGroups = QStringList() << "Math" << "Conversions" << "Conditionals" << "String"
+                                  << "Fuzzy Matching" << "Color" << "Date and Time";
+  static QStringList impureFunctions = QStringList() << "rand" << "randf" << "now";
+
+  if ( function->usesgeometry() || !function->referencedColumns().isEmpty() )
+    return false;
+
+  const QString name = function->name();
+  return QgsExpression::BuiltinFunctions().contains( name ) && pureGroups.contains( function->group() ) && !impureFunctions.contains( name );
+}
+
+int QgsExpressionProgram::tvlValue( const Register& value, QgsExpression* parent )
+{
+  switch ( value.kind )
+  {
+    case Register::Null:
+      return tvlUnknown;
+    case Register::Int:
+      return value.i != 0 ? tvlTrue : tvlFalse;
+    case Register::Double:
+      return value.d != 0 ? tvlTrue : tvlFalse;
+    case Register::Variant:
+      break;
+  }
+
+  bool ok;
+  double x = value.v.toDouble( &ok );
+  if ( !ok )
+  {
+    parent->setEvalErrorString( QObject::tr( "Cannot convert '%1' to boolean" ).arg( value.v.toString() ) );
+    return tvlUnknown;
+  }
+  return x != 0 ? tvlTrue : tvlFalse;
+}
+
+bool QgsExpressionProgram::computeUnary( QgsExpression::UnaryOperator op, const Register& value, Register& result )
+{
+  switch ( op )
+  {
+    case QgsExpression::uoNot:
+      if ( value.kind == Register::Null )
+        result.setNull();
+      else if ( value.isNumeric() )
+        result.setInt( value.toDouble() != 0 ? 0 : 1 );
+      else
+        return false;
+      return true;
+
+    case QgsExpression::uoMinus:
+      if ( value.kind == Register::Int )
+        result.setInt( -value.i );
+      else if ( value.kind == Register::Double && qIsFinite( value.d ) )
+        result.setDouble( -value.d );
+      else
+        return false;
+      return true;
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::computeBinary( QgsExpression::BinaryOperator op, const Register& left, const Register& right, Register& result )
+{
+  const bool anyNull = left.kind == Register::Null || right.kind == Register::Null;
+
+  switch ( op )
+  {
+    case QgsExpression::boPlus:
+    case QgsExpression::boMinus:
+    case QgsExpression::boMul:
+    case QgsExpression::boDiv:
+    case QgsExpression::boMod:
+    case QgsExpression::boPow:
+    {
+      if ( anyNull )
+      {
+        // "+" concatenates strings even if they are null, let the tree implementation decide
+        if ( op == QgsExpression::boPlus && !left.isNumeric() && !right.isNumeric() )
+          return false;
+        result.setNull();
+        return true;
+      }
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+
+      if ( op != QgsExpression::boDiv && op != QgsExpression::boPow && left.kind == Register::Int && right.kind == Register::Int )
+      {
+        const int x = left.i, y = right.i;
+        switch ( op )
+        {
+          case QgsExpression::boPlus: result.setInt( x + y ); break;
+          case QgsExpression::boMinus: result.setInt( x - y ); break;
+          case QgsExpression::boMul: result.setInt( x * y ); break;
+          case QgsExpression::boMod:
+            if ( y == 0 )
+              result.setNull();
+            else
+              result.setInt( x % y );
+            break;
+          default: return false;
+        }
+        return true;
+      }
+
+      const double x = left.toDouble(), y = right.toDouble();
+      if ( !qIsFinite( x ) || !qIsFinite( y ) )
+        return false; // reported as conversion error by the tree implementation
+
+      switch ( op )
+      {
+        case QgsExpression::boPlus: result.setDouble( x + y ); break;
+        case QgsExpression::boMinus: result.setDouble( x - y ); break;
+        case QgsExpression::boMul: result.setDouble( x * y ); break;
+        case QgsExpression::boDiv:
+          if ( y == 0. )
+            result.setNull();
+          else
+            result.setDouble( x / y );
+          break;
+        case QgsExpression::boMod:
+          if ( y == 0. )
+            result.setNull();
+          else
+            result.setDouble( fmod( x, y ) );
+          break;
+        case QgsExpression::boPow: result.setDouble( pow( x, y ) ); break;
+        default: return false;
+      }
+      return true;
+    }
+
+    case QgsExpression::boIntDiv:
+    {
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+      const double x = left.toDouble(), y = right.toDouble();
+      if ( !qIsFinite( x ) || !qIsFinite( y ) )
+        return false;
+      if ( y == 0. )
+        result.setNull();
+      else
+        result.setInt( qFloor( x / y ) );
+      return true;
+    }
+
+    case QgsExpression::boAnd:
+    case QgsExpression::boOr:
+    {
+      if ( left.kind == Register::Variant || right.kind == Register::Variant )
+        return false;
+      const int l = tvlValue( left, 0 ), r = tvlValue( right, 0 );
+      int tvl;
+      if ( op == QgsExpression::boAnd )
+        tvl = l == tvlFalse || r == tvlFalse ? tvlFalse : ( l == tvlUnknown || r == tvlUnknown ? tvlUnknown : tvlTrue );
+      else
+        tvl = l == tvlTrue || r == tvlTrue ? tvlTrue : ( l == tvlUnknown || r == tvlUnknown ? tvlUnknown : tvlFalse );
+
+      if ( tvl == tvlUnknown )
+        result.setNull();
+      else
+        result.setInt( tvl == tvlTrue ? 1 : 0 );
+      return true;
+    }
+
+    case QgsExpression::boEQ:
+    case QgsExpression::boNE:
+    case QgsExpression::boLT:
+    case QgsExpression::boGT:
+    case QgsExpression::boLE:
+    case QgsExpression::boGE:
+    {
+      if ( anyNull )
+      {
+        result.setNull();
+        return true;
+      }
+      if ( !left.isNumeric() || !right.isNumeric() )
+        return false;
+      const double x = left.toDouble(), y = right.toDouble();
+      if ( !qIsFinite( x ) || !qIsFinite( y ) )
+        return false;
+
+      const double diff = x - y;
+      bool res;
+      switch ( op )
+      {
+        case QgsExpression::boEQ: res = diff == 0; break;
+        case QgsExpression::boNE: res = diff != 0; break;
+        case QgsExpression::boLT: res = diff < 0; break;
+        case QgsExpression::boGT: res = diff > 0; break;
+        case QgsExpression::boLE: res = diff <= 0; break;
+        case QgsExpression::boGE: res = diff >= 0; break;
+        default: return false;
+      }
+      result.setInt( res ? 1 : 0 );
+      return true;
+    }
+
+    case QgsExpression::boIs:
+    case QgsExpression::boIsNot:
+    {
+      bool equal;
+      if ( left.kind == Register::Null || right.kind == Register::Null )
+      {
+        equal = left.kind == right.kind;
+      }
+      else
+      {
+        if ( !left.isNumeric() || !right.isNumeric() )
+          return false;
+        const double x = left.toDouble(), y = right.toDouble();
+        if ( !qIsFinite( x ) || !qIsFinite( y ) )
+          return false;
+        equal = x == y;
+      }
+      result.setInt( equal == ( op == QgsExpression::boIs ) ? 1 : 0 );
+      return true;
+    }
+
+    default:
+      // strings, regular expressions and concatenation
+      return false;
+  }
+}
+
+bool QgsExpressionProgram::computeIn( const InList& list, bool notIn, const Register& value, Register& result )
+{
+  if ( value.kind == Register::Null )
+  {
+    result.setNull();
+    return true;
+  }
+  if ( !list.numeric || !value.isNumeric() || !qIsFinite( value.toDouble() ) )
+    return false;
+
+  // a numeric list contains no nulls, so the result is never unknown
+  bool found = qBinaryFind( list.numbers.constBegin(), list.numbers.constEnd(), value.toDouble() ) != list.numbers.constEnd();
+  result.setInt( found != notIn ? 1 : 0 );
+  return true;
+}
+
+QVariant QgsExpressionProgram::run( QgsExpression* parent, const QgsExpressionContext* context )
+{
+  Register* regs = mRegisters.data();
+  const Instruction* code = mCode.constData();
+  const int count = mCode.count();
+
+  // the context feature is fetched once per run instead of once per column reference
+  QgsFeature feature;
+  bool featureFetched = false;
+  bool hasFeature = false;
+
+  int pc = 0;
+  while ( pc < count )
+  {
+    const Instruction& ins = code[pc++];
+    switch ( ins.op )
+    {
+      case opColumnRef:
+      {
+        if ( !featureFetched )
+        {
+          featureFetched = true;
+          if ( context && context->hasVariable( QgsExpressionContext::EXPR_FEATURE ) )
+          {
+            feature = qvariant_cast<QgsFeature>( context->variable( QgsExpressionContext::EXPR_FEATURE ) );
+            hasFeature = true;
+          }
+        }
+
+        QgsExpression::NodeColumnRef* n = static_cast<QgsExpression::NodeColumnRef*>( ins.node );
+        if ( !hasFeature )
+          regs[ins.dest].setVariant( QVariant( "[" + n->name() + "]" ) );
+        else if ( ins.a >= 0 )
+          regs[ins.dest].setVariant( feature.attribute( ins.a ) );
+        else
+          regs[ins.dest].setVariant( feature.attribute( n->name() ) );
+        break;
+      }
+
+      case opUnary:
+      {
+        if ( !computeUnary( static_cast<QgsExpression::UnaryOperator>( ins.c ), regs[ins.a], regs[ins.dest] ) )
+        {
+          QgsExpression::NodeUnaryOperator* n = static_cast<QgsExpression::NodeUnaryOperator*>( ins.node );
+          regs[ins.dest].setVariant( n->compute( parent, regs[ins.a].toVariant() ) );
+          if ( parent->hasEvalError() )
+            return QVariant();
+        }
+        break;
+      }
+
+      case opBinary:
+      {
+        if ( !computeBinary( static_cast<QgsExpression::BinaryOperator>( ins.c ), regs[ins.a], regs[ins.b], regs[ins.dest] ) )
+        {
+          QgsExpression::NodeBinaryOperator* n = static_cast<QgsExpression::NodeBinaryOperator*>( ins.node );
+          regs[ins.dest].setVariant( n->compute( parent, regs[ins.a].toVariant(), regs[ins.b].toVariant() ) );
+          if ( parent->hasEvalError() )
+            return QVariant();
+        }
+        break;
+      }
+
+      case opIn:
+      {
+        QgsExpression::NodeInOperator* n = static_cast<QgsExpression::NodeInOperator*>( ins.node );
+        const InList& list = mInLists.at( ins.b );
+        if ( !computeIn( list, n->isNotIn(), regs[ins.a], regs[ins.dest] ) )
+        {
+          regs[ins.dest].setVariant( n->compute( parent, regs[ins.a].toVariant(), list.values ) );
+          if ( parent->hasEvalError() )
+            return QVariant();
+        }
+        break;
+      }
+
+      case opCallBegin:
+      {
+        CallSlot& slot = mCallSlots[ins.a];
+        QgsExpression::Function* fd = QgsExpression::Functions()[slot.fnIndex];
+        if ( context )
+        {
+          QString name = fd->name();
+          if ( context->hasFunction( name ) )
+            fd = context->function( name );
+        }
+        slot.resolved = fd;
+
+        if ( fd->lazyEval() )
+        {
+          // lazy functions evaluate their argument nodes themselves
+          regs[ins.dest].setVariant( ins.node->eval( parent, context ) );
+          if ( parent->hasEvalError() )
+            return QVariant();
+          pc = ins.c;
+        }
+        break;
+      }
+
+      case opCallArgCheck:
+      {
+        // all "normal" functions return NULL, when any parameter is NULL
+        if ( regs[ins.b].kind == Register::Null && !mCallSlots[ins.a].resolved->handlesNull() )
+        {
+          regs[ins.dest].setNull();
+          pc = ins.c;
+        }
+        break;
+      }
+
+      case opCall:
+      {
+        CallSlot& slot = mCallSlots[ins.a];
+        for ( int i = 0; i < slot.argRegisters.count(); ++i )
+          slot.argValues[i] = regs[slot.argRegisters[i]].toVariant();
+
+        QVariant res = slot.resolved->func( slot.argValues, context, parent );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        regs[ins.dest].setVariant( res );
+        break;
+      }
+
+      case opEvalNode:
+      {
+        regs[ins.dest].setVariant( ins.node->eval( parent, context ) );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        break;
+      }
+
+      case opMove:
+        regs[ins.dest] = regs[ins.a];
+        break;
+
+      case opJump:
+        pc = ins.c;
+        break;
+
+      case opJumpIfNotTrue:
+      {
+        int tvl = tvlValue( regs[ins.a], parent );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        if ( tvl != tvlTrue )
+          pc = ins.c;
+        break;
+      }
+    }
+  }
+
+  return regs[mResultRegister].toVariant();
+}
+
+void QgsExpressionProgram::loadColumn( const Instruction& ins, const QgsFeatureList& features, Column& result )
+{
+  const int count = features.count();
+  QgsExpression::NodeColumnRef* n = static_cast<QgsExpression::NodeColumnRef*>( ins.node );
+
+  QVector<QVariant> values( count );
+  bool allInts = true;
+  bool allDoubles = true;
+  for ( int i = 0; i < count; ++i )
+  {
+    const QVariant value = ins.a >= 0 ? features.at( i ).attribute( ins.a ) : features.at( i ).attribute( n->name() );
+    if ( value.isNull() )
+    {
+      allInts = allDoubles = false;
+    }
+    else
+    {
+      allInts = allInts && value.type() == QVariant::Int;
+      allDoubles = allDoubles && value.type() == QVariant::Double && qIsFinite( value.toDouble() );
+    }
+    values[i] = value;
+  }
+
+  if ( allInts && count > 0 )
+  {
+    result.setInts( count );
+    for ( int i = 0; i < count; ++i )
+      result.intValues[i] = values[i].toInt();
+  }
+  else if ( allDoubles && count > 0 )
+  {
+    result.setDoubles( count );
+    for ( int i = 0; i < count; ++i )
+      result.doubleValues[i] = values[i].toDouble();
+  }
+  else
+  {
+    result.setRows( count );
+    for ( int i = 0; i < count; ++i )
+      result.rows[i].setVariant( values[i] );
+  }
+}
+
+bool QgsExpressionProgram::computeUnaryColumn( QgsExpression::UnaryOperator op, const Column& value, Column& result, int count )
+{
+  if ( value.layout != Column::Ints && value.layout != Column::Doubles )
+    return false;
+
+  if ( op == QgsExpression::uoMinus && value.layout == Column::Ints )
+  {
+    result.setInts( count );
+    const int* x = value.intValues.constData();
+    int* out = result.intValues.data();
+    for ( int i = 0; i < count; ++i )
+      out[i] = -x[i];
+    return true;
+  }
+
+  QVector<double> buffer;
+  const double* x = value.doubles( buffer, count );
+  switch ( op )
+  {
+    case QgsExpression::uoMinus:
+    {
+      result.setDoubles( count );
+      double* out = result.doubleValues.data();
+      for ( int i = 0; i < count; ++i )
+        out[i] = -x[i];
+      return true;
+    }
+
+    case QgsExpression::uoNot:
+    {
+      result.setInts( count );
+      int* out = result.intValues.data();
+      for ( int i = 0; i < count; ++i )
+        out[i] = x[i] != 0 ? 0 : 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::computeBinaryColumn( QgsExpression::BinaryOperator op, const Column& left, const Column& right, Column& result, int count )
+{
+  if ( !left.isNumberColumn() || !right.isNumberColumn() )
+    return false;
+
+  // integer arithmetic stays integer, exactly like computeBinary()
+  if ( left.isIntColumn() && right.isIntColumn() &&
+       ( op == QgsExpression::boPlus || op == QgsExpression::boMinus || op == QgsExpression::boMul || op == QgsExpression::boMod ) )
+  {
+    QVector<int> leftBuffer, rightBuffer;
+    const int* x = left.ints( leftBuffer, count );
+    const int* y = right.ints( rightBuffer, count );
+
+    if ( op == QgsExpression::boMod )
+    {
+      // a zero divisor results in null, leave that to the row by row path
+      for ( int i = 0; i < count; ++i )
+      {
+        if ( y[i] == 0 )
+          return false;
+      }
+    }
+
+    result.setInts( count );
+    int* out = result.intValues.data();
+    switch ( op )
+    {
+      case QgsExpression::boPlus:
+        for ( int i = 0; i < count; ++i )
+          out[i] = x[i] + y[i];
+        break;
+      case QgsExpression::boMinus:
+        for ( int i = 0; i < count; ++i )
+          out[i] = x[i] - y[i];
+        break;
+      case QgsExpression::boMul:
+        for ( int i = 0; i < count; ++i )
+          out[i] = x[i] * y[i];
+        break;
+      case QgsExpression::boMod:
+      default:
+        for ( int i = 0; i < count; ++i )
+          out[i] = x[i] % y[i];
+        break;
+    }
+    return true;
+  }
+
+  QVector<double> leftBuffer, rightBuffer;
+  const double* x = left.doubles( leftBuffer, count );
+  const double* y = right.doubles( rightBuffer, count );
+
+  switch ( op )
+  {
+    case QgsExpression::boDiv:
+    case QgsExpression::boMod:
+    case QgsExpression::boIntDiv:
+      for ( int i = 0; i < count; ++i )
+      {
+        if ( y[i] == 0. )
+          return false;
+      }
+      break;
+    default:
+      break;
+  }
+
+  switch ( op )
+  {
+    case QgsExpression::boPlus:
+    case QgsExpression::boMinus:
+    case QgsExpression::boMul:
+    case QgsExpression::boDiv:
+    case QgsExpression::boMod:
+    case QgsExpression::boPow:
+    {
+      result.setDoubles( count );
+      double* out = result.doubleValues.data();
+      switch ( op )
+      {
+        case QgsExpression::boPlus:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] + y[i];
+          break;
+        case QgsExpression::boMinus:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i];
+          break;
+        case QgsExpression::boMul:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] * y[i];
+          break;
+        case QgsExpression::boDiv:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] / y[i];
+          break;
+        case QgsExpression::boMod:
+          for ( int i = 0; i < count; ++i )
+            out[i] = fmod( x[i], y[i] );
+          break;
+        case QgsExpression::boPow:
+        default:
+          for ( int i = 0; i < count; ++i )
+            out[i] = pow( x[i], y[i] );
+          break;
+      }
+      result.checkFinite();
+      return true;
+    }
+
+    case QgsExpression::boIntDiv:
+    {
+      result.setInts( count );
+      int* out = result.intValues.data();
+      for ( int i = 0; i < count; ++i )
+        out[i] = qFloor( x[i] / y[i] );
+      return true;
+    }
+
+    case QgsExpression::boAnd:
+    case QgsExpression::boOr:
+    {
+      result.setInts( count );
+      int* out = result.intValues.data();
+      if ( op == QgsExpression::boAnd )
+      {
+        for ( int i = 0; i < count; ++i )
+          out[i] = x[i] != 0 && y[i] != 0 ? 1 : 0;
+      }
+      else
+      {
+        for ( int i = 0; i < count; ++i )
+          out[i] = x[i] != 0 || y[i] != 0 ? 1 : 0;
+      }
+      return true;
+    }
+
+    case QgsExpression::boEQ:
+    case QgsExpression::boNE:
+    case QgsExpression::boLT:
+    case QgsExpression::boGT:
+    case QgsExpression::boLE:
+    case QgsExpression::boGE:
+    case QgsExpression::boIs:
+    case QgsExpression::boIsNot:
+    {
+      result.setInts( count );
+      int* out = result.intValues.data();
+      switch ( op )
+      {
+        case QgsExpression::boEQ:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i] == 0 ? 1 : 0;
+          break;
+        case QgsExpression::boNE:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i] != 0 ? 1 : 0;
+          break;
+        case QgsExpression::boLT:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i] < 0 ? 1 : 0;
+          break;
+        case QgsExpression::boGT:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i] > 0 ? 1 : 0;
+          break;
+        case QgsExpression::boLE:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i] <= 0 ? 1 : 0;
+          break;
+        case QgsExpression::boGE:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] - y[i] >= 0 ? 1 : 0;
+          break;
+        case QgsExpression::boIs:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] == y[i] ? 1 : 0;
+          break;
+        case QgsExpression::boIsNot:
+        default:
+          for ( int i = 0; i < count; ++i )
+            out[i] = x[i] == y[i] ? 0 : 1;
+          break;
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+bool QgsExpressionProgram::computeInColumn( const InList& list, bool notIn, const Column& value, Column& result, int count )
+{
+  if ( !list.numeric || ( value.layout != Column::Ints && value.layout != Column::Doubles ) )
+    return false;
+
+  QVector<double> buffer;
+  const double* x = value.doubles( buffer, count );
+  const double* begin = list.numbers.constBegin();
+  const double* end = list.numbers.constEnd();
+
+  result.setInts( count );
+  int* out = result.intValues.data();
+  for ( int i = 0; i < count; ++i )
+  {
+    bool found = qBinaryFind( begin, end, x[i] ) != end;
+    out[i] = found != notIn ? 1 : 0;
+  }
+  return true;
+}
+
+QVariantList QgsExpressionProgram::runBlock( QgsExpression* parent, const QgsFeatureList& features )
+{
+  Q_ASSERT( mColumnar );
+
+  const int count = features.count();
+  BlockErrors errors( count );
+
+  // registers which are never written by an instruction hold literals
+  QVector<Column> columns( mRegisters.count() );
+  for ( int r = 0; r < mRegisters.count(); ++r )
+    columns[r].scalar = mRegisters.at( r );
+
+  Register left, right, value;
+  Q_FOREACH ( const Instruction& ins, mCode )
+  {
+    Column& result = columns[ins.dest];
+    switch ( ins.op )
+    {
+      case opColumnRef:
+        loadColumn( ins, features, result );
+        break;
+
+      case opUnary:
+      {
+        const QgsExpression::UnaryOperator op = static_cast<QgsExpression::UnaryOperator>( ins.c );
+        const Column& operand = columns.at( ins.a );
+        if ( computeUnaryColumn( op, operand, result, count ) )
+          break;
+
+        QgsExpression::NodeUnaryOperator* n = static_cast<QgsExpression::NodeUnaryOperator*>( ins.node );
+        result.setRows( count );
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( errors.failed[i] )
+            continue;
+          operand.value( i, value );
+          if ( !computeUnary( op, value, result.rows[i] ) )
+          {
+            result.rows[i].setVariant( n->compute( parent, value.toVariant() ) );
+            if ( errors.take( parent, i ) )
+              result.rows[i].setNull();
+          }
+        }
+        break;
+      }
+
+      case opBinary:
+      {
+        const QgsExpression::BinaryOperator op = static_cast<QgsExpression::BinaryOperator>( ins.c );
+        const Column& leftColumn = columns.at( ins.a );
+        const Column& rightColumn = columns.at( ins.b );
+        if ( computeBinaryColumn( op, leftColumn, rightColumn, result, count ) )
+          break;
+
+        QgsExpression::NodeBinaryOperator* n = static_cast<QgsExpression::NodeBinaryOperator*>( ins.node );
+        result.setRows( count );
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( errors.failed[i] )
+            continue;
+          leftColumn.value( i, left );
+          rightColumn.value( i, right );
+          if ( !computeBinary( op, left, right, result.rows[i] ) )
+          {
+            result.rows[i].setVariant( n->compute( parent, left.toVariant(), right.toVariant() ) );
+            if ( errors.take( parent, i ) )
+              result.rows[i].setNull();
+          }
+        }
+        break;
+      }
+
+      case opIn:
+      {
+        QgsExpression::NodeInOperator* n = static_cast<QgsExpression::NodeInOperator*>( ins.node );
+        const InList& list = mInLists.at( ins.b );
+        const Column& operand = columns.at( ins.a );
+        if ( computeInColumn( list, n->isNotIn(), operand, result, count ) )
+          break;
+
+        result.setRows( count );
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( errors.failed[i] )
+            continue;
+          operand.value( i, value );
+          if ( !computeIn( list, n->isNotIn(), value, result.rows[i] ) )
+          {
+            result.rows[i].setVariant( n->compute( parent, value.toVariant(), list.values ) );
+            if ( errors.take( parent, i ) )
+              result.rows[i].setNull();
+          }
+        }
+        break;
+      }
+
+      default:
+        // not columnar, see compile()
+        break;
+    }
+  }
+
+  const Column& resultColumn = columns.at( mResultRegister );
+  QVariantList results;
+  results.reserve( count );
+  for ( int i = 0; i < count; ++i )
+    results << ( errors.failed[i] ? QVariant() : resultColumn.variant( i ) );
+
+  // report the error of the first failing feature, like a feature by feature loop stopping at it would
+  if ( !errors.messages.isEmpty() )
+    parent->setEvalErrorString( errors.messages.constBegin().value() );
+
+  return results;
+}
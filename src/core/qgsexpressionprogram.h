@@ -0,0 +1,284 @@
+/***************************************************************************
+                               qgsexpressionprogram.h
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONPROGRAM_H
+#define QGSEXPRESSIONPROGRAM_H
+
+#include <QHash>
+#include <QMap>
+#include <QVariant>
+#include <QVector>
+
+#include "qgsexpression.h"
+#include "qgsfeature.h"
+
+/** \ingroup core
+ * \class QgsExpressionProgram
+ * \brief A prepared QgsExpression node tree lowered into a linear instruction stream.
+ *
+ * Every node of the tree gets its own register. Registers keep integer, double and null
+ * values unboxed, so arithmetic, comparisons and logical operators on numbers run without
+ * virtual dispatch or QVariant conversions. Anything else (strings, dates, intervals, regular
+ * expressions) is handed to the same value level implementation the node tree uses, which
+ * keeps the results identical to QgsExpression::Node::eval(). Lazily evaluated functions and
+ * unknown node types are evaluated through the node tree.
+ *
+ * Programs without control flow, function calls or node tree fallbacks can also be run
+ * over a block of features at once (see runBlock()). Each register then holds a whole
+ * column of values, and columns of non-null numbers are processed in tight loops over
+ * plain arrays.
+ *
+ * Programs are created by QgsExpression::prepare() and are only valid as long as the node
+ * tree they were compiled from is not modified or prepared again.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsExpressionProgram
+{
+  public:
+
+    /** Compiles a prepared node tree. Subtrees which do not depend on the feature or on
+     * non-static variables are evaluated once and replaced by constants, and identical
+     * subtrees are evaluated only once per run.
+     * @param parent expression the tree belongs to, used for evaluating constant subtrees
+     * @param root root node of the expression. The node tree must outlive the program.
+     * @param context context the expression was prepared with. May be null.
+     * @returns new program (ownership is transferred to the caller), or null if root is null
+     */
+    static QgsExpressionProgram* compile( QgsExpression* parent, QgsExpression::Node* root, const QgsExpressionContext* context );
+
+    /** Runs the program.
+     * @param parent expression used for reporting evaluation errors
+     * @param context context to evaluate against. May be null.
+     * @returns result of the expression, identical to the result of the node tree
+     */
+    QVariant run( QgsExpression* parent, const QgsExpressionContext* context );
+
+    /** Returns true if the program consists only of column references and operators,
+     * which allows runBlock() to evaluate it one instruction at a time for all features.
+     */
+    bool isColumnar() const { return mColumnar; }
+
+    /** Runs a columnar program for a block of features. Column references are read
+     * directly from the features, the result for each feature is identical to the result
+     * of run() with that feature set in the context.
+     * @param parent expression used for reporting evaluation errors. If evaluation fails for
+     * any feature, the error of the first failing feature is reported.
+     * @param features features to evaluate the expression for
+     * @returns one value per feature, null for features where evaluation failed
+     * @note must only be called if isColumnar() returns true
+     */
+    QVariantList runBlock( QgsExpression* parent, const QgsFeatureList& features );
+
+    //! Returns the number of instructions in the program
+    int instructionCount() const { return mCode.count(); }
+
+    //! Returns the number of registers used by the program
+    int registerCount() const { return mRegisters.count(); }
+
+    //! Returns the number of instructions which fall back to evaluating a node tree
+    int treeFallbackCount() const;
+
+    //! Returns the number of nodes in the compiled node tree
+    int nodeCount() const { return mNodeCount; }
+
+    //! Returns the number of nodes which were replaced by constants
+    int foldedNodeCount() const { return mFoldedNodeCount; }
+
+    //! Returns the number of nodes which reuse the result of an identical subtree
+    int sharedNodeCount() const { return mSharedNodeCount; }
+
+  private:
+
+    enum OpCode
+    {
+      opColumnRef,      //!< dest = attribute a of the context feature
+      opUnary,          //!< dest = op c ( reg a )
+      opBinary,         //!< dest = reg a  op c  reg b
+      opIn,             //!< dest = reg a in literal list b
+      opCallBegin,      //!< resolve function of call slot a, evaluate lazy functions via tree and jump to c
+      opCallArgCheck,   //!< if reg b is null and function of slot a does not handle nulls, dest = null and jump to c
+      opCall,           //!< dest = function of call slot a applied to its argument registers
+      opEvalNode,       //!< dest = node->eval()
+      opMove,           //!< dest = reg a
+      opJump,           //!< jump to c
+      opJumpIfNotTrue,  //!< jump to c unless reg a is true
+    };
+
+    struct Instruction
+    {
+      Instruction( OpCode opCode = opJump, int destReg = -1, QgsExpression::Node* n = 0 )
+          : op( opCode ), dest( destReg ), a( -1 ), b( -1 ), c( -1 ), node( n ) {}
+
+      OpCode op;
+      int dest;
+      int a;
+      int b;
+      int c;
+      QgsExpression::Node* node;
+    };
+
+    //! Typed register. Numbers and nulls are stored unboxed, everything else as QVariant.
+    struct Register
+    {
+      enum Kind
+      {
+        Null,
+        Int,
+        Double,
+        Variant
+      };
+
+      Register() : kind( Null ), i( 0 ), d( 0 ) {}
+
+      void setNull() { kind = Null; v = QVariant(); }
+      void setInt( int value ) { kind = Int; i = value; }
+      void setDouble( double value ) { kind = Double; d = value; }
+      void setVariant( const QVariant& value );
+      QVariant toVariant() const;
+      bool isNumeric() const { return kind == Int || kind == Double; }
+      double toDouble() const { return kind == Int ? i : d; }
+
+      Kind kind;
+      int i;
+      double d;
+      QVariant v; //!< value for Variant registers and original (typed) value of Null registers
+    };
+
+    //! Register of a block run, holds one value per feature
+    struct Column
+    {
+      enum Layout
+      {
+        Scalar,   //!< the same value for every feature
+        Ints,     //!< non-null integers
+        Doubles,  //!< non-null, finite doubles
+        Rows      //!< one typed register per feature
+      };
+
+      Column() : layout( Scalar ) {}
+
+      void value( int row, Register& out ) const;
+      QVariant variant( int row ) const;
+      //! true for columns of non-null integers, including scalar ones
+      bool isIntColumn() const { return layout == Ints || ( layout == Scalar && scalar.kind == Register::Int ); }
+      //! true for columns of non-null, finite numbers, including scalar ones
+      bool isNumberColumn() const;
+      //! returns the values as doubles, using buffer if a conversion is needed
+      const double* doubles( QVector<double>& buffer, int count ) const;
+      //! returns the values of an integer column, using buffer if a conversion is needed
+      const int* ints( QVector<int>& buffer, int count ) const;
+      void setRows( int count );
+      void setInts( int count ) { layout = Ints; intValues.resize( count ); }
+      void setDoubles( int count ) { layout = Doubles; doubleValues.resize( count ); }
+      //! checks a freshly computed double column and converts it to rows if it contains non-finite values
+      void checkFinite();
+
+      Layout layout;
+      Register scalar;
+      QVector<int> intValues;
+      QVector<double> doubleValues;
+      QVector<Register> rows;
+    };
+
+    //! Per feature error state of a block run
+    struct BlockErrors
+    {
+      explicit BlockErrors( int count ) : failed( count, 0 ) {}
+
+      //! Moves an evaluation error of parent to the given row. Returns true if there was an error.
+      bool take( QgsExpression* parent, int row );
+
+      QVector<char> failed;
+      QMap<int, QString> messages;
+    };
+
+    struct CallSlot
+    {
+      CallSlot() : fnIndex( -1 ), resolved( 0 ) {}
+
+      int fnIndex;
+      QgsExpression::Function* resolved;
+      QVector<int> argRegisters;
+      QVariantList argValues;
+    };
+
+    struct InList
+    {
+      InList() : numeric( true ) {}
+
+      QVariantList values;
+      //! sorted list values if all of them are non-null numbers
+      QVector<double> numbers;
+      bool numeric;
+    };
+
+    //! three-value logic, see qgsexpression.cpp
+    enum TVL
+    {
+      tvlFalse,
+      tvlTrue,
+      tvlUnknown
+    };
+
+    QgsExpressionProgram();
+
+    int addRegister();
+    int addInstruction( const Instruction& instruction );
+    void patchJump( int instruction ) { mCode[instruction].c = mCode.count(); }
+    int compileNode( QgsExpression::Node* node );
+    int compileOperation( QgsExpression::Node* node );
+    int compileConstant( QgsExpression::Node* node );
+    int compileFallback( QgsExpression::Node* node );
+    int compileFunction( QgsExpression::NodeFunction* node );
+    int compileIn( QgsExpression::NodeInOperator* node );
+    int compileCondition( QgsExpression::NodeCondition* node );
+
+    QgsExpression::Function* staticFunction( int fnIndex ) const;
+    bool isConstant( QgsExpression::Node* node ) const;
+    bool sharingKey( QgsExpression::Node* node, QString& key ) const;
+
+    static QList<QgsExpression::Node*> children( QgsExpression::Node* node );
+    static int countNodes( QgsExpression::Node* node );
+    static bool isPureFunction( QgsExpression::Function* function );
+
+    static int tvlValue( const Register& value, QgsExpression* parent );
+    static bool computeUnary( QgsExpression::UnaryOperator op, const Register& value, Register& result );
+    static bool computeBinary( QgsExpression::BinaryOperator op, const Register& left, const Register& right, Register& result );
+    static bool computeIn( const InList& list, bool notIn, const Register& value, Register& result );
+
+    static void loadColumn( const Instruction& ins, const QgsFeatureList& features, Column& result );
+    static bool computeUnaryColumn( QgsExpression::UnaryOperator op, const Column& value, Column& result, int count );
+    static bool computeBinaryColumn( QgsExpression::BinaryOperator op, const Column& left, const Column& right, Column& result, int count );
+    static bool computeInColumn( const InList& list, bool notIn, const Column& value, Column& result, int count );
+
+    QVector<Instruction> mCode;
+    QVector<Register> mRegisters;
+    QVector<CallSlot> mCallSlots;
+    QVector<InList> mInLists;
+    int mResultRegister;
+    bool mColumnar;
+
+    int mNodeCount;
+    int mFoldedNodeCount;
+    int mSharedNodeCount;
+
+    // only used while compiling
+    QgsExpression* mParent;
+    const QgsExpressionContext* mContext;
+    //! registers holding the results of already compiled subtrees, by sharing key
+    QHash<QString, int> mSharedRegisters;
+};
+
+#endif // QGSEXPRESSIONPROGRAM_H
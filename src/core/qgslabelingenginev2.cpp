@@ -24,6 +24,8 @@
 #include "pal.h"
 #include "problem.h"
 
+#include <cfloat>
+
 
 
 // helper function for checking for job cancellation within PAL
@@ -32,6 +34,13 @@ static bool _palIsCancelled( void* ctx )
   return (( QgsRenderContext* ) ctx )->renderingStopped();
 }
 
+//! Describes the coordinates PAL works in: features are in destination CRS and pre-rotated
+static QString _palCoordinates( const QgsMapSettings& mapSettings )
+{
+  QString crs = mapSettings.hasCrsTransformEnabled() ? mapSettings.destinationCrs().toProj4() : QString();
+  return QString( "%1 %2" ).arg( crs ).arg( mapSettings.rotation() );
+}
+
 
 QgsLabelingEngineV2::QgsLabelingEngineV2()
     : mFlags( RenderOutlineLabels | UsePartialCandidates )
@@ -155,6 +164,17 @@ void QgsLabelingEngineV2::processProvider( QgsAbstractLabelProvider* provider, Q
 }
 
 
+void QgsLabelingEngineV2::setPreviousResults( const QgsLabelingResults* results )
+{
+  mPreviousPositions.clear();
+  mPreviousCoordinates.clear();
+  if ( !results || results->mCoordinates.isNull() )
+    return;
+
+  mPreviousPositions = results->labelsWithinRect( QgsRectangle( -DBL_MAX, -DBL_MAX, DBL_MAX, DBL_MAX ) );
+  mPreviousCoordinates = results->mCoordinates;
+}
+
 void QgsLabelingEngineV2::run( QgsRenderContext& context )
 {
   pal::Pal p;
@@ -177,6 +197,21 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
   p.setPolyP( mCandPolygon );
 
   p.setShowPartial( mFlags.testFlag( UsePartialCandidates ) );
+  p.setMultithreaded( !mFlags.testFlag( SingleThreaded ) );
+  p.setPartitioned( !mFlags.testFlag( Unpartitioned ) );
+
+  QString coordinates = _palCoordinates( mMapSettings );
+  mResults->mCoordinates = coordinates;
+  if ( !mPreviousPositions.isEmpty() && mPreviousCoordinates == coordinates )
+  {
+    pal::Pal::PreviousPositions previousPositions;
+    Q_FOREACH ( const QgsLabelPosition& position, mPreviousPositions )
+    {
+      if ( !position.isDiagram )
+        previousPositions[ qMakePair( position.layerID, ( QgsFeatureId ) position.featureId )] << position.labelRect;
+    }
+    p.setPreviousPositions( previousPositions );
+  }
 
 
   // for each provider: get labels and register them in PAL
@@ -378,8 +413,9 @@ QgsAbstractLabelProvider*QgsLabelFeature::provider() const
 
 }
 
-QgsAbstractLabelProvider::QgsAbstractLabelProvider()
+QgsAbstractLabelProvider::QgsAbstractLabelProvider( const QString& layerId )
     : mEngine( 0 )
+    , mLayerId( layerId )
     , mFlags( DrawLabels )
     , mPlacement( QgsPalLayerSettings::AroundPoint )
     , mLinePlacementFlags( 0 )
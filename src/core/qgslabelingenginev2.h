@@ -248,7 +248,7 @@ class CORE_EXPORT QgsAbstractLabelProvider
 
   public:
     //! Construct the provider with default values
-    QgsAbstractLabelProvider();
+    QgsAbstractLabelProvider( const QString& layerId = QString() );
     //! Vritual destructor
     virtual ~QgsAbstractLabelProvider() {}
 
@@ -278,6 +278,9 @@ class CORE_EXPORT QgsAbstractLabelProvider
     //! Name of the layer (for statistics, debugging etc.) - does not need to be unique
     QString name() const { return mName; }
 
+    //! Returns ID of associated layer, or empty string if no layer is associated with the provider
+    QString layerId() const { return mLayerId; }
+
     //! Flags associated with the provider
     Flags flags() const { return mFlags; }
 
@@ -302,6 +305,8 @@ class CORE_EXPORT QgsAbstractLabelProvider
 
     //! Name of the layer
     QString mName;
+    //! Associated layer's ID, if applicable
+    QString mLayerId;
     //! Flags altering drawing and registration of features
     Flags mFlags;
     //! Placement strategy
@@ -360,6 +365,8 @@ class CORE_EXPORT QgsLabelingEngineV2
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
       DrawShadowRects       = 1 << 6,  //!< Whether to show debugging rectangles for drop shadows
+      SingleThreaded        = 1 << 7,  //!< Whether to generate candidates in a single thread (used for unit tests)
+      Unpartitioned         = 1 << 8,  //!< Whether to search large problems as a whole instead of in independent parts (used for unit tests)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -383,6 +390,17 @@ class CORE_EXPORT QgsLabelingEngineV2
     //! For internal use by the providers
     QgsLabelingResults* results() const { return mResults; }
 
+    /** Sets the results of a previous run, e.g. of the previous frame of a map canvas, to keep
+     * the labels stable. Labels of features which are still labeled stay where they were unless
+     * they collide, which keeps the layout steady while panning and zooming a little. Candidates
+     * are still generated and the problem is still solved for every feature, so labeling does not
+     * get faster. The results are only used if they were computed in the same map coordinates
+     * (destination CRS and rotation). Diagrams are always placed from scratch.
+     * @param results previous results, the positions are copied. Pass null to place all labels from scratch.
+     * @note added in QGIS 2.12
+     */
+    void setPreviousResults( const QgsLabelingResults* results );
+
     //! Set flags of the labeling engine
     void setFlags( Flags flags ) { mFlags = flags; }
     //! Get flags of the labeling engine
@@ -425,6 +443,11 @@ class CORE_EXPORT QgsLabelingEngineV2
 
     //! Resulting labeling layout
     QgsLabelingResults* mResults;
+
+    //! Labels placed by a previous run
+    QList<QgsLabelPosition> mPreviousPositions;
+    //! Map coordinates of the previous labels
+    QString mPreviousCoordinates;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsLabelingEngineV2::Flags )
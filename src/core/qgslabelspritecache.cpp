@@ -0,0 +1,178 @@
+/***************************************************************************
+    qgslabelspritecache.cpp
+    -----------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelspritecache.h"
+#include "qgslabeltextmetricscache.h"
+
+#include <QBrush>
+#include <QFont>
+#include <QMutexLocker>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QStringList>
+
+#include <cmath>
+
+// larger sprites are drawn directly, they are unlikely to repeat
+static const int MAX_SPRITE_SIZE = 2048;
+
+// subpixel positions are rounded to 1 / SUBPIXEL_STEPS of a pixel
+static const int SUBPIXEL_STEPS = 4;
+
+//! splits a device coordinate into a pixel and a rounded position within the pixel
+static void _splitCoordinate( double coordinate, int& pixel, double& phase )
+{
+  pixel = ( int ) floor( coordinate );
+  int steps = ( int ) floor(( coordinate - pixel ) * SUBPIXEL_STEPS + 0.5 );
+  if ( steps == SUBPIXEL_STEPS )
+  {
+    ++pixel;
+    steps = 0;
+  }
+  phase = ( double ) steps / SUBPIXEL_STEPS;
+}
+
+QgsLabelSpriteCache::QgsLabelSpriteCache( int maxBytes )
+{
+  mSprites.setMaxCost( maxBytes );
+}
+
+QgsLabelSpriteCache* QgsLabelSpriteCache::instance()
+{
+  static QgsLabelSpriteCache mInstance;
+  return &mInstance;
+}
+
+void QgsLabelSpriteCache::setMaxBytes( int maxBytes )
+{
+  QMutexLocker locker( &mMutex );
+  mSprites.setMaxCost( maxBytes );
+}
+
+int QgsLabelSpriteCache::maxBytes() const
+{
+  QMutexLocker locker( &mMutex );
+  return mSprites.maxCost();
+}
+
+int QgsLabelSpriteCache::totalBytes() const
+{
+  QMutexLocker locker( &mMutex );
+  return mSprites.totalCost();
+}
+
+void QgsLabelSpriteCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mSprites.clear();
+}
+
+bool QgsLabelSpriteCache::drawText( QPainter* painter, const QString& text, const QFont& font, const QPen& pen, const QBrush& brush )
+{
+  if ( maxBytes() == 0 || painter->viewTransformEnabled() )
+    return false;
+
+  // vector devices (QPicture, SVG, PDF, printers) must keep the text as a path
+  if ( !painter->paintEngine() || painter->paintEngine()->type() != QPaintEngine::Raster )
+    return false;
+
+  // sprites are aligned to device pixels, so they may only be scaled and translated
+  QTransform transform = painter->worldTransform();
+  if ( transform.type() > QTransform::TxScale || transform.m11() <= 0 || transform.m22() <= 0 )
+    return false;
+
+  int pixelX, pixelY;
+  double phaseX, phaseY;
+  _splitCoordinate( transform.dx(), pixelX, phaseX );
+  _splitCoordinate( transform.dy(), pixelY, phaseY );
+
+  QStringList keyParts;
+  keyParts << QgsLabelTextMetricsCache::fontKey( font )
+  << QString::number(( int ) pen.style() ) << QString::number( pen.color().rgba() )
+  << QString::number( pen.widthF(), 'g', 12 ) << QString::number(( int ) pen.joinStyle() )
+  << QString::number( pen.miterLimit(), 'g', 12 )
+  << QString::number(( int ) brush.style() ) << QString::number( brush.color().rgba() )
+  << QString::number( transform.m11(), 'g', 12 ) << QString::number( transform.m22(), 'g', 12 )
+  << QString::number( phaseX ) << QString::number( phaseY )
+  << QString::number(( int ) painter->renderHints() )
+  << text;
+  QString key = keyParts.join( "|" );
+
+  Sprite sprite;
+  bool cached = false;
+  {
+    QMutexLocker locker( &mMutex );
+    if ( Sprite* cachedSprite = mSprites.object( key ) )
+    {
+      sprite = *cachedSprite;
+      cached = true;
+    }
+  }
+
+  if ( !cached )
+  {
+    QPainterPath path;
+    path.setFillRule( Qt::WindingFill );
+    path.addText( 0, 0, font, text );
+    if ( path.isEmpty() )
+      return true;
+
+    QTransform spriteTransform( transform.m11(), 0, 0, transform.m22(), phaseX, phaseY );
+    QRectF bounds = spriteTransform.map( path ).boundingRect();
+
+    // the pen reaches beyond the path, up to the miter limit at sharp corners
+    double margin = 1.0;
+    if ( pen.style() != Qt::NoPen )
+    {
+      double penWidth = pen.widthF() * qMax( transform.m11(), transform.m22() );
+      double joinFactor = pen.joinStyle() == Qt::MiterJoin || pen.joinStyle() == Qt::SvgMiterJoin ? qMax( 1.0, pen.miterLimit() ) : 1.0;
+      margin += qMax( 1.0, penWidth ) * joinFactor / 2.0;
+    }
+
+    sprite.left = ( int ) floor( bounds.left() - margin );
+    sprite.top = ( int ) floor( bounds.top() - margin );
+    int width = ( int ) ceil( bounds.right() + margin ) - sprite.left;
+    int height = ( int ) ceil( bounds.bottom() + margin ) - sprite.top;
+    if ( width > MAX_SPRITE_SIZE || height > MAX_SPRITE_SIZE )
+      return false;
+
+    sprite.image = QImage( width, height, QImage::Format_ARGB32_Premultiplied );
+    if ( sprite.image.isNull() )
+      return false;
+    sprite.image.fill( 0 );
+
+    QPainter spritePainter;
+    if ( !spritePainter.begin( &sprite.image ) )
+      return false;
+    spritePainter.setRenderHints( painter->renderHints() );
+    spritePainter.translate( -sprite.left, -sprite.top );
+    spritePainter.setTransform( spriteTransform, true );
+    spritePainter.setPen( pen );
+    spritePainter.setBrush( brush );
+    spritePainter.drawPath( path );
+    spritePainter.end();
+
+    QMutexLocker locker( &mMutex );
+    // sprites larger than the cache are not kept
+    mSprites.insert( key, new Sprite( sprite ), sprite.image.byteCount() );
+  }
+
+  painter->save();
+  painter->setWorldTransform( QTransform() );
+  painter->drawImage( QPoint( pixelX + sprite.left, pixelY + sprite.top ), sprite.image );
+  painter->restore();
+  return true;
+}
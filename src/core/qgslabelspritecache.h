@@ -0,0 +1,94 @@
+/***************************************************************************
+    qgslabelspritecache.h
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELSPRITECACHE_H
+#define QGSLABELSPRITECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+class QBrush;
+class QFont;
+class QPainter;
+class QPen;
+
+/** \ingroup core
+ * \class QgsLabelSpriteCache
+ * \brief Cache of label texts and text buffers rendered into images.
+ *
+ * Drawing a label outline converts the text to a path and rasterizes it each time. The cache
+ * rasterizes each distinct combination of text, font, pen, brush and painter scale once into a
+ * premultiplied image (a sprite) and draws the image for later placements of the same text.
+ * Sprites are aligned to device pixels, the position of the text within a pixel is kept with a
+ * precision of a quarter pixel. Rotated or sheared painters are not supported, labels drawn with
+ * them are not cached. Only painters on raster devices use the cache, labels drawn to vector
+ * devices such as pictures, SVG or PDF files stay vector paths.
+ *
+ * The cache is disabled by default. Its size is limited by the memory used by the images,
+ * the least recently used images are dropped first. It may be used by several render jobs at the
+ * same time.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsLabelSpriteCache
+{
+  public:
+
+    /** Creates a cache
+     * @param maxBytes maximum memory used by the images, 0 disables the cache
+     */
+    explicit QgsLabelSpriteCache( int maxBytes = 0 );
+
+    /** Returns the cache used for drawing labels */
+    static QgsLabelSpriteCache* instance();
+
+    /** Sets the maximum memory used by the images, 0 disables the cache */
+    void setMaxBytes( int maxBytes );
+
+    /** Returns the maximum memory used by the images */
+    int maxBytes() const;
+
+    /** Returns the memory used by the images */
+    int totalBytes() const;
+
+    /** Removes all images */
+    void clear();
+
+    /** Draws a text outline at the origin of the painter, like QPainter::drawPath() with
+     * a path created by QPainterPath::addText() would.
+     * @returns false if the text was not drawn, because the cache is disabled, the painter is
+     * rotated, does not paint on a raster device or the image would be too large. The caller
+     * then draws the text itself.
+     */
+    bool drawText( QPainter* painter, const QString& text, const QFont& font, const QPen& pen, const QBrush& brush );
+
+  private:
+
+    Q_DISABLE_COPY( QgsLabelSpriteCache )
+
+    struct Sprite
+    {
+      QImage image;
+      //! device pixel of the top left corner relative to the pixel of the origin
+      int left;
+      int top;
+    };
+
+    mutable QMutex mMutex;
+    QCache<QString, Sprite> mSprites;
+};
+
+#endif // QGSLABELSPRITECACHE_H
@@ -0,0 +1,152 @@
+/***************************************************************************
+    qgslabeltextmetricscache.cpp
+    ----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabeltextmetricscache.h"
+#include "qgis.h"
+#include "qgspallabeling.h"
+
+#include <QFont>
+#include <QFontMetricsF>
+#include <QMutexLocker>
+
+// separates the font from the text in keys, does not occur in font descriptions
+static const QChar KEY_SEPARATOR( 0 );
+
+QgsLabelTextMetricsCache::QgsLabelTextMetricsCache( int maxCost )
+{
+  mEntries.setMaxCost( maxCost );
+}
+
+QgsLabelTextMetricsCache* QgsLabelTextMetricsCache::instance()
+{
+  static QgsLabelTextMetricsCache mInstance;
+  return &mInstance;
+}
+
+QString QgsLabelTextMetricsCache::fontKey( const QFont& font )
+{
+  // QFont::toString() misses the properties which only affect the layout of text
+  return QString( "%1,%2,%3,%4,%5,%6,%7,%8" )
+         .arg( font.toString() )
+         .arg( font.styleName() )
+         .arg( font.letterSpacing() )
+         .arg(( int ) font.letterSpacingType() )
+         .arg( font.wordSpacing() )
+         .arg(( int ) font.capitalization() )
+         .arg( font.kerning() ? 1 : 0 )
+         .arg( font.stretch() );
+}
+
+qreal QgsLabelTextMetricsCache::width( const QFont& font, const QFontMetricsF& fm, const QString& text )
+{
+  QString key = QString( "w" ) + fontKey( font ) + KEY_SEPARATOR + text;
+  {
+    QMutexLocker locker( &mMutex );
+    if ( Entry* entry = mEntries.object( key ) )
+      return entry->width;
+  }
+
+  // measured without the lock, another job may measure the same text meanwhile
+  Entry* entry = new Entry;
+  entry->width = fm.width( text );
+  qreal width = entry->width;
+
+  QMutexLocker locker( &mMutex );
+  mEntries.insert( key, entry, 1 );
+  return width;
+}
+
+QgsLabelTextMetricsCache::Graphemes QgsLabelTextMetricsCache::graphemes( const QFont& font, const QFontMetricsF& fm, const QString& text, bool curved )
+{
+  QString key = QString( curved ? "c" : "g" ) + fontKey( font ) + KEY_SEPARATOR + text;
+  {
+    QMutexLocker locker( &mMutex );
+    if ( Entry* entry = mEntries.object( key ) )
+      return entry->graphemes;
+  }
+
+  Entry* entry = new Entry;
+  entry->width = 0.0;
+  entry->graphemes = measureGraphemes( font, fm, text, curved );
+  Graphemes graphemes = entry->graphemes;
+
+  QMutexLocker locker( &mMutex );
+  mEntries.insert( key, entry, 1 + graphemes.clusters.count() );
+  return graphemes;
+}
+
+QgsLabelTextMetricsCache::Graphemes QgsLabelTextMetricsCache::measureGraphemes( const QFont& font, const QFontMetricsF& fm, const QString& text, bool curved )
+{
+  qreal letterSpacing = font.letterSpacing();
+  qreal wordSpacing = font.wordSpacing();
+
+  Graphemes graphemes;
+  //split string by valid grapheme boundaries - required for certain scripts (see #6883)
+  graphemes.clusters = QgsPalLabeling::splitToGraphemes( text );
+  const QStringList& clusters = graphemes.clusters;
+  graphemes.widths.reserve( clusters.count() );
+
+  for ( int i = 0; i < clusters.count(); i++ )
+  {
+    // reconstruct how Qt creates word spacing, then adjust per individual stored character
+    // this will allow PAL to create each candidate width = character width + correct spacing
+    qreal charWidth = fm.width( clusters[i] );
+    if ( curved )
+    {
+      qreal wordSpaceFix = qreal( 0.0 );
+      if ( clusters[i] == QString( " " ) )
+      {
+        // word spacing only gets added once at end of consecutive run of spaces, see QTextEngine::shapeText()
+        int nxt = i + 1;
+        wordSpaceFix = ( nxt < clusters.count() && clusters[nxt] != QString( " " ) ) ? wordSpacing : qreal( 0.0 );
+      }
+      // this workaround only works for clusters with a single character. Not sure how it should be handled
+      // with multi-character clusters.
+      if ( clusters[i].length() == 1 &&
+           !qgsDoubleNear( fm.width( QString( clusters[i].at( 0 ) ) ), fm.width( clusters[i].at( 0 ) ) + letterSpacing ) )
+      {
+        // word spacing applied when it shouldn't be
+        wordSpaceFix -= wordSpacing;
+      }
+
+      charWidth = fm.width( QString( clusters[i] ) ) + wordSpaceFix;
+    }
+    graphemes.widths << charWidth;
+  }
+  return graphemes;
+}
+
+void QgsLabelTextMetricsCache::setMaxCost( int maxCost )
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.setMaxCost( maxCost );
+}
+
+int QgsLabelTextMetricsCache::maxCost() const
+{
+  QMutexLocker locker( &mMutex );
+  return mEntries.maxCost();
+}
+
+int QgsLabelTextMetricsCache::totalCost() const
+{
+  QMutexLocker locker( &mMutex );
+  return mEntries.totalCost();
+}
+
+void QgsLabelTextMetricsCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mEntries.clear();
+}
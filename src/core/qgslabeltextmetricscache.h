@@ -0,0 +1,108 @@
+/***************************************************************************
+    qgslabeltextmetricscache.h
+    --------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELTEXTMETRICSCACHE_H
+#define QGSLABELTEXTMETRICSCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QFont;
+class QFontMetricsF;
+
+/** \ingroup core
+ * \class QgsLabelTextMetricsCache
+ * \brief Cache of the measured widths of label texts.
+ *
+ * Measuring text with QFontMetricsF shapes it every time, although the same label texts
+ * repeat across many features and renders. The cache keeps the width of text lines and the
+ * graphemes of curved labels with their advances, keyed by the font (including its size,
+ * spacing and capitalization) and the text. Widths are in pixels of the font metrics, so
+ * they do not depend on the map scale. The least recently used entries are dropped first.
+ *
+ * The cache may be used by several render jobs at the same time.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsLabelTextMetricsCache
+{
+  public:
+
+    //! Graphemes of a text with their advances in pixels
+    struct Graphemes
+    {
+      QStringList clusters;
+      QVector<qreal> widths;
+    };
+
+    /** Creates a cache
+     * @param maxCost maximum total cost of the entries. A line width costs 1, graphemes
+     * cost 1 plus their count.
+     */
+    explicit QgsLabelTextMetricsCache( int maxCost = 100000 );
+
+    /** Returns the cache shared by all render jobs */
+    static QgsLabelTextMetricsCache* instance();
+
+    /** Returns a key which differs for fonts measuring text differently */
+    static QString fontKey( const QFont& font );
+
+    /** Returns the width of a line of text.
+     * @param font font of the text
+     * @param fm metrics of the font, used if the width is not cached
+     * @param text line of text
+     */
+    qreal width( const QFont& font, const QFontMetricsF& fm, const QString& text );
+
+    /** Returns the graphemes of a text and their advances.
+     * @param font font of the text
+     * @param fm metrics of the font, used if the graphemes are not cached
+     * @param text label text
+     * @param curved whether the advances are corrected for letter and word spacing of characters
+     * placed one by one along a curve
+     */
+    Graphemes graphemes( const QFont& font, const QFontMetricsF& fm, const QString& text, bool curved );
+
+    /** Sets the maximum total cost of the entries, 0 disables the cache */
+    void setMaxCost( int maxCost );
+
+    /** Returns the maximum total cost of the entries */
+    int maxCost() const;
+
+    /** Returns the total cost of the entries */
+    int totalCost() const;
+
+    /** Removes all entries */
+    void clear();
+
+  private:
+
+    Q_DISABLE_COPY( QgsLabelTextMetricsCache )
+
+    struct Entry
+    {
+      qreal width;
+      Graphemes graphemes;
+    };
+
+    static Graphemes measureGraphemes( const QFont& font, const QFontMetricsF& fm, const QString& text, bool curved );
+
+    mutable QMutex mMutex;
+    QCache<QString, Entry> mEntries;
+};
+
+#endif // QGSLABELTEXTMETRICSCACHE_H
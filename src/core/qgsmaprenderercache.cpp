@@ -15,14 +15,55 @@
 
 #include "qgsmaprenderercache.h"
 
+#include "qgslogger.h"
 #include "qgsmaplayerregistry.h"
 #include "qgsmaplayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+
+//! default memory limit for images of previous views (in megabytes)
+static const int DEFAULT_MAX_MEMORY_USAGE = 100;
+//! default size limit for images stored in the cache directory (in megabytes)
+static const int DEFAULT_MAX_DISK_USAGE = 500;
+
+static QString md5Hex( const QString& str )
+{
+  return QString::fromLatin1( QCryptographicHash::hash( str.toUtf8(), QCryptographicHash::Md5 ).toHex() );
+}
 
 QgsMapRendererCache::QgsMapRendererCache()
+    : mDpi( 0 )
+    , mRotation( 0.0 )
+    , mDiskImagesLoaded( false )
+    , mDiskUsage( 0 )
+    , mDiskUseCounter( 0 )
+    , mMaxDiskUsage( DEFAULT_MAX_DISK_USAGE * Q_INT64_C( 1024 * 1024 ) )
 {
+  mPreviousImages.setMaxCost( DEFAULT_MAX_MEMORY_USAGE * 1024 );
   clear();
 }
 
+QgsMapRendererCache::~QgsMapRendererCache()
+{
+  // the writes lock the mutex when they finish
+  mMutex.lock();
+  QList< QFuture<void> > pendingWrites = mPendingWrites;
+  mMutex.unlock();
+
+  for ( int i = 0; i < pendingWrites.count(); ++i )
+    pendingWrites[i].waitForFinished();
+}
+
 void QgsMapRendererCache::clear()
 {
   QMutexLocker lock( &mMutex );
@@ -33,33 +74,81 @@ void QgsMapRendererCache::clearInternal()
 {
   mExtent.setMinimal();
   mScale = 0;
+  mOutputSize = QSize();
+  mDpi = 0;
+  mRotation = 0.0;
+  mDestinationCrs.clear();
 
   // make sure we are disconnected from all layers
-  Q_FOREACH ( const QString& layerId, mCachedImages.keys() )
+  Q_FOREACH ( const QString& layerId, mConnectedLayers )
   {
     QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
     if ( layer )
     {
       disconnect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ) );
+      disconnect( layer, SIGNAL( dataChanged() ), this, SLOT( layerRequestedRepaint() ) );
     }
   }
+  mConnectedLayers.clear();
   mCachedImages.clear();
+  mPreviousImages.clear();
+  mStyleHashes.clear();
 }
 
-bool QgsMapRendererCache::init( QgsRectangle extent, double scale )
+void QgsMapRendererCache::clearDiskCache()
+{
+  QMutexLocker lock( &mMutex );
+
+  if ( mCacheDirectory.isEmpty() )
+    return;
+
+  // drop the images still being written
+  for ( QMap<QString, int>::iterator it = mLayerGenerations.begin(); it != mLayerGenerations.end(); ++it )
+    ++it.value();
+
+  QDir dir( mCacheDirectory );
+  Q_FOREACH ( const QString& layerDir, dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot ) )
+  {
+    QDir imageDir( dir.filePath( layerDir ) );
+    Q_FOREACH ( const QString& image, imageDir.entryList( QStringList( "*.png" ), QDir::Files ) )
+      imageDir.remove( image );
+    dir.rmdir( layerDir );
+  }
+  mDiskImages.clear();
+  mDiskUsage = 0;
+}
+
+bool QgsMapRendererCache::init( QgsRectangle extent, double scale, QSize outputSize, int dpi, double rotation, const QString& destinationCrs )
 {
   QMutexLocker lock( &mMutex );
 
   // check whether the params are the same
   if ( extent == mExtent &&
-       scale == mScale )
+       scale == mScale &&
+       outputSize == mOutputSize &&
+       dpi == mDpi &&
+       rotation == mRotation &&
+       destinationCrs == mDestinationCrs )
     return true;
 
-  clearInternal();
+  // keep the images of the previous view, so they can be used when the view is restored
+  if ( !mCachedImages.isEmpty() && mPreviousImages.maxCost() > 0 )
+  {
+    QString key = viewKey();
+    for ( QMap<QString, QImage>::const_iterator it = mCachedImages.constBegin(); it != mCachedImages.constEnd(); ++it )
+    {
+      mPreviousImages.insert( it.key() + '|' + key, new QImage( it.value() ), it.value().byteCount() / 1024 );
+    }
+  }
+  mCachedImages.clear();
 
   // set new params
   mExtent = extent;
   mScale = scale;
+  mOutputSize = outputSize;
+  mDpi = dpi;
+  mRotation = rotation;
+  mDestinationCrs = destinationCrs;
 
   return false;
 }
@@ -70,17 +159,110 @@ void QgsMapRendererCache::setCacheImage( QString layerId, const QImage& img )
   mCachedImages[layerId] = img;
 
   // connect to the layer to listen to layer's repaintRequested() signals
-  QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
-  if ( layer )
+  connectLayer( layerId );
+
+  if ( !mCacheDirectory.isEmpty() && mMaxDiskUsage > 0 )
   {
-    connect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ) );
+    QString path = imagePath( layerId );
+    if ( !path.isEmpty() )
+    {
+      touchDiskImage( path );
+
+      // encoding PNG is slow, the image is written on a worker thread
+      for ( int i = mPendingWrites.count() - 1; i >= 0; --i )
+      {
+        if ( mPendingWrites.at( i ).isFinished() )
+          mPendingWrites.removeAt( i );
+      }
+      mPendingWrites << QtConcurrent::run( this, &QgsMapRendererCache::writeImage, layerId, mLayerGenerations[layerId], path, img );
+    }
   }
 }
 
+void QgsMapRendererCache::writeImage( const QString& layerId, int generation, const QString& path, const QImage& img )
+{
+  // the image is written to a temporary file first, so that a partially written image is never read
+  QString tmpPath = path + ".tmp";
+  if ( !QDir().mkpath( QFileInfo( path ).path() ) || !img.save( tmpPath, "PNG" ) )
+  {
+    QgsDebugMsg( "failed to store cached image " + path );
+    QFile::remove( tmpPath );
+    return;
+  }
+
+  QMutexLocker lock( &mMutex );
+  if ( mLayerGenerations.value( layerId ) != generation )
+  {
+    // the layer's images were invalidated while the image was written
+    QFile::remove( tmpPath );
+    QDir().rmdir( QFileInfo( path ).path() );
+    return;
+  }
+
+  QFile::remove( path );
+  qint64 size = 0;
+  if ( !QFile::rename( tmpPath, path ) )
+  {
+    QgsDebugMsg( "failed to store cached image " + path );
+    QFile::remove( tmpPath );
+  }
+  else
+  {
+    size = QFileInfo( path ).size();
+  }
+
+  // the image may have been removed meanwhile to make space for other images
+  QHash<QString, DiskImage>::iterator it = mDiskImages.find( path );
+  if ( it == mDiskImages.end() )
+  {
+    DiskImage image;
+    image.size = 0;
+    image.lastUse = ++mDiskUseCounter;
+    it = mDiskImages.insert( path, image );
+  }
+  mDiskUsage += size - it->size;
+  it->size = size;
+
+  trimDiskCache();
+}
+
 QImage QgsMapRendererCache::cacheImage( QString layerId )
 {
   QMutexLocker lock( &mMutex );
-  return mCachedImages.value( layerId );
+
+  QMap<QString, QImage>::const_iterator it = mCachedImages.constFind( layerId );
+  if ( it != mCachedImages.constEnd() )
+    return it.value();
+
+  // try an image from one of the previous views
+  QImage* previous = mPreviousImages.take( layerId + '|' + viewKey() );
+  if ( previous )
+  {
+    QImage img = *previous;
+    delete previous;
+    mCachedImages.insert( layerId, img );
+    return img;
+  }
+
+  // try an image stored on disk
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    QString path = imagePath( layerId );
+    if ( !path.isEmpty() && QFile::exists( path ) )
+    {
+      QImage img( path );
+      if ( img.size() == mOutputSize )
+      {
+        touchDiskImage( path );
+        img = img.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+        mCachedImages.insert( layerId, img );
+        connectLayer( layerId );
+        return img;
+      }
+    }
+  }
+
+  return QImage();
 }
 
 void QgsMapRendererCache::layerRequestedRepaint()
@@ -94,11 +276,254 @@ void QgsMapRendererCache::clearCacheImage( QString layerId )
 {
   QMutexLocker lock( &mMutex );
 
-  mCachedImages.remove( layerId );
+  removeLayerImages( layerId );
 
   QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
   if ( layer )
   {
     disconnect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ) );
+    disconnect( layer, SIGNAL( dataChanged() ), this, SLOT( layerRequestedRepaint() ) );
+  }
+  mConnectedLayers.remove( layerId );
+}
+
+void QgsMapRendererCache::setMaximumMemoryUsage( int megabytes )
+{
+  QMutexLocker lock( &mMutex );
+  mPreviousImages.setMaxCost( qMax( megabytes, 0 ) * 1024 );
+}
+
+int QgsMapRendererCache::maximumMemoryUsage() const
+{
+  QMutexLocker lock( &mMutex );
+  return mPreviousImages.maxCost() / 1024;
+}
+
+void QgsMapRendererCache::setCacheDirectory( const QString& path )
+{
+  QMutexLocker lock( &mMutex );
+  mCacheDirectory = path;
+  mDiskImages.clear();
+  mDiskImagesLoaded = false;
+  mDiskUsage = 0;
+}
+
+QString QgsMapRendererCache::cacheDirectory() const
+{
+  QMutexLocker lock( &mMutex );
+  return mCacheDirectory;
+}
+
+void QgsMapRendererCache::setMaximumDiskUsage( int megabytes )
+{
+  QMutexLocker lock( &mMutex );
+  mMaxDiskUsage = qMax( megabytes, 0 ) * Q_INT64_C( 1024 * 1024 );
+  if ( mDiskImagesLoaded )
+    trimDiskCache();
+}
+
+int QgsMapRendererCache::maximumDiskUsage() const
+{
+  QMutexLocker lock( &mMutex );
+  return ( int )( mMaxDiskUsage / ( 1024 * 1024 ) );
+}
+
+QString QgsMapRendererCache::viewKey() const
+{
+  return QString( "%1,%2,%3,%4|%5|%6x%7|%8|%9|%10" )
+         .arg( mExtent.xMinimum(), 0, 'g', 17 ).arg( mExtent.yMinimum(), 0, 'g', 17 )
+         .arg( mExtent.xMaximum(), 0, 'g', 17 ).arg( mExtent.yMaximum(), 0, 'g', 17 )
+         .arg( mScale, 0, 'g', 17 )
+         .arg( mOutputSize.width() ).arg( mOutputSize.height() )
+         .arg( mDpi )
+         .arg( mRotation, 0, 'g', 17 )
+         .arg( mDestinationCrs );
+}
+
+QString QgsMapRendererCache::styleHash( const QString& layerId )
+{
+  QMap<QString, QString>::const_iterator it = mStyleHashes.constFind( layerId );
+  if ( it != mStyleHashes.constEnd() )
+    return it.value();
+
+  QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
+  if ( !layer )
+    return QString();
+
+  QDomDocument doc;
+  QDomElement layerElem = doc.createElement( "maplayer" );
+  doc.appendChild( layerElem );
+  QString errorMessage;
+  if ( !layer->writeSymbology( layerElem, doc, errorMessage ) )
+    return QString();
+
+  QString hash = md5Hex( layer->source() + '|' + doc.toString() );
+  mStyleHashes.insert( layerId, hash );
+  return hash;
+}
+
+QString QgsMapRendererCache::layerDirectory( const QString& layerId ) const
+{
+  return QDir( mCacheDirectory ).filePath( md5Hex( layerId ) );
+}
+
+QString QgsMapRendererCache::imagePath( const QString& layerId )
+{
+  // images of views with unknown output size would be ambiguous
+  if ( !mOutputSize.isValid() || mDpi <= 0 )
+    return QString();
+
+  QString hash = styleHash( layerId );
+  if ( hash.isEmpty() )
+    return QString();
+
+  QString state = dataState( QgsMapLayerRegistry::instance()->mapLayer( layerId ) );
+  if ( state.isEmpty() )
+    return QString();
+
+  return QDir( layerDirectory( layerId ) ).filePath( md5Hex( hash + '|' + state + '|' + viewKey() ) + ".png" );
+}
+
+QString QgsMapRendererCache::dataState( QgsMapLayer* layer )
+{
+  if ( !layer )
+    return QString();
+
+  QgsDataProvider* provider = 0;
+  if ( QgsVectorLayer* vl = qobject_cast<QgsVectorLayer*>( layer ) )
+  {
+    // neither edits nor the selection are kept after a restart
+    if ( vl->isEditable() || vl->selectedFeatureCount() > 0 )
+      return QString();
+    provider = vl->dataProvider();
+  }
+  else if ( QgsRasterLayer* rl = qobject_cast<QgsRasterLayer*>( layer ) )
+  {
+    provider = rl->dataProvider();
+  }
+
+  if ( provider && provider->dataTimestamp().isValid() )
+    return provider->dataTimestamp().toString( Qt::ISODate );
+
+  // file based data: the files sharing the base name of the source (e.g. .shp, .dbf and .shx)
+  QFileInfo sourceInfo( layer->source().section( '|', 0, 0 ) );
+  if ( !sourceInfo.isFile() )
+    return QString();
+
+  QStringList state;
+  QFileInfoList files = sourceInfo.dir().entryInfoList( QStringList( sourceInfo.completeBaseName() + ".*" ), QDir::Files, QDir::Name );
+  Q_FOREACH ( const QFileInfo& file, files )
+  {
+    state << QString( "%1:%2:%3" ).arg( file.fileName() ).arg( file.size() ).arg( file.lastModified().toMSecsSinceEpoch() );
+  }
+  return state.join( "," );
+}
+
+void QgsMapRendererCache::connectLayer( const QString& layerId )
+{
+  if ( mConnectedLayers.contains( layerId ) )
+    return;
+
+  QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
+  if ( layer )
+  {
+    connect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ) );
+    connect( layer, SIGNAL( dataChanged() ), this, SLOT( layerRequestedRepaint() ) );
+    mConnectedLayers.insert( layerId );
+  }
+}
+
+void QgsMapRendererCache::removeLayerImages( const QString& layerId )
+{
+  ++mLayerGenerations[layerId];
+  mCachedImages.remove( layerId );
+  mStyleHashes.remove( layerId );
+
+  QString prefix = layerId + '|';
+  Q_FOREACH ( const QString& key, mPreviousImages.keys() )
+  {
+    if ( key.startsWith( prefix ) )
+      mPreviousImages.remove( key );
+  }
+
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    QDir imageDir( layerDirectory( layerId ) );
+    Q_FOREACH ( const QString& image, imageDir.entryList( QStringList( "*.png" ), QDir::Files ) )
+    {
+      imageDir.remove( image );
+
+      QHash<QString, DiskImage>::iterator it = mDiskImages.find( imageDir.filePath( image ) );
+      if ( it != mDiskImages.end() )
+      {
+        mDiskUsage -= it->size;
+        mDiskImages.erase( it );
+      }
+    }
+    QDir( mCacheDirectory ).rmdir( md5Hex( layerId ) );
+  }
+}
+
+void QgsMapRendererCache::loadDiskImages()
+{
+  if ( mDiskImagesLoaded )
+    return;
+
+  mDiskImagesLoaded = true;
+  mDiskImages.clear();
+  mDiskUsage = 0;
+
+  // images stored by previous sessions are ordered by their modification time
+  QMultiMap<QDateTime, QFileInfo> imagesByTime;
+  QDir dir( mCacheDirectory );
+  Q_FOREACH ( const QString& layerDir, dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot ) )
+  {
+    Q_FOREACH ( const QFileInfo& info, QDir( dir.filePath( layerDir ) ).entryInfoList( QStringList( "*.png" ), QDir::Files ) )
+      imagesByTime.insert( info.lastModified(), info );
+  }
+
+  for ( QMultiMap<QDateTime, QFileInfo>::const_iterator it = imagesByTime.constBegin(); it != imagesByTime.constEnd(); ++it )
+  {
+    DiskImage image;
+    image.size = it.value().size();
+    image.lastUse = ++mDiskUseCounter;
+    mDiskImages.insert( it.value().filePath(), image );
+    mDiskUsage += image.size;
+  }
+}
+
+void QgsMapRendererCache::touchDiskImage( const QString& path )
+{
+  loadDiskImages();
+
+  QHash<QString, DiskImage>::iterator it = mDiskImages.find( path );
+  if ( it == mDiskImages.end() )
+  {
+    // the image is not written yet or it was stored by another cache
+    DiskImage image;
+    image.size = QFileInfo( path ).size();
+    it = mDiskImages.insert( path, image );
+    mDiskUsage += image.size;
+  }
+  it->lastUse = ++mDiskUseCounter;
+}
+
+void QgsMapRendererCache::trimDiskCache()
+{
+  loadDiskImages();
+
+  if ( mDiskUsage <= mMaxDiskUsage )
+    return;
+
+  QMap<qint64, QString> imagesByUse;
+  for ( QHash<QString, DiskImage>::const_iterator it = mDiskImages.constBegin(); it != mDiskImages.constEnd(); ++it )
+    imagesByUse.insert( it->lastUse, it.key() );
+
+  for ( QMap<qint64, QString>::const_iterator it = imagesByUse.constBegin(); it != imagesByUse.constEnd() && mDiskUsage > mMaxDiskUsage; ++it )
+  {
+    QFile::remove( it.value() );
+    mDiskUsage -= mDiskImages.value( it.value() ).size;
+    mDiskImages.remove( it.value() );
+    QDir().rmdir( QFileInfo( it.value() ).path() );
   }
 }
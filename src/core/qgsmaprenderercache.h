@@ -16,19 +16,42 @@
 #ifndef QGSMAPRENDERERCACHE_H
 #define QGSMAPRENDERERCACHE_H
 
+#include <QCache>
+#include <QFuture>
+#include <QHash>
+#include <QList>
 #include <QMap>
 #include <QImage>
 #include <QMutex>
+#include <QSet>
+#include <QSize>
 
 #include "qgsrectangle.h"
 
+class QgsMapLayer;
+
 
 /**
  * This class is responsible for keeping cache of rendered images of individual layers.
  *
+ * The cache is organized in tiers:
+ * - images of the view set by the last call to init() are always kept in memory,
+ * - images of previous views are kept in a memory limited LRU cache
+ *   (see setMaximumMemoryUsage()), so that returning to a previous view does not
+ *   require rendering the layers again,
+ * - optionally the images are also stored in a directory on disk (see setCacheDirectory()),
+ *   where they survive restarts of the application. Images on disk are keyed by the
+ *   layer's source, style and the modification time of its data, so they are not used once
+ *   the style or the data of the layer has changed. Images of layers whose modification time
+ *   is unknown (e.g. database layers), of layers being edited and of layers with selected
+ *   features are not stored on disk. Images are written to disk on a background thread.
+ *   The size of the images on disk is limited (see setMaximumDiskUsage()), the least recently
+ *   used images are removed first.
+ *
  * Once a layer has rendered image stored in the cache (using setCacheImage(...)),
- * the cache listens to repaintRequested() signals from layer. If triggered, the cache
- * removes the rendered image (and disconnects from the layer).
+ * the cache listens to repaintRequested() and dataChanged() signals from layer. If triggered,
+ * the cache removes all rendered images of the layer, including the ones stored on disk
+ * (and disconnects from the layer).
  *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
@@ -41,12 +64,28 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
 
     QgsMapRendererCache();
 
-    //! invalidate the cache contents
+    //! waits until all images are written to the cache directory
+    ~QgsMapRendererCache();
+
+    //! invalidate the cache contents kept in memory
     void clear();
 
-    //! initialize cache: set new parameters and erase cache if parameters have changed
+    //! remove all images stored in the cache directory
+    //! @note added in QGIS 2.12
+    void clearDiskCache();
+
+    //! initialize cache: set new parameters of the view. Images of the previous view are kept
+    //! in the cache and are returned again once the view is initialized with the same parameters
+    //! @param extent visible extent of the map
+    //! @param scale map scale
+    //! @param outputSize size of the rendered images (added in QGIS 2.12)
+    //! @param dpi output resolution of the rendered images (added in QGIS 2.12)
+    //! @param rotation map rotation in degrees (added in QGIS 2.12)
+    //! @param destinationCrs definition of the CRS the layers are reprojected to, empty if they
+    //! are not reprojected (added in QGIS 2.12)
     //! @return flag whether the parameters are the same as last time
-    bool init( QgsRectangle extent, double scale );
+    bool init( QgsRectangle extent, double scale, QSize outputSize = QSize(), int dpi = 0,
+               double rotation = 0.0, const QString& destinationCrs = QString() );
 
     //! set cached image for the specified layer ID
     void setCacheImage( QString layerId, const QImage& img );
@@ -57,6 +96,33 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! remove layer from the cache
     void clearCacheImage( QString layerId );
 
+    //! Sets the maximum memory used by images of previous views (in megabytes).
+    //! Images of the current view are not counted. Use 0 to keep only the current view.
+    //! @note added in QGIS 2.12
+    void setMaximumMemoryUsage( int megabytes );
+
+    //! Returns the maximum memory used by images of previous views (in megabytes)
+    //! @note added in QGIS 2.12
+    int maximumMemoryUsage() const;
+
+    //! Sets the directory where rendered images are stored, so that they may be used
+    //! again after a restart. An empty path (the default) disables the disk cache.
+    //! @note added in QGIS 2.12
+    void setCacheDirectory( const QString& path );
+
+    //! Returns the directory where rendered images are stored, empty if disk cache is disabled
+    //! @note added in QGIS 2.12
+    QString cacheDirectory() const;
+
+    //! Sets the maximum size of the images stored in the cache directory (in megabytes).
+    //! Use 0 to not store any images on disk.
+    //! @note added in QGIS 2.12
+    void setMaximumDiskUsage( int megabytes );
+
+    //! Returns the maximum size of the images stored in the cache directory (in megabytes)
+    //! @note added in QGIS 2.12
+    int maximumDiskUsage() const;
+
   protected slots:
     //! remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
@@ -66,10 +132,68 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     void clearInternal();
 
   protected:
-    QMutex mMutex;
+    mutable QMutex mMutex;
     QgsRectangle mExtent;
     double mScale;
     QMap<QString, QImage> mCachedImages;
+
+  private:
+    //! returns key of the current view
+    QString viewKey() const;
+    //! returns hash of the layer's style used for keying images on disk (without locking)
+    QString styleHash( const QString& layerId );
+    //! returns directory of the layer's images on disk (without locking)
+    QString layerDirectory( const QString& layerId ) const;
+    //! returns path of the layer's image of the current view on disk, empty if the image
+    //! may not be stored on disk (without locking)
+    QString imagePath( const QString& layerId );
+    //! returns the modification time and size of the layer's data, empty if they are unknown
+    //! or the layer's image would not be valid after a restart
+    static QString dataState( QgsMapLayer* layer );
+    //! writes the image to disk unless the layer's images were removed meanwhile. Called from worker threads.
+    void writeImage( const QString& layerId, int generation, const QString& path, const QImage& img );
+    //! starts listening to the layer's changes (without locking)
+    void connectLayer( const QString& layerId );
+    //! removes all images of the layer (without locking)
+    void removeLayerImages( const QString& layerId );
+    //! reads the sizes of the images stored in the cache directory, unless done already (without locking)
+    void loadDiskImages();
+    //! marks the image on disk as the most recently used one (without locking)
+    void touchDiskImage( const QString& path );
+    //! removes the least recently used images from disk until their size is within the limit (without locking)
+    void trimDiskCache();
+
+    QSize mOutputSize;
+    int mDpi;
+    double mRotation;
+    QString mDestinationCrs;
+
+    //! images of previous views, keyed by layer ID and view
+    QCache<QString, QImage> mPreviousImages;
+    //! style hashes of the layers, calculated when first needed
+    QMap<QString, QString> mStyleHashes;
+    //! IDs of the layers we are listening to
+    QSet<QString> mConnectedLayers;
+
+    QString mCacheDirectory;
+    //! incremented whenever the images of a layer are removed, so that pending writes are dropped
+    QMap<QString, int> mLayerGenerations;
+    //! images being written to disk
+    QList< QFuture<void> > mPendingWrites;
+
+    struct DiskImage
+    {
+      qint64 size;
+      qint64 lastUse;
+    };
+    //! images stored in the cache directory, keyed by path
+    QHash<QString, DiskImage> mDiskImages;
+    bool mDiskImagesLoaded;
+    //! total size of the images in the cache directory
+    qint64 mDiskUsage;
+    //! incremented whenever an image on disk is used
+    qint64 mDiskUseCounter;
+    qint64 mMaxDiskUsage;
 };
 
 
@@ -36,6 +36,7 @@
 QgsMapRendererJob::QgsMapRendererJob( const QgsMapSettings& settings )
     : mSettings( settings )
     , mCache( 0 )
+    , mPreviousLabelingResults( 0 )
     , mRenderingTime( 0 )
 {
 }
@@ -145,7 +146,8 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter* painter, QgsPalLabelin
 
   if ( mCache )
   {
-    bool cacheValid = mCache->init( mSettings.visibleExtent(), mSettings.scale() );
+    bool cacheValid = mCache->init( mSettings.visibleExtent(), mSettings.scale(), mSettings.outputSize(), mSettings.outputDpi(),
+                                    mSettings.rotation(), mSettings.hasCrsTransformEnabled() ? mSettings.destinationCrs().toProj4() : QString() );
     QgsDebugMsg( QString( "CACHE VALID: %1" ).arg( cacheValid ) );
     Q_UNUSED( cacheValid );
   }
@@ -120,6 +120,14 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! Does not take ownership of the object.
     void setCache( QgsMapRendererCache* cache );
 
+    /** Sets the labeling results of the previous job, e.g. of the previous frame of a map canvas.
+     * Labels stay where they were in these results unless they collide, so that they do not jump
+     * around between frames. Does not take ownership
+     * of the object, which must stay valid until start() returned.
+     * @note added in QGIS 2.12
+     */
+    void setPreviousLabelingResults( const QgsLabelingResults* results ) { mPreviousLabelingResults = results; }
+
     //! Set which vector layers should be cached while rendering
     //! @note The way how geometries are cached is really suboptimal - this method may be removed in future releases
     void setRequestedGeometryCacheForLayers( const QStringList& layerIds ) { mRequestedGeomCacheForLayers = layerIds; }
@@ -171,6 +179,9 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     QgsMapRendererCache* mCache;
 
+    //! labeling results whose label positions are kept stable
+    const QgsLabelingResults* mPreviousLabelingResults;
+
     //! list of layer IDs for which the geometry cache should be updated
     QStringList mRequestedGeomCacheForLayers;
     //! map of geometry caches
@@ -67,6 +67,7 @@ void QgsMapRendererParallelJob::start()
     mLabelingEngineV2 = new QgsLabelingEngineV2();
     mLabelingEngineV2->readSettingsFromProject();
     mLabelingEngineV2->setMapSettings( mSettings );
+    mLabelingEngineV2->setPreviousResults( mPreviousLabelingResults );
 #else
     mLabelingEngine = new QgsPalLabeling;
     mLabelingEngine->loadEngineSettings();
@@ -67,6 +67,7 @@ void QgsMapRendererSequentialJob::start()
 
   mInternalJob = new QgsMapRendererCustomPainterJob( mSettings, mPainter );
   mInternalJob->setCache( mCache );
+  mInternalJob->setPreviousLabelingResults( mPreviousLabelingResults );
 
   connect( mInternalJob, SIGNAL( finished() ), SLOT( internalFinished() ) );
 
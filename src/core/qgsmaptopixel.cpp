@@ -326,6 +326,24 @@ void QgsMapToPixel::transformInPlace( double& x, double& y ) const
   x = mx; y = my;
 }
 
+void QgsMapToPixel::transformInPlace( double* x, double* y, int count ) const
+{
+  // mMatrix is always affine, so QTransform::map() reduces to these coefficients
+  const double m11 = mMatrix.m11();
+  const double m12 = mMatrix.m12();
+  const double m21 = mMatrix.m21();
+  const double m22 = mMatrix.m22();
+  const double dx = mMatrix.dx();
+  const double dy = mMatrix.dy();
+  for ( int i = 0; i < count; ++i )
+  {
+    double px = x[i];
+    double py = y[i];
+    x[i] = m11 * px + m21 * py + dx;
+    y[i] = m12 * px + m22 * py + dy;
+  }
+}
+
 void QgsMapToPixel::transformInPlace( float& x, float& y ) const
 {
   double mx = x, my = y;
@@ -120,6 +120,18 @@ class CORE_EXPORT QgsMapToPixel
         transformInPlace( x[i], y[i] );
     }
 
+    /**
+     * Transform arrays of map coordinates to device coordinates in place.
+     * The affine transform is applied in a single loop over the arrays, which is
+     * considerably faster than transforming points one by one.
+     * @param x array of x coordinates
+     * @param y array of y coordinates
+     * @param count number of coordinates in the arrays
+     * @note added in QGIS 2.12
+     * @note not available in python bindings
+     */
+    void transformInPlace( double* x, double* y, int count ) const;
+
     QgsPoint toMapCoordinates( int x, int y ) const;
 
     //! Transform device coordinates to map (world) coordinates
@@ -17,6 +17,7 @@
 #include <limits>
 #include "qgsmaptopixelgeometrysimplifier.h"
 #include "qgsapplication.h"
+#include "qgsrenderarena.h"
 
 QgsMapToPixelSimplifier::QgsMapToPixelSimplifier( int simplifyFlags, double tolerance )
     : mSimplifyFlags( simplifyFlags )
@@ -431,7 +432,12 @@ bool QgsMapToPixelSimplifier::simplifyGeometry( QgsGeometry* geometry, int simpl
   const unsigned char* wkb = geometry->asWkb();
   size_t wkbSize = geometry->wkbSize();
 
-  unsigned char* targetWkb = new unsigned char[wkbSize];
+  // the working copy only lives during this call, take it from the scratch memory of the thread
+  QgsRenderArena* arena = QgsRenderArena::instance();
+  QgsRenderArena::Scope scope( arena );
+  unsigned char* targetWkb = arena->allocate<unsigned char>( wkbSize );
+  if ( !targetWkb )
+    return false;
   memcpy( targetWkb, wkb, wkbSize );
 
   if ( simplifyWkbGeometry( simplifyFlags, wkbType, wkb, wkbSize, targetWkb, finalWkbSize, envelope, tolerance ) )
@@ -439,10 +445,8 @@ bool QgsMapToPixelSimplifier::simplifyGeometry( QgsGeometry* geometry, int simpl
     unsigned char* finalWkb = new unsigned char[finalWkbSize];
     memcpy( finalWkb, targetWkb, finalWkbSize );
     geometry->fromWkb( finalWkb, finalWkbSize );
-    delete [] targetWkb;
     return true;
   }
-  delete [] targetWkb;
   return false;
 }
 
@@ -7,6 +7,7 @@
 #include <QColor>
 #include <QStringList>
 #include <QTextStream>
+#include <QXmlStreamWriter>
 
 #ifndef Q_OS_WIN
 #include <netinet/in.h>
@@ -1350,6 +1351,188 @@ QDomElement QgsOgcUtils::geometryToGML( const QgsGeometry *geometry, QDomDocumen
   return geometryToGML( geometry, doc, "GML2", precision );
 }
 
+bool QgsOgcUtils::geometryToGML( const QgsGeometry* geometry, QXmlStreamWriter& writer, const QString& format, int precision, const QString& srsName )
+{
+  if ( !geometry || !geometry->asWkb() )
+    return false;
+
+  QGis::WkbType wkbType = geometry->wkbType();
+  bool gml3 = format == "GML3";
+  bool hasZValue = wkbType == QGis::WKBMultiPoint25D || wkbType == QGis::WKBLineString25D || wkbType == QGis::WKBMultiLineString25D
+                   || wkbType == QGis::WKBPolygon25D || wkbType == QGis::WKBMultiPolygon25D;
+  bool isPoint = wkbType == QGis::WKBPoint || wkbType == QGis::WKBPoint25D;
+  bool isMultiPoint = wkbType == QGis::WKBMultiPoint || wkbType == QGis::WKBMultiPoint25D;
+  bool isPolygon = wkbType == QGis::WKBPolygon || wkbType == QGis::WKBPolygon25D || wkbType == QGis::WKBMultiPolygon || wkbType == QGis::WKBMultiPolygon25D;
+
+  // coordinate and tupel separator
+  QString cs = gml3 ? " " : ",";
+  QString ts = " ";
+  QString coordElemName = gml3 ? ( isPoint || isMultiPoint ? "gml:pos" : "gml:posList" ) : "gml:coordinates";
+
+  QgsConstWkbPtr wkbPtr( geometry->asWkb() + 1 + sizeof( int ) );
+
+  // number of parts of multi geometries
+  int nParts = 1;
+  QString geomElemName, memberElemName, partElemName;
+  switch ( wkbType )
+  {
+    case QGis::WKBPoint25D:
+    case QGis::WKBPoint:
+      geomElemName = "gml:Point";
+      break;
+    case QGis::WKBMultiPoint25D:
+    case QGis::WKBMultiPoint:
+      geomElemName = "gml:MultiPoint";
+      memberElemName = "gml:pointMember";
+      partElemName = "gml:Point";
+      wkbPtr >> nParts;
+      break;
+    case QGis::WKBLineString25D:
+    case QGis::WKBLineString:
+      geomElemName = "gml:LineString";
+      break;
+    case QGis::WKBMultiLineString25D:
+    case QGis::WKBMultiLineString:
+      geomElemName = "gml:MultiLineString";
+      memberElemName = "gml:lineStringMember";
+      partElemName = "gml:LineString";
+      wkbPtr >> nParts;
+      break;
+    case QGis::WKBPolygon25D:
+    case QGis::WKBPolygon:
+    {
+      int numRings;
+      QgsConstWkbPtr( geometry->asWkb() + 1 + sizeof( int ) ) >> numRings;
+      if ( numRings == 0 ) // sanity check for zero rings in polygon
+        return false;
+      geomElemName = "gml:Polygon";
+      break;
+    }
+    case QGis::WKBMultiPolygon25D:
+    case QGis::WKBMultiPolygon:
+      geomElemName = "gml:MultiPolygon";
+      memberElemName = "gml:polygonMember";
+      partElemName = "gml:Polygon";
+      wkbPtr >> nParts;
+      break;
+    default:
+      return false;
+  }
+
+  writer.writeStartElement( geomElemName );
+  if ( !srsName.isEmpty() )
+  {
+    writer.writeAttribute( "srsName", srsName );
+  }
+
+  QString coordString;
+  for ( int part = 0; part < nParts; ++part )
+  {
+    if ( !memberElemName.isEmpty() )
+    {
+      writer.writeStartElement( memberElemName );
+      writer.writeStartElement( partElemName );
+      wkbPtr += 1 + sizeof( int );
+    }
+
+    // points have a single coordinate, lines a single ring
+    int nRings = 1;
+    if ( isPolygon )
+    {
+      wkbPtr >> nRings;
+    }
+
+    for ( int ring = 0; ring < nRings; ++ring )
+    {
+      if ( isPolygon )
+      {
+        writer.writeStartElement( ring == 0 ? "gml:outerBoundaryIs" : "gml:innerBoundaryIs" );
+        writer.writeStartElement( "gml:LinearRing" );
+      }
+
+      int nPoints = 1;
+      if ( !isPoint && !isMultiPoint )
+      {
+        wkbPtr >> nPoints;
+      }
+
+      coordString.clear();
+      for ( int idx = 0; idx < nPoints; ++idx )
+      {
+        if ( idx != 0 )
+        {
+          coordString += ts;
+        }
+
+        double x, y;
+        wkbPtr >> x >> y;
+        coordString += qgsDoubleToString( x, precision ) + cs + qgsDoubleToString( y, precision );
+
+        if ( hasZValue )
+        {
+          wkbPtr += sizeof( double );
+        }
+      }
+
+      writer.writeStartElement( coordElemName );
+      if ( gml3 )
+      {
+        writer.writeAttribute( "srsDimension", "2" );
+      }
+      else
+      {
+        writer.writeAttribute( "cs", cs );
+        writer.writeAttribute( "ts", ts );
+      }
+      writer.writeCharacters( coordString );
+      writer.writeEndElement();
+
+      if ( isPolygon )
+      {
+        writer.writeEndElement(); //gml:LinearRing
+        writer.writeEndElement(); //boundary
+      }
+    }
+
+    if ( !memberElemName.isEmpty() )
+    {
+      writer.writeEndElement(); //part
+      writer.writeEndElement(); //member
+    }
+  }
+
+  writer.writeEndElement();
+  return true;
+}
+
+void QgsOgcUtils::rectangleToGMLBox( const QgsRectangle& box, QXmlStreamWriter& writer, int precision, const QString& srsName )
+{
+  writer.writeStartElement( "gml:Box" );
+  if ( !srsName.isEmpty() )
+  {
+    writer.writeAttribute( "srsName", srsName );
+  }
+  writer.writeStartElement( "gml:coordinates" );
+  writer.writeAttribute( "cs", "," );
+  writer.writeAttribute( "ts", " " );
+  writer.writeCharacters( qgsDoubleToString( box.xMinimum(), precision ) + "," + qgsDoubleToString( box.yMinimum(), precision ) + " "
+                          + qgsDoubleToString( box.xMaximum(), precision ) + "," + qgsDoubleToString( box.yMaximum(), precision ) );
+  writer.writeEndElement();
+  writer.writeEndElement();
+}
+
+void QgsOgcUtils::rectangleToGMLEnvelope( const QgsRectangle& env, QXmlStreamWriter& writer, int precision, const QString& srsName )
+{
+  writer.writeStartElement( "gml:Envelope" );
+  if ( !srsName.isEmpty() )
+  {
+    writer.writeAttribute( "srsName", srsName );
+  }
+  writer.writeTextElement( "gml:lowerCorner", qgsDoubleToString( env.xMinimum(), precision ) + " " + qgsDoubleToString( env.yMinimum(), precision ) );
+  writer.writeTextElement( "gml:upperCorner", qgsDoubleToString( env.xMaximum(), precision ) + " " + qgsDoubleToString( env.yMaximum(), precision ) );
+  writer.writeEndElement();
+}
+
 QDomElement QgsOgcUtils::createGMLCoordinates( const QgsPolyline &points, QDomDocument &doc )
 {
   QDomElement coordElem = doc.createElement( "gml:coordinates" );
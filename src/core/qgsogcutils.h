@@ -6,6 +6,7 @@ class QDomNode;
 class QDomElement;
 class QDomDocument;
 class QString;
+class QXmlStreamWriter;
 
 #include <list>
 #include <QVector>
@@ -66,6 +67,26 @@ class CORE_EXPORT QgsOgcUtils
      */
     static QDomElement rectangleToGMLEnvelope( QgsRectangle* env, QDomDocument& doc, const int &precision = 17 );
 
+    /** Writes the geometry as GML2 or GML3 element to a stream, with the same content as
+     * the element created by geometryToGML( const QgsGeometry*, QDomDocument&, QString, const int& ).
+     * @param srsName value of the srsName attribute of the geometry element, not written if empty
+     * @return false if the geometry cannot be represented in GML, nothing is written then
+     * @note added in QGIS 2.12
+     */
+    static bool geometryToGML( const QgsGeometry* geometry, QXmlStreamWriter& writer, const QString& format, int precision = 17, const QString& srsName = QString() );
+
+    /** Writes the rectangle as GML2 Box to a stream
+     * @param srsName value of the srsName attribute of the box, not written if empty
+     * @note added in QGIS 2.12
+     */
+    static void rectangleToGMLBox( const QgsRectangle& box, QXmlStreamWriter& writer, int precision = 17, const QString& srsName = QString() );
+
+    /** Writes the rectangle as GML3 Envelope to a stream
+     * @param srsName value of the srsName attribute of the envelope, not written if empty
+     * @note added in QGIS 2.12
+     */
+    static void rectangleToGMLEnvelope( const QgsRectangle& env, QXmlStreamWriter& writer, int precision = 17, const QString& srsName = QString() );
+
 
     /** Parse XML with OGC fill into QColor */
     static QColor colorFromOgcFill( const QDomElement& fillElement );
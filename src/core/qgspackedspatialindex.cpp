@@ -0,0 +1,439 @@
+/***************************************************************************
+    qgspackedspatialindex.cpp
+    ----------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspackedspatialindex.h"
+
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgslogger.h"
+#include "qgspoint.h"
+#include "qgsvectordataprovider.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+
+static const char PACKED_INDEX_MAGIC[8] = { 'Q', 'G', 'S', 'P', 'R', 'T', 'R', 'E' };
+static const quint32 PACKED_INDEX_BYTE_ORDER = 0x01020304;
+static const quint32 PACKED_INDEX_VERSION = 2;
+
+/** File header of a packed index. Followed by the entries. Not a part of public API. */
+struct QgsPackedSpatialIndexHeader
+{
+  char magic[8];
+  quint32 byteOrder; // detects files written on a machine with different endianness
+  quint32 version;
+  quint32 nodeSize;
+  quint32 reserved;
+  quint64 itemCount;
+  quint64 entryCount;
+  char sourceHash[16]; // MD5 of the signature of the indexed data source
+};
+
+/** Bounding box of a feature (leaf level) or a node. For nodes the id is the position of
+ * the first child in the entry array. Not a part of public API. */
+struct QgsPackedSpatialIndexEntry
+{
+  double xMin;
+  double yMin;
+  double xMax;
+  double yMax;
+  qint64 id;
+};
+
+/** Data of a packed spatial index, either built in memory or mapped from a file */
+class QgsPackedSpatialIndexData : public QSharedData
+{
+  public:
+    QgsPackedSpatialIndexData()
+        : mEntries( 0 )
+        , mItemCount( 0 )
+        , mNodeSize( 0 )
+        , mMapped( 0 )
+    {}
+
+    ~QgsPackedSpatialIndexData()
+    {
+      if ( mMapped )
+        mFile.unmap( mMapped );
+    }
+
+    //! Returns the end positions of the levels of a tree, the root being the last entry
+    static QVector<quint64> levelEnds( quint64 itemCount, int nodeSize )
+    {
+      QVector<quint64> ends;
+      if ( itemCount == 0 )
+        return ends;
+
+      quint64 levelCount = itemCount;
+      quint64 end = itemCount;
+      ends << end;
+      do
+      {
+        levelCount = ( levelCount + nodeSize - 1 ) / nodeSize;
+        end += levelCount;
+        ends << end;
+      }
+      while ( levelCount > 1 );
+      return ends;
+    }
+
+    quint64 entryCount() const { return mLevelEnds.isEmpty() ? 0 : mLevelEnds.last(); }
+
+    //! First entry, pointing either to mStorage or to the mapped file
+    const QgsPackedSpatialIndexEntry* mEntries;
+    quint64 mItemCount;
+    int mNodeSize;
+    QVector<quint64> mLevelEnds;
+
+    //! Entries of an index built in memory
+    QVector<QgsPackedSpatialIndexEntry> mStorage;
+
+    //! Index file and its mapping
+    QFile mFile;
+    uchar* mMapped;
+
+  private:
+    Q_DISABLE_COPY( QgsPackedSpatialIndexData )
+};
+
+static bool _lessCenterX( const QgsPackedSpatialIndexEntry& e1, const QgsPackedSpatialIndexEntry& e2 )
+{
+  return e1.xMin + e1.xMax < e2.xMin + e2.xMax;
+}
+
+static bool _lessCenterY( const QgsPackedSpatialIndexEntry& e1, const QgsPackedSpatialIndexEntry& e2 )
+{
+  return e1.yMin + e1.yMax < e2.yMin + e2.yMax;
+}
+
+static inline bool _intersects( const QgsPackedSpatialIndexEntry& e, const QgsRectangle& rect )
+{
+  return e.xMin <= rect.xMaximum() && e.xMax >= rect.xMinimum() && e.yMin <= rect.yMaximum() && e.yMax >= rect.yMinimum();
+}
+
+static inline double _sqrDist( const QgsPackedSpatialIndexEntry& e, double x, double y )
+{
+  double dx = x < e.xMin ? e.xMin - x : ( x > e.xMax ? x - e.xMax : 0.0 );
+  double dy = y < e.yMin ? e.yMin - y : ( y > e.yMax ? y - e.yMax : 0.0 );
+  return dx * dx + dy * dy;
+}
+
+// -------------------------------------------------------------------------
+
+QgsPackedSpatialIndex::QgsPackedSpatialIndex()
+{
+}
+
+QgsPackedSpatialIndex::QgsPackedSpatialIndex( const QgsFeatureIterator& fi, int nodeSize )
+{
+  d = new QgsPackedSpatialIndexData;
+  d->mNodeSize = qMax( nodeSize, 2 );
+
+  QVector<QgsPackedSpatialIndexEntry>& entries = d->mStorage;
+  QgsFeatureIterator it( fi );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( !f.constGeometry() )
+      continue;
+
+    QgsRectangle box = f.constGeometry()->boundingBox();
+    QgsPackedSpatialIndexEntry e = { box.xMinimum(), box.yMinimum(), box.xMaximum(), box.yMaximum(), f.id() };
+    entries << e;
+  }
+
+  d->mItemCount = entries.size();
+  d->mLevelEnds = QgsPackedSpatialIndexData::levelEnds( d->mItemCount, d->mNodeSize );
+  if ( d->mItemCount == 0 )
+    return;
+
+  // sort-tile-recursive order: vertical slices of boxes sorted by x, each slice sorted by y
+  int leafNodeCount = ( d->mItemCount + d->mNodeSize - 1 ) / d->mNodeSize;
+  int sliceSize = d->mNodeSize * ( int ) ceil( sqrt( ( double ) leafNodeCount ) );
+  qSort( entries.begin(), entries.end(), _lessCenterX );
+  for ( int i = 0; i < entries.size(); i += sliceSize )
+  {
+    qSort( entries.begin() + i, entries.begin() + qMin( i + sliceSize, entries.size() ), _lessCenterY );
+  }
+
+  // pack the nodes of every level
+  entries.reserve( d->entryCount() );
+  for ( int level = 1; level < d->mLevelEnds.size(); ++level )
+  {
+    quint64 childEnd = d->mLevelEnds[level - 1];
+    for ( quint64 child = level == 1 ? 0 : d->mLevelEnds[level - 2]; child < childEnd; child += d->mNodeSize )
+    {
+      QgsPackedSpatialIndexEntry node = entries[child];
+      node.id = child;
+      quint64 end = qMin( child + d->mNodeSize, childEnd );
+      for ( quint64 i = child + 1; i < end; ++i )
+      {
+        const QgsPackedSpatialIndexEntry& e = entries[i];
+        node.xMin = qMin( node.xMin, e.xMin );
+        node.yMin = qMin( node.yMin, e.yMin );
+        node.xMax = qMax( node.xMax, e.xMax );
+        node.yMax = qMax( node.yMax, e.yMax );
+      }
+      entries << node;
+    }
+  }
+
+  d->mEntries = entries.constData();
+}
+
+QgsPackedSpatialIndex::QgsPackedSpatialIndex( const QgsPackedSpatialIndex& other )
+    : d( other.d )
+{
+}
+
+QgsPackedSpatialIndex::~QgsPackedSpatialIndex()
+{
+}
+
+QgsPackedSpatialIndex& QgsPackedSpatialIndex::operator=( const QgsPackedSpatialIndex & other )
+{
+  if ( this != &other )
+    d = other.d;
+  return *this;
+}
+
+bool QgsPackedSpatialIndex::isValid() const
+{
+  return d.constData() != 0;
+}
+
+int QgsPackedSpatialIndex::count() const
+{
+  return d ? d->mItemCount : 0;
+}
+
+QgsRectangle QgsPackedSpatialIndex::extent() const
+{
+  if ( !d || d->mItemCount == 0 )
+    return QgsRectangle();
+
+  const QgsPackedSpatialIndexEntry& root = d->mEntries[d->entryCount() - 1];
+  return QgsRectangle( root.xMin, root.yMin, root.xMax, root.yMax );
+}
+
+//! returns the MD5 hash of a source signature, as stored in the header
+static QByteArray sourceHash( const QString& sourceSignature )
+{
+  return QCryptographicHash::hash( sourceSignature.toUtf8(), QCryptographicHash::Md5 );
+}
+
+QString QgsPackedSpatialIndex::sourceSignature( const QgsVectorDataProvider* provider )
+{
+  if ( !provider )
+    return QString();
+
+  QStringList parts;
+  parts << provider->name() << provider->dataSourceUri() << QString::number( provider->featureCount() );
+
+  QDateTime timestamp = provider->dataTimestamp();
+  if ( timestamp.isValid() )
+    parts << timestamp.toString( Qt::ISODate );
+
+  // file based sources, the layer options follow the file name
+  QFileInfo info( provider->dataSourceUri().split( '|' ).first() );
+  if ( info.isFile() )
+    parts << QString::number( info.size() ) << info.lastModified().toString( Qt::ISODate );
+
+  return parts.join( "|" );
+}
+
+bool QgsPackedSpatialIndex::writeToFile( const QString& path, const QString& sourceSignature ) const
+{
+  if ( !d )
+    return false;
+
+  QString tmpPath = path + ".tmp";
+  QFile file( tmpPath );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+  {
+    QgsDebugMsg( QString( "Cannot write spatial index file %1" ).arg( tmpPath ) );
+    return false;
+  }
+
+  QgsPackedSpatialIndexHeader header;
+  memcpy( header.magic, PACKED_INDEX_MAGIC, sizeof( header.magic ) );
+  header.byteOrder = PACKED_INDEX_BYTE_ORDER;
+  header.version = PACKED_INDEX_VERSION;
+  header.nodeSize = d->mNodeSize;
+  header.reserved = 0;
+  header.itemCount = d->mItemCount;
+  header.entryCount = d->entryCount();
+  QByteArray hash = sourceHash( sourceSignature );
+  memcpy( header.sourceHash, hash.constData(), sizeof( header.sourceHash ) );
+
+  qint64 entriesSize = header.entryCount * sizeof( QgsPackedSpatialIndexEntry );
+  bool ok = file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) ) == sizeof( header )
+            && ( entriesSize == 0 || file.write( reinterpret_cast<const char*>( d->mEntries ), entriesSize ) == entriesSize );
+  file.close();
+  if ( !ok )
+  {
+    QFile::remove( tmpPath );
+    return false;
+  }
+
+  // rename replaces the file atomically on POSIX systems, processes which mapped the old file keep it
+  if ( std::rename( QFile::encodeName( tmpPath ).constData(), QFile::encodeName( path ).constData() ) != 0 )
+  {
+    QFile::remove( path );
+    if ( !QFile::rename( tmpPath, path ) )
+    {
+      QFile::remove( tmpPath );
+      return false;
+    }
+  }
+  return true;
+}
+
+bool QgsPackedSpatialIndex::readFromFile( const QString& path, const QString& sourceSignature )
+{
+  QExplicitlySharedDataPointer<QgsPackedSpatialIndexData> data( new QgsPackedSpatialIndexData );
+  data->mFile.setFileName( path );
+  if ( !data->mFile.open( QIODevice::ReadOnly ) )
+    return false;
+
+  qint64 size = data->mFile.size();
+  if ( size < ( qint64 ) sizeof( QgsPackedSpatialIndexHeader ) )
+    return false;
+
+  data->mMapped = data->mFile.map( 0, size );
+  if ( !data->mMapped )
+  {
+    QgsDebugMsg( QString( "Cannot map spatial index file %1" ).arg( path ) );
+    return false;
+  }
+
+  const QgsPackedSpatialIndexHeader* header = reinterpret_cast<const QgsPackedSpatialIndexHeader*>( data->mMapped );
+  if ( memcmp( header->magic, PACKED_INDEX_MAGIC, sizeof( header->magic ) ) != 0
+       || header->byteOrder != PACKED_INDEX_BYTE_ORDER
+       || header->version != PACKED_INDEX_VERSION
+       || header->nodeSize < 2 )
+  {
+    QgsDebugMsg( QString( "%1 is not a spatial index file of this platform" ).arg( path ) );
+    return false;
+  }
+
+  if ( memcmp( header->sourceHash, sourceHash( sourceSignature ).constData(), sizeof( header->sourceHash ) ) != 0 )
+  {
+    QgsDebugMsg( QString( "Spatial index file %1 was written for another state of the data source" ).arg( path ) );
+    return false;
+  }
+
+  data->mNodeSize = header->nodeSize;
+  data->mItemCount = header->itemCount;
+  data->mLevelEnds = QgsPackedSpatialIndexData::levelEnds( data->mItemCount, data->mNodeSize );
+  if ( header->entryCount != data->entryCount()
+       || ( quint64 ) size != sizeof( QgsPackedSpatialIndexHeader ) + data->entryCount() * sizeof( QgsPackedSpatialIndexEntry ) )
+  {
+    QgsDebugMsg( QString( "Spatial index file %1 is truncated" ).arg( path ) );
+    return false;
+  }
+
+  data->mEntries = reinterpret_cast<const QgsPackedSpatialIndexEntry*>( data->mMapped + sizeof( QgsPackedSpatialIndexHeader ) );
+  d = data;
+  return true;
+}
+
+QList<QgsFeatureId> QgsPackedSpatialIndex::intersects( const QgsRectangle& rect ) const
+{
+  QList<QgsFeatureId> list;
+  if ( !d || d->mItemCount == 0 )
+    return list;
+
+  // stack of entry positions and their levels
+  QVector< QPair<quint64, int> > stack;
+  stack << qMakePair( d->entryCount() - 1, d->mLevelEnds.size() - 1 );
+  while ( !stack.isEmpty() )
+  {
+    QPair<quint64, int> item = stack.last();
+    stack.pop_back();
+
+    const QgsPackedSpatialIndexEntry& e = d->mEntries[item.first];
+    if ( !_intersects( e, rect ) )
+      continue;
+
+    if ( item.second == 0 )
+    {
+      list << e.id;
+      continue;
+    }
+
+    quint64 end = qMin( ( quint64 ) e.id + d->mNodeSize, d->mLevelEnds[item.second - 1] );
+    for ( quint64 child = e.id; child < end; ++child )
+    {
+      stack << qMakePair( child, item.second - 1 );
+    }
+  }
+
+  return list;
+}
+
+/** Entry of the best-first search queue. Not a part of public API. */
+struct QgsPackedSpatialIndexQueueItem
+{
+  double sqrDist;
+  quint64 pos;
+  int level;
+
+  //! ordered for a min-heap by distance
+  bool operator<( const QgsPackedSpatialIndexQueueItem& other ) const { return sqrDist > other.sqrDist; }
+};
+
+QList<QgsFeatureId> QgsPackedSpatialIndex::nearestNeighbor( const QgsPoint& point, int neighbors ) const
+{
+  QList<QgsFeatureId> list;
+  if ( !d || d->mItemCount == 0 || neighbors <= 0 )
+    return list;
+
+  double x = point.x();
+  double y = point.y();
+
+  std::priority_queue<QgsPackedSpatialIndexQueueItem> queue;
+  quint64 rootPos = d->entryCount() - 1;
+  QgsPackedSpatialIndexQueueItem root = { _sqrDist( d->mEntries[rootPos], x, y ), rootPos, d->mLevelEnds.size() - 1 };
+  queue.push( root );
+  while ( !queue.empty() && list.size() < neighbors )
+  {
+    QgsPackedSpatialIndexQueueItem item = queue.top();
+    queue.pop();
+
+    const QgsPackedSpatialIndexEntry& e = d->mEntries[item.pos];
+    if ( item.level == 0 )
+    {
+      // no entry left in the queue is closer than this feature
+      list << e.id;
+      continue;
+    }
+
+    quint64 end = qMin( ( quint64 ) e.id + d->mNodeSize, d->mLevelEnds[item.level - 1] );
+    for ( quint64 child = e.id; child < end; ++child )
+    {
+      QgsPackedSpatialIndexQueueItem childItem = { _sqrDist( d->mEntries[child], x, y ), child, item.level - 1 };
+      queue.push( childItem );
+    }
+  }
+
+  return list;
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+    qgspackedspatialindex.h
+    ----------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPACKEDSPATIALINDEX_H
+#define QGSPACKEDSPATIALINDEX_H
+
+#include <QExplicitlySharedDataPointer>
+#include <QList>
+
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
+
+class QgsFeatureIterator;
+class QgsPoint;
+class QgsVectorDataProvider;
+class QgsPackedSpatialIndexData;
+
+/** \ingroup core
+ * \class QgsPackedSpatialIndex
+ * \brief Immutable packed R-tree of feature bounding boxes.
+ *
+ * The tree is bulk loaded with the sort-tile-recursive algorithm and stored as a single flat
+ * array of fixed-size entries: the feature boxes first, followed by the nodes of each level
+ * up to the root. The array can be written to a file, usually next to the data source, and
+ * memory-mapped when it is read again, so that opening an index does not require a scan
+ * of the layer and several processes share the same pages.
+ *
+ * The index cannot be modified after it has been built. All queries are const and may be
+ * run concurrently from several threads. The index file has to be written again when the
+ * data source changes, files of an older state of the data source are rejected when they are
+ * read.
+ * \note added in QGIS 2.12
+ */
+class CORE_EXPORT QgsPackedSpatialIndex
+{
+  public:
+
+    /** Constructor for an empty, invalid index */
+    QgsPackedSpatialIndex();
+
+    /** Constructor - builds the index from the features of the iterator.
+     * @param fi feature iterator, features without geometry are skipped
+     * @param nodeSize maximum number of children of a node
+     */
+    explicit QgsPackedSpatialIndex( const QgsFeatureIterator& fi, int nodeSize = 16 );
+
+    /** Copy constructor. The index data is shared with the other index */
+    QgsPackedSpatialIndex( const QgsPackedSpatialIndex& other );
+
+    ~QgsPackedSpatialIndex();
+
+    QgsPackedSpatialIndex& operator=( const QgsPackedSpatialIndex& other );
+
+    /** Returns true if the index has been built or successfully read from a file */
+    bool isValid() const;
+
+    /** Returns the number of indexed features */
+    int count() const;
+
+    /** Returns the extent of all indexed features */
+    QgsRectangle extent() const;
+
+    /** Returns a signature of the current state of a data source, built from the provider,
+     * its URI, the feature count and the modification time of the data.
+     * @see writeToFile()
+     */
+    static QString sourceSignature( const QgsVectorDataProvider* provider );
+
+    /** Writes the index to a file. The file is replaced atomically, so processes
+     * reading the old file are not affected.
+     * @param path file name
+     * @param sourceSignature signature of the indexed data source, usually from sourceSignature()
+     * @returns true on success
+     */
+    bool writeToFile( const QString& path, const QString& sourceSignature ) const;
+
+    /** Memory-maps an index written by writeToFile(). The file remains open
+     * while the index or any of its copies exist.
+     * @param path file name
+     * @param sourceSignature signature of the data source in its current state. An index
+     * written for another signature is outdated and not read.
+     * @returns true if the file is a valid index of the data source
+     */
+    bool readFromFile( const QString& path, const QString& sourceSignature );
+
+    /** Returns features whose bounding box intersects the specified rectangle */
+    QList<QgsFeatureId> intersects( const QgsRectangle& rect ) const;
+
+    /** Returns the nearest features (their count is specified by second parameter),
+     * ordered by the distance between the point and their bounding box */
+    QList<QgsFeatureId> nearestNeighbor( const QgsPoint& point, int neighbors ) const;
+
+  private:
+
+    QExplicitlySharedDataPointer<QgsPackedSpatialIndexData> d;
+};
+
+#endif // QGSPACKEDSPATIALINDEX_H
@@ -6,6 +6,7 @@
 #include <pal/feature.h>
 
 #include "qgslabelingenginev2.h"
+#include "qgslabeltextmetricscache.h"
 
 using namespace pal;
 
@@ -52,9 +53,6 @@ class QgsTextLabelFeature : public QgsLabelFeature
 
       mFontMetrics = new QFontMetricsF( *fm ); // duplicate metrics for when drawing label
 
-      qreal letterSpacing = mDefinedFont.letterSpacing();
-      qreal wordSpacing = mDefinedFont.wordSpacing();
-
       // max angle between curved label characters (20.0/-20.0 was default in QGIS <= 1.8)
       if ( maxinangle < 20.0 )
         maxinangle = 20.0;
@@ -71,41 +69,13 @@ class QgsTextLabelFeature : public QgsLabelFeature
 
       // mLetterSpacing/mWordSpacing = 0.0 is default for non-curved labels
       // (non-curved spacings handled by Qt in QgsPalLayerSettings/QgsPalLabeling)
-      qreal charWidth;
-      qreal wordSpaceFix;
-
-      //split string by valid grapheme boundaries - required for certain scripts (see #6883)
-      mClusters = QgsPalLabeling::splitToGraphemes( mLabelText );
+      QgsLabelTextMetricsCache::Graphemes graphemes = QgsLabelTextMetricsCache::instance()->graphemes( mDefinedFont, *fm, mLabelText, curvedLabeling );
+      mClusters = graphemes.clusters;
 
       mInfo = new pal::LabelInfo( mClusters.count(), labelHeight, maxinangle, maxoutangle );
       for ( int i = 0; i < mClusters.count(); i++ )
       {
-        // reconstruct how Qt creates word spacing, then adjust per individual stored character
-        // this will allow PAL to create each candidate width = character width + correct spacing
-        charWidth = fm->width( mClusters[i] );
-        if ( curvedLabeling )
-        {
-          wordSpaceFix = qreal( 0.0 );
-          if ( mClusters[i] == QString( " " ) )
-          {
-            // word spacing only gets added once at end of consecutive run of spaces, see QTextEngine::shapeText()
-            int nxt = i + 1;
-            wordSpaceFix = ( nxt < mClusters.count() && mClusters[nxt] != QString( " " ) ) ? wordSpacing : qreal( 0.0 );
-          }
-          // this workaround only works for clusters with a single character. Not sure how it should be handled
-          // with multi-character clusters.
-          if ( mClusters[i].length() == 1 &&
-               !qgsDoubleNear( fm->width( QString( mClusters[i].at( 0 ) ) ), fm->width( mClusters[i].at( 0 ) ) + letterSpacing ) )
-          {
-            // word spacing applied when it shouldn't be
-            wordSpaceFix -= wordSpacing;
-          }
-
-          charWidth = fm->width( QString( mClusters[i] ) ) + wordSpaceFix;
-        }
-
-        double labelWidth = mapScale * charWidth / fontScale;
-        mInfo->char_info[i].width = labelWidth;
+        mInfo->char_info[i].width = mapScale * graphemes.widths.at( i ) / fontScale;
       }
     }
 
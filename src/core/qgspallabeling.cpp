@@ -40,6 +40,8 @@
 #include "qgsdiagramrendererv2.h"
 #include "qgsfontutils.h"
 #include "qgslabelsearchtree.h"
+#include "qgslabelspritecache.h"
+#include "qgslabeltextmetricscache.h"
 #include "qgsexpression.h"
 #include "qgsdatadefined.h"
 #include "qgslabelingenginev2.h"
@@ -1721,6 +1723,11 @@ bool QgsPalLayerSettings::checkMinimumSizeMM( const QgsRenderContext& ct, const
 }
 
 void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF* fm, QString text, double& labelX, double& labelY, QgsFeature* f, QgsRenderContext *context )
+{
+  calculateLabelSize( fm, ( const QFont* ) 0, text, labelX, labelY, f, context );
+}
+
+void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF* fm, const QFont* font, QString text, double& labelX, double& labelY, QgsFeature* f, QgsRenderContext *context )
 {
   if ( !fm || !f )
   {
@@ -1878,7 +1885,8 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF* fm, QString t
 
   for ( int i = 0; i < lines; ++i )
   {
-    double width = fm->width( multiLineSplit.at( i ) );
+    // the same label texts are measured over and over, with the font of a label they are cached
+    double width = font ? QgsLabelTextMetricsCache::instance()->width( *font, *fm, multiLineSplit.at( i ) ) : fm->width( multiLineSplit.at( i ) );
     if ( width > w )
     {
       w = width;
@@ -2166,7 +2174,7 @@ void QgsPalLayerSettings::registerFeature( QgsFeature& f, QgsRenderContext &cont
   // NOTE: this should come AFTER any option that affects font metrics
   QScopedPointer<QFontMetricsF> labelFontMetrics( new QFontMetricsF( labelFont ) );
   double labelX, labelY; // will receive label size
-  calculateLabelSize( labelFontMetrics.data(), labelText, labelX, labelY, mCurFeat, &context );
+  calculateLabelSize( labelFontMetrics.data(), &labelFont, labelText, labelX, labelY, mCurFeat, &context );
 
 
   // maximum angle between curved label characters (hardcoded defaults used in QGIS <2.0)
@@ -4399,9 +4407,6 @@ void QgsPalLabeling::drawLabelBuffer( QgsRenderContext& context,
   double penSize = tmpLyr.scaleToPixelContext( tmpLyr.bufferSize, context,
                    ( tmpLyr.bufferSizeInMapUnits ? QgsPalLayerSettings::MapUnits : QgsPalLayerSettings::MM ), true, tmpLyr.bufferSizeMapUnitScale );
 
-  QPainterPath path;
-  path.setFillRule( Qt::WindingFill );
-  path.addText( 0, 0, tmpLyr.textFont, component.text() );
   QPen pen( tmpLyr.bufferColor );
   pen.setWidthF( penSize );
   pen.setJoinStyle( tmpLyr.bufferJoinStyle );
@@ -4412,6 +4417,25 @@ void QgsPalLabeling::drawLabelBuffer( QgsRenderContext& context,
     tmpColor.setAlpha( 0 );
   }
 
+  // without a shadow the buffer's drawing is not needed, it may be drawn from a cached sprite
+  if ( !( tmpLyr.shadowDraw && tmpLyr.shadowUnder == QgsPalLayerSettings::ShadowBuffer ) )
+  {
+    p->save();
+    if ( context.useAdvancedEffects() )
+    {
+      p->setCompositionMode( tmpLyr.bufferBlendMode );
+    }
+    p->scale( component.dpiRatio(), component.dpiRatio() );
+    bool drawn = QgsLabelSpriteCache::instance()->drawText( p, component.text(), tmpLyr.textFont, pen, tmpColor );
+    p->restore();
+    if ( drawn )
+      return;
+  }
+
+  QPainterPath path;
+  path.setFillRule( Qt::WindingFill );
+  path.addText( 0, 0, tmpLyr.textFont, component.text() );
+
   // store buffer's drawing in QPicture for drop shadow call
   QPicture buffPict;
   QPainter buffp;
@@ -621,6 +621,9 @@ class CORE_EXPORT QgsPalLayerSettings
       DDPointF
     };
 
+    //! Calculates the size of a label. Widths of text lines are cached if the font of the metrics is given.
+    void calculateLabelSize( const QFontMetricsF* fm, const QFont* font, QString text, double& labelX, double& labelY, QgsFeature* f, QgsRenderContext* context );
+
     // convenience data defined evaluation function
     bool dataDefinedValEval( DataDefinedValueType valType,
                              QgsPalLayerSettings::DataDefinedProperties p,
@@ -779,8 +782,11 @@ class CORE_EXPORT QgsLabelingResults
     QgsLabelingResults( const QgsLabelingResults& ) {} // no copying allowed
 
     QgsLabelSearchTree* mLabelSearchTree;
+    //! Map coordinates the labels were placed in, null if unknown
+    QString mCoordinates;
 
     friend class QgsPalLabeling;
+    friend class QgsLabelingEngineV2;
     friend class QgsVectorLayerLabelProvider;
     friend class QgsVectorLayerDiagramProvider;
 };
@@ -0,0 +1,191 @@
+/***************************************************************************
+    qgsrenderarena.cpp
+    ------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrenderarena.h"
+
+#include <QThreadStorage>
+
+#include <cstdlib>
+
+//! minimum size of a chunk of raw memory
+static const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+//! alignment of allocations
+static const size_t ARENA_ALIGNMENT = 16;
+//! maximum number of pooled polygons
+static const int ARENA_MAX_POLYGONS = 256;
+//! polygons with a larger capacity are not kept in the pool
+static const int ARENA_MAX_POLYGON_CAPACITY = 1024 * 1024;
+//! maximum total capacity of the pooled polygons, in points
+static const int ARENA_MAX_POOLED_POINTS = 1024 * 1024;
+//! polygons of this capacity are kept by reset() regardless of the use of the pool
+static const int ARENA_MIN_POLYGON_CAPACITY = 256;
+//! reset() shrinks the arena if it is larger than this factor times the memory used since the last reset
+static const size_t ARENA_SHRINK_FACTOR = 4;
+
+static QThreadStorage<QgsRenderArena*> sArenas;
+
+QgsRenderArena* QgsRenderArena::instance()
+{
+  if ( !sArenas.hasLocalData() )
+    sArenas.setLocalData( new QgsRenderArena );
+  return sArenas.localData();
+}
+
+QgsRenderArena::QgsRenderArena()
+    : mChunk( 0 )
+    , mOffset( 0 )
+    , mChunkStart( 0 )
+    , mPeakUsage( 0 )
+    , mPooledPoints( 0 )
+    , mPeakPolygonSize( 0 )
+{
+}
+
+QgsRenderArena::~QgsRenderArena()
+{
+  for ( int i = 0; i < mChunks.size(); ++i )
+    free( mChunks[i].data );
+}
+
+void* QgsRenderArena::allocate( size_t size )
+{
+  size = ( size + ARENA_ALIGNMENT - 1 ) & ~( ARENA_ALIGNMENT - 1 );
+
+  if ( mChunk < mChunks.size() && mOffset + size <= mChunks[mChunk].size )
+  {
+    void* ptr = mChunks[mChunk].data + mOffset;
+    mOffset += size;
+    mPeakUsage = qMax( mPeakUsage, mChunkStart + mOffset );
+    return ptr;
+  }
+
+  // continue in the next chunk, replacing it if it is too small
+  int next = mChunks.isEmpty() ? 0 : mChunk + 1;
+  if ( next < mChunks.size() && mChunks[next].size < size )
+  {
+    free( mChunks[next].data );
+    mChunks.remove( next );
+  }
+  if ( next >= mChunks.size() || mChunks[next].size < size )
+  {
+    Chunk chunk;
+    chunk.size = qMax( size, ARENA_CHUNK_SIZE );
+    chunk.data = static_cast<char*>( malloc( chunk.size ) );
+    if ( !chunk.data )
+      return 0;
+    mChunks.insert( next, chunk );
+  }
+
+  // the rest of the current chunk stays unused and counts as used
+  if ( next > mChunk )
+    mChunkStart += mChunks[mChunk].size;
+  mChunk = next;
+  mOffset = size;
+  mPeakUsage = qMax( mPeakUsage, mChunkStart + mOffset );
+  return mChunks[mChunk].data;
+}
+
+void QgsRenderArena::rewind( int chunk, size_t offset )
+{
+  if ( chunk != mChunk )
+  {
+    mChunkStart = 0;
+    for ( int i = 0; i < chunk; ++i )
+      mChunkStart += mChunks[i].size;
+  }
+  mChunk = chunk;
+  mOffset = offset;
+}
+
+void QgsRenderArena::reset()
+{
+  // one chunk which can hold everything allocated before avoids switching chunks next time,
+  // but a single large feature must not keep a large chunk alive for the lifetime of the thread
+  size_t total = capacity();
+  size_t needed = qMax( mPeakUsage, ARENA_CHUNK_SIZE );
+  size_t size = total > ARENA_SHRINK_FACTOR * needed ? needed : total;
+  if ( mChunks.size() > 1 || ( !mChunks.isEmpty() && size < total ) )
+  {
+    for ( int i = 0; i < mChunks.size(); ++i )
+      free( mChunks[i].data );
+    mChunks.clear();
+
+    Chunk chunk;
+    chunk.size = size;
+    chunk.data = static_cast<char*>( malloc( chunk.size ) );
+    if ( chunk.data )
+      mChunks << chunk;
+  }
+  mChunk = 0;
+  mOffset = 0;
+  mChunkStart = 0;
+  mPeakUsage = 0;
+
+  // the same for pooled polygons: drop those much larger than any polygon used since the last reset
+  int maxCapacity = ( int ) ARENA_SHRINK_FACTOR * qMax( mPeakPolygonSize, ARENA_MIN_POLYGON_CAPACITY );
+  for ( int i = mPolygons.size() - 1; i >= 0; --i )
+  {
+    if ( mPolygons[i].capacity() > maxCapacity )
+    {
+      mPooledPoints -= mPolygons[i].capacity();
+      mPolygons.removeAt( i );
+    }
+  }
+  mPeakPolygonSize = 0;
+}
+
+int QgsRenderArena::pooledPoints() const
+{
+  return mPooledPoints;
+}
+
+size_t QgsRenderArena::capacity() const
+{
+  size_t total = 0;
+  for ( int i = 0; i < mChunks.size(); ++i )
+    total += mChunks[i].size;
+  return total;
+}
+
+QPolygonF QgsRenderArena::takePolygon()
+{
+  if ( mPolygons.isEmpty() )
+    return QPolygonF();
+
+  QPolygonF polygon = mPolygons.takeLast();
+  mPooledPoints -= polygon.capacity();
+  polygon.resize( 0 );
+  return polygon;
+}
+
+void QgsRenderArena::recyclePolygon( QPolygonF& polygon )
+{
+  mPeakPolygonSize = qMax( mPeakPolygonSize, polygon.size() );
+  if ( mPolygons.size() < ARENA_MAX_POLYGONS && polygon.capacity() > 0 && polygon.capacity() <= ARENA_MAX_POLYGON_CAPACITY
+       && mPooledPoints + polygon.capacity() <= ARENA_MAX_POOLED_POINTS )
+  {
+    // reserve() marks the capacity as fixed, so that resizing the polygon does not shrink it
+    polygon.reserve( polygon.capacity() );
+    mPooledPoints += polygon.capacity();
+    mPolygons << polygon;
+  }
+  polygon = QPolygonF();
+}
+
+void QgsRenderArena::recyclePolygons( QList<QPolygonF>& polygons )
+{
+  for ( int i = 0; i < polygons.size(); ++i )
+    recyclePolygon( polygons[i] );
+  polygons.clear();
+}
@@ -0,0 +1,129 @@
+/***************************************************************************
+    qgsrenderarena.h
+    ----------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRENDERARENA_H
+#define QGSRENDERARENA_H
+
+#include <QList>
+#include <QPolygonF>
+#include <QVector>
+
+#include <cstddef>
+
+/** \ingroup core
+ * \class QgsRenderArena
+ * \brief Scratch memory for the temporary data of rendering a feature.
+ *
+ * Every thread has its own arena, so features rendered by parallel jobs do not contend
+ * for the heap. Raw memory is handed out by a bump allocator: allocate() only advances a
+ * position in a large chunk, and a Scope gives back everything allocated while it existed,
+ * typically once per feature. Qt containers cannot use such memory, so polygons are pooled
+ * instead: takePolygon() returns an empty polygon which keeps the capacity it had when it
+ * was recycled, so the rings of the next feature usually fit without reallocating.
+ *
+ * Memory of an arena must not be used after its scope ended and never by another thread.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsRenderArena
+{
+  public:
+
+    /** Rewinds the arena to the position it had when the scope was created */
+    class Scope
+    {
+      public:
+        explicit Scope( QgsRenderArena* arena )
+            : mArena( arena )
+            , mChunk( arena->mChunk )
+            , mOffset( arena->mOffset )
+        {}
+        ~Scope() { mArena->rewind( mChunk, mOffset ); }
+
+      private:
+        Q_DISABLE_COPY( Scope )
+
+        QgsRenderArena* mArena;
+        int mChunk;
+        size_t mOffset;
+    };
+
+    /** Returns the arena of the calling thread */
+    static QgsRenderArena* instance();
+
+    QgsRenderArena();
+    ~QgsRenderArena();
+
+    /** Returns uninitialized memory of the given size, aligned for any type.
+     * The memory is valid until the enclosing Scope ends.
+     */
+    void* allocate( size_t size );
+
+    /** Returns uninitialized memory for count objects of a plain type */
+    template <class T> T* allocate( int count ) { return static_cast<T*>( allocate( count * sizeof( T ) ) ); }
+
+    /** Returns an empty polygon from the pool */
+    QPolygonF takePolygon();
+
+    /** Returns a polygon to the pool. The polygon is cleared. The pool is limited in the
+     * number of polygons and in their total capacity, other polygons are released.
+     */
+    void recyclePolygon( QPolygonF& polygon );
+
+    /** Returns all polygons of a list to the pool. The list is cleared. */
+    void recyclePolygons( QList<QPolygonF>& polygons );
+
+    /** Releases the raw memory of all chunks but one and merges them for the next use.
+     * If much less memory was used since the last reset than the arena holds, the arena
+     * shrinks to the size that was used. Pooled polygons much larger than any polygon
+     * recycled since the last reset are released too.
+     * Must not be called while a Scope of the arena exists.
+     */
+    void reset();
+
+    /** Returns the total size of the chunks of the arena */
+    size_t capacity() const;
+
+    /** Returns the total capacity of the pooled polygons, in points */
+    int pooledPoints() const;
+
+  private:
+
+    Q_DISABLE_COPY( QgsRenderArena )
+
+    struct Chunk
+    {
+      char* data;
+      size_t size;
+    };
+
+    void rewind( int chunk, size_t offset );
+
+    QVector<Chunk> mChunks;
+    //! current chunk and position in it
+    int mChunk;
+    size_t mOffset;
+    //! total size of the chunks before the current chunk
+    size_t mChunkStart;
+    //! largest amount of memory in use since the last reset
+    size_t mPeakUsage;
+
+    QList<QPolygonF> mPolygons;
+    //! total capacity of the pooled polygons
+    int mPooledPoints;
+    //! size of the largest polygon recycled since the last reset
+    int mPeakPolygonSize;
+};
+
+#endif // QGSRENDERARENA_H
@@ -34,6 +34,7 @@ QgsRenderContext::QgsRenderContext()
     , mLabelingEngine2( 0 )
     , mShowSelection( true )
     , mUseRenderingOptimization( true )
+    , mParallelTileRendering( false )
     , mGeometry( 0 )
 {
   mVectorSimplifyMethod.setSimplifyHints( QgsVectorSimplifyMethod::NoSimplification );
@@ -52,6 +53,7 @@ QgsRenderContext QgsRenderContext::fromMapSettings( const QgsMapSettings& mapSet
   ctx.setForceVectorOutput( mapSettings.testFlag( QgsMapSettings::ForceVectorOutput ) );
   ctx.setUseAdvancedEffects( mapSettings.testFlag( QgsMapSettings::UseAdvancedEffects ) );
   ctx.setUseRenderingOptimization( mapSettings.testFlag( QgsMapSettings::UseRenderingOptimization ) );
+  ctx.setParallelTileRendering( mapSettings.testFlag( QgsMapSettings::ParallelTileRendering ) );
   ctx.setCoordinateTransform( 0 );
   ctx.setSelectionColor( mapSettings.selectionColor() );
   ctx.setShowSelection( mapSettings.testFlag( QgsMapSettings::DrawSelection ) );
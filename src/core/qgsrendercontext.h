@@ -122,6 +122,22 @@ class CORE_EXPORT QgsRenderContext
     bool useRenderingOptimization() const { return mUseRenderingOptimization; }
     void setUseRenderingOptimization( bool enabled ) { mUseRenderingOptimization = enabled; }
 
+    /** Returns true if large vector layers may be split into tiles rendered on separate threads
+     * @see setParallelTileRendering()
+     * @note added in QGIS 2.12
+     */
+    bool parallelTileRendering() const { return mParallelTileRendering; }
+
+    /** Sets whether large vector layers may be split into tiles rendered on separate threads.
+     * Layers with labels, diagrams, paint effects, feature blending or renderers other than
+     * single symbol, categorized and graduated are always rendered on a single thread.
+     * Overlapping features owned by different tiles may be drawn in a different order
+     * than on a single thread.
+     * @see parallelTileRendering()
+     * @note added in QGIS 2.12
+     */
+    void setParallelTileRendering( bool enabled ) { mParallelTileRendering = enabled; }
+
     //! Added in QGIS v2.4
     const QgsVectorSimplifyMethod& vectorSimplifyMethod() const { return mVectorSimplifyMethod; }
     void setVectorSimplifyMethod( const QgsVectorSimplifyMethod& simplifyMethod ) { mVectorSimplifyMethod = simplifyMethod; }
@@ -200,6 +216,9 @@ class CORE_EXPORT QgsRenderContext
     /** True if the rendering optimization (geometry simplification) can be executed*/
     bool mUseRenderingOptimization;
 
+    /** True if large vector layers may be rendered as tiles on separate threads*/
+    bool mParallelTileRendering;
+
     /** Simplification object which holds the information about how to simplify the features for fast rendering */
     QgsVectorSimplifyMethod mVectorSimplifyMethod;
 
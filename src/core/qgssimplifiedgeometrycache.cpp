@@ -0,0 +1,142 @@
+/***************************************************************************
+    qgssimplifiedgeometrycache.cpp
+    ------------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssimplifiedgeometrycache.h"
+#include "qgsgeometry.h"
+#include "qgsvectorlayer.h"
+#include "qgswkbgeometryview.h"
+
+#include <QMutexLocker>
+
+#include <climits>
+#include <cmath>
+
+//! number of tolerance bands per power of two
+static const int BANDS_PER_OCTAVE = 4;
+
+QgsSimplifiedGeometryCache::Source::Source( const QgsGeometry& geometry )
+    : boundingBox( geometry.boundingBox() )
+    , wkbSize( geometry.wkbSize() )
+{
+}
+
+QgsSimplifiedGeometryCache::QgsSimplifiedGeometryCache( QgsVectorLayer* layer, int maxVertices )
+    : mGeneration( 0 )
+{
+  mGeometries.setMaxCost( maxVertices );
+
+  connect( layer, SIGNAL( featureDeleted( QgsFeatureId ) ), SLOT( remove( QgsFeatureId ) ) );
+  connect( layer, SIGNAL( geometryChanged( QgsFeatureId, QgsGeometry& ) ), SLOT( geometryChanged( QgsFeatureId, QgsGeometry& ) ) );
+  connect( layer, SIGNAL( dataChanged() ), SLOT( invalidate() ) );
+  // committing or rolling back edits may change feature ids
+  connect( layer, SIGNAL( editingStopped() ), SLOT( invalidate() ) );
+}
+
+int QgsSimplifiedGeometryCache::toleranceBand( double tolerance )
+{
+  if ( !( tolerance > 0 ) )
+    return INT_MIN;
+
+  int band = ( int ) floor( log( tolerance ) / log( 2.0 ) * BANDS_PER_OCTAVE );
+  // the tolerance of the band must not be larger than the requested one, even with rounding errors
+  if ( bandTolerance( band ) > tolerance )
+    --band;
+  return band;
+}
+
+double QgsSimplifiedGeometryCache::bandTolerance( int band )
+{
+  return pow( 2.0, ( double ) band / BANDS_PER_OCTAVE );
+}
+
+void QgsSimplifiedGeometryCache::setMaxVertices( int maxVertices )
+{
+  QMutexLocker locker( &mMutex );
+  mGeometries.setMaxCost( maxVertices );
+}
+
+int QgsSimplifiedGeometryCache::maxVertices() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeometries.maxCost();
+}
+
+int QgsSimplifiedGeometryCache::vertexCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeometries.totalCost();
+}
+
+int QgsSimplifiedGeometryCache::generation() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGeneration;
+}
+
+bool QgsSimplifiedGeometryCache::geometry( QgsFeatureId fid, int band, const Source& source, QgsGeometry& geometry ) const
+{
+  QMutexLocker locker( &mMutex );
+  Entry* cached = mGeometries.object( qMakePair( fid, band ) );
+  // a changed geometry is simplified again and replaces the entry
+  if ( !cached || cached->source != source )
+    return false;
+
+  // the geometry shares the data of the cached one, editing it detaches it from the cache
+  geometry = cached->geometry;
+  return true;
+}
+
+void QgsSimplifiedGeometryCache::insert( QgsFeatureId fid, int band, const Source& source, const QgsGeometry& geometry, int generation )
+{
+  if ( !geometry.asWkb() )
+    return;
+
+  int vertexCount = QgsWkbGeometryView( geometry.asWkb(), geometry.wkbSize() ).vertexCount();
+  Entry* entry = new Entry;
+  entry->geometry = geometry;
+  entry->source = source;
+
+  QMutexLocker locker( &mMutex );
+  if ( generation != mGeneration || mGeometries.maxCost() == 0 )
+  {
+    delete entry;
+    return;
+  }
+  mBands.insert( band );
+  mGeometries.insert( qMakePair( fid, band ), entry, qMax( 1, vertexCount ) );
+}
+
+void QgsSimplifiedGeometryCache::remove( QgsFeatureId fid )
+{
+  QMutexLocker locker( &mMutex );
+  ++mGeneration;
+  Q_FOREACH ( int band, mBands )
+  {
+    mGeometries.remove( qMakePair( fid, band ) );
+  }
+}
+
+void QgsSimplifiedGeometryCache::invalidate()
+{
+  QMutexLocker locker( &mMutex );
+  ++mGeneration;
+  mGeometries.clear();
+  mBands.clear();
+}
+
+void QgsSimplifiedGeometryCache::geometryChanged( QgsFeatureId fid, QgsGeometry& geometry )
+{
+  Q_UNUSED( geometry );
+  remove( fid );
+}
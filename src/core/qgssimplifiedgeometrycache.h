@@ -0,0 +1,151 @@
+/***************************************************************************
+    qgssimplifiedgeometrycache.h
+    ----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSIMPLIFIEDGEOMETRYCACHE_H
+#define QGSSIMPLIFIEDGEOMETRYCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsrectangle.h"
+
+class QgsVectorLayer;
+
+/** \ingroup core
+ * \class QgsSimplifiedGeometryCache
+ * \brief Cache of the geometries of a vector layer simplified for rendering.
+ *
+ * Tolerances are grouped into bands of a quarter of a power of two. A geometry is simplified
+ * with the lower bound of the band of the requested tolerance, so that the cached geometry can
+ * be drawn at every scale of the band: at most 2^(1/4) times as detailed as needed, but never
+ * coarser. The size of the cache is limited by the total number of vertices of the cached
+ * geometries. Changed and deleted features are removed from the cache, and the whole cache
+ * is cleared when the data of the layer changed or editing stopped. Changes the layer does
+ * not signal are detected by comparing the bounding box and WKB size of the fetched geometry
+ * with the ones of the geometry the cached geometry was simplified from.
+ *
+ * The cache may be used by several render jobs at the same time. Cached geometries are
+ * implicitly shared with the features they are returned for.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsSimplifiedGeometryCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    /** Creates a cache for the features of a layer
+     * @param layer layer whose edits invalidate the cache
+     * @param maxVertices maximum total number of vertices of the cached geometries
+     */
+    QgsSimplifiedGeometryCache( QgsVectorLayer* layer, int maxVertices );
+
+    /** Returns the band of a tolerance, or INT_MIN for tolerances which are not positive */
+    static int toleranceBand( double tolerance );
+
+    /** Returns the tolerance geometries of a band are simplified with */
+    static double bandTolerance( int band );
+
+    /** Sets the maximum total number of vertices of the cached geometries, 0 disables the cache */
+    void setMaxVertices( int maxVertices );
+
+    /** Returns the maximum total number of vertices of the cached geometries */
+    int maxVertices() const;
+
+    /** Returns the total number of vertices of the cached geometries */
+    int vertexCount() const;
+
+    /** Identifies the geometry a cached geometry was simplified from by its bounding box and WKB size.
+     * Cached geometries are only returned for a source geometry with the same bounding box and size,
+     * so that changes which the layer does not signal, e.g. made directly through the data provider
+     * or by another application, do not leave simplified versions of old geometries in the cache.
+     * Both are cheap for geometries fetched as WKB: the size is known and the bounding box is
+     * computed once and kept with the geometry, it is used for the simplification as well.
+     */
+    struct Source
+    {
+      Source() : wkbSize( 0 ) {}
+      explicit Source( const QgsGeometry& geometry );
+
+      bool operator==( const Source& other ) const { return wkbSize == other.wkbSize && boundingBox == other.boundingBox; }
+      bool operator!=( const Source& other ) const { return !( *this == other ); }
+
+      QgsRectangle boundingBox;
+      int wkbSize;
+    };
+
+    /** Returns a number which changes whenever cached geometries become invalid.
+     * Geometries simplified from features fetched before a change must not be inserted.
+     */
+    int generation() const;
+
+    /** Replaces a geometry with its cached simplified version.
+     * @param fid feature id
+     * @param band tolerance band
+     * @param source the feature's geometry before simplification
+     * @param geometry receives the simplified geometry, shared with the cache
+     * @returns false if the feature is not cached for the band or its geometry changed
+     */
+    bool geometry( QgsFeatureId fid, int band, const Source& source, QgsGeometry& geometry ) const;
+
+    /** Caches a simplified geometry, unless the cache was invalidated after the given generation
+     * @param fid feature id
+     * @param band tolerance band
+     * @param source the feature's geometry before simplification
+     * @param geometry simplified geometry
+     * @param generation generation of the cache when the feature was fetched
+     */
+    void insert( QgsFeatureId fid, int band, const Source& source, const QgsGeometry& geometry, int generation );
+
+  public slots:
+
+    /** Removes the geometries of a feature */
+    void remove( QgsFeatureId fid );
+
+    /** Removes all geometries */
+    void invalidate();
+
+  private slots:
+
+    void geometryChanged( QgsFeatureId fid, QgsGeometry& geometry );
+
+  private:
+
+    Q_DISABLE_COPY( QgsSimplifiedGeometryCache )
+
+    typedef QPair<QgsFeatureId, int> Key;
+
+    struct Entry
+    {
+      //! simplified geometry
+      QgsGeometry geometry;
+      //! the geometry it was simplified from
+      Source source;
+    };
+
+    mutable QMutex mMutex;
+    //! simplified geometries, the cost of an entry is its vertex count
+    QCache<Key, Entry> mGeometries;
+    //! bands which may have cached geometries
+    QSet<int> mBands;
+    int mGeneration;
+};
+
+#endif // QGSSIMPLIFIEDGEOMETRYCACHE_H
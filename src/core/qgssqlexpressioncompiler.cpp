@@ -0,0 +1,561 @@
+/***************************************************************************
+                          qgssqlexpressioncompiler.cpp
+                          ----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssqlexpressioncompiler.h"
+
+#include <QSettings>
+
+#include <qnumeric.h>
+
+QgsSqlExpressionCompiler::QgsSqlExpressionCompiler( const QgsFields& fields, const Flags& flags )
+    : mFields( fields )
+    , mFlags( flags )
+{
+}
+
+QgsSqlExpressionCompiler::~QgsSqlExpressionCompiler()
+{
+
+}
+
+bool QgsSqlExpressionCompiler::isEnabled()
+{
+  QSettings settings;
+  if ( settings.contains( "/qgis/compileExpressions" ) )
+    return settings.value( "/qgis/compileExpressions", false ).toBool();
+  return settings.value( "/qgis/postgres/compileExpressions", false ).toBool();
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compile( const QgsExpression* exp )
+{
+  mResult.clear();
+
+  // only boolean expressions have the same truth value in SQL and in QgsExpression
+  if ( !exp->rootNode() || valueType( exp->rootNode() ) != vtBoolean )
+    return Fail;
+
+  Result result = compileNode( exp->rootNode(), mResult );
+  if ( result == Fail )
+    mResult.clear();
+  return result;
+}
+
+QString QgsSqlExpressionCompiler::quotedIdentifier( const QString& identifier )
+{
+  QString quoted = identifier;
+  quoted.replace( '"', "\"\"" );
+  quoted = quoted.prepend( '\"' ).append( '\"' );
+  return quoted;
+}
+
+QString QgsSqlExpressionCompiler::quotedValue( const QVariant& value, bool& ok )
+{
+  ok = true;
+
+  if ( value.isNull() )
+    return "NULL";
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      return value.toString();
+
+    case QVariant::Double:
+      return qgsDoubleToString( value.toDouble() );
+
+    case QVariant::String:
+    {
+      QString v = value.toString();
+      v.replace( '\'', "''" );
+      return v.prepend( '\'' ).append( '\'' );
+    }
+
+    default:
+      ok = false;
+      return QString();
+  }
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compileNode( const QgsExpression::Node* node, QString& result )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntUnaryOperator:
+      return compileUnary( static_cast<const QgsExpression::NodeUnaryOperator*>( node ), result );
+
+    case QgsExpression::ntBinaryOperator:
+      return compileBinary( static_cast<const QgsExpression::NodeBinaryOperator*>( node ), result );
+
+    case QgsExpression::ntInOperator:
+      return compileIn( static_cast<const QgsExpression::NodeInOperator*>( node ), result );
+
+    case QgsExpression::ntLiteral:
+    {
+      const QgsExpression::NodeLiteral* n = static_cast<const QgsExpression::NodeLiteral*>( node );
+      bool ok;
+      result = quotedValue( n->value(), ok );
+      return ok ? Complete : Fail;
+    }
+
+    case QgsExpression::ntColumnRef:
+    {
+      const QgsExpression::NodeColumnRef* n = static_cast<const QgsExpression::NodeColumnRef*>( node );
+
+      if ( mFields.indexFromName( n->name() ) == -1 )
+        // Not a provider field
+        return Fail;
+
+      result = quotedIdentifier( n->name() );
+      return Complete;
+    }
+
+    case QgsExpression::ntFunction:
+    case QgsExpression::ntCondition:
+      break;
+  }
+
+  return Fail;
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compileUnary( const QgsExpression::NodeUnaryOperator* n, QString& result )
+{
+  switch ( n->op() )
+  {
+    case QgsExpression::uoNot:
+    {
+      // the negation of a superset is not a superset
+      QString operand;
+      if ( valueType( n->operand() ) != vtBoolean || compileNode( n->operand(), operand ) != Complete )
+        return Fail;
+
+      result = "(NOT " + operand + ")";
+      return Complete;
+    }
+
+    case QgsExpression::uoMinus:
+    {
+      if ( !isNumeric( valueType( n->operand() ) ) )
+        return Fail;
+
+      if ( n->operand()->nodeType() == QgsExpression::ntLiteral )
+      {
+        // negative numbers are parsed as negated literals
+        QVariant value = static_cast<const QgsExpression::NodeLiteral*>( n->operand() )->value();
+        value = value.type() == QVariant::Double ? QVariant( -value.toDouble() ) : QVariant( -value.toLongLong() );
+        bool ok;
+        result = quotedValue( value, ok );
+        return ok ? Complete : Fail;
+      }
+
+      QString operand;
+      if ( mFlags & NoUnaryMinus || compileNode( n->operand(), operand ) != Complete )
+        return Fail;
+
+      result = "(-" + operand + ")";
+      return Complete;
+    }
+  }
+
+  return Fail;
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compileBinary( const QgsExpression::NodeBinaryOperator* n, QString& result )
+{
+  QString op;
+  switch ( n->op() )
+  {
+    case QgsExpression::boAnd:
+    {
+      QString left, right;
+      Result lr = valueType( n->opLeft() ) == vtBoolean ? compileNode( n->opLeft(), left ) : Fail;
+      Result rr = valueType( n->opRight() ) == vtBoolean ? compileNode( n->opRight(), right ) : Fail;
+
+      if ( lr == Fail && rr == Fail )
+        return Fail;
+
+      // a feature can only match if both sides match, so one side alone selects a superset
+      if ( lr == Fail || rr == Fail )
+      {
+        result = lr == Fail ? right : left;
+        return Partial;
+      }
+
+      result = "(" + left + " AND " + right + ")";
+      return lr == Complete && rr == Complete ? Complete : Partial;
+    }
+
+    case QgsExpression::boOr:
+    {
+      if ( valueType( n->opLeft() ) != vtBoolean || valueType( n->opRight() ) != vtBoolean )
+        return Fail;
+
+      QString left, right;
+      Result lr = compileNode( n->opLeft(), left );
+      Result rr = compileNode( n->opRight(), right );
+      if ( lr == Fail || rr == Fail )
+        return Fail;
+
+      result = "(" + left + " OR " + right + ")";
+      return lr == Complete && rr == Complete ? Complete : Partial;
+    }
+
+    case QgsExpression::boEQ:
+    case QgsExpression::boNE:
+    case QgsExpression::boLT:
+    case QgsExpression::boGT:
+    case QgsExpression::boLE:
+    case QgsExpression::boGE:
+      return compileComparison( n, result );
+
+    case QgsExpression::boLike:
+    case QgsExpression::boNotLike:
+    case QgsExpression::boILike:
+    case QgsExpression::boNotILike:
+      return compileLike( n, result );
+
+    case QgsExpression::boIs:
+    case QgsExpression::boIsNot:
+    {
+      // only comparisons with NULL behave alike in all dialects
+      const QgsExpression::Node* operand;
+      if ( valueType( n->opRight() ) == vtNull )
+        operand = n->opLeft();
+      else if ( valueType( n->opLeft() ) == vtNull )
+        operand = n->opRight();
+      else
+        return Fail;
+
+      QString str;
+      if ( compileNode( operand, str ) != Complete )
+        return Fail;
+
+      result = QString( "(%1 %2 NULL)" ).arg( str ).arg( n->op() == QgsExpression::boIs ? "IS" : "IS NOT" );
+      return Complete;
+    }
+
+    case QgsExpression::boPlus:
+      op = "+";
+      break;
+
+    case QgsExpression::boMinus:
+      op = "-";
+      break;
+
+    case QgsExpression::boMul:
+      op = "*";
+      break;
+
+    case QgsExpression::boMod:
+    {
+      // QgsExpression returns NULL for a zero divisor, most databases raise an error
+      if ( n->opRight()->nodeType() != QgsExpression::ntLiteral ||
+           static_cast<const QgsExpression::NodeLiteral*>( n->opRight() )->value().toLongLong() == 0 )
+        return Fail;
+
+      op = "%";
+      break;
+    }
+
+    case QgsExpression::boConcat:
+    {
+      // numbers other than integers are converted to strings differently
+      ValueType lt = valueType( n->opLeft() ), rt = valueType( n->opRight() );
+      if (( lt != vtString && lt != vtInteger ) || ( rt != vtString && rt != vtInteger ) )
+        return Fail;
+
+      QString left, right;
+      if ( compileNode( n->opLeft(), left ) != Complete || compileNode( n->opRight(), right ) != Complete )
+        return Fail;
+
+      result = "(" + left + " || " + right + ")";
+      return Complete;
+    }
+
+    case QgsExpression::boDiv:  // SQL divides integers without remainder
+    case QgsExpression::boIntDiv:
+    case QgsExpression::boPow:
+    case QgsExpression::boRegexp:
+      return Fail;
+  }
+
+  if ( op.isNull() || valueType( n ) == vtUnknown )
+    return Fail;
+
+  QString left, right;
+  if ( compileNode( n->opLeft(), left ) != Complete || compileNode( n->opRight(), right ) != Complete )
+    return Fail;
+
+  result = "(" + left + " " + op + " " + right + ")";
+  return Complete;
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compileComparison( const QgsExpression::NodeBinaryOperator* n, QString& result )
+{
+  ValueType lt = valueType( n->opLeft() ), rt = valueType( n->opRight() );
+
+  QString op;
+  Result match = Complete;
+  switch ( n->op() )
+  {
+    case QgsExpression::boEQ:
+      op = "=";
+      break;
+    case QgsExpression::boNE:
+      op = "<>";
+      break;
+    case QgsExpression::boLT:
+      op = "<";
+      break;
+    case QgsExpression::boGT:
+      op = ">";
+      break;
+    case QgsExpression::boLE:
+      op = "<=";
+      break;
+    case QgsExpression::boGE:
+      op = ">=";
+      break;
+    default:
+      return Fail;
+  }
+
+  if ( isNumeric( lt ) && isNumeric( rt ) )
+  {
+    // numbers are always compared numerically
+  }
+  else if ( lt == vtString && rt == vtString && ( isTextLiteral( n->opLeft() ) || isTextLiteral( n->opRight() ) ) )
+  {
+    // QgsExpression compares strings by value and only if one of them is not a number,
+    // so only (in)equality with a non numeric literal has the same result as in SQL
+    if ( n->op() == QgsExpression::boEQ )
+      match = mFlags & CaseInsensitiveStringMatch ? Partial : Complete;
+    else if ( n->op() != QgsExpression::boNE || mFlags & CaseInsensitiveStringMatch )
+      return Fail;
+  }
+  else
+  {
+    return Fail;
+  }
+
+  QString left, right;
+  if ( compileNode( n->opLeft(), left ) != Complete || compileNode( n->opRight(), right ) != Complete )
+    return Fail;
+
+  result = "(" + left + " " + op + " " + right + ")";
+  return match;
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compileLike( const QgsExpression::NodeBinaryOperator* n, QString& result )
+{
+  if ( valueType( n->opLeft() ) != vtString || !isLikePattern( n->opRight() ) )
+    return Fail;
+
+  bool negated = n->op() == QgsExpression::boNotLike || n->op() == QgsExpression::boNotILike;
+  bool caseInsensitive = n->op() == QgsExpression::boILike || n->op() == QgsExpression::boNotILike;
+
+  Result match = Complete;
+  if ( mFlags & LikeIsCaseInsensitive )
+  {
+    if ( caseInsensitive )
+    {
+      // SQL databases usually only fold the case of ASCII characters
+      QString pattern = static_cast<const QgsExpression::NodeLiteral*>( n->opRight() )->value().toString();
+      for ( int i = 0; i < pattern.length(); ++i )
+      {
+        if ( pattern.at( i ).unicode() > 0x7f )
+          return Fail;
+      }
+    }
+    else if ( negated )
+    {
+      return Fail;
+    }
+    else
+    {
+      match = Partial;
+    }
+  }
+  else if ( caseInsensitive )
+  {
+    // needs a dialect specific operator
+    return Fail;
+  }
+
+  QString left, right;
+  if ( compileNode( n->opLeft(), left ) != Complete || compileNode( n->opRight(), right ) != Complete )
+    return Fail;
+
+  result = QString( "(%1 %2LIKE %3)" ).arg( left ).arg( negated ? "NOT " : "" ).arg( right );
+  return match;
+}
+
+QgsSqlExpressionCompiler::Result QgsSqlExpressionCompiler::compileIn( const QgsExpression::NodeInOperator* n, QString& result )
+{
+  if ( n->list()->count() == 0 )
+    return Fail;
+
+  ValueType type = valueType( n->node() );
+  if ( !isNumeric( type ) && type != vtString )
+    return Fail;
+
+  QStringList list;
+  Q_FOREACH ( const QgsExpression::Node* ln, n->list()->list() )
+  {
+    ValueType lt = valueType( ln );
+    if ( ln->nodeType() != QgsExpression::ntLiteral ||
+         ( lt != vtNull && ( type == vtString ? !isTextLiteral( ln ) : !isNumeric( lt ) ) ) )
+      return Fail;
+
+    QString s;
+    if ( compileNode( ln, s ) != Complete )
+      return Fail;
+    list << s;
+  }
+
+  Result match = Complete;
+  if ( type == vtString && mFlags & CaseInsensitiveStringMatch )
+  {
+    if ( n->isNotIn() )
+      return Fail;
+    match = Partial;
+  }
+
+  QString nd;
+  if ( compileNode( n->node(), nd ) != Complete )
+    return Fail;
+
+  result = QString( "(%1 %2IN (%3))" ).arg( nd ).arg( n->isNotIn() ? "NOT " : "" ).arg( list.join( "," ) );
+  return match;
+}
+
+QgsSqlExpressionCompiler::ValueType QgsSqlExpressionCompiler::valueType( const QgsExpression::Node* node ) const
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+    {
+      const QVariant& value = static_cast<const QgsExpression::NodeLiteral*>( node )->value();
+      if ( value.isNull() )
+        return vtNull;
+
+      switch ( value.type() )
+      {
+        case QVariant::Bool:
+          return vtBoolean;
+        case QVariant::Int:
+        case QVariant::LongLong:
+          return vtInteger;
+        case QVariant::Double:
+          return vtDouble;
+        case QVariant::String:
+          return vtString;
+        default:
+          return vtUnknown;
+      }
+    }
+
+    case QgsExpression::ntColumnRef:
+    {
+      int idx = mFields.indexFromName( static_cast<const QgsExpression::NodeColumnRef*>( node )->name() );
+      if ( idx == -1 )
+        return vtUnknown;
+
+      switch ( mFields[idx].type() )
+      {
+        case QVariant::Int:
+        case QVariant::LongLong:
+          return vtInteger;
+        case QVariant::Double:
+          return vtDouble;
+        case QVariant::String:
+          return vtString;
+        default:
+          return vtUnknown;
+      }
+    }
+
+    case QgsExpression::ntUnaryOperator:
+    {
+      const QgsExpression::NodeUnaryOperator* n = static_cast<const QgsExpression::NodeUnaryOperator*>( node );
+      if ( n->op() == QgsExpression::uoNot )
+        return vtBoolean;
+
+      ValueType type = valueType( n->operand() );
+      return isNumeric( type ) ? type : vtUnknown;
+    }
+
+    case QgsExpression::ntBinaryOperator:
+    {
+      const QgsExpression::NodeBinaryOperator* n = static_cast<const QgsExpression::NodeBinaryOperator*>( node );
+      ValueType lt = valueType( n->opLeft() ), rt = valueType( n->opRight() );
+      switch ( n->op() )
+      {
+        case QgsExpression::boPlus:
+        case QgsExpression::boMinus:
+        case QgsExpression::boMul:
+          if ( lt == vtInteger && rt == vtInteger )
+            return vtInteger;
+          return isNumeric( lt ) && isNumeric( rt ) ? vtDouble : vtUnknown;
+
+        case QgsExpression::boMod:
+        case QgsExpression::boIntDiv:
+          return lt == vtInteger && rt == vtInteger ? vtInteger : vtUnknown;
+
+        case QgsExpression::boDiv:
+        case QgsExpression::boPow:
+          return isNumeric( lt ) && isNumeric( rt ) ? vtDouble : vtUnknown;
+
+        case QgsExpression::boConcat:
+          return vtString;
+
+        default:
+          return vtBoolean;
+      }
+    }
+
+    case QgsExpression::ntInOperator:
+      return vtBoolean;
+
+    case QgsExpression::ntFunction:
+    case QgsExpression::ntCondition:
+      break;
+  }
+
+  return vtUnknown;
+}
+
+bool QgsSqlExpressionCompiler::isTextLiteral( const QgsExpression::Node* node )
+{
+  if ( node->nodeType() != QgsExpression::ntLiteral )
+    return false;
+
+  const QVariant& value = static_cast<const QgsExpression::NodeLiteral*>( node )->value();
+  if ( value.isNull() || value.type() != QVariant::String )
+    return false;
+
+  bool ok;
+  double number = value.toString().toDouble( &ok );
+  return !ok || !qIsFinite( number );
+}
+
+bool QgsSqlExpressionCompiler::isLikePattern( const QgsExpression::Node* node )
+{
+  if ( node->nodeType() != QgsExpression::ntLiteral )
+    return false;
+
+  // backslashes are escape characters in some dialects, but not in QgsExpression
+  const QVariant& value = static_cast<const QgsExpression::NodeLiteral*>( node )->value();
+  return !value.isNull() && value.type() == QVariant::String && !value.toString().contains( '\\' );
+}
@@ -0,0 +1,143 @@
+/***************************************************************************
+                          qgssqlexpressioncompiler.h
+                          --------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSQLEXPRESSIONCOMPILER_H
+#define QGSSQLEXPRESSIONCOMPILER_H
+
+#include "qgsexpression.h"
+#include "qgsfield.h"
+
+/** \ingroup core
+ * \class QgsSqlExpressionCompiler
+ * \brief Generic expression compiler for translating QgsExpressions to SQL WHERE clauses.
+ *
+ * Only the subset of expressions for which the SQL result is known to match the result of
+ * QgsExpression is translated: logical operators, comparisons of numbers, equality of strings,
+ * IN lists, LIKE patterns, IS NULL checks and integer or floating point arithmetic on fields
+ * of the data source. Providers subclass the compiler to adapt quoting and the operator set
+ * to their SQL dialect.
+ *
+ * A Partial result is a clause which selects a superset of the matching features, e.g. because
+ * part of an AND could not be translated or because the database compares strings case
+ * insensitively. Such a clause may be used to reduce the number of fetched features, but the
+ * expression still needs to be evaluated for every returned feature.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsSqlExpressionCompiler
+{
+  public:
+
+    //! Result of expression compilation
+    enum Result
+    {
+      None, //!< No expression
+      Complete, //!< Expression was successfully compiled and can be completely delegated to provider
+      Partial, //!< Expression was partially compiled, the clause selects a superset of the matching features
+      Fail //!< Provider cannot handle expression
+    };
+
+    //! Enumeration of flags for describing the behaviour of the SQL dialect
+    enum Flag
+    {
+      CaseInsensitiveStringMatch = 0x01,  //!< Provider performs case-insensitive string comparisons
+      LikeIsCaseInsensitive = 0x02, //!< Provider treats LIKE as case-insensitive
+      NoUnaryMinus = 0x04, //!< Provider does not support unary minus on non-literal values
+    };
+    Q_DECLARE_FLAGS( Flags, Flag )
+
+    /** Constructor for expression compiler.
+     * @param fields fields from provider
+     * @param flags flags describing the SQL dialect
+     */
+    explicit QgsSqlExpressionCompiler( const QgsFields& fields, const Flags& flags = Flags() );
+    virtual ~QgsSqlExpressionCompiler();
+
+    /** Returns true if providers should compile expressions, as set in the options.
+     * The setting /qgis/compileExpressions replaces /qgis/postgres/compileExpressions,
+     * which is used as long as the new setting was never saved.
+     */
+    static bool isEnabled();
+
+    /** Compiles an expression and returns the result of the compilation.
+     * The resulting WHERE clause is available through result().
+     */
+    virtual Result compile( const QgsExpression* exp );
+
+    /** Returns the compiled expression string for use by the provider.
+     */
+    virtual QString result() { return mResult; }
+
+  protected:
+
+    //! Type of the value an expression node evaluates to, as far as it is known at compile time
+    enum ValueType
+    {
+      vtUnknown,
+      vtNull,
+      vtBoolean,
+      vtInteger,
+      vtDouble,
+      vtString
+    };
+
+    /** Returns a quoted column identifier, in the format expected by the provider.
+     * Derived classes should override this if special handling of identifiers is required.
+     */
+    virtual QString quotedIdentifier( const QString& identifier );
+
+    /** Returns a quoted attribute value, in the format expected by the provider.
+     * Derived classes should override this if special handling of attribute values is required.
+     * @param value value to quote
+     * @param ok set to false if the value cannot be represented in the SQL dialect
+     */
+    virtual QString quotedValue( const QVariant& value, bool &ok );
+
+    /** Compiles an expression node and returns the result of the compilation.
+     * Derived classes may override this to support dialect specific operators and
+     * should call the base implementation for all other nodes.
+     * @param node expression node to compile
+     * @param str string representing compiled node should be stored in this parameter
+     * @returns result of node compilation
+     */
+    virtual Result compileNode( const QgsExpression::Node* node, QString& str );
+
+    //! Returns the type of value a node evaluates to
+    ValueType valueType( const QgsExpression::Node* node ) const;
+
+    //! Returns true if node is a string literal which QgsExpression would not compare as a number
+    static bool isTextLiteral( const QgsExpression::Node* node );
+
+    //! Returns true if node is a string literal usable as a LIKE pattern in any SQL dialect
+    static bool isLikePattern( const QgsExpression::Node* node );
+
+    static bool isNumeric( ValueType type ) { return type == vtInteger || type == vtDouble; }
+
+    QString mResult;
+    QgsFields mFields;
+
+  private:
+
+    Result compileUnary( const QgsExpression::NodeUnaryOperator* node, QString& str );
+    Result compileBinary( const QgsExpression::NodeBinaryOperator* node, QString& str );
+    Result compileComparison( const QgsExpression::NodeBinaryOperator* node, QString& str );
+    Result compileLike( const QgsExpression::NodeBinaryOperator* node, QString& str );
+    Result compileIn( const QgsExpression::NodeInOperator* node, QString& str );
+
+    Flags mFlags;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS( QgsSqlExpressionCompiler::Flags )
+
+#endif // QGSSQLEXPRESSIONCOMPILER_H
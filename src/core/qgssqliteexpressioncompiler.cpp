@@ -0,0 +1,56 @@
+/***************************************************************************
+                      qgssqliteexpressioncompiler.cpp
+                      -------------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssqliteexpressioncompiler.h"
+
+QgsSQLiteExpressionCompiler::QgsSQLiteExpressionCompiler( const QgsFields& fields )
+    : QgsSqlExpressionCompiler( fields, QgsSqlExpressionCompiler::LikeIsCaseInsensitive )
+{
+}
+
+QString QgsSQLiteExpressionCompiler::quotedValue( const QVariant& value, bool& ok )
+{
+  // SQLite has no boolean type
+  if ( !value.isNull() && value.type() == QVariant::Bool )
+  {
+    ok = true;
+    return value.toBool() ? "1" : "0";
+  }
+
+  return QgsSqlExpressionCompiler::quotedValue( value, ok );
+}
+
+QgsSqlExpressionCompiler::Result QgsSQLiteExpressionCompiler::compileNode( const QgsExpression::Node* node, QString& result )
+{
+  if ( node->nodeType() == QgsExpression::ntBinaryOperator )
+  {
+    const QgsExpression::NodeBinaryOperator* n = static_cast<const QgsExpression::NodeBinaryOperator*>( node );
+    if ( n->op() == QgsExpression::boDiv )
+    {
+      // SQLite returns NULL for a zero divisor like QgsExpression does,
+      // but the division must not be truncated for integer operands
+      if ( !isNumeric( valueType( n->opLeft() ) ) || !isNumeric( valueType( n->opRight() ) ) )
+        return Fail;
+
+      QString left, right;
+      if ( compileNode( n->opLeft(), left ) != Complete || compileNode( n->opRight(), right ) != Complete )
+        return Fail;
+
+      result = "(1.0 * " + left + " / " + right + ")";
+      return Complete;
+    }
+  }
+
+  return QgsSqlExpressionCompiler::compileNode( node, result );
+}
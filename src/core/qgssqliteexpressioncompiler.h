@@ -0,0 +1,44 @@
+/***************************************************************************
+                       qgssqliteexpressioncompiler.h
+                       -----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSQLITEEXPRESSIONCOMPILER_H
+#define QGSSQLITEEXPRESSIONCOMPILER_H
+
+#include "qgssqlexpressioncompiler.h"
+
+/** \ingroup core
+ * \class QgsSQLiteExpressionCompiler
+ * \brief Expression compiler for translation to SQLite SQL WHERE clauses.
+ *
+ * Used by the SpatiaLite provider and by the OGR provider for GeoPackage and SQLite
+ * data sources, whose attribute filters are handed to SQLite unchanged.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsSQLiteExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+
+    /** Constructor for expression compiler.
+     * @param fields fields from provider
+     */
+    explicit QgsSQLiteExpressionCompiler( const QgsFields& fields );
+
+  protected:
+
+    virtual QString quotedValue( const QVariant& value, bool& ok ) override;
+    virtual Result compileNode( const QgsExpression::Node* node, QString& str ) override;
+};
+
+#endif // QGSSQLITEEXPRESSIONCOMPILER_H
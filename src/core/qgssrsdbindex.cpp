@@ -0,0 +1,459 @@
+/***************************************************************************
+    qgssrsdbindex.cpp
+    -----------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssrsdbindex.h"
+
+#include "qgsapplication.h"
+#include "qgslogger.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRegExp>
+#include <QStringList>
+#include <QVector>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char SRS_INDEX_MAGIC[8] = { 'Q', 'G', 'S', 'S', 'R', 'S', 'D', 'B' };
+static const quint32 SRS_INDEX_BYTE_ORDER = 0x01020304;
+static const quint32 SRS_INDEX_VERSION = 1;
+static const int SRS_INDEX_TABLES = 5;
+static const int SRS_INDEX_STRINGS = 5;
+
+/** File header of a srs.db index. Followed by the records, the lookup tables and
+ * the UTF-8 string data. Not a part of public API. */
+struct QgsSrsDbIndexHeader
+{
+  char magic[8];
+  quint32 byteOrder; // detects files written on a machine with different endianness
+  quint32 version;
+  qint64 dbSize; // size and modification time of the indexed srs.db
+  qint64 dbModified;
+  quint32 recordCount;
+  quint32 stringsSize;
+};
+
+/** Row of tbl_srs. Strings are stored as offset and length in the string data, in the
+ * order description, projection acronym, ellipsoid acronym, parameters and auth id.
+ * Not a part of public API. */
+struct QgsSrsDbIndexRecord
+{
+  qint32 srsId;
+  qint32 srid;
+  quint32 flags;
+  quint32 strings[SRS_INDEX_STRINGS][2];
+};
+
+/** Entry of a lookup table, sorted by key and record position. Not a part of public API. */
+struct QgsSrsDbIndexEntry
+{
+  quint32 key;
+  quint32 record;
+
+  bool operator<( const QgsSrsDbIndexEntry& other ) const
+  {
+    return key < other.key || ( key == other.key && record < other.record );
+  }
+};
+
+enum RecordFlag
+{
+  GeographicFlag = 0x01,
+  DeprecatedFlag = 0x02
+};
+
+//! FNV-1a hash of the UTF-8 representation, stable across platforms and Qt versions
+static quint32 _hashString( const QString& str )
+{
+  QByteArray utf8 = str.toUtf8();
+  quint32 hash = 2166136261u;
+  for ( int i = 0; i < utf8.size(); ++i )
+  {
+    hash ^= static_cast<uchar>( utf8.at( i ) );
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static quint32 _key( QgsSrsDbIndex::Key key, const QString& value )
+{
+  switch ( key )
+  {
+    case QgsSrsDbIndex::AuthId:
+      return _hashString( value.toLower() );
+    case QgsSrsDbIndex::Srid:
+    case QgsSrsDbIndex::SrsId:
+      return static_cast<quint32>( value.toLong() );
+    case QgsSrsDbIndex::Parameters:
+      return _hashString( value.trimmed() );
+    case QgsSrsDbIndex::ParameterSet:
+      return _hashString( QgsSrsDbIndex::normalizedParameters( value ) );
+  }
+  return 0;
+}
+
+static QDateTime _lastModified( const QFileInfo& info )
+{
+  return info.lastModified().toUTC();
+}
+
+// -------------------------------------------------------------------------
+
+QgsSrsDbIndex* QgsSrsDbIndex::instance()
+{
+  // indexes are kept per database path, as srsDbFilePath() depends on the application prefix
+  static QMutex sMutex;
+  static QHash<QString, QgsSrsDbIndex*> sIndexes;
+
+  QString dbPath = QgsApplication::srsDbFilePath();
+  QMutexLocker locker( &sMutex );
+  QgsSrsDbIndex*& index = sIndexes[dbPath];
+  if ( !index )
+  {
+    index = new QgsSrsDbIndex();
+    if ( !index->open( indexFilePath( dbPath ), dbPath ) && QFileInfo( dbPath ).exists()
+         && !QgsApplication::qgisSettingsDirPath().isEmpty() )
+    {
+      // no index installed with srs.db or it is outdated, use one in the user settings
+      QString userIndexPath = QgsApplication::qgisSettingsDirPath() + "srs.db.idx";
+      if ( !index->open( userIndexPath, dbPath ) && build( dbPath, userIndexPath ) )
+      {
+        index->open( userIndexPath, dbPath );
+      }
+    }
+  }
+  return index;
+}
+
+QString QgsSrsDbIndex::indexFilePath( const QString& dbPath )
+{
+  return dbPath + ".idx";
+}
+
+QString QgsSrsDbIndex::normalizedParameters( const QString& proj4 )
+{
+  // split on spaces followed by a plus sign (+) to deal
+  // also with parameters containing spaces (e.g. +nadgrids)
+  QStringList params;
+  Q_FOREACH ( const QString& param, proj4.split( QRegExp( "\\s+(?=\\+)" ), QString::SkipEmptyParts ) )
+  {
+    QString p = param.trimmed();
+    if ( !p.isEmpty() && !p.startsWith( "+datum=" ) )
+      params << p;
+  }
+  params.sort();
+  return params.join( " " );
+}
+
+bool QgsSrsDbIndex::build( const QString& dbPath, const QString& indexPath )
+{
+  QFileInfo dbInfo( dbPath );
+  if ( !dbInfo.exists() )
+    return false;
+
+  sqlite3 *db;
+  if ( sqlite3_open_v2( dbPath.toUtf8().constData(), &db, SQLITE_OPEN_READONLY, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "Cannot open %1: %2" ).arg( dbPath ).arg( sqlite3_errmsg( db ) ) );
+    sqlite3_close( db );
+    return false;
+  }
+
+  // rows are indexed in the order of the "order by deprecated" queries of QgsCoordinateReferenceSystem
+  const char *sql = "SELECT srs_id,description,projection_acronym,ellipsoid_acronym,parameters,srid,"
+                    "auth_name||':'||auth_id,is_geo,deprecated FROM tbl_srs ORDER BY deprecated,srs_id";
+  sqlite3_stmt *stmt;
+  if ( sqlite3_prepare_v2( db, sql, -1, &stmt, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "Cannot read tbl_srs from %1: %2" ).arg( dbPath ).arg( sqlite3_errmsg( db ) ) );
+    sqlite3_close( db );
+    return false;
+  }
+
+  QVector<QgsSrsDbIndexRecord> records;
+  QVector<QgsSrsDbIndexEntry> tables[SRS_INDEX_TABLES];
+  QByteArray strings;
+
+  int result;
+  while (( result = sqlite3_step( stmt ) ) == SQLITE_ROW )
+  {
+    QgsSrsDbIndexRecord rec;
+    rec.srsId = sqlite3_column_int( stmt, 0 );
+    rec.srid = sqlite3_column_int( stmt, 5 );
+    rec.flags = ( sqlite3_column_int( stmt, 7 ) != 0 ? GeographicFlag : 0 )
+                | ( sqlite3_column_int( stmt, 8 ) != 0 ? DeprecatedFlag : 0 );
+
+    const int columns[SRS_INDEX_STRINGS] = { 1, 2, 3, 4, 6 };
+    QString values[SRS_INDEX_STRINGS];
+    for ( int i = 0; i < SRS_INDEX_STRINGS; ++i )
+    {
+      const char *text = reinterpret_cast<const char *>( sqlite3_column_text( stmt, columns[i] ) );
+      values[i] = QString::fromUtf8( text ? text : "" );
+      QByteArray utf8 = values[i].toUtf8();
+      rec.strings[i][0] = strings.size();
+      rec.strings[i][1] = utf8.size();
+      strings.append( utf8 );
+    }
+
+    quint32 pos = records.size();
+    QgsSrsDbIndexEntry entry;
+    entry.record = pos;
+    entry.key = _key( AuthId, values[4] );
+    tables[AuthId] << entry;
+    entry.key = rec.srid;
+    tables[Srid] << entry;
+    entry.key = rec.srsId;
+    tables[SrsId] << entry;
+    entry.key = _key( Parameters, values[3] );
+    tables[Parameters] << entry;
+    entry.key = _key( ParameterSet, values[3] );
+    tables[ParameterSet] << entry;
+
+    records << rec;
+  }
+  sqlite3_finalize( stmt );
+  sqlite3_close( db );
+
+  if ( result != SQLITE_DONE )
+  {
+    QgsDebugMsg( QString( "Reading tbl_srs from %1 failed" ).arg( dbPath ) );
+    return false;
+  }
+
+  for ( int i = 0; i < SRS_INDEX_TABLES; ++i )
+  {
+    std::sort( tables[i].begin(), tables[i].end() );
+  }
+
+  QgsSrsDbIndexHeader header;
+  memcpy( header.magic, SRS_INDEX_MAGIC, sizeof( header.magic ) );
+  header.byteOrder = SRS_INDEX_BYTE_ORDER;
+  header.version = SRS_INDEX_VERSION;
+  header.dbSize = dbInfo.size();
+  header.dbModified = _lastModified( dbInfo ).toMSecsSinceEpoch();
+  header.recordCount = records.size();
+  header.stringsSize = strings.size();
+
+  QString tmpPath = indexPath + ".tmp";
+  QFile file( tmpPath );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+  {
+    QgsDebugMsg( QString( "Cannot write srs.db index %1" ).arg( tmpPath ) );
+    return false;
+  }
+
+  qint64 recordsSize = records.size() * sizeof( QgsSrsDbIndexRecord );
+  qint64 tableSize = records.size() * sizeof( QgsSrsDbIndexEntry );
+  bool ok = file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) ) == sizeof( header )
+            && file.write( reinterpret_cast<const char*>( records.constData() ), recordsSize ) == recordsSize;
+  for ( int i = 0; ok && i < SRS_INDEX_TABLES; ++i )
+  {
+    ok = file.write( reinterpret_cast<const char*>( tables[i].constData() ), tableSize ) == tableSize;
+  }
+  ok = ok && file.write( strings ) == strings.size();
+  file.close();
+  if ( !ok )
+  {
+    QFile::remove( tmpPath );
+    return false;
+  }
+
+  // rename replaces the file atomically on POSIX systems, processes which mapped the old file keep it
+  if ( std::rename( QFile::encodeName( tmpPath ).constData(), QFile::encodeName( indexPath ).constData() ) != 0 )
+  {
+    QFile::remove( indexPath );
+    if ( !QFile::rename( tmpPath, indexPath ) )
+    {
+      QFile::remove( tmpPath );
+      return false;
+    }
+  }
+  return true;
+}
+
+QgsSrsDbIndex::QgsSrsDbIndex()
+    : mMapped( 0 )
+    , mHeader( 0 )
+    , mRecords( 0 )
+    , mStrings( 0 )
+{
+  memset( mTables, 0, sizeof( mTables ) );
+}
+
+QgsSrsDbIndex::~QgsSrsDbIndex()
+{
+  close();
+}
+
+void QgsSrsDbIndex::close()
+{
+  if ( mMapped )
+    mFile.unmap( mMapped );
+  mFile.close();
+  mMapped = 0;
+  mHeader = 0;
+  mRecords = 0;
+  mStrings = 0;
+  memset( mTables, 0, sizeof( mTables ) );
+}
+
+bool QgsSrsDbIndex::open( const QString& indexPath, const QString& dbPath )
+{
+  close();
+
+  QFileInfo dbInfo( dbPath );
+  mFile.setFileName( indexPath );
+  if ( !dbInfo.exists() || !mFile.open( QIODevice::ReadOnly ) )
+    return false;
+
+  qint64 size = mFile.size();
+  if ( size < ( qint64 ) sizeof( QgsSrsDbIndexHeader ) )
+  {
+    close();
+    return false;
+  }
+
+  mMapped = mFile.map( 0, size );
+  if ( !mMapped )
+  {
+    QgsDebugMsg( QString( "Cannot map srs.db index %1" ).arg( indexPath ) );
+    close();
+    return false;
+  }
+
+  const QgsSrsDbIndexHeader* header = reinterpret_cast<const QgsSrsDbIndexHeader*>( mMapped );
+  if ( memcmp( header->magic, SRS_INDEX_MAGIC, sizeof( header->magic ) ) != 0
+       || header->byteOrder != SRS_INDEX_BYTE_ORDER
+       || header->version != SRS_INDEX_VERSION )
+  {
+    QgsDebugMsg( QString( "%1 is not a srs.db index of this platform" ).arg( indexPath ) );
+    close();
+    return false;
+  }
+
+  if ( header->dbSize != dbInfo.size() || header->dbModified != _lastModified( dbInfo ).toMSecsSinceEpoch() )
+  {
+    QgsDebugMsg( QString( "srs.db index %1 is outdated" ).arg( indexPath ) );
+    close();
+    return false;
+  }
+
+  qint64 recordsSize = ( qint64 ) header->recordCount * sizeof( QgsSrsDbIndexRecord );
+  qint64 tableSize = ( qint64 ) header->recordCount * sizeof( QgsSrsDbIndexEntry );
+  if ( size != ( qint64 ) sizeof( QgsSrsDbIndexHeader ) + recordsSize + SRS_INDEX_TABLES * tableSize + header->stringsSize )
+  {
+    QgsDebugMsg( QString( "srs.db index %1 is truncated" ).arg( indexPath ) );
+    close();
+    return false;
+  }
+
+  const uchar* data = mMapped + sizeof( QgsSrsDbIndexHeader );
+  mRecords = reinterpret_cast<const QgsSrsDbIndexRecord*>( data );
+  data += recordsSize;
+  for ( int i = 0; i < SRS_INDEX_TABLES; ++i )
+  {
+    mTables[i] = reinterpret_cast<const QgsSrsDbIndexEntry*>( data );
+    data += tableSize;
+  }
+  mStrings = reinterpret_cast<const char*>( data );
+  mHeader = header;
+  return true;
+}
+
+int QgsSrsDbIndex::count() const
+{
+  return mHeader ? mHeader->recordCount : 0;
+}
+
+QString QgsSrsDbIndex::string( quint32 offset, quint32 length ) const
+{
+  if ( ( quint64 ) offset + length > mHeader->stringsSize )
+    return QString();
+  return QString::fromUtf8( mStrings + offset, length );
+}
+
+QgsSrsDbIndex::Record QgsSrsDbIndex::record( quint32 pos ) const
+{
+  const QgsSrsDbIndexRecord& rec = mRecords[pos];
+  Record r;
+  r.srsId = rec.srsId;
+  r.srid = rec.srid;
+  r.description = string( rec.strings[0][0], rec.strings[0][1] );
+  r.projectionAcronym = string( rec.strings[1][0], rec.strings[1][1] );
+  r.ellipsoidAcronym = string( rec.strings[2][0], rec.strings[2][1] );
+  r.parameters = string( rec.strings[3][0], rec.strings[3][1] );
+  r.authId = string( rec.strings[4][0], rec.strings[4][1] );
+  r.geographic = rec.flags & GeographicFlag;
+  r.deprecated = rec.flags & DeprecatedFlag;
+  return r;
+}
+
+bool QgsSrsDbIndex::matches( Key key, const Record& record, const QString& value ) const
+{
+  // keys are hashes, compare the actual values
+  switch ( key )
+  {
+    case AuthId:
+      return record.authId.compare( value, Qt::CaseInsensitive ) == 0;
+    case Srid:
+      return record.srid == value.toLong();
+    case SrsId:
+      return record.srsId == value.toLong();
+    case Parameters:
+      return record.parameters.trimmed() == value.trimmed();
+    case ParameterSet:
+      return normalizedParameters( record.parameters ) == normalizedParameters( value );
+  }
+  return false;
+}
+
+QList<QgsSrsDbIndex::Record> QgsSrsDbIndex::records( Key key, const QString& value ) const
+{
+  QList<Record> list;
+  if ( !mHeader || mHeader->recordCount == 0 )
+    return list;
+
+  QgsSrsDbIndexEntry search;
+  search.key = _key( key, value );
+  search.record = 0;
+
+  const QgsSrsDbIndexEntry* begin = mTables[key];
+  const QgsSrsDbIndexEntry* end = begin + mHeader->recordCount;
+  for ( const QgsSrsDbIndexEntry* it = std::lower_bound( begin, end, search ); it != end && it->key == search.key; ++it )
+  {
+    if ( it->record >= mHeader->recordCount )
+      break;
+
+    Record r = record( it->record );
+    if ( matches( key, r, value ) )
+      list << r;
+  }
+  return list;
+}
+
+bool QgsSrsDbIndex::find( Key key, const QString& value, Record& record ) const
+{
+  QList<Record> list = records( key, value );
+  if ( list.isEmpty() )
+    return false;
+
+  record = list.first();
+  return true;
+}
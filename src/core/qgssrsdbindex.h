@@ -0,0 +1,133 @@
+/***************************************************************************
+    qgssrsdbindex.h
+    ---------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSRSDBINDEX_H
+#define QGSSRSDBINDEX_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+struct QgsSrsDbIndexHeader;
+struct QgsSrsDbIndexRecord;
+struct QgsSrsDbIndexEntry;
+
+/** \ingroup core
+ * \class QgsSrsDbIndex
+ * \brief Read-only, memory-mapped index of the CRS table of srs.db.
+ *
+ * The index contains all rows of tbl_srs of the system srs.db together with sorted lookup
+ * tables by authority id, postgis srid, internal srs id and proj4 parameters. It is written
+ * next to srs.db when the database is synchronized during installation, or to the user
+ * settings directory when it is missing or older than srs.db. Lookups are binary searches
+ * on the mapped file and do not need to open the SQLite database, and all processes
+ * using the same index file share its pages.
+ *
+ * Entries are returned in the order SQLite would return them from a query ordered
+ * by deprecated, i.e. non-deprecated definitions first. The user database is not indexed.
+ * \note added in QGIS 2.12
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsSrsDbIndex
+{
+  public:
+
+    //! Lookup tables of the index
+    enum Key
+    {
+      AuthId, //!< Authority id, e.g. "EPSG:4326", case insensitive
+      Srid, //!< Postgis srid
+      SrsId, //!< Internal srs.db id
+      Parameters, //!< Exact proj4 definition
+      ParameterSet //!< Proj4 definition with parameters in any order, ignoring +datum
+    };
+
+    //! Row of tbl_srs
+    struct Record
+    {
+      long srsId;
+      long srid;
+      QString description;
+      QString projectionAcronym;
+      QString ellipsoidAcronym;
+      QString parameters;
+      QString authId;
+      bool geographic;
+      bool deprecated;
+    };
+
+    /** Returns the index of QgsApplication::srsDbFilePath(). The index is opened,
+     * and built if needed, on first use. The returned index may be invalid, in which
+     * case srs.db has to be queried directly.
+     */
+    static QgsSrsDbIndex* instance();
+
+    /** Writes the index of a srs.db file.
+     * @param dbPath path of srs.db
+     * @param indexPath path of the index file, replaced atomically
+     * @returns true on success
+     */
+    static bool build( const QString& dbPath, const QString& indexPath );
+
+    /** Returns the default path of the index of a srs.db file */
+    static QString indexFilePath( const QString& dbPath );
+
+    /** Returns the proj4 parameters without +datum, sorted, as used for ParameterSet lookups */
+    static QString normalizedParameters( const QString& proj4 );
+
+    //! Constructor for an invalid index
+    QgsSrsDbIndex();
+    ~QgsSrsDbIndex();
+
+    /** Memory-maps an index file.
+     * @param indexPath path of the index file
+     * @param dbPath path of the indexed srs.db. The index is rejected if the database
+     * was modified after the index was built.
+     * @returns true if the file is a valid and up to date index
+     */
+    bool open( const QString& indexPath, const QString& dbPath );
+
+    /** Returns true if the index has been opened */
+    bool isValid() const { return mHeader != 0; }
+
+    /** Returns the number of indexed CRS definitions */
+    int count() const;
+
+    /** Returns all records matching a value, non-deprecated ones first */
+    QList<Record> records( Key key, const QString& value ) const;
+
+    /** Finds the first record matching a value.
+     * @returns true if a record was found
+     */
+    bool find( Key key, const QString& value, Record& record ) const;
+
+  private:
+
+    Q_DISABLE_COPY( QgsSrsDbIndex )
+
+    void close();
+    Record record( quint32 pos ) const;
+    QString string( quint32 offset, quint32 length ) const;
+    bool matches( Key key, const Record& record, const QString& value ) const;
+
+    QFile mFile;
+    uchar* mMapped;
+    const QgsSrsDbIndexHeader* mHeader;
+    const QgsSrsDbIndexRecord* mRecords;
+    //! Lookup tables, in the order of Key
+    const QgsSrsDbIndexEntry* mTables[5];
+    const char* mStrings;
+};
+
+#endif // QGSSRSDBINDEX_H
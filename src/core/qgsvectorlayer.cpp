@@ -82,6 +82,7 @@
 #include "qgssymbologyv2conversion.h"
 #include "qgspallabeling.h"
 #include "qgssimplifymethod.h"
+#include "qgssimplifiedgeometrycache.h"
 #include "qgsexpressioncontext.h"
 
 #include "diagram/qgsdiagram.h"
@@ -169,6 +170,11 @@ QgsVectorLayer::QgsVectorLayer( QString vectorLayerPath,
   mSimplifyMethod.setThreshold( settings.value( "/qgis/simplifyDrawingTol", mSimplifyMethod.threshold() ).toFloat() );
   mSimplifyMethod.setForceLocalOptimization( settings.value( "/qgis/simplifyLocal", mSimplifyMethod.forceLocalOptimization() ).toBool() );
   mSimplifyMethod.setMaximumScale( settings.value( "/qgis/simplifyMaxScale", mSimplifyMethod.maximumScale() ).toFloat() );
+
+  // the cache may be released by a renderer in another thread
+  mSimplifiedGeometryCache = QSharedPointer<QgsSimplifiedGeometryCache>(
+                               new QgsSimplifiedGeometryCache( this, settings.value( "/qgis/simplifyCacheVertices", 1000000 ).toInt() ),
+                               &QObject::deleteLater );
 } // QgsVectorLayer ctor
 
 
@@ -3300,15 +3306,27 @@ QList<QVariant> QgsVectorLayer::getValues( const QString &fieldOrExpression, boo
   }
 
   // create list of non-null attribute values
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
+    // evaluate the expression for blocks of features at once
+    const int blockSize = 1024;
+    QgsFeatureList block;
+    block.reserve( blockSize );
+    while ( fit.nextFeature( f ) )
     {
-      context.setFeature( f );
-      QVariant v = expression->evaluate( &context );
-      values << v;
+      block << f;
+      if ( block.count() == blockSize )
+      {
+        values << expression->evaluateBlock( block, &context );
+        block.clear();
+      }
     }
-    else
+    if ( !block.isEmpty() )
+      values << expression->evaluateBlock( block, &context );
+  }
+  else
+  {
+    while ( fit.nextFeature( f ) )
     {
       values << f.attribute( attrNum );
     }
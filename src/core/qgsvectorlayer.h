@@ -24,6 +24,7 @@
 #include <QList>
 #include <QStringList>
 #include <QFont>
+#include <QSharedPointer>
 
 #include "qgis.h"
 #include "qgsmaplayer.h"
@@ -58,6 +59,7 @@ class QgsRectangle;
 class QgsRectangle;
 class QgsRelation;
 class QgsRelationManager;
+class QgsSimplifiedGeometryCache;
 class QgsSingleSymbolRendererV2;
 class QgsSymbolV2;
 class QgsVectorDataProvider;
@@ -1770,6 +1772,13 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
      */
     inline const QgsVectorSimplifyMethod& simplifyMethod() const { return mSimplifyMethod; }
 
+    /** Returns the cache of the geometries simplified for rendering. Renderers keep a reference
+     *  while they draw, so the cache may outlive the layer.
+     *  @note added in QGIS 2.12
+     *  @note not available in python bindings
+     */
+    QSharedPointer<QgsSimplifiedGeometryCache> simplifiedGeometryCache() const { return mSimplifiedGeometryCache; }
+
     /** Returns whether the VectorLayer can apply the specified simplification hint
      *  @note Do not use in 3rd party code - may be removed in future version!
      *  @note added in 2.2
@@ -2105,6 +2114,9 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
     /** Simplification object which holds the information about how to simplify the features for fast rendering */
     QgsVectorSimplifyMethod mSimplifyMethod;
 
+    /** Geometries simplified by the renderers, shared with them */
+    QSharedPointer<QgsSimplifiedGeometryCache> mSimplifiedGeometryCache;
+
     /** Label [old deprecated implementation] */
     QgsLabel *mLabel;
 
@@ -32,9 +32,9 @@ QgsVectorLayerDiagramProvider::QgsVectorLayerDiagramProvider(
   const QgsCoordinateReferenceSystem& crs,
   QgsAbstractFeatureSource* source,
   bool ownsSource )
-    : mSettings( *diagSettings )
+    : QgsAbstractLabelProvider( layerId )
+    , mSettings( *diagSettings )
     , mDiagRenderer( diagRenderer->clone() )
-    , mLayerId( layerId )
     , mFields( fields )
     , mLayerCrs( crs )
     , mSource( source )
@@ -45,9 +45,9 @@ QgsVectorLayerDiagramProvider::QgsVectorLayerDiagramProvider(
 
 
 QgsVectorLayerDiagramProvider::QgsVectorLayerDiagramProvider( QgsVectorLayer* layer, bool ownFeatureLoop )
-    : mSettings( *layer->diagramLayerSettings() )
+    : QgsAbstractLabelProvider( layer->id() )
+    , mSettings( *layer->diagramLayerSettings() )
     , mDiagRenderer( layer->diagramRenderer()->clone() )
-    , mLayerId( layer->id() )
     , mFields( layer->fields() )
     , mLayerCrs( layer->crs() )
     , mSource( ownFeatureLoop ? new QgsVectorLayerFeatureSource( layer ) : 0 )
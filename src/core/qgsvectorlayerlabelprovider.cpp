@@ -18,6 +18,7 @@
 #include "qgsdatadefined.h"
 #include "qgsgeometry.h"
 #include "qgslabelsearchtree.h"
+#include "qgslabelspritecache.h"
 #include "qgspalgeometry.h"
 #include "qgspallabeling.h"
 #include "qgsvectorlayer.h"
@@ -45,10 +46,10 @@ static void _fixQPictureDPI( QPainter* p )
 
 
 QgsVectorLayerLabelProvider::QgsVectorLayerLabelProvider( QgsVectorLayer* layer, bool withFeatureLoop, const QgsPalLayerSettings* settings, const QString& layerName )
+    : QgsAbstractLabelProvider( layer->id() )
 {
   mSettings = settings ? *settings : QgsPalLayerSettings::fromLayer( layer );
   mName = layerName.isEmpty() ? layer->id() : layerName;
-  mLayerId = layer->id();
   mFields = layer->fields();
   mCrs = layer->crs();
   if ( withFeatureLoop )
@@ -72,8 +73,8 @@ QgsVectorLayerLabelProvider::QgsVectorLayerLabelProvider(
   const QgsCoordinateReferenceSystem& crs,
   QgsAbstractFeatureSource* source,
   bool ownsSource )
-    : mSettings( settings )
-    , mLayerId( layerId )
+    : QgsAbstractLabelProvider( layerId )
+    , mSettings( settings )
     , mFields( fields )
     , mCrs( crs )
     , mSource( source )
@@ -601,6 +602,25 @@ void QgsVectorLayerLabelProvider::drawLabelPrivate( pal::LabelPosition* label, Q
       }
       else
       {
+        // without a shadow the text's drawing is not needed, outlined text may be drawn from a cached sprite
+        if ( mEngine->testFlag( QgsLabelingEngineV2::RenderOutlineLabels )
+             && !( tmpLyr.shadowDraw && tmpLyr.shadowUnder == QgsPalLayerSettings::ShadowText ) )
+        {
+          painter->save();
+          if ( context.useAdvancedEffects() )
+          {
+            painter->setCompositionMode( tmpLyr.blendMode );
+          }
+          painter->scale( component.dpiRatio(), component.dpiRatio() );
+          bool drawn = QgsLabelSpriteCache::instance()->drawText( painter, component.text(), tmpLyr.textFont, Qt::NoPen, tmpLyr.textColor );
+          painter->restore();
+          if ( drawn )
+          {
+            painter->restore();
+            continue;
+          }
+        }
+
         // draw label's text, QPainterPath method
         QPainterPath path;
         path.setFillRule( Qt::WindingFill );
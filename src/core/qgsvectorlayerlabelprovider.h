@@ -76,8 +76,6 @@ class CORE_EXPORT QgsVectorLayerLabelProvider : public QgsAbstractLabelProvider
   protected:
     //! Layer's labeling configuration
     QgsPalLayerSettings mSettings;
-    //! Layer's ID
-    QString mLayerId;
 
     // these are needed only if using own renderer loop
 
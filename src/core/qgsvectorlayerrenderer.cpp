@@ -25,6 +25,7 @@
 #include "qgsrendercontext.h"
 #include "qgssinglesymbolrendererv2.h"
 #include "qgssymbollayerv2.h"
+#include "qgssymbollayerv2utils.h"
 #include "qgssymbolv2.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectorlayerdiagramprovider.h"
@@ -32,13 +33,85 @@
 #include "qgsvectorlayerlabeling.h"
 #include "qgsvectorlayerlabelprovider.h"
 #include "qgspainteffect.h"
+#include "qgsrenderarena.h"
+#include "qgsmaptopixelgeometrysimplifier.h"
+#include "qgssimplifiedgeometrycache.h"
 
 #include <QSettings>
 #include <QPicture>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <climits>
 
 // TODO:
 // - passing of cache to QgsVectorLayer
 
+//! minimum number of features of a layer to split its rendering into parallel tiles
+static const int PARALLEL_TILES_MIN_FEATURES = 50000;
+//! maximum number of parallel tiles of a layer
+static const int PARALLEL_TILES_MAX_COUNT = 8;
+//! maximum error of approximated reprojection, in pixels
+static const double APPROXIMATE_TRANSFORM_PIXEL_ERROR = 0.25;
+//! pixels added around the features drawn into a tile image for antialiasing
+static const double PARALLEL_TILES_IMAGE_MARGIN = 2;
+
+//! returns the symbol layers of the renderer's symbols ordered by their rendering pass
+static QgsSymbolV2LevelOrder symbolLevels( QgsFeatureRendererV2* renderer, QgsRenderContext& context )
+{
+  QgsSymbolV2LevelOrder levels;
+  QgsSymbolV2List symbols = renderer->symbols( context );
+  for ( int i = 0; i < symbols.count(); i++ )
+  {
+    QgsSymbolV2* sym = symbols[i];
+    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
+    {
+      int level = sym->symbolLayer( j )->renderingPass();
+      if ( level < 0 || level >= 1000 ) // ignore invalid levels
+        continue;
+      QgsSymbolV2LevelItem item( sym, j );
+      while ( level >= levels.count() ) // append new empty levels
+        levels.append( QgsSymbolV2Level() );
+      levels[level].append( item );
+    }
+  }
+  return levels;
+}
+
+//! returns how many pixels the renderer's symbols may draw beyond the features' bounding boxes, or -1 if unknown
+static double symbolBleed( QgsFeatureRendererV2* renderer, QgsRenderContext& context )
+{
+  // symbol layers whose extent is known from their size, width and offset
+  QStringList knownLayerTypes;
+  knownLayerTypes << "SimpleFill" << "GradientFill" << "ShapeburstFill" << "SimpleLine"
+  << "SimpleMarker" << "SvgMarker" << "FontMarker";
+
+  double bleed = 0;
+  Q_FOREACH ( QgsSymbolV2* symbol, renderer->symbols( context ) )
+  {
+    for ( int i = 0; i < symbol->symbolLayerCount(); i++ )
+    {
+      QgsSymbolLayerV2* layer = symbol->symbolLayer( i );
+      if ( !knownLayerTypes.contains( layer->layerType() ) || layer->hasDataDefinedProperties()
+           || layer->outputUnit() == QgsSymbolV2::Mixed )
+        return -1;
+
+      double layerBleed = layer->estimateMaxBleed() * QgsSymbolLayerV2Utils::lineWidthScaleFactor( context, layer->outputUnit(), layer->mapUnitScale() );
+      if ( layer->type() == QgsSymbolV2::Marker )
+      {
+        // the whole size covers rotated markers and their outlines
+        QgsMarkerSymbolLayerV2* marker = static_cast<QgsMarkerSymbolLayerV2*>( layer );
+        double size = marker->size() * QgsSymbolLayerV2Utils::pixelSizeScaleFactor( context, marker->sizeUnit(), marker->sizeMapUnitScale() );
+        double offset = sqrt( marker->offset().x() * marker->offset().x() + marker->offset().y() * marker->offset().y() )
+                        * QgsSymbolLayerV2Utils::pixelSizeScaleFactor( context, marker->offsetUnit(), marker->offsetMapUnitScale() );
+        layerBleed = qMax( layerBleed, size + offset );
+      }
+      bleed = qMax( bleed, layerBleed );
+    }
+  }
+  return bleed + PARALLEL_TILES_IMAGE_MARGIN;
+}
+
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRenderContext& context )
     : QgsMapLayerRenderer( layer->id() )
@@ -51,6 +124,12 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRender
     , mLabelProvider( 0 )
     , mDiagramProvider( 0 )
     , mLayerTransparency( 0 )
+    , mCacheSimplifier( 0 )
+    , mCacheBand( 0 )
+    , mCacheGeneration( 0 )
+    , mApproximateTransform( true )
+    , mTileTarget( 0 )
+    , mTileMargin( -1 )
 {
   mSource = new QgsVectorLayerFeatureSource( layer );
 
@@ -66,6 +145,7 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRender
 
   mSimplifyMethod = layer->simplifyMethod();
   mSimplifyGeometry = layer->simplifyDrawingCanbeApplied( mContext, QgsVectorSimplifyMethod::GeometrySimplification );
+  mSimplifiedGeometryCache = layer->simplifiedGeometryCache();
 
   QSettings settings;
   mVertexMarkerOnlyForSelection = settings.value( "/qgis/digitizing/marker_only_for_selected", false ).toBool();
@@ -86,6 +166,8 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRender
 
   mVertexMarkerSize = settings.value( "/qgis/digitizing/marker_size", 3 ).toInt();
 
+  mApproximateTransform = settings.value( "/qgis/approximate_vector_transform", true ).toBool();
+
   if ( !mRendererV2 )
     return;
 
@@ -105,13 +187,22 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRender
   prepareLabeling( layer, mAttrNames );
   prepareDiagrams( layer, mAttrNames );
 
+  if ( canRenderInTiles( layer ) )
+  {
+    // feature sources are not thread safe - every tile gets its own one
+    int tileCount = qMin( QThreadPool::globalInstance()->maxThreadCount(), PARALLEL_TILES_MAX_COUNT );
+    for ( int i = 0; i < tileCount; ++i )
+      mTileSources << new QgsVectorLayerFeatureSource( layer );
+  }
 }
 
 
 QgsVectorLayerRenderer::~QgsVectorLayerRenderer()
 {
+  delete mCacheSimplifier;
   delete mRendererV2;
   delete mSource;
+  qDeleteAll( mTileSources );
 }
 
 
@@ -169,7 +260,7 @@ bool QgsVectorLayerRenderer::render()
     const QgsCoordinateTransform* ct = mContext.coordinateTransform();
 
     // resize the tolerance using the change of size of an 1-BBOX from the source CoordinateSystem to the target CoordinateSystem
-    if ( ct && !(( QgsCoordinateTransform* )ct )->isShortCircuited() )
+    if ( ct && !ct->isShortCircuited() )
     {
       try
       {
@@ -208,12 +299,26 @@ bool QgsVectorLayerRenderer::render()
 
     if ( validTransform )
     {
-      QgsSimplifyMethod simplifyMethod;
-      simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
-      simplifyMethod.setTolerance( map2pixelTol );
-      simplifyMethod.setForceLocalOptimization( mSimplifyMethod.forceLocalOptimization() );
+      int band = QgsSimplifiedGeometryCache::toleranceBand( map2pixelTol );
+      if ( mSimplifyMethod.forceLocalOptimization() && mSimplifiedGeometryCache
+           && mSimplifiedGeometryCache->maxVertices() > 0 && band != INT_MIN )
+      {
+        // the geometries would be simplified locally by the feature iterator anyway, so
+        // simplify them here with the tolerance of the band and reuse them while the band is the same
+        int simplifyFlags = QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope;
+        mCacheSimplifier = new QgsMapToPixelSimplifier( simplifyFlags, QgsSimplifiedGeometryCache::bandTolerance( band ) );
+        mCacheBand = band;
+        mCacheGeneration = mSimplifiedGeometryCache->generation();
+      }
+      else
+      {
+        QgsSimplifyMethod simplifyMethod;
+        simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
+        simplifyMethod.setTolerance( map2pixelTol );
+        simplifyMethod.setForceLocalOptimization( mSimplifyMethod.forceLocalOptimization() );
 
-      featureRequest.setSimplifyMethod( simplifyMethod );
+        featureRequest.setSimplifyMethod( simplifyMethod );
+      }
 
       QgsVectorSimplifyMethod vectorMethod = mSimplifyMethod;
       mContext.setVectorSimplifyMethod( vectorMethod );
@@ -232,12 +337,50 @@ bool QgsVectorLayerRenderer::render()
     mContext.setVectorSimplifyMethod( vectorMethod );
   }
 
-  QgsFeatureIterator fit = mSource->getFeatures( featureRequest );
+  // reproject the vertices by interpolation in a grid over the requested extent if its error is
+  // below a fraction of a pixel. The context transform may be shared, so a clone is used.
+  const QgsCoordinateTransform* exactTransform = mContext.coordinateTransform();
+  QgsCoordinateTransform* approximateTransform = 0;
+  if ( mApproximateTransform && exactTransform && !exactTransform->isShortCircuited() )
+  {
+    approximateTransform = exactTransform->clone();
+    double tolerance = APPROXIMATE_TRANSFORM_PIXEL_ERROR * mContext.mapToPixel().mapUnitsPerPixel();
+    if ( approximateTransform->setApproximation( requestExtent, tolerance ) )
+    {
+      mContext.setCoordinateTransform( approximateTransform );
+    }
+    else
+    {
+      delete approximateTransform;
+      approximateTransform = 0;
+    }
+  }
 
-  if (( mRendererV2->capabilities() & QgsFeatureRendererV2::SymbolLevels ) && mRendererV2->usingSymbolLevels() )
-    drawRendererV2Levels( fit );
+  // the tile images are composited onto the painter with plain source-over painting
+  QPainter* painter = mContext.painter();
+  if ( !mTileSources.isEmpty() && !mCache && requestExtent.isFinite() && !requestExtent.isEmpty()
+       && painter->compositionMode() == QPainter::CompositionMode_SourceOver && painter->opacity() == 1.0 )
+  {
+    drawRendererV2Tiles( featureRequest, requestExtent );
+  }
   else
-    drawRendererV2( fit );
+  {
+    QgsFeatureIterator fit = mSource->getFeatures( featureRequest );
+
+    if (( mRendererV2->capabilities() & QgsFeatureRendererV2::SymbolLevels ) && mRendererV2->usingSymbolLevels() )
+      drawRendererV2Levels( fit );
+    else
+      drawRendererV2( fit );
+  }
+
+  if ( approximateTransform )
+  {
+    mContext.setCoordinateTransform( exactTransform );
+    delete approximateTransform;
+  }
+
+  // merge the scratch memory used for the features of this layer, so that the next layer fits into one chunk
+  QgsRenderArena::instance()->reset();
 
   if ( usingEffect )
   {
@@ -267,6 +410,10 @@ void QgsVectorLayerRenderer::setGeometryCachePointer( QgsGeometryCache* cache )
   {
     // Destroy all cached geometries and clear the references to them
     mCache->setCachedGeometriesRect( mContext.extent() );
+
+    // geometries are cached from a single thread, the layer will not be rendered in tiles
+    qDeleteAll( mTileSources );
+    mTileSources.clear();
   }
 }
 
@@ -274,69 +421,102 @@ void QgsVectorLayerRenderer::setGeometryCachePointer( QgsGeometryCache* cache )
 
 void QgsVectorLayerRenderer::drawRendererV2( QgsFeatureIterator& fit )
 {
+  // features are fetched in blocks, which allows the renderer to evaluate
+  // its expressions for the whole block at once
+  const int blockSize = 512;
+  QgsFeatureList block;
+  block.reserve( blockSize );
+
   QgsFeature fet;
-  while ( fit.nextFeature( fet ) )
+  bool fetching = true;
+  while ( fetching )
   {
-    try
+    block.clear();
+    while ( block.count() < blockSize )
     {
+      if ( !fit.nextFeature( fet ) )
+      {
+        fetching = false;
+        break;
+      }
       if ( !fet.constGeometry() )
         continue; // skip features without geometry
 
+      simplifyFeature( fet );
+      block << fet;
+    }
+
+    if ( block.isEmpty() )
+      break;
+
+    mRendererV2->prepareFeatureBlock( block, mContext );
+
+    for ( QgsFeatureList::iterator it = block.begin(); it != block.end(); ++it )
+    {
       if ( mContext.renderingStopped() )
       {
         QgsDebugMsg( QString( "Drawing of vector layer %1 cancelled." ).arg( layerID() ) );
+        fetching = false;
         break;
       }
 
-      mContext.expressionContext().setFeature( fet );
+      drawFeature( *it );
+    }
+  }
 
-      bool sel = mContext.showSelection() && mSelectedFeatureIds.contains( fet.id() );
-      bool drawMarker = ( mDrawVertexMarkers && mContext.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+  stopRendererV2( NULL );
+}
 
-      if ( mCache )
-      {
-        // Cache this for the use of (e.g.) modifying the feature's uncommitted geometry.
-        mCache->cacheGeometry( fet.id(), *fet.constGeometry() );
-      }
+void QgsVectorLayerRenderer::drawFeature( QgsFeature& fet )
+{
+  try
+  {
+    mContext.expressionContext().setFeature( fet );
+
+    bool sel = mContext.showSelection() && mSelectedFeatureIds.contains( fet.id() );
+    bool drawMarker = ( mDrawVertexMarkers && mContext.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+    if ( mCache )
+    {
+      // Cache this for the use of (e.g.) modifying the feature's uncommitted geometry.
+      mCache->cacheGeometry( fet.id(), *fet.constGeometry() );
+    }
 
-      // render feature
-      bool rendered = mRendererV2->renderFeature( fet, mContext, -1, sel, drawMarker );
+    // render feature
+    bool rendered = mRendererV2->renderFeature( fet, mContext, -1, sel, drawMarker );
 
-      // labeling - register feature
-      Q_UNUSED( rendered );
-      if ( rendered && mContext.labelingEngine() )
+    // labeling - register feature
+    Q_UNUSED( rendered );
+    if ( rendered && mContext.labelingEngine() )
+    {
+      if ( mLabeling )
       {
-        if ( mLabeling )
-        {
-          mContext.labelingEngine()->registerFeature( mLayerID, fet, mContext );
-        }
-        if ( mDiagrams )
-        {
-          mContext.labelingEngine()->registerDiagramFeature( mLayerID, fet, mContext );
-        }
+        mContext.labelingEngine()->registerFeature( mLayerID, fet, mContext );
       }
-      // new labeling engine
-      if ( rendered && mContext.labelingEngineV2() )
+      if ( mDiagrams )
       {
-        if ( mLabelProvider )
-        {
-          mLabelProvider->registerFeature( fet, mContext );
-        }
-        if ( mDiagramProvider )
-        {
-          mDiagramProvider->registerFeature( fet, mContext );
-        }
+        mContext.labelingEngine()->registerDiagramFeature( mLayerID, fet, mContext );
       }
     }
-    catch ( const QgsCsException &cse )
+    // new labeling engine
+    if ( rendered && mContext.labelingEngineV2() )
     {
-      Q_UNUSED( cse );
-      QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
-                   .arg( fet.id() ).arg( cse.what() ) );
+      if ( mLabelProvider )
+      {
+        mLabelProvider->registerFeature( fet, mContext );
+      }
+      if ( mDiagramProvider )
+      {
+        mDiagramProvider->registerFeature( fet, mContext );
+      }
     }
   }
-
-  stopRendererV2( NULL );
+  catch ( const QgsCsException &cse )
+  {
+    Q_UNUSED( cse );
+    QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                 .arg( fet.id() ).arg( cse.what() ) );
+  }
 }
 
 void QgsVectorLayerRenderer::drawRendererV2Levels( QgsFeatureIterator& fit )
@@ -366,6 +546,8 @@ void QgsVectorLayerRenderer::drawRendererV2Levels( QgsFeatureIterator& fit )
       return;
     }
 
+    simplifyFeature( fet );
+
     mContext.expressionContext().setFeature( fet );
     QgsSymbolV2* sym = mRendererV2->symbolForFeature( fet, mContext );
     if ( !sym )
@@ -412,22 +594,7 @@ void QgsVectorLayerRenderer::drawRendererV2Levels( QgsFeatureIterator& fit )
   }
 
   // find out the order
-  QgsSymbolV2LevelOrder levels;
-  QgsSymbolV2List symbols = mRendererV2->symbols( mContext );
-  for ( int i = 0; i < symbols.count(); i++ )
-  {
-    QgsSymbolV2* sym = symbols[i];
-    for ( int j = 0; j < sym->symbolLayerCount(); j++ )
-    {
-      int level = sym->symbolLayer( j )->renderingPass();
-      if ( level < 0 || level >= 1000 ) // ignore invalid levels
-        continue;
-      QgsSymbolV2LevelItem item( sym, j );
-      while ( level >= levels.count() ) // append new empty levels
-        levels.append( QgsSymbolV2Level() );
-      levels[level].append( item );
-    }
-  }
+  QgsSymbolV2LevelOrder levels = symbolLevels( mRendererV2, mContext );
 
   // 2. draw features in correct order
   for ( int l = 0; l < levels.count(); l++ )
@@ -487,6 +654,324 @@ void QgsVectorLayerRenderer::stopRendererV2( QgsSingleSymbolRendererV2* selRende
 }
 
 
+bool QgsVectorLayerRenderer::canRenderInTiles( QgsVectorLayer* layer ) const
+{
+  if ( !mContext.parallelTileRendering() || mContext.forceVectorOutput() )
+    return false;
+
+  if ( qMin( QThreadPool::globalInstance()->maxThreadCount(), PARALLEL_TILES_MAX_COUNT ) < 2 )
+    return false;
+
+  if ( !mContext.extent().isFinite() || mContext.extent().isEmpty() )
+    return false;
+
+  // tiles are composited as images
+  if ( !mContext.painter() || !mContext.painter()->device() || mContext.painter()->device()->devType() != QInternal::Image )
+    return false;
+
+  // labels and diagrams are registered with the labeling engine from a single thread
+  if ( mLabeling || mDiagrams || mLabelProvider || mDiagramProvider )
+    return false;
+
+  // only renderers which keep no state between features may split the features among tiles
+  QString type = mRendererV2->type();
+  if ( type != "singleSymbol" && type != "categorizedSymbol" && type != "graduatedSymbol" )
+    return false;
+
+  // paint effects and feature blending need all features drawn onto one image
+  if ( mRendererV2->paintEffect() && mRendererV2->paintEffect()->enabled() )
+    return false;
+  if ( mContext.useAdvancedEffects() && mFeatureBlendMode != QPainter::CompositionMode_SourceOver )
+    return false;
+
+  return layer->featureCount() >= PARALLEL_TILES_MIN_FEATURES;
+}
+
+QgsRectangle QgsVectorLayerRenderer::tileExtent( int index ) const
+{
+  int count = mTileSources.count();
+  double tileWidth = mTilesExtent.width() / count;
+  double xMax = index == count - 1 ? mTilesExtent.xMaximum() : mTilesExtent.xMinimum() + ( index + 1 ) * tileWidth;
+  return QgsRectangle( mTilesExtent.xMinimum() + index * tileWidth, mTilesExtent.yMinimum(), xMax, mTilesExtent.yMaximum() );
+}
+
+int QgsVectorLayerRenderer::tileForFeature( const QgsGeometry* geometry ) const
+{
+  // every feature is owned by the strip containing the center of its bounding box if the geometry
+  // intersects that strip, otherwise by the first strip it intersects. A multipart or concave geometry
+  // may miss the strip of its center, which does not fetch it if the provider filters by exact intersection
+  int count = mTileSources.count();
+  QgsRectangle bbox = geometry->boundingBox();
+  double tileWidth = mTilesExtent.width() / count;
+  int first = qBound( 0, ( int ) floor(( bbox.xMinimum() - mTilesExtent.xMinimum() ) / tileWidth ), count - 1 );
+  int last = qBound( 0, ( int ) floor(( bbox.xMaximum() - mTilesExtent.xMinimum() ) / tileWidth ), count - 1 );
+  int center = qBound( 0, ( int ) floor(( bbox.center().x() - mTilesExtent.xMinimum() ) / tileWidth ), count - 1 );
+  if ( first == last || geometry->intersects( tileExtent( center ) ) )
+    return center;
+
+  for ( int i = first; i <= last; ++i )
+  {
+    if ( i != center && geometry->intersects( tileExtent( i ) ) )
+      return i;
+  }
+  return center;
+}
+
+QRect QgsVectorLayerRenderer::tileImageRect( const QgsRectangle& bbox, QgsRenderContext& context ) const
+{
+  QRect target = mTileTarget->rect();
+  if ( mTileMargin < 0 )
+    return target;
+
+  QgsRectangle extent = bbox;
+  if ( context.coordinateTransform() )
+  {
+    try
+    {
+      extent = context.coordinateTransform()->transformBoundingBox( bbox );
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse );
+      return target;
+    }
+  }
+
+  // the corners are mapped one by one, the map may be rotated
+  const QgsMapToPixel& mtp = context.mapToPixel();
+  QPolygonF corners;
+  corners << mtp.transform( extent.xMinimum(), extent.yMinimum() ).toQPointF()
+  << mtp.transform( extent.xMaximum(), extent.yMinimum() ).toQPointF()
+  << mtp.transform( extent.xMaximum(), extent.yMaximum() ).toQPointF()
+  << mtp.transform( extent.xMinimum(), extent.yMaximum() ).toQPointF();
+  QRectF rect = corners.boundingRect().adjusted( -mTileMargin, -mTileMargin, mTileMargin, mTileMargin );
+  return mTileTransform.mapRect( rect ).toAlignedRect() & target;
+}
+
+QImage QgsVectorLayerRenderer::tileImage( const QRect& rect ) const
+{
+  QImage image( rect.size(), QImage::Format_ARGB32_Premultiplied );
+  image.setDotsPerMeterX( mTileTarget->dotsPerMeterX() );
+  image.setDotsPerMeterY( mTileTarget->dotsPerMeterY() );
+  image.fill( 0 );
+  return image;
+}
+
+void QgsVectorLayerRenderer::simplifyFeature( QgsFeature& fet ) const
+{
+  if ( !mCacheSimplifier )
+    return;
+
+  QgsGeometry* geometry = fet.geometry();
+  QgsSimplifiedGeometryCache::Source source( *geometry );
+  if ( mSimplifiedGeometryCache->geometry( fet.id(), mCacheBand, source, *geometry ) )
+    return;
+
+  QGis::GeometryType geometryType = geometry->type();
+  if ( geometryType != QGis::Line && geometryType != QGis::Polygon )
+    return;
+
+  mCacheSimplifier->simplifyGeometry( geometry );
+  mSimplifiedGeometryCache->insert( fet.id(), mCacheBand, source, *geometry, mCacheGeneration );
+}
+
+void QgsVectorLayerRenderer::drawRendererV2Tiles( const QgsFeatureRequest& featureRequest, const QgsRectangle& requestExtent )
+{
+  QPainter* painter = mContext.painter();
+
+  mTilesExtent = requestExtent;
+  mTileTarget = static_cast<QImage*>( painter->device() );
+  mTileMargin = symbolBleed( mRendererV2, mContext );
+  if ( mTileMargin >= 0 && mDrawVertexMarkers )
+    mTileMargin += mVertexMarkerSize;
+  mTileTransform = painter->transform();
+  mTileRenderHints = painter->renderHints();
+
+  // the extent is split into vertical strips. Every tile fetches the features of its strip
+  // and draws those it owns, so each feature is drawn exactly once
+  int count = mTileSources.count();
+
+  QList<Tile*> tiles;
+  for ( int i = 0; i < count; ++i )
+  {
+    Tile* tile = new Tile;
+    tile->index = i;
+    tile->source = mTileSources.at( i );
+    tile->renderer = mRendererV2->clone();
+    tile->context = mContext;
+    tile->context.setCoordinateTransform( mContext.coordinateTransform() ? mContext.coordinateTransform()->clone() : 0 );
+    tile->context.setLabelingEngine( 0 );
+    tile->context.setLabelingEngineV2( 0 );
+    tile->request = featureRequest;
+    tile->request.setFilterRect( tileExtent( i ) );
+    tiles << tile;
+  }
+
+  QList< QFuture<void> > futures;
+  Q_FOREACH ( Tile* tile, tiles )
+  {
+    futures << QtConcurrent::run( this, &QgsVectorLayerRenderer::renderTile, tile );
+  }
+  for ( int i = 0; i < futures.count(); ++i )
+  {
+    futures[i].waitForFinished();
+  }
+
+  // composite the tiles level by level so that the symbol levels of all tiles are kept in order
+  int levelCount = 0;
+  Q_FOREACH ( Tile* tile, tiles )
+  {
+    levelCount = qMax( levelCount, tile->images.count() );
+  }
+
+  painter->save();
+  painter->resetTransform();
+  for ( int l = 0; l < levelCount; ++l )
+  {
+    Q_FOREACH ( Tile* tile, tiles )
+    {
+      if ( l < tile->images.count() && !tile->images.at( l ).isNull() )
+        painter->drawImage( tile->imageRect.topLeft(), tile->images.at( l ) );
+    }
+  }
+  painter->restore();
+
+  Q_FOREACH ( Tile* tile, tiles )
+  {
+    delete tile->context.coordinateTransform();
+    delete tile->renderer;
+    delete tile;
+  }
+  mTileTarget = 0;
+
+  mRendererV2->stopRender( mContext );
+}
+
+void QgsVectorLayerRenderer::renderTile( Tile* tile )
+{
+  QgsRenderContext& context = tile->context;
+  QgsFeatureRendererV2* renderer = tile->renderer;
+
+  // the owned features are collected first, the tile images only cover the area they are drawn into
+  QgsFeatureList owned;
+  QgsRectangle ownedExtent;
+  ownedExtent.setMinimal();
+  QgsFeatureIterator fit = tile->source->getFeatures( tile->request );
+  QgsFeature fet;
+  while ( fit.nextFeature( fet ) && !mContext.renderingStopped() )
+  {
+    if ( !fet.constGeometry() || tileForFeature( fet.constGeometry() ) != tile->index )
+      continue; // skip features without geometry or drawn by another tile
+
+    QgsRectangle bbox = fet.constGeometry()->boundingBox();
+    ownedExtent.combineExtentWith( &bbox );
+    simplifyFeature( fet );
+    owned << fet;
+  }
+  fit.close();
+
+  if ( owned.isEmpty() || mContext.renderingStopped() )
+    return;
+
+  tile->imageRect = tileImageRect( ownedExtent, context );
+  if ( tile->imageRect.isEmpty() )
+    return;
+
+  QTransform transform = mTileTransform * QTransform::fromTranslate( -tile->imageRect.left(), -tile->imageRect.top() );
+  QPainter painter;
+  tile->images << tileImage( tile->imageRect );
+  painter.begin( &tile->images.last() );
+  painter.setTransform( transform );
+  painter.setRenderHints( mTileRenderHints );
+  context.setPainter( &painter );
+
+  renderer->startRender( context, mFields );
+
+  if (( renderer->capabilities() & QgsFeatureRendererV2::SymbolLevels ) && renderer->usingSymbolLevels() )
+  {
+    QHash< QgsSymbolV2*, QList<QgsFeature> > features; // key = symbol, value = array of features
+    for ( QgsFeatureList::iterator it = owned.begin(); it != owned.end(); ++it )
+    {
+      context.expressionContext().setFeature( *it );
+      QgsSymbolV2* sym = renderer->symbolForFeature( *it, context );
+      if ( sym )
+        features[sym].append( *it );
+    }
+
+    // every level is drawn into a separate image, so that the levels of all tiles can be composited in order
+    QgsSymbolV2LevelOrder levels = symbolLevels( renderer, context );
+    for ( int l = 0; l < levels.count() && !mContext.renderingStopped(); l++ )
+    {
+      if ( l > 0 )
+      {
+        painter.end();
+        tile->images << tileImage( tile->imageRect );
+        painter.begin( &tile->images.last() );
+        painter.setTransform( transform );
+        painter.setRenderHints( mTileRenderHints );
+      }
+
+      QgsSymbolV2Level& level = levels[l];
+      for ( int i = 0; i < level.count(); i++ )
+      {
+        QgsSymbolV2LevelItem& item = level[i];
+        QList<QgsFeature>& lst = features[item.symbol()];
+        for ( QList<QgsFeature>::iterator it = lst.begin(); it != lst.end() && !mContext.renderingStopped(); ++it )
+        {
+          bool sel = mSelectedFeatureIds.contains( it->id() );
+          bool drawMarker = ( mDrawVertexMarkers && context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+          context.expressionContext().setFeature( *it );
+          try
+          {
+            renderer->renderFeature( *it, context, item.layer(), sel, drawMarker );
+          }
+          catch ( const QgsCsException &cse )
+          {
+            Q_UNUSED( cse );
+            QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                         .arg( it->id() ).arg( cse.what() ) );
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+    const int blockSize = 512;
+    for ( int start = 0; start < owned.count() && !mContext.renderingStopped(); start += blockSize )
+    {
+      QgsFeatureList block = owned.mid( start, blockSize );
+      renderer->prepareFeatureBlock( block, context );
+
+      for ( QgsFeatureList::iterator it = block.begin(); it != block.end() && !mContext.renderingStopped(); ++it )
+      {
+        bool sel = context.showSelection() && mSelectedFeatureIds.contains( it->id() );
+        bool drawMarker = ( mDrawVertexMarkers && context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+        context.expressionContext().setFeature( *it );
+        try
+        {
+          renderer->renderFeature( *it, context, -1, sel, drawMarker );
+        }
+        catch ( const QgsCsException &cse )
+        {
+          Q_UNUSED( cse );
+          QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                       .arg( it->id() ).arg( cse.what() ) );
+        }
+      }
+    }
+  }
+
+  renderer->stopRender( context );
+  painter.end();
+  context.setPainter( 0 );
+
+  QgsRenderArena::instance()->reset();
+}
+
+
 
 
 void QgsVectorLayerRenderer::prepareLabeling( QgsVectorLayer* layer, QStringList& attributeNames )
@@ -26,10 +26,14 @@ class QgsDiagramLayerSettings;
 
 class QgsGeometryCache;
 class QgsFeatureIterator;
+class QgsMapToPixelSimplifier;
+class QgsSimplifiedGeometryCache;
 class QgsSingleSymbolRendererV2;
 
+#include <QImage>
 #include <QList>
 #include <QPainter>
+#include <QSharedPointer>
 
 typedef QList<int> QgsAttributeList;
 
@@ -40,6 +44,7 @@ typedef QList<int> QgsAttributeList;
 #include "qgsvectorsimplifymethod.h"
 
 #include "qgsmaplayerrenderer.h"
+#include "qgsrendercontext.h"
 
 class QgsVectorLayerLabelProvider;
 class QgsVectorLayerDiagramProvider;
@@ -74,6 +79,10 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     void drawRendererV2( QgsFeatureIterator& fit );
 
+    /** Draw a single feature with renderer V2 and register it for labeling and diagrams
+     */
+    void drawFeature( QgsFeature& fet );
+
     /** Draw layer with renderer V2 using symbol levels. QgsFeatureRenderer::startRender() needs to be called before using this method
      */
     void drawRendererV2Levels( QgsFeatureIterator& fit );
@@ -81,6 +90,59 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     /** Stop version 2 renderer and selected renderer (if required) */
     void stopRendererV2( QgsSingleSymbolRendererV2* selRenderer );
 
+    /** One vertical strip of the map extent rendered on a separate thread.
+     * Each tile uses its own feature source, renderer and render context,
+     * so that no state is shared between the worker threads. A tile fetches the
+     * features of its strip and draws those it owns.
+     */
+    struct Tile
+    {
+      Tile() : source( 0 ), renderer( 0 ), index( 0 ) {}
+
+      QgsVectorLayerFeatureSource* source;
+      QgsFeatureRendererV2* renderer;
+      QgsRenderContext context;
+      QgsFeatureRequest request;
+      int index;
+      //! area of the map image covered by the tile images
+      QRect imageRect;
+      //! rendered image - one image per symbol level if symbol levels are used
+      QList<QImage> images;
+    };
+
+    /** Returns true if the layer is large enough and its renderer, effects and labeling
+     * allow it to be rendered in parallel tiles.
+     */
+    bool canRenderInTiles( QgsVectorLayer* layer ) const;
+
+    /** Draw the features of the request in parallel tiles and composite the tile images
+     * into the context's painter. QgsFeatureRenderer::startRender() needs to be called before using this method
+     */
+    void drawRendererV2Tiles( const QgsFeatureRequest& featureRequest, const QgsRectangle& requestExtent );
+
+    //! Draws the features owned by a tile into the tile's images. Called from worker threads.
+    void renderTile( Tile* tile );
+
+    //! Returns the extent of a strip, in layer coordinates
+    QgsRectangle tileExtent( int index ) const;
+
+    //! Returns the index of the strip which owns the feature with given geometry
+    int tileForFeature( const QgsGeometry* geometry ) const;
+
+    /** Returns the area of the map image the features within given bounding box may be drawn into.
+     * Called from worker threads.
+     */
+    QRect tileImageRect( const QgsRectangle& bbox, QgsRenderContext& context ) const;
+
+    //! Returns a blank image for the given area of the map image
+    QImage tileImage( const QRect& rect ) const;
+
+    /** Replaces the geometry of a fetched feature with its simplified version from the cache,
+     * or simplifies and caches it. Does nothing if the feature iterator simplifies the geometries.
+     * Called from worker threads.
+     */
+    void simplifyFeature( QgsFeature& fet ) const;
+
 
   protected:
 
@@ -121,6 +183,28 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     QgsVectorSimplifyMethod mSimplifyMethod;
     bool mSimplifyGeometry;
+
+    //! simplified geometries of the layer
+    QSharedPointer<QgsSimplifiedGeometryCache> mSimplifiedGeometryCache;
+    //! simplifier for the tolerance band of the cache, null if the feature iterator simplifies
+    QgsMapToPixelSimplifier* mCacheSimplifier;
+    int mCacheBand;
+    int mCacheGeneration;
+
+    //! whether vertices may be reprojected by interpolation when the error is below a fraction of a pixel
+    bool mApproximateTransform;
+
+    //! feature sources for parallel tile rendering, only created if the layer is rendered in tiles
+    QList<QgsVectorLayerFeatureSource*> mTileSources;
+    //! extent covered by the tiles, in layer coordinates
+    QgsRectangle mTilesExtent;
+    //! map image the tiles are composited into
+    const QImage* mTileTarget;
+    //! pixels the symbols may be drawn beyond the features' bounding boxes, negative if unknown
+    double mTileMargin;
+    //! world transform and render hints the tiles are drawn with
+    QTransform mTileTransform;
+    QPainter::RenderHints mTileRenderHints;
 };
 
 
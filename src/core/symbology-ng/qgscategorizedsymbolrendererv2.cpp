@@ -244,7 +244,8 @@ QgsSymbolV2* QgsCategorizedSymbolRendererV2::originalSymbolForFeature( QgsFeatur
   if ( mAttrNum == -1 )
   {
     Q_ASSERT( mExpression.data() );
-    value = mExpression->evaluate( &context.expressionContext() );
+    if ( !blockValue( feature, value ) )
+      value = mExpression->evaluate( &context.expressionContext() );
   }
   else
   {
@@ -445,6 +446,13 @@ void QgsCategorizedSymbolRendererV2::stopRender( QgsRenderContext& context )
   }
   mTempSymbols.clear();
   mExpression.reset();
+  clearBlockValues();
+}
+
+void QgsCategorizedSymbolRendererV2::prepareFeatureBlock( const QgsFeatureList& features, QgsRenderContext& context )
+{
+  if ( mAttrNum == -1 && mExpression.data() )
+    evaluateBlockValues( mExpression.data(), features, context );
 }
 
 QList<QString> QgsCategorizedSymbolRendererV2::usedAttributes()
@@ -84,6 +84,8 @@ class CORE_EXPORT QgsCategorizedSymbolRendererV2 : public QgsFeatureRendererV2
 
     virtual void stopRender( QgsRenderContext& context ) override;
 
+    virtual void prepareFeatureBlock( const QgsFeatureList& features, QgsRenderContext& context ) override;
+
     virtual QList<QString> usedAttributes() override;
 
     virtual QString dump() const override;
@@ -356,7 +356,8 @@ QgsSymbolV2* QgsGraduatedSymbolRendererV2::originalSymbolForFeature( QgsFeature&
   QVariant value;
   if ( mAttrNum < 0 || mAttrNum >= attrs.count() )
   {
-    value = mExpression->evaluate( &context.expressionContext() );
+    if ( !blockValue( feature, value ) )
+      value = mExpression->evaluate( &context.expressionContext() );
   }
   else
   {
@@ -423,6 +424,13 @@ void QgsGraduatedSymbolRendererV2::stopRender( QgsRenderContext& context )
     delete it2.value();
   }
   mTempSymbols.clear();
+  clearBlockValues();
+}
+
+void QgsGraduatedSymbolRendererV2::prepareFeatureBlock( const QgsFeatureList& features, QgsRenderContext& context )
+{
+  if ( mAttrNum == -1 && mExpression.data() )
+    evaluateBlockValues( mExpression.data(), features, context );
 }
 
 QList<QString> QgsGraduatedSymbolRendererV2::usedAttributes()
@@ -18,6 +18,7 @@
 #include "qgssymbollayerv2utils.h"
 #include "qgsrulebasedrendererv2.h"
 #include "qgsdatadefined.h"
+#include "qgsexpression.h"
 
 #include "qgssinglesymbolrendererv2.h" // for default renderer
 
@@ -35,10 +36,16 @@
 #include "qgspainteffectregistry.h"
 #include "qgswkbptr.h"
 #include "qgspointv2.h"
+#include "qgsrenderarena.h"
+#include "qgswkbgeometryview.h"
 
 #include <QDomElement>
 #include <QDomDocument>
 #include <QPolygonF>
+#include <QThreadStorage>
+
+#include <float.h>
+#include <string.h>
 
 
 
@@ -62,6 +69,96 @@ const unsigned char* QgsFeatureRendererV2::_getPoint( QPointF& pt, QgsRenderCont
   return wkbPtr;
 }
 
+/** Coordinates of the ring being rendered, as separate x/y arrays. Feature rendering runs
+ * in several threads, every thread reuses its own buffers for all rings. Not a part of public API. */
+class QgsRenderCoordinateBuffers
+{
+  public:
+    //! Makes sure the buffers can hold count coordinates
+    void reserve( int count )
+    {
+      if ( x.size() < count )
+      {
+        x.resize( count );
+        y.resize( count );
+        z.resize( count );
+      }
+    }
+
+    QVector<double> x;
+    QVector<double> y;
+    QVector<double> z;
+};
+
+static QThreadStorage<QgsRenderCoordinateBuffers*> sCoordinateBuffers;
+
+static QgsRenderCoordinateBuffers& _coordinateBuffers()
+{
+  if ( !sCoordinateBuffers.hasLocalData() )
+    sCoordinateBuffers.setLocalData( new QgsRenderCoordinateBuffers );
+  return *sCoordinateBuffers.localData();
+}
+
+// reads nPoints coordinates from the WKB into the buffers, returns their bounding box in rect
+static QgsConstWkbPtr _readCoordinates( QgsConstWkbPtr wkbPtr, int nPoints, bool hasZValue, bool hasMValue, QgsRenderCoordinateBuffers& buffers, QgsRectangle& rect )
+{
+  buffers.reserve( nPoints );
+  double* x = buffers.x.data();
+  double* y = buffers.y.data();
+  int skip = ( hasZValue ? sizeof( double ) : 0 ) + ( hasMValue ? sizeof( double ) : 0 );
+  double xMin = DBL_MAX, yMin = DBL_MAX, xMax = -DBL_MAX, yMax = -DBL_MAX;
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    wkbPtr >> x[i] >> y[i];
+    wkbPtr += skip;
+    xMin = qMin( xMin, x[i] );
+    yMin = qMin( yMin, y[i] );
+    xMax = qMax( xMax, x[i] );
+    yMax = qMax( yMax, y[i] );
+  }
+  rect = QgsRectangle( xMin, yMin, xMax, yMax );
+  return wkbPtr;
+}
+
+static void _copyToBuffers( const QPolygonF& pts, QgsRenderCoordinateBuffers& buffers )
+{
+  buffers.reserve( pts.size() );
+  double* x = buffers.x.data();
+  double* y = buffers.y.data();
+  const QPointF* ptr = pts.constData();
+  for ( int i = 0; i < pts.size(); ++i, ++ptr )
+  {
+    x[i] = ptr->x();
+    y[i] = ptr->y();
+  }
+}
+
+// transforms the first count coordinates of the buffers to screen coordinates and stores them in pts:
+// the CRS transform handles the whole ring in one call, the map to pixel transform is a single loop
+static void _transformToScreen( QgsRenderCoordinateBuffers& buffers, int count, QgsRenderContext& context, QPolygonF& pts )
+{
+  double* x = buffers.x.data();
+  double* y = buffers.y.data();
+
+  const QgsCoordinateTransform* ct = context.coordinateTransform();
+  if ( ct && ct->isInitialised() && !ct->isShortCircuited() && count > 0 )
+  {
+    double* z = buffers.z.data();
+    memset( z, 0, count * sizeof( double ) );
+    ct->transformCoords( count, x, y, z );
+  }
+
+  context.mapToPixel().transformInPlace( x, y, count );
+
+  pts.resize( count );
+  QPointF* ptr = pts.data();
+  for ( int i = 0; i < count; ++i, ++ptr )
+  {
+    ptr->rx() = x[i];
+    ptr->ry() = y[i];
+  }
+}
+
 const unsigned char* QgsFeatureRendererV2::_getLineString( QPolygonF& pts, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent )
 {
   QgsConstWkbPtr wkbPtr( wkb + 1 );
@@ -71,10 +168,8 @@ const unsigned char* QgsFeatureRendererV2::_getLineString( QPolygonF& pts, QgsRe
   bool hasZValue = QgsWKBTypes::hasZ(( QgsWKBTypes::Type )wkbType );
   bool hasMValue = QgsWKBTypes::hasM(( QgsWKBTypes::Type )wkbType );
 
-  double x = 0.0;
-  double y = 0.0;
-  const QgsCoordinateTransform* ct = context.coordinateTransform();
-  const QgsMapToPixel& mtp = context.mapToPixel();
+  QgsRenderCoordinateBuffers& buffers = _coordinateBuffers();
+  int count;
 
   //apply clipping for large lines to achieve a better rendering performance
   if ( clipToExtent && nPoints > 1 )
@@ -83,35 +178,18 @@ const unsigned char* QgsFeatureRendererV2::_getLineString( QPolygonF& pts, QgsRe
     double cw = e.width() / 10; double ch = e.height() / 10;
     QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
     wkbPtr = QgsConstWkbPtr( QgsClipper::clippedLineWKB( wkb, clipRect, pts ) );
+    _copyToBuffers( pts, buffers );
+    count = pts.size();
   }
   else
   {
-    pts.resize( nPoints );
-
-    QPointF* ptr = pts.data();
-    for ( unsigned int i = 0; i < nPoints; ++i, ++ptr )
-    {
-      wkbPtr >> x >> y;
-      if ( hasZValue )
-        wkbPtr += sizeof( double );
-      if ( hasMValue )
-        wkbPtr += sizeof( double );
-
-      *ptr = QPointF( x, y );
-    }
+    QgsRectangle rect;
+    wkbPtr = _readCoordinates( wkbPtr, nPoints, hasZValue, hasMValue, buffers, rect );
+    count = nPoints;
   }
 
-  //transform the QPolygonF to screen coordinates
-  if ( ct )
-  {
-    ct->transformPolygon( pts );
-  }
-
-  QPointF* ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
+  //transform the points to screen coordinates
+  _transformToScreen( buffers, count, context, pts );
 
   return wkbPtr;
 }
@@ -129,11 +207,11 @@ const unsigned char* QgsFeatureRendererV2::_getPolygon( QPolygonF& pts, QList<QP
   bool hasZValue = QgsWKBTypes::hasZ(( QgsWKBTypes::Type )wkbType );
   bool hasMValue = QgsWKBTypes::hasM(( QgsWKBTypes::Type )wkbType );
 
-  double x, y;
-  holes.clear();
+  // the rings of the previous polygon are reused for the holes
+  QgsRenderArena* arena = QgsRenderArena::instance();
+  arena->recyclePolygons( holes );
 
-  const QgsCoordinateTransform* ct = context.coordinateTransform();
-  const QgsMapToPixel& mtp = context.mapToPixel();
+  QgsRenderCoordinateBuffers& buffers = _coordinateBuffers();
   const QgsRectangle& e = context.extent();
   double cw = e.width() / 10; double ch = e.height() / 10;
   QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
@@ -143,45 +221,34 @@ const unsigned char* QgsFeatureRendererV2::_getPolygon( QPolygonF& pts, QList<QP
     unsigned int nPoints;
     wkbPtr >> nPoints;
 
-    QPolygonF poly( nPoints );
-
-    // Extract the points from the WKB and store in a pair of vectors.
-    QPointF* ptr = poly.data();
-    for ( unsigned int jdx = 0; jdx < nPoints; ++jdx, ++ptr )
-    {
-      wkbPtr >> x >> y;
-      if ( hasZValue )
-        wkbPtr += sizeof( double );
-      if ( hasMValue )
-        wkbPtr += sizeof( double );
-
-      *ptr = QPointF( x, y );
-    }
+    // Extract the points from the WKB and store them in the x and y buffers.
+    QgsRectangle ringRect;
+    wkbPtr = _readCoordinates( wkbPtr, nPoints, hasZValue, hasMValue, buffers, ringRect );
 
     if ( nPoints < 1 )
       continue;
 
-    //clip close to view extent, if needed
-    QRectF ptsRect = poly.boundingRect();
-    if ( clipToExtent && !context.extent().contains( ptsRect ) ) QgsClipper::trimPolygon( poly, clipRect );
-
-    //transform the QPolygonF to screen coordinates
-    if ( ct )
-    {
-      ct->transformPolygon( poly );
-    }
-
+    if ( idx > 0 )
+      holes.append( arena->takePolygon() );
+    QPolygonF& poly = idx == 0 ? pts : holes.last();
+    int count = nPoints;
 
-    ptr = poly.data();
-    for ( int i = 0; i < poly.size(); ++i, ++ptr )
+    //clip close to view extent, if needed
+    if ( clipToExtent && !context.extent().contains( ringRect ) )
     {
-      mtp.transformInPlace( ptr->rx(), ptr->ry() );
+      poly.resize( nPoints );
+      QPointF* ptr = poly.data();
+      for ( unsigned int jdx = 0; jdx < nPoints; ++jdx, ++ptr )
+      {
+        *ptr = QPointF( buffers.x[jdx], buffers.y[jdx] );
+      }
+      QgsClipper::trimPolygon( poly, clipRect );
+      _copyToBuffers( poly, buffers );
+      count = poly.size();
     }
 
-    if ( idx == 0 )
-      pts = poly;
-    else
-      holes.append( poly );
+    //transform the points to screen coordinates
+    _transformToScreen( buffers, count, context, poly );
   }
 
   return wkbPtr;
@@ -210,6 +277,37 @@ void QgsFeatureRendererV2::copyPaintEffect( QgsFeatureRendererV2 *destRenderer )
   destRenderer->setPaintEffect( mPaintEffect->clone() );
 }
 
+void QgsFeatureRendererV2::evaluateBlockValues( QgsExpression* expression, const QgsFeatureList& features, QgsRenderContext& context )
+{
+  clearBlockValues();
+  if ( !expression )
+    return;
+
+  mBlockValues = expression->evaluateBlock( features, &context.expressionContext() );
+  for ( int i = 0; i < features.count(); ++i )
+  {
+    QgsFeatureId fid = features.at( i ).id();
+    // ids are not guaranteed to be unique, such features are evaluated one by one
+    mBlockIndex.insert( fid, mBlockIndex.contains( fid ) ? -1 : i );
+  }
+}
+
+bool QgsFeatureRendererV2::blockValue( const QgsFeature& feature, QVariant& value ) const
+{
+  int index = mBlockIndex.value( feature.id(), -1 );
+  if ( index < 0 || index >= mBlockValues.count() )
+    return false;
+
+  value = mBlockValues.at( index );
+  return true;
+}
+
+void QgsFeatureRendererV2::clearBlockValues()
+{
+  mBlockValues.clear();
+  mBlockIndex.clear();
+}
+
 
 QgsFeatureRendererV2::QgsFeatureRendererV2( QString type )
     : mType( type )
@@ -282,17 +380,24 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
 
 
   const QgsGeometry* geom = feature.constGeometry();
-  if ( !geom || !geom->geometry() )
+  if ( !geom || geom->isEmpty() )
   {
     return;
   }
 
   const QgsGeometry* segmentizedGeometry = geom;
   bool deleteSegmentizedGeometry = false;
-  context.setGeometry( geom->geometry() );
+
+  // rings of the feature are taken from the scratch pool of the thread and returned to it after drawing
+  QgsRenderArena* arena = QgsRenderArena::instance();
+
+  // Linear geometries are drawn straight from their WKB. The geometry tree is only built for
+  // curves, which have to be segmentized and whose vertices are used by marker line symbols.
+  bool curved = false;
+  context.setGeometry( 0 );
 
   //convert curve types to normal point/line/polygon ones
-  switch ( QgsWKBTypes::flatType( geom->geometry()->wkbType() ) )
+  switch ( QgsWKBTypes::flatType(( QgsWKBTypes::Type )geom->wkbType() ) )
   {
     case QgsWKBTypes::CurvePolygon:
     case QgsWKBTypes::CircularString:
@@ -300,6 +405,12 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
     case QgsWKBTypes::MultiSurface:
     case QgsWKBTypes::MultiCurve:
     {
+      if ( !geom->geometry() )
+      {
+        return;
+      }
+      curved = true;
+      context.setGeometry( geom->geometry() );
       QgsAbstractGeometryV2* g = geom->geometry()->segmentize();
       if ( !g )
       {
@@ -312,7 +423,7 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
       break;
   }
 
-  switch ( QgsWKBTypes::flatType( segmentizedGeometry->geometry()->wkbType() ) )
+  switch ( QgsWKBTypes::flatType(( QgsWKBTypes::Type )segmentizedGeometry->wkbType() ) )
   {
     case QgsWKBTypes::Point:
     {
@@ -333,9 +444,10 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
         QgsDebugMsg( "linestring can be drawn only with line symbol!" );
         break;
       }
-      QPolygonF pts;
+      QPolygonF pts = arena->takePolygon();
       _getLineString( pts, context, segmentizedGeometry->asWkb(), symbol->clipFeaturesToExtent() );
       (( QgsLineSymbolV2* )symbol )->renderPolyline( pts, &feature, context, layer, selected );
+      arena->recyclePolygon( pts );
     }
     break;
     case QgsWKBTypes::Polygon:
@@ -345,10 +457,12 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
         QgsDebugMsg( "polygon can be drawn only with fill symbol!" );
         break;
       }
-      QPolygonF pts;
+      QPolygonF pts = arena->takePolygon();
       QList<QPolygonF> holes;
       _getPolygon( pts, holes, context, segmentizedGeometry->asWkb(), symbol->clipFeaturesToExtent() );
       (( QgsFillSymbolV2* )symbol )->renderPolygon( pts, ( holes.count() ? &holes : NULL ), &feature, context, layer, selected );
+      arena->recyclePolygon( pts );
+      arena->recyclePolygons( holes );
     }
     break;
 
@@ -387,9 +501,9 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
       unsigned int num;
       wkbPtr >> num;
       const unsigned char* ptr = wkbPtr;
-      QPolygonF pts;
+      QPolygonF pts = arena->takePolygon();
 
-      const QgsGeometryCollectionV2* geomCollection = dynamic_cast<const QgsGeometryCollectionV2*>( geom->geometry() );
+      const QgsGeometryCollectionV2* geomCollection = curved ? dynamic_cast<const QgsGeometryCollectionV2*>( geom->geometry() ) : 0;
 
       for ( unsigned int i = 0; i < num; ++i )
       {
@@ -400,6 +514,7 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
         ptr = QgsConstWkbPtr( _getLineString( pts, context, ptr, symbol->clipFeaturesToExtent() ) );
         (( QgsLineSymbolV2* )symbol )->renderPolyline( pts, &feature, context, layer, selected );
       }
+      arena->recyclePolygon( pts );
     }
     break;
 
@@ -416,10 +531,10 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
       unsigned int num;
       wkbPtr >> num;
       const unsigned char* ptr = wkbPtr;
-      QPolygonF pts;
+      QPolygonF pts = arena->takePolygon();
       QList<QPolygonF> holes;
 
-      const QgsGeometryCollectionV2* geomCollection = dynamic_cast<const QgsGeometryCollectionV2*>( geom->geometry() );
+      const QgsGeometryCollectionV2* geomCollection = curved ? dynamic_cast<const QgsGeometryCollectionV2*>( geom->geometry() ) : 0;
 
       for ( unsigned int i = 0; i < num; ++i )
       {
@@ -430,6 +545,8 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
         ptr = _getPolygon( pts, holes, context, ptr, symbol->clipFeaturesToExtent() );
         (( QgsFillSymbolV2* )symbol )->renderPolygon( pts, ( holes.count() ? &holes : NULL ), &feature, context, layer, selected );
       }
+      arena->recyclePolygon( pts );
+      arena->recyclePolygons( holes );
       break;
     }
     default:
@@ -442,10 +559,10 @@ void QgsFeatureRendererV2::renderFeatureWithSymbol( QgsFeature& feature, QgsSymb
     const QgsMapToPixel& mtp = context.mapToPixel();
 
     QgsPointV2 vertexPoint;
-    QgsVertexId vertexId;
+    QgsWkbGeometryView::VertexIterator vertexIt = QgsWkbGeometryView( geom->asWkb(), geom->wkbSize() ).vertices();
     double x, y, z;
     QPointF mapPoint;
-    while ( geom->geometry()->nextVertex( vertexId, vertexPoint ) )
+    while ( vertexIt.next( vertexPoint ) )
     {
       //transform
       x = vertexPoint.x(); y = vertexPoint.y(); z = vertexPoint.z();
@@ -17,10 +17,12 @@
 #define QGSRENDERERV2_H
 
 #include "qgis.h"
+#include "qgsfeature.h"
 #include "qgsrectangle.h"
 #include "qgsrendercontext.h"
 #include "qgssymbolv2.h"
 
+#include <QHash>
 #include <QList>
 #include <QString>
 #include <QVariant>
@@ -139,6 +141,20 @@ class CORE_EXPORT QgsFeatureRendererV2
      */
     virtual QString filter() { return QString::null; }
 
+    /**
+     * Called by the vector layer renderer with a block of features before they are
+     * rendered one by one with {@link renderFeature()}, in the same order.
+     * Renderers which classify features by an expression may override this method to
+     * evaluate the expression for the whole block at once (see QgsExpression::evaluateBlock()).
+     * Must be called between startRender() and stopRender() calls.
+     * The default implementation does nothing.
+     *
+     * @param features features which will be rendered next
+     * @param context render context
+     * @note added in QGIS 2.12
+     */
+    virtual void prepareFeatureBlock( const QgsFeatureList& features, QgsRenderContext& context ) { Q_UNUSED( features ); Q_UNUSED( context ); }
+
     virtual QList<QString> usedAttributes() = 0;
 
     virtual ~QgsFeatureRendererV2();
@@ -339,6 +355,29 @@ class CORE_EXPORT QgsFeatureRendererV2
      */
     void copyPaintEffect( QgsFeatureRendererV2 *destRenderer ) const;
 
+    /** Evaluates an expression for a block of features and keeps the results
+     * until the next block or until clearBlockValues() is called.
+     * @param expression prepared expression to evaluate
+     * @param features block of features passed to prepareFeatureBlock()
+     * @param context render context
+     * @see blockValue()
+     * @note added in QGIS 2.12
+     */
+    void evaluateBlockValues( QgsExpression* expression, const QgsFeatureList& features, QgsRenderContext& context );
+
+    /** Looks up the value evaluated by evaluateBlockValues() for a feature.
+     * @param feature feature of the current block
+     * @param value will be set to the evaluated value
+     * @returns false if no value is available for the feature, e.g. because its id
+     * is not unique within the block
+     * @note added in QGIS 2.12
+     */
+    bool blockValue( const QgsFeature& feature, QVariant& value ) const;
+
+    //! Discards values evaluated by evaluateBlockValues(). Should be called from stopRender().
+    //! @note added in QGIS 2.12
+    void clearBlockValues();
+
     QString mType;
 
     bool mUsingSymbolLevels;
@@ -352,6 +391,11 @@ class CORE_EXPORT QgsFeatureRendererV2
 
     bool mForceRaster;
 
+    //! values evaluated for the current feature block
+    QVariantList mBlockValues;
+    //! index of each feature id into mBlockValues, -1 for ids occurring more than once
+    QHash<QgsFeatureId, int> mBlockIndex;
+
     /** @note this function is used to convert old sizeScale expresssions to symbol
      * level DataDefined size
      */
@@ -18,6 +18,7 @@
 #include "qgsapplication.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsconfig.h"
+#include "qgssrsdbindex.h"
 
 #include <QRegExp>
 
@@ -54,6 +55,12 @@ int main( int argc, char ** argv )
 
   CPLPopErrorHandler();
 
+  // index of the synchronized database, used by QgsCoordinateReferenceSystem instead of querying it
+  if ( !QgsSrsDbIndex::build( QgsApplication::srsDbFilePath(), QgsSrsDbIndex::indexFilePath( QgsApplication::srsDbFilePath() ) ) )
+  {
+    std::cout << "CRS database index could not be written." << std::endl;
+  }
+
   if ( res == 0 )
   {
     std::cout << "No CRS updates were necessary." << std::endl;
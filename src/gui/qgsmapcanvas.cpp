@@ -563,6 +563,11 @@ void QgsMapCanvas::setCachingEnabled( bool enabled )
   if ( enabled )
   {
     mCache = new QgsMapRendererCache;
+
+    QSettings settings;
+    mCache->setMaximumMemoryUsage( settings.value( "/qgis/render_cache_memory", mCache->maximumMemoryUsage() ).toInt() );
+    mCache->setMaximumDiskUsage( settings.value( "/qgis/render_cache_disk_size", mCache->maximumDiskUsage() ).toInt() );
+    mCache->setCacheDirectory( settings.value( "/qgis/render_cache_directory" ).toString() );
   }
   else
   {
@@ -676,6 +681,8 @@ void QgsMapCanvas::refreshMap()
     mJob = new QgsMapRendererSequentialJob( mSettings );
   connect( mJob, SIGNAL( finished() ), SLOT( rendererJobFinished() ) );
   mJob->setCache( mCache );
+  // labels stay where they were in the previous frame unless they collide
+  mJob->setPreviousLabelingResults( mLabelingResults );
 
   QStringList layersForGeometryCache;
   Q_FOREACH ( const QString& id, mSettings.layers() )
@@ -2003,6 +2010,8 @@ void QgsMapCanvas::refreshAllLayers()
 
   // clear the cache
   clearCache();
+  if ( mCache )
+    mCache->clearDiskCache();
 
   // and then refresh
   refresh();
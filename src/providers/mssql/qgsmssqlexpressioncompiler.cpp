@@ -0,0 +1,86 @@
+/***************************************************************************
+                       qgsmssqlexpressioncompiler.cpp
+                       ------------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmssqlexpressioncompiler.h"
+
+QgsMssqlExpressionCompiler::QgsMssqlExpressionCompiler( QgsMssqlFeatureSource* source )
+    : QgsSqlExpressionCompiler( source->mFields, QgsSqlExpressionCompiler::CaseInsensitiveStringMatch
+                                | QgsSqlExpressionCompiler::LikeIsCaseInsensitive )
+{
+}
+
+QString QgsMssqlExpressionCompiler::quotedIdentifier( const QString& identifier )
+{
+  QString quoted = identifier;
+  quoted.replace( "]", "]]" );
+  return quoted.prepend( '[' ).append( ']' );
+}
+
+QString QgsMssqlExpressionCompiler::quotedValue( const QVariant& value, bool& ok )
+{
+  if ( value.isNull() )
+  {
+    ok = true;
+    return "NULL";
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Bool:
+      // there are no boolean literals in Transact-SQL
+      ok = false;
+      return QString();
+
+    case QVariant::String:
+    {
+      // unicode string literal
+      ok = true;
+      QString v = value.toString();
+      v.replace( '\'', "''" );
+      return v.prepend( "N'" ).append( '\'' );
+    }
+
+    default:
+      return QgsSqlExpressionCompiler::quotedValue( value, ok );
+  }
+}
+
+QgsSqlExpressionCompiler::Result QgsMssqlExpressionCompiler::compileNode( const QgsExpression::Node* node, QString& result )
+{
+  if ( node->nodeType() == QgsExpression::ntBinaryOperator )
+  {
+    const QgsExpression::NodeBinaryOperator* n = static_cast<const QgsExpression::NodeBinaryOperator*>( node );
+    switch ( n->op() )
+    {
+      case QgsExpression::boConcat:
+        // strings are concatenated with +, which fails for numbers
+        return Fail;
+
+      case QgsExpression::boLike:
+      case QgsExpression::boNotLike:
+      case QgsExpression::boILike:
+      case QgsExpression::boNotILike:
+        // brackets start character ranges in Transact-SQL patterns
+        if ( n->opRight()->nodeType() != QgsExpression::ntLiteral ||
+             static_cast<const QgsExpression::NodeLiteral*>( n->opRight() )->value().toString().contains( '[' ) )
+          return Fail;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return QgsSqlExpressionCompiler::compileNode( node, result );
+}
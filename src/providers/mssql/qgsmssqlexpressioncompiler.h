@@ -0,0 +1,36 @@
+/***************************************************************************
+                        qgsmssqlexpressioncompiler.h
+                        ----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSMSSQLEXPRESSIONCOMPILER_H
+#define QGSMSSQLEXPRESSIONCOMPILER_H
+
+#include "qgssqlexpressioncompiler.h"
+#include "qgsmssqlfeatureiterator.h"
+
+/** Translates expressions to Transact-SQL. The default collations of SQL Server
+ * compare strings and LIKE patterns case insensitively.
+ */
+class QgsMssqlExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+
+    explicit QgsMssqlExpressionCompiler( QgsMssqlFeatureSource* source );
+
+  protected:
+    virtual QString quotedIdentifier( const QString& identifier ) override;
+    virtual QString quotedValue( const QVariant& value, bool& ok ) override;
+    virtual Result compileNode( const QgsExpression::Node* node, QString& str ) override;
+};
+
+#endif // QGSMSSQLEXPRESSIONCOMPILER_H
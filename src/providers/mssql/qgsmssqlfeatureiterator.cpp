@@ -16,16 +16,19 @@
  ***************************************************************************/
 
 #include "qgsmssqlfeatureiterator.h"
+#include "qgsmssqlexpressioncompiler.h"
 #include "qgsmssqlprovider.h"
 #include "qgslogger.h"
 
 #include <QObject>
 #include <QTextStream>
+#include <QSettings>
 #include <QSqlRecord>
 
 
 QgsMssqlFeatureIterator::QgsMssqlFeatureIterator( QgsMssqlFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsMssqlFeatureSource>( source, ownSource, request )
+    , mExpressionCompiled( false )
 {
   mClosed = false;
   mQuery = NULL;
@@ -121,6 +124,26 @@ void QgsMssqlFeatureIterator::BuildStatement( const QgsFeatureRequest& request )
     mStatement += fidfilter;
     filterAdded = true;
   }
+  else if ( request.filterType() == QgsFeatureRequest::FilterExpression
+            && QgsSqlExpressionCompiler::isEnabled() )
+  {
+    QgsMssqlExpressionCompiler compiler( mSource );
+
+    QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      if ( !filterAdded )
+        mStatement += " WHERE ";
+      else
+        mStatement += " AND ";
+
+      mStatement += compiler.result();
+      filterAdded = true;
+
+      //if only partial success when compiling expression, we need to double-check results using QGIS' expressions
+      mExpressionCompiled = ( result == QgsSqlExpressionCompiler::Complete );
+    }
+  }
 
   if ( !mSource->mSqlWhereClause.isEmpty() )
   {
@@ -184,6 +207,14 @@ bool QgsMssqlFeatureIterator::fetchFeature( QgsFeature& feature )
 }
 
 
+bool QgsMssqlFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
+{
+  if ( !mExpressionCompiled )
+    return QgsAbstractFeatureIterator::nextFeatureFilterExpression( f );
+  else
+    return fetchFeature( f );
+}
+
 bool QgsMssqlFeatureIterator::rewind()
 {
   if ( mClosed )
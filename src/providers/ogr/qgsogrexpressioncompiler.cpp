@@ -0,0 +1,55 @@
+/***************************************************************************
+                        qgsogrexpressioncompiler.cpp
+                        ----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsogrexpressioncompiler.h"
+
+QgsOgrExpressionCompiler::QgsOgrExpressionCompiler( QgsOgrFeatureSource* source )
+    : QgsSqlExpressionCompiler( source->mFields, QgsSqlExpressionCompiler::CaseInsensitiveStringMatch
+                                | QgsSqlExpressionCompiler::LikeIsCaseInsensitive
+                                | QgsSqlExpressionCompiler::NoUnaryMinus )
+{
+}
+
+QString QgsOgrExpressionCompiler::quotedValue( const QVariant& value, bool& ok )
+{
+  if ( !value.isNull() && value.type() == QVariant::Bool )
+  {
+    // OGR SQL has no boolean literals
+    ok = false;
+    return QString();
+  }
+
+  return QgsSqlExpressionCompiler::quotedValue( value, ok );
+}
+
+QgsSqlExpressionCompiler::Result QgsOgrExpressionCompiler::compileNode( const QgsExpression::Node* node, QString& result )
+{
+  if ( node->nodeType() == QgsExpression::ntBinaryOperator )
+  {
+    switch ( static_cast<const QgsExpression::NodeBinaryOperator*>( node )->op() )
+    {
+      case QgsExpression::boPlus:
+      case QgsExpression::boMinus:
+      case QgsExpression::boMul:
+      case QgsExpression::boMod:
+      case QgsExpression::boConcat:
+        return Fail;
+
+      default:
+        break;
+    }
+  }
+
+  return QgsSqlExpressionCompiler::compileNode( node, result );
+}
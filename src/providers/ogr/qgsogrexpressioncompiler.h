@@ -0,0 +1,36 @@
+/***************************************************************************
+                         qgsogrexpressioncompiler.h
+                         --------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSOGREXPRESSIONCOMPILER_H
+#define QGSOGREXPRESSIONCOMPILER_H
+
+#include "qgssqlexpressioncompiler.h"
+#include "qgsogrfeatureiterator.h"
+
+/** Translates expressions to OGR SQL attribute filters, which are evaluated by OGR itself.
+ * OGR SQL compares strings and LIKE patterns case insensitively and has no reliable
+ * support for arithmetic or string concatenation.
+ */
+class QgsOgrExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+
+    explicit QgsOgrExpressionCompiler( QgsOgrFeatureSource* source );
+
+  protected:
+    virtual QString quotedValue( const QVariant& value, bool& ok ) override;
+    virtual Result compileNode( const QgsExpression::Node* node, QString& str ) override;
+};
+
+#endif // QGSOGREXPRESSIONCOMPILER_H
@@ -15,7 +15,9 @@
 #include "qgsogrfeatureiterator.h"
 
 #include "qgsogrprovider.h"
+#include "qgsogrexpressioncompiler.h"
 #include "qgsogrgeometrysimplifier.h"
+#include "qgssqliteexpressioncompiler.h"
 
 #include "qgsapplication.h"
 #include "qgsgeometry.h"
@@ -24,6 +26,8 @@
 
 #include <QTextCodec>
 #include <QFile>
+#include <QScopedPointer>
+#include <QSettings>
 
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
@@ -37,6 +41,8 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource* source, bool
     : QgsAbstractFeatureIteratorFromSource<QgsOgrFeatureSource>( source, ownSource, request )
     , ogrLayer( 0 )
     , mSubsetStringSet( false )
+    , mAttributeFilterSet( false )
+    , mExpressionCompiled( false )
     , mGeometrySimplifier( NULL )
 {
   mFeatureFetched = false;
@@ -82,6 +88,39 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource* source, bool
     OGR_L_SetSpatialFilter( ogrLayer, 0 );
   }
 
+  // attribute filters on SQL result layers are not necessarily evaluated in the same dialect
+  if ( request.filterType() == QgsFeatureRequest::FilterExpression && !mSubsetStringSet
+       && QgsSqlExpressionCompiler::isEnabled() )
+  {
+    QScopedPointer<QgsSqlExpressionCompiler> compiler;
+    if ( mSource->mDriverName == "SQLite" || mSource->mDriverName == "GPKG" )
+    {
+      // these drivers hand attribute filters to SQLite
+      compiler.reset( new QgsSQLiteExpressionCompiler( mSource->mFields ) );
+    }
+    else if ( !( QStringList() << "PostgreSQL" << "MySQL" << "OCI" << "ODBC" << "PGeo" << "MSSQLSpatial" << "WFS" << "CartoDB" << "GFT" ).contains( mSource->mDriverName ) )
+    {
+      // drivers which do not forward attribute filters to a database or web service evaluate OGR SQL
+      compiler.reset( new QgsOgrExpressionCompiler( mSource ) );
+    }
+
+    QgsSqlExpressionCompiler::Result result = compiler ? compiler->compile( request.filterExpression() ) : QgsSqlExpressionCompiler::Fail;
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      if ( OGR_L_SetAttributeFilter( ogrLayer, mSource->mEncoding->fromUnicode( compiler->result() ).constData() ) == OGRERR_NONE )
+      {
+        //if only partial success when compiling expression, we need to double-check results using QGIS' expressions
+        mExpressionCompiled = ( result == QgsSqlExpressionCompiler::Complete );
+        mAttributeFilterSet = true;
+      }
+      else
+      {
+        QgsDebugMsg( QString( "Setting attribute filter %1 failed" ).arg( compiler->result() ) );
+        OGR_L_SetAttributeFilter( ogrLayer, 0 );
+      }
+    }
+  }
+
   //start with first feature
   rewind();
 }
@@ -194,6 +233,14 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature& feature )
 }
 
 
+bool QgsOgrFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
+{
+  if ( !mExpressionCompiled )
+    return QgsAbstractFeatureIterator::nextFeatureFilterExpression( f );
+  else
+    return fetchFeature( f );
+}
+
 bool QgsOgrFeatureIterator::rewind()
 {
   if ( mClosed )
@@ -216,6 +263,11 @@ bool QgsOgrFeatureIterator::close()
   {
     OGR_DS_ReleaseResultSet( mConn->ds, ogrLayer );
   }
+  else if ( mAttributeFilterSet )
+  {
+    // the layer is shared with later users of the pooled connection
+    OGR_L_SetAttributeFilter( ogrLayer, 0 );
+  }
 
   QgsOgrConnPool::instance()->releaseConnection( mConn );
   mConn = 0;
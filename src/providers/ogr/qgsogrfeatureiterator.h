@@ -43,6 +43,7 @@ class QgsOgrFeatureSource : public QgsAbstractFeatureSource
     QString mDriverName;
 
     friend class QgsOgrFeatureIterator;
+    friend class QgsOgrExpressionCompiler;
 };
 
 class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgrFeatureSource>
@@ -62,6 +63,9 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
     //! fetch next feature, return true on success
     virtual bool fetchFeature( QgsFeature& feature ) override;
 
+    //! fetch next feature filter expression
+    bool nextFeatureFilterExpression( QgsFeature& f ) override;
+
     //! Setup the simplification of geometries to fetch using the specified simplify method
     virtual bool prepareSimplification( const QgsSimplifyMethod& simplifyMethod ) override;
 
@@ -78,6 +82,12 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
 
     bool mSubsetStringSet;
 
+    //! Set to true, if a compiled filter expression was set as attribute filter of the layer
+    bool mAttributeFilterSet;
+
+    //! Set to true, if the attribute filter completely evaluates the filter expression
+    bool mExpressionCompiled;
+
     //! Set to true, if geometry is in the requested columns
     bool mFetchGeometry;
 
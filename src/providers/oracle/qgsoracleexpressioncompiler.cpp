@@ -0,0 +1,58 @@
+/***************************************************************************
+                      qgsoracleexpressioncompiler.cpp
+                      -------------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsoracleexpressioncompiler.h"
+#include "qgsoracleconn.h"
+
+QgsOracleExpressionCompiler::QgsOracleExpressionCompiler( QgsOracleFeatureSource* source )
+    : QgsSqlExpressionCompiler( source->mFields )
+{
+}
+
+QString QgsOracleExpressionCompiler::quotedIdentifier( const QString& identifier )
+{
+  return QgsOracleConn::quotedIdentifier( identifier );
+}
+
+QString QgsOracleExpressionCompiler::quotedValue( const QVariant& value, bool& ok )
+{
+  if ( !value.isNull() && ( value.type() == QVariant::Bool ||
+                            ( value.type() == QVariant::String && value.toString().isEmpty() ) ) )
+  {
+    // no boolean literals, and empty strings would be compared as NULL
+    ok = false;
+    return QString();
+  }
+
+  return QgsSqlExpressionCompiler::quotedValue( value, ok );
+}
+
+QgsSqlExpressionCompiler::Result QgsOracleExpressionCompiler::compileNode( const QgsExpression::Node* node, QString& result )
+{
+  if ( node->nodeType() == QgsExpression::ntBinaryOperator )
+  {
+    switch ( static_cast<const QgsExpression::NodeBinaryOperator*>( node )->op() )
+    {
+      case QgsExpression::boMod:
+      case QgsExpression::boConcat:
+        // no % operator, and || treats NULL as an empty string
+        return Fail;
+
+      default:
+        break;
+    }
+  }
+
+  return QgsSqlExpressionCompiler::compileNode( node, result );
+}
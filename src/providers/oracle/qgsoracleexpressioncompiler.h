@@ -0,0 +1,36 @@
+/***************************************************************************
+                       qgsoracleexpressioncompiler.h
+                       -----------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSORACLEEXPRESSIONCOMPILER_H
+#define QGSORACLEEXPRESSIONCOMPILER_H
+
+#include "qgssqlexpressioncompiler.h"
+#include "qgsoraclefeatureiterator.h"
+
+/** Translates expressions to Oracle SQL. Oracle treats empty strings as NULL
+ * and has neither boolean literals nor a modulo operator.
+ */
+class QgsOracleExpressionCompiler : public QgsSqlExpressionCompiler
+{
+  public:
+
+    explicit QgsOracleExpressionCompiler( QgsOracleFeatureSource* source );
+
+  protected:
+    virtual QString quotedIdentifier( const QString& identifier ) override;
+    virtual QString quotedValue( const QVariant& value, bool& ok ) override;
+    virtual Result compileNode( const QgsExpression::Node* node, QString& str ) override;
+};
+
+#endif // QGSORACLEEXPRESSIONCOMPILER_H
@@ -14,6 +14,7 @@
  ***************************************************************************/
 
 #include "qgsoraclefeatureiterator.h"
+#include "qgsoracleexpressioncompiler.h"
 #include "qgsoracleprovider.h"
 
 #include "qgslogger.h"
@@ -21,10 +22,12 @@
 #include "qgsgeometry.h"
 
 #include <QObject>
+#include <QSettings>
 
 QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleFeatureSource* source, bool ownSource, const QgsFeatureRequest &request )
     : QgsAbstractFeatureIteratorFromSource<QgsOracleFeatureSource>( source, ownSource, request )
     , mRewind( false )
+    , mExpressionCompiled( false )
 {
   mConnection = QgsOracleConn::connectDb( mSource->mUri.connectionInfo() );
   if ( !mConnection )
@@ -89,6 +92,19 @@ QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleFeatureSource* sour
       break;
 
     case QgsFeatureRequest::FilterExpression:
+      if ( QgsSqlExpressionCompiler::isEnabled() )
+      {
+        QgsOracleExpressionCompiler compiler( mSource );
+
+        QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+        if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+        {
+          whereClause = QgsOracleUtils::andWhereClauses( whereClause, compiler.result() );
+
+          //if only partial success when compiling expression, we need to double-check results using QGIS' expressions
+          mExpressionCompiled = ( result == QgsSqlExpressionCompiler::Complete );
+        }
+      }
       break;
 
     case QgsFeatureRequest::FilterRect:
@@ -242,6 +258,14 @@ bool QgsOracleFeatureIterator::fetchFeature( QgsFeature& feature )
   }
 }
 
+bool QgsOracleFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
+{
+  if ( !mExpressionCompiled )
+    return QgsAbstractFeatureIterator::nextFeatureFilterExpression( f );
+  else
+    return fetchFeature( f );
+}
+
 bool QgsOracleFeatureIterator::rewind()
 {
   if ( !mQry.isActive() )
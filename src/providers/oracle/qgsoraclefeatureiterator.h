@@ -52,6 +52,7 @@ class QgsOracleFeatureSource : public QgsAbstractFeatureSource
     QSharedPointer<QgsOracleSharedData> mShared;
 
     friend class QgsOracleFeatureIterator;
+    friend class QgsOracleExpressionCompiler;
 };
 
 
@@ -72,12 +73,18 @@ class QgsOracleFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     //! fetch next feature, return true on success
     virtual bool fetchFeature( QgsFeature& feature );
 
+    //! fetch next feature filter expression
+    bool nextFeatureFilterExpression( QgsFeature& f );
+
     bool openQuery( QString whereClause );
 
     QgsOracleConn *mConnection;
     QSqlQuery mQry;
     bool mRewind;
     QgsAttributeList mAttributeList;
+
+    //! Set to true, if the filter expression was completely compiled to the WHERE clause
+    bool mExpressionCompiled;
 };
 
 #endif // QGSORACLEFEATUREITERATOR_H
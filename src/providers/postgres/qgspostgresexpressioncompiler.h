@@ -16,33 +16,19 @@
 #ifndef QGSPOSTGRESEXPRESSIONCOMPILER_H
 #define QGSPOSTGRESEXPRESSIONCOMPILER_H
 
-#include "qgsexpression.h"
+#include "qgssqlexpressioncompiler.h"
 #include "qgspostgresfeatureiterator.h"
 
-class QgsPostgresExpressionCompiler
+class QgsPostgresExpressionCompiler : public QgsSqlExpressionCompiler
 {
   public:
-    enum Result
-    {
-      None,
-      Complete,
-      Partial,
-      Fail
-    };
 
     explicit QgsPostgresExpressionCompiler( QgsPostgresFeatureSource* source );
-    ~QgsPostgresExpressionCompiler();
 
-    Result compile( const QgsExpression* exp );
-
-    const QString& result() { return mResult; }
-
-  private:
-    Result compile( const QgsExpression::Node* node, QString& str );
-
-  private:
-    QString mResult;
-    QgsPostgresFeatureSource* mSource;
+  protected:
+    virtual QString quotedIdentifier( const QString& identifier ) override;
+    virtual QString quotedValue( const QVariant& value, bool& ok ) override;
+    virtual Result compileNode( const QgsExpression::Node* node, QString& str ) override;
 };
 
 #endif // QGSPOSTGRESEXPRESSIONCOMPILER_H
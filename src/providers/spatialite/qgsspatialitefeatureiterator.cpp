@@ -20,12 +20,16 @@
 
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
+#include "qgssqliteexpressioncompiler.h"
+
+#include <QSettings>
 
 
 
 QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsSpatiaLiteFeatureSource>( source, ownSource, request )
     , sqliteStatement( NULL )
+    , mExpressionCompiled( false )
 {
 
   mHandle = QgsSpatiaLiteConnPool::instance()->acquireConnection( mSource->mSqlitePath );
@@ -49,6 +53,24 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
   {
     whereClause += whereClauseFids();
   }
+  else if ( request.filterType() == QgsFeatureRequest::FilterExpression
+            && QgsSqlExpressionCompiler::isEnabled() )
+  {
+    QgsSQLiteExpressionCompiler compiler( mSource->mFields );
+
+    QgsSqlExpressionCompiler::Result result = compiler.compile( request.filterExpression() );
+    if ( result == QgsSqlExpressionCompiler::Complete || result == QgsSqlExpressionCompiler::Partial )
+    {
+      if ( !whereClause.isEmpty() )
+      {
+        whereClause += " AND ";
+      }
+      whereClause += compiler.result();
+
+      //if only partial success when compiling expression, we need to double-check results using QGIS' expressions
+      mExpressionCompiled = ( result == QgsSqlExpressionCompiler::Complete );
+    }
+  }
 
   if ( !mSource->mSubsetString.isEmpty() )
   {
@@ -102,6 +124,14 @@ bool QgsSpatiaLiteFeatureIterator::fetchFeature( QgsFeature& feature )
 }
 
 
+bool QgsSpatiaLiteFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
+{
+  if ( !mExpressionCompiled )
+    return QgsAbstractFeatureIterator::nextFeatureFilterExpression( f );
+  else
+    return fetchFeature( f );
+}
+
 bool QgsSpatiaLiteFeatureIterator::rewind()
 {
   if ( mClosed )
@@ -69,6 +69,9 @@ class QgsSpatiaLiteFeatureIterator : public QgsAbstractFeatureIteratorFromSource
     //! fetch next feature, return true on success
     virtual bool fetchFeature( QgsFeature& feature ) override;
 
+    //! fetch next feature filter expression
+    bool nextFeatureFilterExpression( QgsFeature& f ) override;
+
     QString whereClauseRect();
     QString whereClauseFid();
     QString whereClauseFids();
@@ -96,6 +99,9 @@ class QgsSpatiaLiteFeatureIterator : public QgsAbstractFeatureIteratorFromSource
 
     bool mHasPrimaryKey;
     QgsFeatureId mRowNumber;
+
+    //! Set to true, if the filter expression was completely compiled to the WHERE clause
+    bool mExpressionCompiled;
 };
 
 #endif // QGSSPATIALITEFEATUREITERATOR_H
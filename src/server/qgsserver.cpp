@@ -25,6 +25,7 @@
 #include "qgscapabilitiescache.h"
 #include "qgsfontutils.h"
 #include "qgsgetrequesthandler.h"
+#include "qgslabelspritecache.h"
 #include "qgspostrequesthandler.h"
 #include "qgssoaprequesthandler.h"
 #include "qgsproviderregistry.h"
@@ -49,6 +50,16 @@
 #include <fcgi_stdio.h>
 #include <stdlib.h>
 
+#ifndef Q_OS_WIN
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 
 // Static initialisers, default values for fcgi server
 QgsApplication* QgsServer::mQgsApplication = NULL;
@@ -102,6 +113,104 @@ void QgsServer::setupNetworkAccessManager()
   nam->setCache( cache );
 }
 
+#ifndef Q_OS_WIN
+static volatile sig_atomic_t sTerminateWorkerPool = 0;
+
+static void terminateWorkerPool( int signal )
+{
+  Q_UNUSED( signal );
+  sTerminateWorkerPool = 1;
+}
+#endif
+
+/**
+ * @brief QgsServer::startWorkerPool forks QGIS_SERVER_WORKERS worker processes
+ * accepting requests on the shared FastCGI socket. Requests are handled by processes
+ * rather than threads, because request handling uses process-global state (getenv,
+ * the fcgi_stdio streams and QgsProject::instance()). The workers are forked after the
+ * application and the providers are initialised, which saves repeating it in every worker.
+ * Nothing is shared between the workers afterwards: each one has its own project, layer
+ * and capabilities caches, network access and python plugins. The parent process restarts
+ * workers which exit and terminates the workers when it gets SIGTERM or SIGINT.
+ */
+void QgsServer::startWorkerPool()
+{
+#ifndef Q_OS_WIN
+  if ( mCaptureOutput || FCGX_IsCGI() )
+  {
+    return;
+  }
+
+  bool conversionOk = false;
+  int workerCount = QString( getenv( "QGIS_SERVER_WORKERS" ) ).toInt( &conversionOk );
+  if ( !conversionOk || workerCount < 2 )
+  {
+    return;
+  }
+
+  if ( getenv( "DISPLAY" ) )
+  {
+    // the connection to the X server cannot be shared by several processes
+    fprintf( FCGI_stderr, "QGIS_SERVER_WORKERS ignored: DISPLAY is set\n" );
+    return;
+  }
+
+  struct sigaction terminateAction;
+  memset( &terminateAction, 0, sizeof( terminateAction ) );
+  terminateAction.sa_handler = terminateWorkerPool;
+  sigemptyset( &terminateAction.sa_mask );
+  sigaction( SIGTERM, &terminateAction, NULL );
+  sigaction( SIGINT, &terminateAction, NULL );
+
+  QHash<pid_t, time_t> workers; // pid and start time
+  while ( !sTerminateWorkerPool )
+  {
+    while ( workers.size() < workerCount && !sTerminateWorkerPool )
+    {
+      pid_t pid = fork();
+      if ( pid == 0 )
+      {
+        // worker: continue with the initialisation and handle requests
+        signal( SIGTERM, SIG_DFL );
+        signal( SIGINT, SIG_DFL );
+        return;
+      }
+      if ( pid < 0 )
+      {
+        fprintf( FCGI_stderr, "Could not fork worker process: %s\n", strerror( errno ) );
+        sleep( 1 );
+        break;
+      }
+      workers.insert( pid, time( NULL ) );
+    }
+
+    int status;
+    pid_t pid = waitpid( -1, &status, 0 );
+    if ( pid > 0 && workers.contains( pid ) )
+    {
+      // avoid a fork loop if workers fail right after the start
+      if ( time( NULL ) - workers.take( pid ) < 1 )
+      {
+        sleep( 1 );
+      }
+    }
+    else if ( pid < 0 && errno == ECHILD )
+    {
+      workers.clear();
+    }
+  }
+
+  Q_FOREACH ( pid_t pid, workers.keys() )
+  {
+    kill( pid, SIGTERM );
+  }
+  while ( waitpid( -1, NULL, 0 ) > 0 || errno == EINTR )
+  {
+  }
+  exit( 0 );
+#endif
+}
+
 /**
  * @brief QgsServer::createRequestHandler factory, creates a request instance
  * @param captureOutput
@@ -341,7 +450,6 @@ bool QgsServer::init( int & argc, char ** argv )
   QgsApplication::skipGdalDriver( "JP2ECW" );
 #endif
 
-  setupNetworkAccessManager();
   QDomImplementation::setInvalidDataPolicy( QDomImplementation::DropInvalidChars );
 
   // Instantiate the plugin directory so that providers are loaded
@@ -354,6 +462,19 @@ bool QgsServer::init( int & argc, char ** argv )
 
   QgsApplication::createDB(); //init qgis.db (e.g. necessary for user crs)
 
+  // rendered labels are cached if a size in megabytes is given
+  bool conversionOk = false;
+  int labelSpriteCacheSize = QString( getenv( "QGIS_SERVER_LABEL_CACHE_SIZE" ) ).toInt( &conversionOk );
+  if ( conversionOk && labelSpriteCacheSize > 0 )
+  {
+    QgsLabelSpriteCache::instance()->setMaxBytes( qMin( labelSpriteCacheSize, 1024 ) * 1024 * 1024 );
+  }
+
+  // everything created from here on, including the caches, is private to each worker process
+  startWorkerPool();
+
+  setupNetworkAccessManager();
+
   QString defaultConfigFilePath;
   QFileInfo projectFileInfo = defaultProjectFile(); //try to find a .qgs file in the server directory
   if ( projectFileInfo.exists() )
@@ -95,6 +95,9 @@ class SERVER_EXPORT QgsServer
     static QFileInfo defaultProjectFile();
     static QFileInfo defaultAdminSLD();
     static void setupNetworkAccessManager();
+    //! Forks the pool of worker processes if requested by QGIS_SERVER_WORKERS. The workers do not share caches.
+    //! Returns in the workers only, the parent process supervises the pool until it is terminated
+    static void startWorkerPool();
     //! Create and return a request handler instance
     static QgsRequestHandler* createRequestHandler(
       const bool captureOutput = FALSE );
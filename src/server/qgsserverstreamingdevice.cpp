@@ -16,17 +16,21 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsserverstreamingdevice.h"
 #include "qgsrequesthandler.h"
 
-QgsServerStreamingDevice::QgsServerStreamingDevice( const QString& formatName, QgsRequestHandler* rh, QObject* parent ): QIODevice( parent ), mFormatName( formatName ), mRequestHandler( rh )
+QgsServerStreamingDevice::QgsServerStreamingDevice( const QString& formatName, QgsRequestHandler* rh, QObject* parent, int chunkSize ): QIODevice( parent ), mFormatName( formatName ), mRequestHandler( rh ), mChunkSize( chunkSize )
 {
 }
 
-QgsServerStreamingDevice::QgsServerStreamingDevice(): QIODevice( 0 ), mRequestHandler( 0 )
+QgsServerStreamingDevice::QgsServerStreamingDevice(): QIODevice( 0 ), mRequestHandler( 0 ), mChunkSize( 0 )
 {
 
 }
 
 QgsServerStreamingDevice::~QgsServerStreamingDevice()
 {
+  if ( isOpen() )
+  {
+    close();
+  }
 }
 
 bool QgsServerStreamingDevice::open( OpenMode mode )
@@ -43,13 +47,28 @@ bool QgsServerStreamingDevice::open( OpenMode mode )
 
 void QgsServerStreamingDevice::close()
 {
+  flush();
   QIODevice::close();
 }
 
+void QgsServerStreamingDevice::flush()
+{
+  if ( mBuffer.isEmpty() || !mRequestHandler )
+  {
+    return;
+  }
+
+  mRequestHandler->setGetFeatureResponse( &mBuffer );
+  mBuffer.clear();
+}
+
 qint64 QgsServerStreamingDevice::writeData( const char * data, qint64 maxSize )
 {
-  QByteArray ba( data, maxSize );
-  mRequestHandler->setGetFeatureResponse( &ba );
+  mBuffer.append( data, maxSize );
+  if ( mBuffer.size() >= mChunkSize )
+  {
+    flush();
+  }
   return maxSize;
 }
 
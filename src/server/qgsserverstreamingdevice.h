@@ -20,10 +20,15 @@ email                : marco.hugentobler at sourcepole dot com
 
 class QgsRequestHandler;
 
+/** Write only device sending the written data to the client as it is produced.
+ * Data is collected into chunks of chunkSize bytes before it is passed to the request handler,
+ * so that many small writes do not result in many small responses. The remaining data
+ * is sent when the device is closed or destroyed.
+ */
 class QgsServerStreamingDevice: public QIODevice
 {
   public:
-    QgsServerStreamingDevice( const QString& formatName, QgsRequestHandler* rh, QObject* parent = 0 );
+    QgsServerStreamingDevice( const QString& formatName, QgsRequestHandler* rh, QObject* parent = 0, int chunkSize = 65536 );
     ~QgsServerStreamingDevice();
 
     bool isSequential() const override { return false; }
@@ -31,9 +36,14 @@ class QgsServerStreamingDevice: public QIODevice
     bool open( OpenMode mode ) override;
     void close() override;
 
+    /** Sends the data collected so far to the client*/
+    void flush();
+
   protected:
     QString mFormatName;
     QgsRequestHandler* mRequestHandler;
+    QByteArray mBuffer;
+    int mChunkSize;
 
     QgsServerStreamingDevice(); //default constructor forbidden
 
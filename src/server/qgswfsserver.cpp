@@ -37,6 +37,7 @@
 #include "qgslegendmodel.h"
 #include "qgscomposerlegenditem.h"
 #include "qgsrequesthandler.h"
+#include "qgsserverstreamingdevice.h"
 #include "qgsogcutils.h"
 
 #include <QImage>
@@ -53,6 +54,7 @@
 #include <QSvgGenerator>
 #include <QUrl>
 #include <QPaintEngine>
+#include <QXmlStreamWriter>
 
 #ifndef Q_OS_WIN
 #include <netinet/in.h>
@@ -70,6 +72,8 @@ QgsWFSServer::QgsWFSServer( const QString& configFilePath, QMap<QString, QString
     : QgsOWSServer( configFilePath, parameters, rh )
     , mWithGeom( true )
     , mConfigParser( cp )
+    , mStreamingDevice( 0 )
+    , mXmlWriter( 0 )
 {
 }
 
@@ -77,11 +81,15 @@ QgsWFSServer::QgsWFSServer()
     : QgsOWSServer( QString(), QMap<QString, QString>(), 0 )
     , mWithGeom( true )
     , mConfigParser( 0 )
+    , mStreamingDevice( 0 )
+    , mXmlWriter( 0 )
 {
 }
 
 QgsWFSServer::~QgsWFSServer()
 {
+  delete mXmlWriter;
+  delete mStreamingDevice;
 }
 
 void QgsWFSServer::executeRequest()
@@ -1102,15 +1110,23 @@ int QgsWFSServer::getFeature( QgsRequestHandler& request, const QString& format
 
 void QgsWFSServer::startGetFeature( QgsRequestHandler& request, const QString& format, int prec, QgsCoordinateReferenceSystem& crs, QgsRectangle* rect )
 {
-  QByteArray result;
+  //features are serialised directly to the output device, which sends them in chunks
+  delete mXmlWriter;
+  mXmlWriter = 0;
+  delete mStreamingDevice;
+  mStreamingDevice = new QgsServerStreamingDevice( format == "GeoJSON" ? "text/plain; charset=utf-8" : "text/xml; charset=utf-8", &request );
+  if ( !mStreamingDevice->open( QIODevice::WriteOnly ) )
+  {
+    throw QgsMapServiceException( "Internal server error", "Error opening output device for writing" );
+  }
+
   QString fcString;
   if ( format == "GeoJSON" )
   {
     fcString = "{\"type\": \"FeatureCollection\",\n";
     fcString += " \"bbox\": [ " + qgsDoubleToString( rect->xMinimum(), prec ) + ", " + qgsDoubleToString( rect->yMinimum(), prec ) + ", " + qgsDoubleToString( rect->xMaximum(), prec ) + ", " + qgsDoubleToString( rect->yMaximum(), prec ) + "],\n";
     fcString += " \"features\": [\n";
-    result = fcString.toUtf8();
-    request.startGetFeatureResponse( &result, format );
+    mStreamingDevice->write( fcString.toUtf8() );
   }
   else
   {
@@ -1183,59 +1199,40 @@ void QgsWFSServer::startGetFeature( QgsRequestHandler& request, const QString& f
     hrefString = mapUrl.toString();
 
     //wfs:FeatureCollection valid
-    fcString = "<wfs:FeatureCollection";
-    fcString += " xmlns:wfs=\"" + WFS_NAMESPACE + "\"";
-    fcString += " xmlns:ogc=\"" + OGC_NAMESPACE + "\"";
-    fcString += " xmlns:gml=\"" + GML_NAMESPACE + "\"";
-    fcString += " xmlns:ows=\"http://www.opengis.net/ows\"";
-    fcString += " xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
-    fcString += " xmlns:qgs=\"" + QGS_NAMESPACE + "\"";
-    fcString += " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"";
-    fcString += " xsi:schemaLocation=\"" + WFS_NAMESPACE + " http://schemas.opengis.net/wfs/1.0.0/wfs.xsd " + QGS_NAMESPACE + " " + hrefString.replace( "&", "&amp;" ) + "\"";
-    fcString += ">";
-    result = fcString.toUtf8();
-    request.startGetFeatureResponse( &result, format );
-
-    QDomDocument doc;
-    QDomElement bbElem = doc.createElement( "gml:boundedBy" );
-    if ( format == "GML3" )
+    mXmlWriter = new QXmlStreamWriter( mStreamingDevice );
+    mXmlWriter->writeStartElement( "wfs:FeatureCollection" );
+    mXmlWriter->writeAttribute( "xmlns:wfs", WFS_NAMESPACE );
+    mXmlWriter->writeAttribute( "xmlns:ogc", OGC_NAMESPACE );
+    mXmlWriter->writeAttribute( "xmlns:gml", GML_NAMESPACE );
+    mXmlWriter->writeAttribute( "xmlns:ows", "http://www.opengis.net/ows" );
+    mXmlWriter->writeAttribute( "xmlns:xlink", "http://www.w3.org/1999/xlink" );
+    mXmlWriter->writeAttribute( "xmlns:qgs", QGS_NAMESPACE );
+    mXmlWriter->writeAttribute( "xmlns:xsi", "http://www.w3.org/2001/XMLSchema-instance" );
+    mXmlWriter->writeAttribute( "xsi:schemaLocation", WFS_NAMESPACE + " http://schemas.opengis.net/wfs/1.0.0/wfs.xsd " + QGS_NAMESPACE + " " + hrefString );
+
+    if ( rect )
     {
-      QDomElement envElem = QgsOgcUtils::rectangleToGMLEnvelope( rect, doc, prec );
-      if ( !envElem.isNull() )
+      QString srsName = crs.isValid() ? crs.authid() : QString();
+      mXmlWriter->writeStartElement( "gml:boundedBy" );
+      if ( format == "GML3" )
       {
-        if ( crs.isValid() )
-        {
-          envElem.setAttribute( "srsName", crs.authid() );
-        }
-        bbElem.appendChild( envElem );
-        doc.appendChild( bbElem );
+        QgsOgcUtils::rectangleToGMLEnvelope( *rect, *mXmlWriter, prec, srsName );
       }
-    }
-    else
-    {
-      QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( rect, doc, prec );
-      if ( !boxElem.isNull() )
+      else
       {
-        if ( crs.isValid() )
-        {
-          boxElem.setAttribute( "srsName", crs.authid() );
-        }
-        bbElem.appendChild( boxElem );
-        doc.appendChild( bbElem );
+        QgsOgcUtils::rectangleToGMLBox( *rect, *mXmlWriter, prec, srsName );
       }
+      mXmlWriter->writeEndElement();
     }
-    result = doc.toByteArray();
-    request.setGetFeatureResponse( &result );
   }
-  fcString = "";
 }
 
 void QgsWFSServer::setGetFeature( QgsRequestHandler& request, const QString& format, QgsFeature* feat, int featIdx, int prec, QgsCoordinateReferenceSystem& crs, QgsAttributeList attrIndexes, QSet<QString> excludedAttributes ) /*const*/
 {
-  if ( !feat->isValid() )
+  Q_UNUSED( request );
+  if ( !feat->isValid() || !mStreamingDevice )
     return;
 
-  QByteArray result;
   if ( format == "GeoJSON" )
   {
     QString fcString;
@@ -1246,51 +1243,37 @@ void QgsWFSServer::setGetFeature( QgsRequestHandler& request, const QString& for
     fcString += createFeatureGeoJSON( feat, prec, crs, attrIndexes, excludedAttributes );
     fcString += "\n";
 
-    result = fcString.toUtf8();
-    request.setGetFeatureResponse( &result );
-    fcString = "";
+    mStreamingDevice->write( fcString.toUtf8() );
   }
-  else
+  else if ( mXmlWriter )
   {
-    QDomDocument gmlDoc;
-    QDomElement featureElement;
-    if ( format == "GML3" )
-    {
-      featureElement = createFeatureGML3( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes );
-      gmlDoc.appendChild( featureElement );
-    }
-    else
-    {
-      featureElement = createFeatureGML2( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes );
-      gmlDoc.appendChild( featureElement );
-    }
-
-    result = gmlDoc.toByteArray();
-    request.setGetFeatureResponse( &result );
-    gmlDoc.removeChild( featureElement );
+    writeFeatureGML( feat, format, prec, crs, attrIndexes, excludedAttributes );
   }
 }
 
 void QgsWFSServer::endGetFeature( QgsRequestHandler& request, const QString& format )
 {
-  QByteArray result;
-  QString fcString;
-  if ( format == "GeoJSON" )
+  Q_UNUSED( request );
+  if ( !mStreamingDevice )
   {
-    fcString += " ]\n";
-    fcString += "}";
+    return;
+  }
 
-    result = fcString.toUtf8();
-    request.endGetFeatureResponse( &result );
-    fcString = "";
+  if ( format == "GeoJSON" )
+  {
+    mStreamingDevice->write( " ]\n}" );
   }
-  else
+  else if ( mXmlWriter )
   {
-    fcString = "</wfs:FeatureCollection>";
-    result = fcString.toUtf8();
-    request.endGetFeatureResponse( &result );
-    fcString = "";
+    mXmlWriter->writeEndElement(); //wfs:FeatureCollection
   }
+
+  //sends the remaining data
+  mStreamingDevice->close();
+  delete mXmlWriter;
+  mXmlWriter = 0;
+  delete mStreamingDevice;
+  mStreamingDevice = 0;
 }
 
 QDomDocument QgsWFSServer::transaction( const QString& requestBody )
@@ -1765,127 +1748,58 @@ QString QgsWFSServer::createFeatureGeoJSON( QgsFeature* feat, int prec, QgsCoord
   return fStr;
 }
 
-QDomElement QgsWFSServer::createFeatureGML2( QgsFeature* feat, QDomDocument& doc, int prec, QgsCoordinateReferenceSystem& crs, QgsAttributeList attrIndexes, QSet<QString> excludedAttributes ) /*const*/
+void QgsWFSServer::writeFeatureGML( QgsFeature* feat, const QString& format, int prec, QgsCoordinateReferenceSystem& crs, const QgsAttributeList& attrIndexes, const QSet<QString>& excludedAttributes )
 {
+  bool gml3 = format == "GML3";
+  QString srsName = crs.isValid() ? crs.authid() : QString();
+
   //gml:FeatureMember
-  QDomElement featureElement = doc.createElement( "gml:featureMember"/*wfs:FeatureMember*/ );
+  mXmlWriter->writeStartElement( "gml:featureMember"/*wfs:FeatureMember*/ );
 
   //qgs:%TYPENAME%
-  QDomElement typeNameElement = doc.createElement( "qgs:" + mTypeName /*qgs:%TYPENAME%*/ );
-  typeNameElement.setAttribute( "fid", mTypeName + "." + QString::number( feat->id() ) );
-  featureElement.appendChild( typeNameElement );
+  mXmlWriter->writeStartElement( "qgs:" + mTypeName /*qgs:%TYPENAME%*/ );
+  mXmlWriter->writeAttribute( gml3 ? "gml:id" : "fid", mTypeName + "." + QString::number( feat->id() ) );
 
-  if ( mWithGeom && mGeometryName != "NONE" )
+  QgsGeometry* geom = feat->geometry();
+  if ( geom && mWithGeom && mGeometryName != "NONE" )
   {
-    //add geometry column (as gml)
-    QgsGeometry* geom = feat->geometry();
-
-    QDomElement geomElem = doc.createElement( "qgs:geometry" );
-    QDomElement gmlElem;
+    QgsGeometry* gmlGeom = geom;
     if ( mGeometryName == "EXTENT" )
     {
-      QgsGeometry* bbox = QgsGeometry::fromRect( geom->boundingBox() );
-      gmlElem = QgsOgcUtils::geometryToGML( bbox , doc, prec );
-      delete bbox;
+      gmlGeom = QgsGeometry::fromRect( geom->boundingBox() );
     }
     else if ( mGeometryName == "CENTROID" )
     {
-      QgsGeometry* centroid = geom->centroid();
-      gmlElem = QgsOgcUtils::geometryToGML( centroid, doc, prec );
-      delete centroid;
+      gmlGeom = geom->centroid();
     }
-    else
-      gmlElem = QgsOgcUtils::geometryToGML( geom, doc, prec );
-    if ( !gmlElem.isNull() )
-    {
-      QgsRectangle box = geom->boundingBox();
-      QDomElement bbElem = doc.createElement( "gml:boundedBy" );
-      QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
 
-      if ( crs.isValid() )
+    // the bounding box precedes the geometry, but is only written if the geometry has a GML representation
+    QString geometryGML;
+    QXmlStreamWriter geometryWriter( &geometryGML );
+    if ( QgsOgcUtils::geometryToGML( gmlGeom, geometryWriter, format, prec, srsName ) )
+    {
+      mXmlWriter->writeStartElement( "gml:boundedBy" );
+      if ( gml3 )
       {
-        boxElem.setAttribute( "srsName", crs.authid() );
-        gmlElem.setAttribute( "srsName", crs.authid() );
+        QgsOgcUtils::rectangleToGMLEnvelope( geom->boundingBox(), *mXmlWriter, prec, srsName );
       }
-
-      bbElem.appendChild( boxElem );
-      typeNameElement.appendChild( bbElem );
-
-      geomElem.appendChild( gmlElem );
-      typeNameElement.appendChild( geomElem );
-    }
-  }
-
-  //read all attribute values from the feature
-  QgsAttributes featureAttributes = feat->attributes();
-  const QgsFields* fields = feat->fields();
-  for ( int i = 0; i < attrIndexes.count(); ++i )
-  {
-    int idx = attrIndexes[i];
-    QString attributeName = fields->at( idx ).name();
-    //skip attribute if it is excluded from WFS publication
-    if ( excludedAttributes.contains( attributeName ) )
-    {
-      continue;
-    }
-
-    QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QString( " " ), QString( "_" ) ) );
-    QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-    fieldElem.appendChild( fieldText );
-    typeNameElement.appendChild( fieldElem );
-  }
-
-  return featureElement;
-}
-
-QDomElement QgsWFSServer::createFeatureGML3( QgsFeature* feat, QDomDocument& doc, int prec, QgsCoordinateReferenceSystem& crs, QgsAttributeList attrIndexes, QSet<QString> excludedAttributes ) /*const*/
-{
-  //gml:FeatureMember
-  QDomElement featureElement = doc.createElement( "gml:featureMember"/*wfs:FeatureMember*/ );
-
-  //qgs:%TYPENAME%
-  QDomElement typeNameElement = doc.createElement( "qgs:" + mTypeName /*qgs:%TYPENAME%*/ );
-  typeNameElement.setAttribute( "gml:id", mTypeName + "." + QString::number( feat->id() ) );
-  featureElement.appendChild( typeNameElement );
-
-  if ( mWithGeom && mGeometryName != "NONE" )
-  {
-    //add geometry column (as gml)
-    QgsGeometry* geom = feat->geometry();
-
-    QDomElement geomElem = doc.createElement( "qgs:geometry" );
-    QDomElement gmlElem;
-    if ( mGeometryName == "EXTENT" )
-    {
-      QgsGeometry* bbox = QgsGeometry::fromRect( geom->boundingBox() );
-      gmlElem = QgsOgcUtils::geometryToGML( bbox, doc, "GML3", prec );
-      delete bbox;
-    }
-    else if ( mGeometryName == "CENTROID" )
-    {
-      QgsGeometry* centroid = geom->centroid();
-      gmlElem = QgsOgcUtils::geometryToGML( centroid, doc, "GML3", prec );
-      delete centroid;
-    }
-    else
-      gmlElem = QgsOgcUtils::geometryToGML( geom, doc, "GML3", prec );
-    if ( !gmlElem.isNull() )
-    {
-      QgsRectangle box = geom->boundingBox();
-      QDomElement bbElem = doc.createElement( "gml:boundedBy" );
-      QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
-
-      if ( crs.isValid() )
+      else
       {
-        boxElem.setAttribute( "srsName", crs.authid() );
-        gmlElem.setAttribute( "srsName", crs.authid() );
+        QgsOgcUtils::rectangleToGMLBox( geom->boundingBox(), *mXmlWriter, prec, srsName );
       }
+      mXmlWriter->writeEndElement();
+
+      //add geometry column (as gml)
+      mXmlWriter->writeStartElement( "qgs:geometry" );
+      // closes the start tag, the writer passes everything to the device right away
+      mXmlWriter->writeCharacters( QString() );
+      mStreamingDevice->write( geometryGML.toUtf8() );
+      mXmlWriter->writeEndElement();
+    }
 
-      bbElem.appendChild( boxElem );
-      typeNameElement.appendChild( bbElem );
-
-      geomElem.appendChild( gmlElem );
-      typeNameElement.appendChild( geomElem );
+    if ( gmlGeom != geom )
+    {
+      delete gmlGeom;
     }
   }
 
@@ -1902,13 +1816,11 @@ QDomElement QgsWFSServer::createFeatureGML3( QgsFeature* feat, QDomDocument& doc
       continue;
     }
 
-    QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QString( " " ), QString( "_" ) ) );
-    QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-    fieldElem.appendChild( fieldText );
-    typeNameElement.appendChild( fieldElem );
+    mXmlWriter->writeTextElement( "qgs:" + attributeName.replace( QString( " " ), QString( "_" ) ), featureAttributes[idx].toString() );
   }
 
-  return featureElement;
+  mXmlWriter->writeEndElement(); //qgs:%TYPENAME%
+  mXmlWriter->writeEndElement(); //gml:featureMember
 }
 
 QString QgsWFSServer::serviceUrl() const
@@ -45,11 +45,13 @@ class QgsRectangle;
 class QgsGeometry;
 class QgsSymbol;
 class QgsRequestHandler;
+class QgsServerStreamingDevice;
 class QFile;
 class QFont;
 class QImage;
 class QPaintDevice;
 class QPainter;
+class QXmlStreamWriter;
 
 
 /** This class handles all the wms server requests. The parameters and values have to be passed in the form of
@@ -102,6 +104,13 @@ class QgsWFSServer: public QgsOWSServer
 
     QgsWFSProjectParser* mConfigParser;
 
+    /* Output device and XML writer of the GetFeature response currently sent */
+    QgsServerStreamingDevice* mStreamingDevice;
+    QXmlStreamWriter* mXmlWriter;
+
+    /** Writes a feature as GML2 or GML3 featureMember to the streamed GetFeature response*/
+    void writeFeatureGML( QgsFeature* feat, const QString& format, int prec, QgsCoordinateReferenceSystem& crs, const QgsAttributeList& attrIndexes, const QSet<QString>& excludedAttributes );
+
   protected:
 
     void startGetFeature( QgsRequestHandler& request, const QString& format, int prec, QgsCoordinateReferenceSystem& crs, QgsRectangle* rect );
@@ -114,12 +123,6 @@ class QgsWFSServer: public QgsOWSServer
     //methods to write GeoJSON
     QString createFeatureGeoJSON( QgsFeature* feat, int prec, QgsCoordinateReferenceSystem& crs, QgsAttributeList attrIndexes, QSet<QString> excludedAttributes ) /*const*/;
 
-    //methods to write GML2
-    QDomElement createFeatureGML2( QgsFeature* feat, QDomDocument& doc, int prec, QgsCoordinateReferenceSystem& crs, QgsAttributeList attrIndexes, QSet<QString> excludedAttributes ) /*const*/;
-
-    //methods to write GML3
-    QDomElement createFeatureGML3( QgsFeature* feat, QDomDocument& doc, int prec, QgsCoordinateReferenceSystem& crs, QgsAttributeList attrIndexes, QSet<QString> excludedAttributes ) /*const*/;
-
     void addTransactionResult( QDomDocument& responseDoc, QDomElement& responseElem, const QString& status, const QString& locator, const QString& message );
 };
 
@@ -48,6 +48,7 @@
 #include "qgsfeature.h"
 #include "qgseditorwidgetregistry.h"
 #include "qgsserverstreamingdevice.h"
+#include "qgswmstilecache.h"
 
 #include <QImage>
 #include <QPainter>
@@ -55,6 +56,7 @@
 #include <QTemporaryFile>
 #include <QTextStream>
 #include <QDir>
+#include <QFileInfo>
 
 //for printing
 #include "qgscomposition.h"
@@ -182,7 +184,11 @@ void QgsWMSServer::executeRequest()
     QImage* result = 0;
     try
     {
-      result = getMap();
+      result = getMapFromMetaTile();
+      if ( !result )
+      {
+        result = getMap();
+      }
     }
     catch ( QgsMapServiceException& ex )
     {
@@ -1333,6 +1339,132 @@ QImage* QgsWMSServer::getMap( HitTest* hitTest )
   return theImage;
 }
 
+QImage* QgsWMSServer::getMapFromMetaTile()
+{
+  QgsWMSTileCache* tileCache = QgsWMSTileCache::instance();
+  int metaTileSize = tileCache->metaTileSize();
+  if ( metaTileSize < 2 )
+  {
+    return 0;
+  }
+
+  //external styles and data are usually sent for a single request only
+  if ( mParameters.contains( "SLD" ) || mParameters.contains( "SLD_BODY" ) || mParameters.contains( "GML" ) )
+  {
+    return 0;
+  }
+
+  bool widthOk, heightOk;
+  int width = mParameters.value( "WIDTH" ).toInt( &widthOk );
+  int height = mParameters.value( "HEIGHT" ).toInt( &heightOk );
+  if ( !widthOk || !heightOk || width <= 0 || height <= 0
+       || width > tileCache->maxMetaTileSize() / metaTileSize || height > tileCache->maxMetaTileSize() / metaTileSize )
+  {
+    return 0;
+  }
+
+  bool bboxOk;
+  QgsRectangle bbox = _parseBBOX( mParameters.value( "BBOX" ), bboxOk );
+  if ( !bboxOk || bbox.isEmpty() )
+  {
+    return 0;
+  }
+
+  //the tiles of a metatile are sliced in image coordinates, so the axes of the BBOX must not be swapped
+  QString version = mParameters.value( "VERSION", "1.3.0" );
+  QString crs = mParameters.value( "CRS", mParameters.value( "SRS" ) );
+  if ( version != "1.1.1" && !crs.isEmpty() && QgsCRSCache::instance()->crsByAuthId( crs ).axisInverted() )
+  {
+    return 0;
+  }
+
+  //tiles are only cached if the BBOX is aligned to the grid of the tile size with origin 0/0 (this is the case for the common tile matrix sets)
+  double tileWidth = bbox.width();
+  double tileHeight = bbox.height();
+  double columnPos = bbox.xMinimum() / tileWidth;
+  double rowPos = bbox.yMinimum() / tileHeight;
+  qlonglong column = qRound64( columnPos );
+  qlonglong row = qRound64( rowPos );
+  if ( qAbs( columnPos - column ) > 1E-6 || qAbs( rowPos - row ) > 1E-6 )
+  {
+    return 0;
+  }
+
+  //key of all the request parameters except the extent. The modification time invalidates tiles on disk after the project has changed
+  QString requestKey = QFileInfo( mConfigFilePath ).lastModified().toString( Qt::ISODate );
+  QMap<QString, QString>::const_iterator paramIt = mParameters.constBegin();
+  for ( ; paramIt != mParameters.constEnd(); ++paramIt )
+  {
+    if ( paramIt.key() != "BBOX" )
+    {
+      requestKey += '&' + paramIt.key() + '=' + paramIt.value();
+    }
+  }
+
+  QImage tile = tileCache->searchTile( mConfigFilePath, requestKey, column, row );
+  if ( !tile.isNull() )
+  {
+    QgsDebugMsg( "Found tile in tile cache" );
+    return new QImage( tile );
+  }
+
+  //render the metatile containing the tile
+  qlonglong metaColumn = column >= 0 ? column / metaTileSize : -(( -column - 1 ) / metaTileSize ) - 1;
+  qlonglong metaRow = row >= 0 ? row / metaTileSize : -(( -row - 1 ) / metaTileSize ) - 1;
+  double metaXMin = metaColumn * metaTileSize * tileWidth;
+  double metaYMin = metaRow * metaTileSize * tileHeight;
+
+  QMap<QString, QString> tileParameters = mParameters;
+  mParameters.insert( "WIDTH", QString::number( width * metaTileSize ) );
+  mParameters.insert( "HEIGHT", QString::number( height * metaTileSize ) );
+  mParameters.insert( "BBOX", QString( "%1,%2,%3,%4" )
+                      .arg( metaXMin, 0, 'g', 17 ).arg( metaYMin, 0, 'g', 17 )
+                      .arg( metaXMin + metaTileSize * tileWidth, 0, 'g', 17 )
+                      .arg( metaYMin + metaTileSize * tileHeight, 0, 'g', 17 ) );
+  if ( !checkMaximumWidthHeight() )
+  {
+    mParameters = tileParameters;
+    return 0;
+  }
+
+  QImage* metaTile = 0;
+  try
+  {
+    metaTile = getMap();
+  }
+  catch ( QgsMapServiceException& )
+  {
+    mParameters = tileParameters;
+    throw;
+  }
+  mParameters = tileParameters;
+
+  if ( !metaTile )
+  {
+    return 0;
+  }
+
+  //slice the metatile. Rows of the grid go up, rows of the image go down
+  QImage* result = 0;
+  for ( int r = 0; r < metaTileSize; ++r )
+  {
+    for ( int c = 0; c < metaTileSize; ++c )
+    {
+      QImage slice = metaTile->copy( c * width, ( metaTileSize - 1 - r ) * height, width, height );
+      qlonglong sliceColumn = metaColumn * metaTileSize + c;
+      qlonglong sliceRow = metaRow * metaTileSize + r;
+      tileCache->insertTile( mConfigFilePath, requestKey, sliceColumn, sliceRow, slice );
+      if ( sliceColumn == column && sliceRow == row )
+      {
+        result = new QImage( slice );
+      }
+    }
+  }
+  delete metaTile;
+
+  return result;
+}
+
 void QgsWMSServer::getMapAsDxf()
 {
   QgsServerStreamingDevice d( "application/dxf" , mRequestHandler );
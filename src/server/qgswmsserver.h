@@ -84,6 +84,11 @@ class QgsWMSServer: public QgsOWSServer
     of the image object). If an instance to existing hit test structure is passed, instead of rendering
     it will fill the structure with symbols that would be used for rendering */
     QImage* getMap( HitTest* hitTest = 0 );
+    /** Returns the map of a tile request as a tile of a metatile (a block of NxN tiles which is rendered at once).
+    The tiles of the metatile are stored in the tile cache, so that neighbouring tile requests do not need rendering.
+    The caller takes ownership of the image object.
+    @return 0 if metatiling is disabled or if the request is not suitable for metatiling (in this case getMap() should be used)*/
+    QImage* getMapFromMetaTile();
     /** GetMap request with vector format output. This output is usually symbolized (difference to WFS GetFeature)*/
     void getMapAsDxf();
     /** Returns an SLD file with the style of the requested layer. Exception is raised in case of troubles :-)*/
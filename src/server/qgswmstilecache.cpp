@@ -0,0 +1,222 @@
+/***************************************************************************
+                              qgswmstilecache.cpp
+                              -------------------
+  begin                : October 2026
+  copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswmstilecache.h"
+#include "qgslogger.h"
+#include "qgsmessagelog.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+#include <stdlib.h>
+
+static QString md5Hex( const QString& str )
+{
+  return QString::fromLatin1( QCryptographicHash::hash( str.toUtf8(), QCryptographicHash::Md5 ).toHex() );
+}
+
+//! reads a non-negative integer from an environment variable, returns the default value if it is not set or invalid
+static int intFromEnv( const char* name, int defaultValue )
+{
+  char* env = getenv( name );
+  if ( !env )
+  {
+    return defaultValue;
+  }
+
+  bool conversionOk = false;
+  int value = QString( env ).toInt( &conversionOk );
+  return conversionOk && value >= 0 ? value : defaultValue;
+}
+
+QgsWMSTileCache* QgsWMSTileCache::instance()
+{
+  static QgsWMSTileCache mInstance( intFromEnv( "QGIS_SERVER_METATILE_SIZE", 0 ),
+                                    intFromEnv( "QGIS_SERVER_TILE_CACHE_MEMORY", 64 ),
+                                    QString::fromLocal8Bit( getenv( "QGIS_SERVER_TILE_CACHE_DIRECTORY" ) ),
+                                    intFromEnv( "QGIS_SERVER_TILE_CACHE_TTL", 300 ),
+                                    intFromEnv( "QGIS_SERVER_METATILE_MAX_SIZE", 4096 ) );
+  return &mInstance;
+}
+
+QgsWMSTileCache::QgsWMSTileCache( int metaTileSize, int maxMemory, const QString& cacheDirectory, int timeToLive, int maxMetaTileSize )
+    : mMetaTileSize( metaTileSize > 1 ? metaTileSize : 0 )
+    , mMaxMetaTileSize( maxMetaTileSize )
+    , mTimeToLive( qMax( timeToLive, 0 ) )
+    , mCacheDirectory( cacheDirectory )
+{
+  mTiles.setMaxCost( qMax( maxMemory, 0 ) * 1024 );
+}
+
+QgsWMSTileCache::~QgsWMSTileCache()
+{
+}
+
+QImage QgsWMSTileCache::searchTile( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row )
+{
+  QMutexLocker locker( &mMutex );
+
+  checkProjectFile( configFilePath );
+
+  QString key = memoryKey( configFilePath, requestKey, column, row );
+  Tile* tile = mTiles.object( key );
+  if ( tile )
+  {
+    if ( !isExpired( tile->created ) )
+    {
+      return tile->image;
+    }
+    mTiles.remove( key );
+  }
+
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    QFileInfo tileInfo( tilePath( configFilePath, requestKey, column, row ) );
+    if ( tileInfo.exists() )
+    {
+      if ( isExpired( tileInfo.lastModified() ) )
+      {
+        QFile::remove( tileInfo.filePath() );
+        return QImage();
+      }
+
+      QImage diskTile( tileInfo.filePath() );
+      if ( !diskTile.isNull() )
+      {
+        if ( !mConfigFiles.contains( configFilePath ) )
+        {
+          mConfigFiles.insert( configFilePath, QFileInfo( configFilePath ).lastModified() );
+        }
+
+        Tile* cachedTile = new Tile;
+        cachedTile->image = diskTile;
+        cachedTile->created = tileInfo.lastModified();
+        mTiles.insert( key, cachedTile, diskTile.byteCount() / 1024 );
+        return diskTile;
+      }
+    }
+  }
+
+  return QImage();
+}
+
+void QgsWMSTileCache::insertTile( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row, const QImage& tile )
+{
+  //encoding PNG is slow, so the tile is written to a temporary file before the cache is locked.
+  //The temporary file is only renamed once complete, so that a partially written tile is never read
+  QString path;
+  QTemporaryFile tmpFile;
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    path = tilePath( configFilePath, requestKey, column, row );
+    tmpFile.setFileTemplate( path + ".XXXXXX.tmp" );
+    if ( !QDir().mkpath( projectDirectory( configFilePath ) ) || !tmpFile.open() || !tile.save( &tmpFile, "PNG" ) )
+    {
+      QgsMessageLog::logMessage( "Tile cache: could not write tile " + path, "Server", QgsMessageLog::WARNING );
+      path.clear();
+    }
+  }
+
+  QMutexLocker locker( &mMutex );
+
+  checkProjectFile( configFilePath );
+  if ( !mConfigFiles.contains( configFilePath ) )
+  {
+    mConfigFiles.insert( configFilePath, QFileInfo( configFilePath ).lastModified() );
+  }
+
+  Tile* cachedTile = new Tile;
+  cachedTile->image = tile;
+  cachedTile->created = QDateTime::currentDateTime();
+  mTiles.insert( memoryKey( configFilePath, requestKey, column, row ), cachedTile, tile.byteCount() / 1024 );
+
+  if ( !path.isEmpty() )
+  {
+    QFile::remove( path );
+    if ( tmpFile.rename( path ) )
+    {
+      tmpFile.setAutoRemove( false );
+    }
+    else
+    {
+      QgsMessageLog::logMessage( "Tile cache: could not write tile " + path, "Server", QgsMessageLog::WARNING );
+    }
+  }
+}
+
+void QgsWMSTileCache::removeProjectFileTiles( const QString& configFilePath )
+{
+  QMutexLocker locker( &mMutex );
+  removeProjectFileTilesInternal( configFilePath );
+}
+
+QString QgsWMSTileCache::memoryKey( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row ) const
+{
+  return QString( "%1|%2|%3,%4" ).arg( configFilePath ).arg( requestKey ).arg( column ).arg( row );
+}
+
+QString QgsWMSTileCache::projectDirectory( const QString& configFilePath ) const
+{
+  return QDir( mCacheDirectory ).filePath( md5Hex( configFilePath ) );
+}
+
+QString QgsWMSTileCache::tilePath( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row ) const
+{
+  return QDir( projectDirectory( configFilePath ) ).filePath( QString( "%1_%2_%3.png" ).arg( md5Hex( requestKey ) ).arg( column ).arg( row ) );
+}
+
+bool QgsWMSTileCache::isExpired( const QDateTime& created ) const
+{
+  return mTimeToLive > 0 && created.secsTo( QDateTime::currentDateTime() ) >= mTimeToLive;
+}
+
+void QgsWMSTileCache::checkProjectFile( const QString& configFilePath )
+{
+  QHash<QString, QDateTime>::const_iterator it = mConfigFiles.constFind( configFilePath );
+  if ( it != mConfigFiles.constEnd() && QFileInfo( configFilePath ).lastModified() != it.value() )
+  {
+    removeProjectFileTilesInternal( configFilePath );
+  }
+}
+
+void QgsWMSTileCache::removeProjectFileTilesInternal( const QString& configFilePath )
+{
+  QgsMessageLog::logMessage( "Removing tile cache entries for project file: " + configFilePath, "Server", QgsMessageLog::INFO );
+
+  QString prefix = configFilePath + '|';
+  Q_FOREACH ( const QString& key, mTiles.keys() )
+  {
+    if ( key.startsWith( prefix ) )
+    {
+      mTiles.remove( key );
+    }
+  }
+
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    QDir projectDir( projectDirectory( configFilePath ) );
+    Q_FOREACH ( const QString& tile, projectDir.entryList( QStringList( "*.png" ), QDir::Files ) )
+    {
+      projectDir.remove( tile );
+    }
+    QDir( mCacheDirectory ).rmdir( md5Hex( configFilePath ) );
+  }
+
+  mConfigFiles.remove( configFilePath );
+}
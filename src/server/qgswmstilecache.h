@@ -0,0 +1,123 @@
+/***************************************************************************
+                              qgswmstilecache.h
+                              -----------------
+  begin                : October 2026
+  copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWMSTILECACHE_H
+#define QGSWMSTILECACHE_H
+
+#include <QCache>
+#include <QDateTime>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+/** A singleton class that caches the tiles sliced from rendered GetMap metatiles.
+
+ Tiled clients request many small neighbouring images. If metatiling is enabled, the WMS server
+ renders a block of NxN tiles at once and stores all of them in this cache, so that the neighbouring
+ requests do not need to render (and label) the same features again.
+
+ The cache is configured with environment variables:
+ - QGIS_SERVER_METATILE_SIZE: number of tiles in each direction of a metatile (metatiling is disabled if not set or smaller than 2)
+ - QGIS_SERVER_METATILE_MAX_SIZE: maximum width and height of a metatile in pixels (default 4096). Larger tiles are rendered without metatiling
+ - QGIS_SERVER_TILE_CACHE_MEMORY: memory used by the cached tiles in megabytes (default 64)
+ - QGIS_SERVER_TILE_CACHE_DIRECTORY: directory where tiles are also stored on disk (disk cache is disabled if not set)
+ - QGIS_SERVER_TILE_CACHE_TTL: seconds after which cached tiles expire (default 300, 0 keeps tiles until the configuration file changes)
+
+ Tiles are keyed by the configuration file, a key of the request parameters and the position of the tile
+ in the tile grid. Tiles of a configuration file are removed if the modification time of the file changes.
+ Changes of the layer data are not detected, they show up once the tiles have expired. Metatiling should
+ only be enabled with a time to live that suits how often the data changes.
+ */
+class SERVER_EXPORT QgsWMSTileCache: public QObject
+{
+    Q_OBJECT
+  public:
+    /** Returns the cache configured by the environment variables*/
+    static QgsWMSTileCache* instance();
+
+    /** Creates a cache with the given settings instead of the environment variables
+      @param metaTileSize number of tiles in each direction of a metatile (0 disables metatiling)
+      @param maxMemory memory used by the cached tiles in megabytes
+      @param cacheDirectory directory where tiles are also stored on disk, empty to keep tiles only in memory
+      @param timeToLive seconds after which cached tiles expire, 0 if they do not expire
+      @param maxMetaTileSize maximum width and height of a metatile in pixels*/
+    QgsWMSTileCache( int metaTileSize, int maxMemory, const QString& cacheDirectory = QString(), int timeToLive = 300, int maxMetaTileSize = 4096 );
+    ~QgsWMSTileCache();
+
+    /** Returns the number of tiles in each direction of a metatile (0 if metatiling is disabled)*/
+    int metaTileSize() const { return mMetaTileSize; }
+
+    /** Returns the maximum width and height of a metatile in pixels*/
+    int maxMetaTileSize() const { return mMaxMetaTileSize; }
+
+    /** Returns the seconds after which cached tiles expire, 0 if they do not expire*/
+    int timeToLive() const { return mTimeToLive; }
+
+    /** Searches for a tile.
+      @param configFilePath path of the configuration file
+      @param requestKey key of the request parameters (without the extent)
+      @param column column of the tile in the tile grid
+      @param row row of the tile in the tile grid
+      @return the tile image or a null image if it is not in the cache or has expired*/
+    QImage searchTile( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row );
+
+    /** Inserts a tile into the cache (in memory and on disk if enabled)*/
+    void insertTile( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row, const QImage& tile );
+
+    /** Removes the tiles of a configuration file*/
+    void removeProjectFileTiles( const QString& configFilePath );
+
+  private:
+    Q_DISABLE_COPY( QgsWMSTileCache )
+
+    struct Tile
+    {
+      QImage image;
+      QDateTime created;
+    };
+
+    QString memoryKey( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row ) const;
+    QString projectDirectory( const QString& configFilePath ) const;
+    QString tilePath( const QString& configFilePath, const QString& requestKey, qlonglong column, qlonglong row ) const;
+
+    /** Returns true if a tile created at the given time has expired*/
+    bool isExpired( const QDateTime& created ) const;
+
+    /** Removes the tiles of a configuration file if the file was modified since the tiles were inserted (without locking)*/
+    void checkProjectFile( const QString& configFilePath );
+
+    /** Removes the tiles of a configuration file (without locking)*/
+    void removeProjectFileTilesInternal( const QString& configFilePath );
+
+    QMutex mMutex;
+
+    /** Tiles in memory, the cost is the size of the tile in kilobytes*/
+    QCache<QString, Tile> mTiles;
+
+    /** Config files of the cached tiles with their modification time when the first tile was inserted.
+      The modification time is polled on every search, no event loop is needed to detect changes*/
+    QHash<QString, QDateTime> mConfigFiles;
+
+    int mMetaTileSize;
+    int mMaxMetaTileSize;
+    int mTimeToLive;
+
+    QString mCacheDirectory;
+};
+
+#endif // QGSWMSTILECACHE_H
@@ -82,6 +82,7 @@ void usage( std::string const & appName )
             << "\t[--prefix path]\tpath to a different build of qgis, may be used to test old versions\n"
             << "\t[--quality]\trenderer hint(s), comma separated, possible values: Antialiasing,TextAntialiasing,SmoothPixmapTransform,NonCosmeticDefaultPen\n"
             << "\t[--parallel]\trender layers in parallel instead of sequentially\n"
+            << "\t[--tiles]\trender large vector layers in tiles on separate threads\n"
             << "\t[--print type]\twhat kind of time to print, possible values: wall,total,user,sys. Default is total.\n"
             << "\t[--help]\t\tthis text\n\n"
             << "  FILES:\n"
@@ -138,6 +139,7 @@ int main( int argc, char *argv[] )
   int mySnapshotHeight = 600;
   QString myQuality = "";
   bool myParallel = false;
+  bool myParallelTiles = false;
   QString myPrintTime = "total";
 
   // This behaviour will set initial extent of map canvas, but only if
@@ -178,6 +180,7 @@ int main( int argc, char *argv[] )
       {"prefix", required_argument, 0, 'r'},
       {"quality", required_argument, 0, 'q'},
       {"parallel", no_argument, 0, 'P'},
+      {"tiles", no_argument, 0, 'T'},
       {"print", required_argument, 0, 'R'},
       {0, 0, 0, 0}
     };
@@ -252,6 +255,10 @@ int main( int argc, char *argv[] )
         myParallel = true;
         break;
 
+      case 'T':
+        myParallelTiles = true;
+        break;
+
       case 'R':
         myPrintTime = optarg;
         break;
@@ -340,6 +347,10 @@ int main( int argc, char *argv[] )
     {
       myParallel = true;
     }
+    else if ( arg == "--tiles" || arg == "-T" )
+    {
+      myParallelTiles = true;
+    }
     else if ( i + 1 < argc && ( arg == "--print" || arg == "-R" ) )
     {
       myPrintTime = argv[++i];
@@ -517,6 +528,7 @@ int main( int argc, char *argv[] )
   }
 
   qbench->setParallel( myParallel );
+  qbench->setParallelTiles( myParallelTiles );
 
   /////////////////////////////////////////////////////////////////////
   // autoload any file names that were passed in on the command line
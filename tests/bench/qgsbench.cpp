@@ -128,6 +128,7 @@ QgsBench::QgsBench( int theWidth, int theHeight, int theIterations )
     , mUserStart( 0.0 )
     , mSysStart( 0.0 )
     , mParallel( false )
+    , mParallelTiles( false )
 {
   QgsDebugMsg( "entered" );
 
@@ -208,6 +209,8 @@ void QgsBench::render()
   // TODO: do we need the other QPainter flags?
   mMapSettings.setFlag( QgsMapSettings::Antialiasing, mRendererHints.testFlag( QPainter::Antialiasing ) );
 
+  mMapSettings.setFlag( QgsMapSettings::ParallelTileRendering, mParallelTiles );
+
   for ( int i = 0; i < mIterations; i++ )
   {
     QgsMapRendererQImageJob* job;
@@ -60,6 +60,8 @@ class QgsBench :  public QObject
 
     void setParallel( bool enabled ) { mParallel = enabled; }
 
+    void setParallelTiles( bool enabled ) { mParallelTiles = enabled; }
+
   public slots:
     void readProject( const QDomDocument &doc );
 
@@ -94,6 +96,8 @@ class QgsBench :  public QObject
     QgsMapSettings mMapSettings;
 
     bool mParallel;
+
+    bool mParallelTiles;
 };
 
 #endif // QGSBENCH_H
@@ -44,6 +44,7 @@ class TestQgsVectorAnalyzer : public QObject
     void simplifyGeometry();
     void polygonCentroids();
     void layerExtent();
+    void parallelProcessing();
   private:
     QgsGeometryAnalyzer mAnalyzer;
     QgsVectorLayer * mpLineLayer;
@@ -137,5 +138,57 @@ void TestQgsVectorAnalyzer::layerExtent()
   QVERIFY( mAnalyzer.extent( mpPointLayer, myFileName ) );
 }
 
+void TestQgsVectorAnalyzer::parallelProcessing()
+{
+  QString myTmpDir = QDir::tempPath() + "/";
+  QgsGeometryAnalyzer parallelAnalyzer;
+  parallelAnalyzer.setParallelProcessing( true );
+  QVERIFY( parallelAnalyzer.parallelProcessing() );
+
+  QVERIFY( mAnalyzer.buffer( mpPolyLayer, myTmpDir + "buffer_layer.shp", 1.0 ) );
+  QVERIFY( parallelAnalyzer.buffer( mpPolyLayer, myTmpDir + "buffer_parallel_layer.shp", 1.0 ) );
+  QVERIFY( mAnalyzer.buffer( mpPolyLayer, myTmpDir + "bufferdissolve_layer.shp", 1.0, false, true ) );
+  QVERIFY( parallelAnalyzer.buffer( mpPolyLayer, myTmpDir + "bufferdissolve_parallel_layer.shp", 1.0, false, true ) );
+  QVERIFY( mAnalyzer.convexHull( mpLineLayer, myTmpDir + "convexhull_layer.shp" ) );
+  QVERIFY( parallelAnalyzer.convexHull( mpLineLayer, myTmpDir + "convexhull_parallel_layer.shp" ) );
+  QVERIFY( mAnalyzer.dissolve( mpPolyLayer, myTmpDir + "dissolve_layer.shp" ) );
+  QVERIFY( parallelAnalyzer.dissolve( mpPolyLayer, myTmpDir + "dissolve_parallel_layer.shp" ) );
+
+  //the results must not depend on the execution mode
+  QStringList names;
+  names << "buffer" << "bufferdissolve" << "convexhull" << "dissolve";
+  Q_FOREACH ( const QString& name, names )
+  {
+    QgsVectorLayer serialLayer( myTmpDir + name + "_layer.shp", name, "ogr" );
+    QgsVectorLayer parallelLayer( myTmpDir + name + "_parallel_layer.shp", name + "_parallel", "ogr" );
+    QVERIFY( serialLayer.isValid() );
+    QVERIFY( parallelLayer.isValid() );
+    QCOMPARE( parallelLayer.featureCount(), serialLayer.featureCount() );
+
+    QgsFeatureIterator serialIt = serialLayer.getFeatures();
+    QgsFeatureIterator parallelIt = parallelLayer.getFeatures();
+    QgsFeature serialFeature, parallelFeature;
+    while ( serialIt.nextFeature( serialFeature ) )
+    {
+      QVERIFY( parallelIt.nextFeature( parallelFeature ) );
+      QCOMPARE( parallelFeature.attributes(), serialFeature.attributes() );
+      QCOMPARE( parallelFeature.constGeometry()->exportToWkt(), serialFeature.constGeometry()->exportToWkt() );
+    }
+  }
+
+  //the tree union dissolves everything into one feature covering all input features
+  QgsVectorLayer dissolveLayer( myTmpDir + "dissolve_layer.shp", "dissolve", "ogr" );
+  QCOMPARE( dissolveLayer.featureCount(), 1L );
+  QgsFeature dissolveFeature;
+  QVERIFY( dissolveLayer.getFeatures().nextFeature( dissolveFeature ) );
+  QScopedPointer<QgsGeometry> dissolveArea( dissolveFeature.constGeometry()->buffer( 0.000001, 5 ) );
+  QgsFeatureIterator polyIt = mpPolyLayer->getFeatures();
+  QgsFeature polyFeature;
+  while ( polyIt.nextFeature( polyFeature ) )
+  {
+    QVERIFY( dissolveArea->contains( polyFeature.constGeometry() ) );
+  }
+}
+
 QTEST_MAIN( TestQgsVectorAnalyzer )
 #include "testqgsvectoranalyzer.moc"
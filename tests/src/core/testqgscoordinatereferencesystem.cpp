@@ -20,6 +20,7 @@ Email                : sherman at mrcc dot com
 
 //header for class being tested
 #include <qgscoordinatereferencesystem.h>
+#include <qgssrsdbindex.h>
 #include <qgis.h>
 #include <qgsvectorlayer.h>
 
@@ -61,6 +62,8 @@ class TestQgsCoordinateReferenceSystem: public QObject
     void mapUnits();
     void setValidationHint();
     void axisInverted();
+    void srsDbIndex();
+    void srsDbIndexParameterSet();
   private:
     void debugPrint( QgsCoordinateReferenceSystem &theCrs );
     // these used by createFromESRIWkt()
@@ -438,6 +441,80 @@ void TestQgsCoordinateReferenceSystem::axisInverted()
 }
 
 
+void TestQgsCoordinateReferenceSystem::srsDbIndex()
+{
+  QString indexPath = QDir::tempPath() + "/testqgssrsdbindex.idx";
+  QVERIFY( QgsSrsDbIndex::build( QgsApplication::srsDbFilePath(), indexPath ) );
+
+  QgsSrsDbIndex index;
+  QVERIFY( index.open( indexPath, QgsApplication::srsDbFilePath() ) );
+  QVERIFY( index.count() > 0 );
+
+  QgsSrsDbIndex::Record record;
+  QVERIFY( index.find( QgsSrsDbIndex::AuthId, "epsg:4326", record ) );
+  QCOMPARE( record.srsId, GEOCRS_ID );
+  QCOMPARE( record.srid, GEOSRID );
+  QVERIFY( record.geographic );
+  QVERIFY( index.find( QgsSrsDbIndex::Srid, QString::number( GEOSRID ), record ) );
+  QCOMPARE( record.authId, QString( "EPSG:4326" ) );
+  QVERIFY( index.find( QgsSrsDbIndex::SrsId, QString::number( GEOCRS_ID ), record ) );
+  QCOMPARE( record.srid, GEOSRID );
+  QVERIFY( index.find( QgsSrsDbIndex::Parameters, GEOPROJ4, record ) );
+  QCOMPARE( record.srid, GEOSRID );
+  bool found = false;
+  Q_FOREACH ( const QgsSrsDbIndex::Record& r, index.records( QgsSrsDbIndex::ParameterSet, "+no_defs  +proj=longlat" ) )
+  {
+    found = found || r.srid == GEOSRID;
+  }
+  QVERIFY( found );
+  QVERIFY( !index.find( QgsSrsDbIndex::AuthId, "EPSG:0", record ) );
+
+  // an index of another database is rejected
+  QVERIFY( !index.open( indexPath, QgsApplication::qgisUserDbFilePath() ) );
+  QVERIFY( !index.isValid() );
+  QFile::remove( indexPath );
+
+  // lookups through the index give the same results as the database
+  QgsCoordinateReferenceSystem myCrs;
+  QVERIFY( myCrs.createFromOgcWmsCrs( "epsg:32633" ) );
+  QCOMPARE( myCrs.authid(), QString( "EPSG:32633" ) );
+  QgsCoordinateReferenceSystem myProj4Crs;
+  QVERIFY( myProj4Crs.createFromProj4( myCrs.toProj4() ) );
+  QCOMPARE( myProj4Crs.srsid(), myCrs.srsid() );
+}
+
+void TestQgsCoordinateReferenceSystem::srsDbIndexParameterSet()
+{
+  // British National Grid is defined with +towgs84 in srs.db
+  QgsCoordinateReferenceSystem myCrs;
+  QVERIFY( myCrs.createFromOgcWmsCrs( "EPSG:27700" ) );
+  QStringList params = myCrs.toProj4().split( ' ', QString::SkipEmptyParts );
+  QVERIFY( params.filter( QRegExp( "^\\+towgs84=" ) ).size() == 1 );
+  if ( QgsSrsDbIndex::instance()->isValid() )
+    QCOMPARE( QgsSrsDbIndex::instance()->records( QgsSrsDbIndex::ParameterSet, myCrs.toProj4() ).size(), 1 );
+
+  // the parameters may be in any order
+  QStringList reversed;
+  Q_FOREACH ( const QString& param, params )
+    reversed.prepend( param );
+  QgsCoordinateReferenceSystem myReversedCrs;
+  QVERIFY( myReversedCrs.createFromProj4( reversed.join( " " ) ) );
+  QCOMPARE( myReversedCrs.srsid(), myCrs.srsid() );
+
+  // the definition in srs.db has an extra +towgs84, which is found by the srs.db query but
+  // rejected as the parameters differ
+  QStringList withoutTowgs84;
+  Q_FOREACH ( const QString& param, reversed )
+  {
+    if ( !param.startsWith( "+towgs84=" ) )
+      withoutTowgs84 << param;
+  }
+  QCOMPARE( withoutTowgs84.size(), params.size() - 1 );
+  QgsCoordinateReferenceSystem myCrsWithoutTowgs84;
+  QVERIFY( myCrsWithoutTowgs84.createFromProj4( withoutTowgs84.join( " " ) ) );
+  QVERIFY( myCrsWithoutTowgs84.srsid() != myCrs.srsid() );
+}
+
 void TestQgsCoordinateReferenceSystem::debugPrint(
   QgsCoordinateReferenceSystem &theCrs )
 {
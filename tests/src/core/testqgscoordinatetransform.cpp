@@ -16,7 +16,9 @@
  ***************************************************************************/
 #include "qgscoordinatetransform.h"
 #include "qgsapplication.h"
+#include "qgscrscache.h"
 #include <QObject>
+#include <QtConcurrentRun>
 #include <QtTest/QtTest>
 
 class TestQgsCoordinateTransform: public QObject
@@ -27,6 +29,8 @@ class TestQgsCoordinateTransform: public QObject
     void initTestCase();
     void cleanupTestCase();
     void transformBoundingBox();
+    void projectionCache();
+    void approximateTransform();
 
   private:
 
@@ -73,5 +77,83 @@ void TestQgsCoordinateTransform::transformBoundingBox()
   QVERIFY( qgsDoubleNear( resultRect.yMaximum(), expectedRect.yMaximum(), 0.001 ) );
 }
 
+static QgsPoint _transformPoint( const QgsCoordinateTransform* tr, QgsPoint p )
+{
+  return tr->transform( p );
+}
+
+void TestQgsCoordinateTransform::projectionCache()
+{
+  QgsCoordinateReferenceSystem sourceSrs;
+  sourceSrs.createFromSrid( 3994 );
+  QgsCoordinateReferenceSystem destSrs;
+  destSrs.createFromSrid( 4326 );
+
+  QgsProjectionCache* cache = QgsProjectionCache::instance();
+  QgsCoordinateTransform tr1( sourceSrs, destSrs );
+  QVERIFY( tr1.isInitialised() );
+
+  // a second transform between the same CRS reuses the projections
+  int hits = cache->hits();
+  int misses = cache->misses();
+  QgsCoordinateTransform tr2( sourceSrs, destSrs );
+  QCOMPARE( cache->hits(), hits + 2 );
+  QCOMPARE( cache->misses(), misses );
+
+  // other threads get their own projections with the same results
+  QgsPoint p( 6374985, -3626584 );
+  QgsPoint mainResult = tr2.transform( p );
+  int count = cache->count();
+  QgsPoint threadResult = QtConcurrent::run( _transformPoint, &tr2, p ).result();
+  QCOMPARE( threadResult, mainResult );
+  QVERIFY( cache->count() >= count );
+}
+
+void TestQgsCoordinateTransform::approximateTransform()
+{
+  QgsCoordinateReferenceSystem sourceSrs;
+  sourceSrs.createFromSrid( 4326 );
+  QgsCoordinateReferenceSystem destSrs;
+  destSrs.createFromSrid( 3857 );
+
+  QgsCoordinateTransform exact( sourceSrs, destSrs );
+  QgsCoordinateTransform* approximate = exact.clone();
+  QVERIFY( !approximate->hasApproximation() );
+  double tolerance = 0.1;
+  QVERIFY( approximate->setApproximation( QgsRectangle( 10, 40, 20, 50 ), tolerance ) );
+  QVERIFY( approximate->hasApproximation() );
+
+  // points within the grid are interpolated, the others transformed exactly
+  double x[] = { 10.0, 12.345, 17.5, 19.999, 25.0 };
+  double y[] = { 40.0, 48.2, 44.4, 49.999, 45.0 };
+  double z[] = { 0, 0, 0, 0, 0 };
+  double ax[5], ay[5], az[5];
+  memcpy( ax, x, sizeof( x ) );
+  memcpy( ay, y, sizeof( y ) );
+  memcpy( az, z, sizeof( z ) );
+  exact.transformCoords( 5, x, y, z );
+  approximate->transformCoords( 5, ax, ay, az );
+  for ( int i = 0; i < 4; ++i )
+  {
+    QVERIFY( qAbs( ax[i] - x[i] ) < tolerance );
+    QVERIFY( qAbs( ay[i] - y[i] ) < tolerance );
+  }
+  QCOMPARE( ax[4], x[4] );
+  QCOMPARE( ay[4], y[4] );
+
+  // clones share the approximation, reverse transforms are exact
+  QgsCoordinateTransform* clone = approximate->clone();
+  QVERIFY( clone->hasApproximation() );
+  QgsPoint p = clone->transform( QgsPoint( x[1], y[1] ), QgsCoordinateTransform::ReverseTransform );
+  QVERIFY( qgsDoubleNear( p.x(), 12.345, 1e-9 ) );
+  QVERIFY( qgsDoubleNear( p.y(), 48.2, 1e-9 ) );
+  delete clone;
+
+  // a grid which cannot meet the tolerance is not used
+  QVERIFY( !approximate->setApproximation( QgsRectangle( -180, -85, 180, 85 ), 1e-9, 9 ) );
+  QVERIFY( !approximate->hasApproximation() );
+  delete approximate;
+}
+
 QTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
@@ -665,6 +665,251 @@ class TestQgsExpression: public QObject
       run_evaluation_test( exp3, evalError, result );
     }
 
+    void evaluation_compiled_data()
+    {
+      evaluation_data();
+    }
+
+    void evaluation_compiled()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, evalError );
+      QFETCH( QVariant, result );
+
+      // a successfully prepared expression is evaluated by its compiled program
+      QgsExpressionContext context;
+      QgsExpression exp( string );
+      if ( exp.prepare( &context ) )
+        QVERIFY( exp.isCompiled() );
+      run_evaluation_test( exp, evalError, result );
+    }
+
+    void eval_compiled_columns()
+    {
+      QgsFields fields;
+      fields.append( QgsField( "x1", QVariant::Int ) );
+      fields.append( QgsField( "x2", QVariant::Double ) );
+      fields.append( QgsField( "name", QVariant::String ) );
+
+      QList<QgsAttributes> rows;
+      rows << ( QgsAttributes() << QVariant( 5 ) << QVariant( 2.5 ) << QVariant( "a" ) );
+      rows << ( QgsAttributes() << QVariant( 0 ) << QVariant( -1.0 ) << QVariant( "b" ) );
+      rows << ( QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) );
+      rows << ( QgsAttributes() << QVariant( 2 ) << QVariant( 0.0 ) << QVariant( "12" ) );
+
+      QStringList expressions;
+      expressions << "x1 + x2 * 2"
+      << "x1 / x1"
+      << "x1 % 3 - x1 // 2"
+      << "x1 > 3 and name = 'a'"
+      << "x1 < 3 or x2 >= 0"
+      << "not x1"
+      << "-x2 ^ 2"
+      << "x1 is null"
+      << "x2 is not 2.5"
+      << "x1 in (1, 2, 5)"
+      << "x1 not in (1, 'a', NULL)"
+      << "name in ('a', 'b')"
+      << "case when x1 > 3 then name || 'x' when x2 < 0 then x2 else 'other' end"
+      << "case when x1 = 2 then 'two' end"
+      << "coalesce( x2, 0 ) + 1"
+      << "upper( name ) || x1"
+      << "name + x1"
+      << "name + name"
+      << "x1 + 'b'";
+
+      Q_FOREACH ( const QString& expression, expressions )
+      {
+        QgsExpression treeExp( expression );
+        treeExp.setCompilationEnabled( false );
+        QgsExpression compiledExp( expression );
+
+        Q_FOREACH ( const QgsAttributes& attributes, rows )
+        {
+          QgsFeature f( fields );
+          f.setAttributes( attributes );
+          QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+          QVERIFY( treeExp.prepare( &context ) );
+          QVERIFY( !treeExp.isCompiled() );
+          QVERIFY( compiledExp.prepare( &context ) );
+          QVERIFY( compiledExp.isCompiled() );
+
+          QVariant expected = treeExp.evaluate( &context );
+          QVariant res = compiledExp.evaluate( &context );
+          QCOMPARE( compiledExp.hasEvalError(), treeExp.hasEvalError() );
+          QCOMPARE( res.type(), expected.type() );
+          QCOMPARE( res, expected );
+        }
+      }
+    }
+
+    void eval_block_data()
+    {
+      QTest::addColumn<bool>( "uniform" );
+      QTest::newRow( "non-null numbers" ) << true;
+      QTest::newRow( "mixed values" ) << false;
+    }
+
+    void eval_block()
+    {
+      QFETCH( bool, uniform );
+
+      QgsFields fields;
+      fields.append( QgsField( "x1", QVariant::Int ) );
+      fields.append( QgsField( "x2", QVariant::Double ) );
+      fields.append( QgsField( "name", QVariant::String ) );
+
+      QgsFeatureList features;
+      for ( int i = 0; i < 50; ++i )
+      {
+        QgsFeature f( fields, i );
+        if ( !uniform && i % 7 == 3 )
+          f.setAttributes( QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) );
+        else if ( !uniform && i == 20 )
+          f.setAttributes( QgsAttributes() << QVariant( "20" ) << QVariant( "x" ) << QVariant( "c" ) );
+        else
+          f.setAttributes( QgsAttributes() << QVariant( i - 10 ) << QVariant( i * 0.5 - 3 ) << QVariant( i % 2 ? "a" : "b" ) );
+        features << f;
+      }
+
+      QStringList expressions;
+      expressions << "x1"
+      << "x1 + x2 * 2"
+      << "x1 * 3 - 1"
+      << "x1 / 4"
+      << "x2 / x1"
+      << "x1 % 3 - x1 // 2"
+      << "x1 > 3 and x2 < 10"
+      << "x1 < 3 or x2 >= 0"
+      << "not x1"
+      << "-x2 ^ 2"
+      << "x1 is 5"
+      << "x2 is not 2.5"
+      << "x1 in (1, 2, 5)"
+      << "x1 not in (1, 'a', NULL)"
+      << "x1 > 3 and name = 'a'"
+      << "name + x1"
+      << "2 * 3"
+      << "case when x1 > 3 then name else 'other' end"
+      << "coalesce( x2, 0 ) + 1";
+
+      QgsExpressionContext referenceContext = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature(), fields );
+      QgsExpressionContext blockContext = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature(), fields );
+
+      Q_FOREACH ( const QString& expression, expressions )
+      {
+        QgsExpression reference( expression );
+        reference.setCompilationEnabled( false );
+        QVERIFY( reference.prepare( &referenceContext ) );
+        QgsExpression exp( expression );
+        QVERIFY( exp.prepare( &blockContext ) );
+
+        QString firstError;
+        QVariantList expected;
+        Q_FOREACH ( const QgsFeature& f, features )
+        {
+          referenceContext.setFeature( f );
+          QVariant res = reference.evaluate( &referenceContext );
+          if ( reference.hasEvalError() )
+          {
+            if ( firstError.isNull() )
+              firstError = reference.evalErrorString();
+            res = QVariant();
+          }
+          expected << res;
+        }
+
+        QVariantList results = exp.evaluateBlock( features, &blockContext );
+        QCOMPARE( results.count(), features.count() );
+        QCOMPARE( exp.evalErrorString(), firstError );
+        for ( int i = 0; i < results.count(); ++i )
+        {
+          QCOMPARE( results.at( i ).type(), expected.at( i ).type() );
+          QCOMPARE( results.at( i ), expected.at( i ) );
+        }
+      }
+
+      // empty block
+      QgsExpression exp( "x1 + 1" );
+      QVERIFY( exp.prepare( &blockContext ) );
+      QVERIFY( exp.evaluateBlock( QgsFeatureList(), &blockContext ).isEmpty() );
+      QVERIFY( !exp.hasEvalError() );
+    }
+
+    void eval_compiled_optimizations_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<int>( "nodeCount" );
+      QTest::addColumn<int>( "foldedNodeCount" );
+      QTest::addColumn<int>( "sharedNodeCount" );
+
+      QTest::newRow( "static variable" ) << "@static_var / 1000 * 2 + x1" << 8 << 6 << 0;
+      QTest::newRow( "non-static variable" ) << "@dynamic_var * 2 + x1" << 6 << 0 << 0;
+      QTest::newRow( "pure function" ) << "x1 + sqrt( 16 )" << 4 << 2 << 0;
+      QTest::newRow( "impure function" ) << "x1 + rand( 1, 1 )" << 5 << 0 << 0;
+      QTest::newRow( "constant condition" ) << "case when 1 > 2 then 'a' else upper( 'b' ) end" << 7 << 7 << 0;
+      QTest::newRow( "constant with error" ) << "'a' * 2 + x1" << 5 << 0 << 0;
+      QTest::newRow( "shared subtree" ) << "x1 * 1.5 + x1 * 1.5" << 7 << 0 << 3;
+      QTest::newRow( "shared column" ) << "x1 + x1" << 3 << 0 << 1;
+      QTest::newRow( "shared function" ) << "lower( x2 ) || lower( x2 )" << 5 << 0 << 2;
+      QTest::newRow( "different literals" ) << "x2 * 0.1 + x2 * 0.10000001" << 7 << 0 << 1;
+      QTest::newRow( "not shared from condition" ) << "case when x1 > 0 then x2 * 2 end + x2 * 2" << 11 << 0 << 0;
+      QTest::newRow( "not shared from arguments" ) << "coalesce( x2 * 2, 0 ) + x2 * 2" << 9 << 0 << 0;
+      QTest::newRow( "shared into condition" ) << "x2 * 2 + case when x1 > 0 then x2 * 2 end" << 11 << 0 << 3;
+    }
+
+    void eval_compiled_optimizations()
+    {
+      QFETCH( QString, string );
+      QFETCH( int, nodeCount );
+      QFETCH( int, foldedNodeCount );
+      QFETCH( int, sharedNodeCount );
+
+      QgsFields fields;
+      fields.append( QgsField( "x1", QVariant::Int ) );
+      fields.append( QgsField( "x2", QVariant::Double ) );
+
+      QgsExpressionContextScope* scope = new QgsExpressionContextScope();
+      scope->addVariable( QgsExpressionContextScope::StaticVariable( "static_var", 2500, false, true ) );
+      scope->addVariable( QgsExpressionContextScope::StaticVariable( "dynamic_var", 3 ) );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature(), fields );
+      context << scope;
+      QVERIFY( context.isStatic( "static_var" ) );
+      QVERIFY( !context.isStatic( "dynamic_var" ) );
+
+      QgsExpression reference( string );
+      reference.setCompilationEnabled( false );
+      QVERIFY( reference.prepare( &context ) );
+      QCOMPARE( reference.compilationStatistics().nodeCount, 0 );
+
+      QgsExpression exp( string );
+      QVERIFY( exp.prepare( &context ) );
+      QVERIFY( !exp.hasEvalError() );
+      QgsExpression::CompilationStatistics statistics = exp.compilationStatistics();
+      QCOMPARE( statistics.nodeCount, nodeCount );
+      QCOMPARE( statistics.foldedNodeCount, foldedNodeCount );
+      QCOMPARE( statistics.sharedNodeCount, sharedNodeCount );
+
+      QList<QgsAttributes> rows;
+      rows << ( QgsAttributes() << QVariant( 5 ) << QVariant( 2.5 ) );
+      rows << ( QgsAttributes() << QVariant( -1 ) << QVariant( 4.0 ) );
+      rows << ( QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) );
+      Q_FOREACH ( const QgsAttributes& attributes, rows )
+      {
+        QgsFeature f( fields );
+        f.setAttributes( attributes );
+        context.setFeature( f );
+
+        QVariant expected = reference.evaluate( &context );
+        QVariant res = exp.evaluate( &context );
+        QCOMPARE( exp.hasEvalError(), reference.hasEvalError() );
+        QCOMPARE( exp.evalErrorString(), reference.evalErrorString() );
+        QCOMPARE( res.type(), expected.type() );
+        QCOMPARE( res, expected );
+      }
+    }
+
     void eval_precedence()
     {
       QCOMPARE( QgsExpression::BinaryOperatorText[QgsExpression::boDiv], "/" );
@@ -24,12 +24,14 @@
 #include <QPointF>
 #include <QImage>
 #include <QPainter>
+#include <QtConcurrentMap>
 
 //qgis includes...
 #include <qgsapplication.h>
 #include <qgsgeometry.h>
 #include <qgspoint.h>
 #include "qgspointv2.h"
+#include "qgswkbgeometryview.h"
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -82,6 +84,12 @@ class TestQgsGeometry : public QObject
 
     void dataStream();
 
+    void wkbView();
+    void repeatedRelations();
+    void sharedRelationsInThreads();
+    void sharedWkbInThreads();
+    void relationsAfterReshape();
+
   private:
     /** A helper method to do a render check to see if the geometry op is as expected */
     bool renderCheck( QString theTestName, QString theComment = "", int mismatchCount = 0 );
@@ -739,6 +747,200 @@ void TestQgsGeometry::dataStream()
   QVERIFY( resultGeometry.isEmpty() );
 }
 
+void TestQgsGeometry::wkbView()
+{
+  QScopedPointer<QgsGeometry> source( QgsGeometry::fromWkt( "MultiPolygon (((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 4 2, 4 4, 2 2)),((20 20, 30 20, 30 25, 20 20)))" ) );
+  int size = source->wkbSize();
+
+  // view on the bytes
+  QgsWkbGeometryView view( source->asWkb(), size );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.wkbSize(), size );
+  QCOMPARE( view.wkbType(), QgsWKBTypes::MultiPolygon );
+  QCOMPARE( view.partCount(), 2 );
+  QCOMPARE( view.vertexCount(), 13 );
+  QVERIFY( !view.hasCurvedSegments() );
+  QCOMPARE( view.boundingBox(), QgsRectangle( 0, 0, 30, 25 ) );
+
+  QgsWkbGeometryView::VertexIterator it = view.vertices();
+  QgsPointV2 point;
+  int count = 0;
+  while ( it.next( point ) )
+  {
+    if ( count == 5 )
+    {
+      QCOMPARE( point, QgsPointV2( 2, 2 ) );
+      QCOMPARE( it.part(), 0 );
+      QCOMPARE( it.ring(), 1 );
+      QCOMPARE( it.vertex(), 0 );
+    }
+    ++count;
+  }
+  QCOMPARE( count, 13 );
+  QCOMPARE( it.part(), 1 );
+  QCOMPARE( it.ring(), 0 );
+  QCOMPARE( it.vertex(), 3 );
+
+  // truncated or unknown geometries are rejected
+  QVERIFY( !QgsWkbGeometryView( source->asWkb(), size - 1 ).isValid() );
+  QVERIFY( !QgsWkbGeometryView( 0, 0 ).isValid() );
+  QByteArray broken(( const char* )source->asWkb(), size );
+  broken[1] = 99;
+  QVERIFY( !QgsWkbGeometryView(( const unsigned char* )broken.constData(), size ).isValid() );
+
+  // a geometry set from WKB answers from the bytes
+  unsigned char* wkb = new unsigned char[size];
+  memcpy( wkb, source->asWkb(), size );
+  QgsGeometry geom;
+  geom.fromWkb( wkb, size );
+  QVERIFY( !geom.isEmpty() );
+  QCOMPARE( geom.asWkb(), ( const unsigned char* )wkb );
+  QCOMPARE( geom.wkbType(), QGis::WKBMultiPolygon );
+  QCOMPARE( geom.type(), QGis::Polygon );
+  QVERIFY( geom.isMultipart() );
+  QCOMPARE( geom.boundingBox(), QgsRectangle( 0, 0, 30, 25 ) );
+
+  // editing a copy builds its own geometry and leaves the original untouched
+  QgsGeometry copy( geom );
+  QVERIFY( copy.moveVertex( 15, 25, 9 ) );
+  QCOMPARE( copy.vertexAt( 9 ), QgsPoint( 15, 25 ) );
+  QCOMPARE( geom.asWkb(), ( const unsigned char* )wkb );
+  QCOMPARE( geom.vertexAt( 9 ), QgsPoint( 20, 20 ) );
+  QCOMPARE( geom.geometry()->asWkt(), source->geometry()->asWkt() );
+}
+
+void TestQgsGeometry::repeatedRelations()
+{
+  // the filter takes part in every test and is prepared after the first ones, the results must not change
+  QScopedPointer<QgsGeometry> filter( QgsGeometry::fromWkt( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(4 4, 6 4, 6 6, 4 6, 4 4))" ) );
+  for ( int i = 0; i < 3; ++i )
+  {
+    QScopedPointer<QgsGeometry> inside( QgsGeometry::fromWkt( "Point (1 1)" ) );
+    QScopedPointer<QgsGeometry> hole( QgsGeometry::fromWkt( "Point (5 5)" ) );
+    QScopedPointer<QgsGeometry> crossing( QgsGeometry::fromWkt( "LineString (-5 5, 5 1)" ) );
+
+    QVERIFY( inside->intersects( filter.data() ) );
+    QVERIFY( filter->contains( inside.data() ) );
+    QVERIFY( inside->within( filter.data() ) );
+    QVERIFY( !filter->within( inside.data() ) );
+    QVERIFY( !inside->contains( filter.data() ) );
+
+    QVERIFY( !hole->intersects( filter.data() ) );
+    QVERIFY( hole->disjoint( filter.data() ) );
+    QVERIFY( !filter->contains( hole.data() ) );
+
+    QVERIFY( crossing->crosses( filter.data() ) );
+    QVERIFY( filter->crosses( crossing.data() ) );
+    QVERIFY( !crossing->within( filter.data() ) );
+
+    QgsPoint p( 5, 5 );
+    QVERIFY( !filter->contains( &p ) );
+    p = QgsPoint( 2, 8 );
+    QVERIFY( filter->contains( &p ) );
+  }
+
+  // editing the geometry drops its prepared geometry
+  QVERIFY( filter->deleteRing( 1 ) );
+  QScopedPointer<QgsGeometry> hole( QgsGeometry::fromWkt( "Point (5 5)" ) );
+  QVERIFY( hole->intersects( filter.data() ) );
+  QVERIFY( filter->contains( hole.data() ) );
+
+  // rectangle tests decided by the bounding box alone
+  QVERIFY( filter->intersects( QgsRectangle( -1, -1, 11, 11 ) ) );
+  QVERIFY( !filter->intersects( QgsRectangle( 20, 20, 30, 30 ) ) );
+  QVERIFY( filter->intersects( QgsRectangle( 9, 9, 20, 20 ) ) );
+  QScopedPointer<QgsGeometry> diagonal( QgsGeometry::fromWkt( "LineString (0 0, 10 10)" ) );
+  QVERIFY( !diagonal->intersects( QgsRectangle( 6, 0, 10, 4 ) ) );
+}
+
+//! counts the points of a grid inside a copy of the filter
+static int pointsInside( const QgsGeometry& filter )
+{
+  int count = 0;
+  for ( int x = 0; x < 20; ++x )
+  {
+    for ( int y = 0; y < 20; ++y )
+    {
+      QScopedPointer<QgsGeometry> point( QgsGeometry::fromPoint( QgsPoint( x + 0.5, y + 0.5 ) ) );
+      if ( point->within( &filter ) && filter.intersects( point.data() ) )
+        ++count;
+    }
+  }
+  return count;
+}
+
+void TestQgsGeometry::sharedRelationsInThreads()
+{
+  // copies share the data of the filter, each thread prepares the filter for itself
+  QgsGeometry* filter = QgsGeometry::fromWkt( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(4 4, 6 4, 6 6, 4 6, 4 4))" );
+  QList<QgsGeometry> copies;
+  for ( int i = 0; i < 16; ++i )
+    copies << *filter;
+  delete filter;
+
+  QList<int> counts = QtConcurrent::blockingMapped( copies, pointsInside );
+  QCOMPARE( counts.count(), copies.count() );
+  Q_FOREACH ( int count, counts )
+  {
+    QCOMPARE( count, 96 );
+  }
+}
+
+//! returns the area of a copy of a geometry set from WKB, which is parsed by the first thread using it
+static double lazyArea( const QgsGeometry& geom )
+{
+  if ( geom.boundingBox() != QgsRectangle( 0, 0, 10, 10 ) )
+    return -1;
+  return geom.area();
+}
+
+void TestQgsGeometry::sharedWkbInThreads()
+{
+  QScopedPointer<QgsGeometry> source( QgsGeometry::fromWkt( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(4 4, 6 4, 6 6, 4 6, 4 4))" ) );
+  int size = source->wkbSize();
+
+  for ( int i = 0; i < 50; ++i )
+  {
+    unsigned char* wkb = new unsigned char[size];
+    memcpy( wkb, source->asWkb(), size );
+    QgsGeometry geom;
+    geom.fromWkb( wkb, size );
+
+    // the copies share the unparsed WKB
+    QList<QgsGeometry> copies;
+    for ( int j = 0; j < 16; ++j )
+      copies << geom;
+
+    QList<double> areas = QtConcurrent::blockingMapped( copies, lazyArea );
+    QCOMPARE( areas.count(), copies.count() );
+    Q_FOREACH ( double area, areas )
+    {
+      QCOMPARE( area, 96.0 );
+    }
+  }
+}
+
+void TestQgsGeometry::relationsAfterReshape()
+{
+  QScopedPointer<QgsGeometry> polygon( QgsGeometry::fromWkt( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  QScopedPointer<QgsGeometry> outside( QgsGeometry::fromWkt( "Point (12 5)" ) );
+
+  // repeated tests prepare the polygon
+  for ( int i = 0; i < 3; ++i )
+  {
+    QVERIFY( !polygon->contains( outside.data() ) );
+    QVERIFY( !outside->intersects( polygon.data() ) );
+  }
+
+  // the prepared geometry of the old shape is not used after reshaping
+  QList<QgsPoint> reshapeLine;
+  reshapeLine << QgsPoint( 8, 2 ) << QgsPoint( 15, 2 ) << QgsPoint( 15, 8 ) << QgsPoint( 8, 8 );
+  QCOMPARE( polygon->reshapeGeometry( reshapeLine ), 0 );
+  QVERIFY( polygon->contains( outside.data() ) );
+  QVERIFY( outside->intersects( polygon.data() ) );
+  QVERIFY( outside->within( polygon.data() ) );
+}
+
 bool TestQgsGeometry::renderCheck( QString theTestName, QString theComment, int mismatchCount )
 {
   mReport += "<h2>" + theTestName + "</h2>\n";
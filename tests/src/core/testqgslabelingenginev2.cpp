@@ -16,14 +16,17 @@
 #include <QtTest/QtTest>
 
 #include <qgsapplication.h>
+#include <qgsgeometry.h>
 #include <qgslabelingenginev2.h>
 #include <qgsmaplayerregistry.h>
 #include <qgsmaprenderersequentialjob.h>
 #include <qgsrulebasedlabeling.h>
+#include <qgsvectordataprovider.h>
 #include <qgsvectorlayer.h>
 #include <qgsvectorlayerdiagramprovider.h>
 #include <qgsvectorlayerlabeling.h>
 #include <qgsvectorlayerlabelprovider.h>
+#include <pal/rtree.hpp>
 
 class TestQgsLabelingEngineV2 : public QObject
 {
@@ -36,6 +39,10 @@ class TestQgsLabelingEngineV2 : public QObject
     void testBasic();
     void testDiagrams();
     void testRuleBased();
+    void testRepeatable();
+    void testBulkLoad();
+    void testIndependentParts();
+    void testPreviousResults();
 
   private:
     QgsVectorLayer* vl;
@@ -213,5 +220,248 @@ void TestQgsLabelingEngineV2::testRuleBased()
 
 }
 
+static QImage renderLabels( const QgsMapSettings& mapSettings, QgsVectorLayer* vl,
+                            QgsLabelingEngineV2::Flags flags = QgsLabelingEngineV2::RenderOutlineLabels | QgsLabelingEngineV2::UsePartialCandidates,
+                            QgsPalLabeling::Search searchMethod = QgsPalLabeling::Chain )
+{
+  QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+  img.fill( 0 );
+  QPainter p( &img );
+  QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+  context.setPainter( &p );
+
+  QgsLabelingEngineV2 engine;
+  engine.setMapSettings( mapSettings );
+  engine.setFlags( flags );
+  engine.setSearchMethod( searchMethod );
+  engine.addProvider( new QgsVectorLayerLabelProvider( vl ) );
+  engine.run( context );
+  p.end();
+  return img;
+}
+
+void TestQgsLabelingEngineV2::testRepeatable()
+{
+  // candidates are generated by several threads, the result must not depend on their timing
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QStringList() << vl->id() );
+
+  vl->setCustomProperty( "labeling", "pal" );
+  vl->setCustomProperty( "labeling/enabled", true );
+  vl->setCustomProperty( "labeling/fieldName", "Class" );
+
+  QImage img = renderLabels( mapSettings, vl );
+  for ( int i = 0; i < 5; ++i )
+  {
+    QCOMPARE( renderLabels( mapSettings, vl ), img );
+  }
+
+  // the single threaded path finds the same solution, also when many labels collide
+  vl->setCustomProperty( "labeling/fontSize", 24 );
+  mapSettings.setOutputSize( QSize( 200, 150 ) );
+  QgsLabelingEngineV2::Flags flags = QgsLabelingEngineV2::RenderOutlineLabels | QgsLabelingEngineV2::UsePartialCandidates;
+  QList<QgsPalLabeling::Search> searchMethods;
+  searchMethods << QgsPalLabeling::Chain << QgsPalLabeling::Popmusic_Tabu << QgsPalLabeling::Popmusic_Chain
+  << QgsPalLabeling::Popmusic_Tabu_Chain << QgsPalLabeling::Falp;
+  Q_FOREACH ( QgsPalLabeling::Search searchMethod, searchMethods )
+  {
+    QImage serial = renderLabels( mapSettings, vl, flags | QgsLabelingEngineV2::SingleThreaded, searchMethod );
+    QCOMPARE( renderLabels( mapSettings, vl, flags, searchMethod ), serial );
+  }
+
+  vl->removeCustomProperty( "labeling/fontSize" );
+  vl->setCustomProperty( "labeling/enabled", false );
+}
+
+static bool collectItem( int* item, void* ctx )
+{
+  *( QList<int*>* ) ctx << item;
+  return true;
+}
+
+void TestQgsLabelingEngineV2::testBulkLoad()
+{
+  QVector<double> mins;
+  QVector<double> maxs;
+  // the tree stores pointers, as the tree of label candidates does
+  QVector<int> values( 1000 );
+  QVector<int*> items;
+  qsrand( 1 );
+  for ( int i = 0; i < 1000; ++i )
+  {
+    double x = qrand() % 1000;
+    double y = qrand() % 1000;
+    mins << x << y;
+    maxs << x + qrand() % 20 << y + qrand() % 20;
+    items << &values[i];
+  }
+
+  pal::RTree<int*, double, 2, double> inserted;
+  for ( int i = 0; i < items.count(); ++i )
+  {
+    inserted.Insert( mins.constData() + 2 * i, maxs.constData() + 2 * i, items[i] );
+  }
+  pal::RTree<int*, double, 2, double> loaded;
+  loaded.BulkLoad( mins.constData(), maxs.constData(), items.constData(), items.count() );
+  QCOMPARE( loaded.Count(), items.count() );
+
+  for ( int i = 0; i < 100; ++i )
+  {
+    double amin[2] = { double( qrand() % 1000 ), double( qrand() % 1000 ) };
+    double amax[2] = { amin[0] + 50, amin[1] + 50 };
+    QList<int*> expected;
+    QList<int*> found;
+    inserted.Search( amin, amax, collectItem, &expected );
+    loaded.Search( amin, amax, collectItem, &found );
+    qSort( expected );
+    qSort( found );
+    QCOMPARE( found, expected );
+  }
+
+  // the loaded tree stays usable for removal
+  loaded.Remove( mins.constData(), maxs.constData(), items[0] );
+  QCOMPARE( loaded.Count(), items.count() - 1 );
+
+  // loading replaces the previous entries
+  loaded.BulkLoad( mins.constData(), maxs.constData(), items.constData(), 0 );
+  QCOMPARE( loaded.Count(), 0 );
+}
+
+static QStringList placedLabels( const QgsMapSettings& mapSettings, QgsVectorLayer* layer, QgsLabelingEngineV2::Flags flags = 0 )
+{
+  QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &img );
+  QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+  context.setPainter( &p );
+
+  QgsLabelingEngineV2 engine;
+  engine.setMapSettings( mapSettings );
+  engine.setFlags( engine.flags() | flags );
+  engine.addProvider( new QgsVectorLayerLabelProvider( layer ) );
+  engine.run( context );
+  p.end();
+
+  QStringList labels;
+  Q_FOREACH ( const QgsLabelPosition& label, engine.results()->labelsWithinRect( mapSettings.extent() ) )
+  {
+    labels << QString( "%1 %2" ).arg( label.featureId ).arg( label.labelRect.toString() );
+  }
+  labels.sort();
+  return labels;
+}
+
+void TestQgsLabelingEngineV2::testIndependentParts()
+{
+  // many small groups of conflicting labels, solved as independent parts of the problem
+  QgsVectorLayer layer( "Point?field=name:string", "groups", "memory" );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int group = 0; group < 400; ++group )
+  {
+    double x = ( group % 20 ) * 100;
+    double y = ( group / 20 ) * 100;
+    for ( int i = 0; i < 3; ++i )
+    {
+      QgsFeature feature( layer.pendingFields() );
+      feature.setAttribute( 0, QString( "label %1" ).arg( i ) );
+      feature.setGeometry( QgsGeometry::fromPoint( QgsPoint( x + i * 0.5, y ) ) );
+      features << feature;
+    }
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  layer.setCustomProperty( "labeling", "pal" );
+  layer.setCustomProperty( "labeling/enabled", true );
+  layer.setCustomProperty( "labeling/fieldName", "name" );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 2000, 2000 ) );
+  mapSettings.setExtent( QgsRectangle( -50, -50, 1950, 1950 ) );
+
+  QStringList labels = placedLabels( mapSettings, &layer );
+
+  // every group has at least one label
+  QSet<int> labeledGroups;
+  Q_FOREACH ( const QString& label, labels )
+  {
+    labeledGroups << ( label.section( ' ', 0, 0 ).toInt() - 1 ) / 3;
+  }
+  QCOMPARE( labeledGroups.count(), 400 );
+
+  // the parts are solved at least as well as the whole problem
+  QStringList unpartitioned = placedLabels( mapSettings, &layer, QgsLabelingEngineV2::Unpartitioned );
+  QVERIFY( labels.count() >= unpartitioned.count() );
+
+  // the parts searched in a single thread give the same solution
+  QCOMPARE( placedLabels( mapSettings, &layer, QgsLabelingEngineV2::SingleThreaded ), labels );
+  QCOMPARE( placedLabels( mapSettings, &layer ), labels );
+}
+
+static QgsLabelingResults* labelingResults( const QgsMapSettings& mapSettings, QgsVectorLayer* layer, const QgsLabelingResults* previousResults )
+{
+  QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &img );
+  QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+  context.setPainter( &p );
+
+  QgsLabelingEngineV2 engine;
+  engine.setMapSettings( mapSettings );
+  engine.setPreviousResults( previousResults );
+  engine.addProvider( new QgsVectorLayerLabelProvider( layer ) );
+  engine.run( context );
+  p.end();
+
+  return engine.takeResults();
+}
+
+void TestQgsLabelingEngineV2::testPreviousResults()
+{
+  // rows of points whose labels collide with the labels of their neighbours
+  QgsVectorLayer layer( "Point?field=name:string", "rows", "memory" );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 200; ++i )
+  {
+    QgsFeature feature( layer.pendingFields() );
+    feature.setAttribute( 0, QString( "label %1" ).arg( i ) );
+    feature.setGeometry( QgsGeometry::fromPoint( QgsPoint(( i % 20 ) * 10, ( i / 20 ) * 4 ) ) );
+    features << feature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  layer.setCustomProperty( "labeling", "pal" );
+  layer.setCustomProperty( "labeling/enabled", true );
+  layer.setCustomProperty( "labeling/fieldName", "name" );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 800, 400 ) );
+  mapSettings.setExtent( QgsRectangle( -20, -20, 220, 60 ) );
+  QScopedPointer<QgsLabelingResults> previous( labelingResults( mapSettings, &layer, 0 ) );
+  QList<QgsLabelPosition> previousLabels = previous->labelsWithinRect( mapSettings.extent() );
+  QVERIFY( !previousLabels.isEmpty() );
+
+  // after a small pan, the labels of all features which are still labeled do not move
+  mapSettings.setExtent( QgsRectangle( -17, -21, 223, 59 ) );
+  QScopedPointer<QgsLabelingResults> results( labelingResults( mapSettings, &layer, previous.data() ) );
+  QList<QgsLabelPosition> labels = results->labelsWithinRect( mapSettings.extent() );
+  QVERIFY( !labels.isEmpty() );
+  int kept = 0;
+  Q_FOREACH ( const QgsLabelPosition& label, labels )
+  {
+    Q_FOREACH ( const QgsLabelPosition& previousLabel, previousLabels )
+    {
+      if ( previousLabel.featureId != label.featureId )
+        continue;
+
+      QVERIFY( qgsDoubleNear( label.labelRect.xMinimum(), previousLabel.labelRect.xMinimum(), 1e-6 ) );
+      QVERIFY( qgsDoubleNear( label.labelRect.yMinimum(), previousLabel.labelRect.yMinimum(), 1e-6 ) );
+      ++kept;
+    }
+  }
+  QCOMPARE( kept, previousLabels.count() );
+}
+
 QTEST_MAIN( TestQgsLabelingEngineV2 )
 #include "testqgslabelingenginev2.moc"
@@ -0,0 +1,190 @@
+/***************************************************************************
+     testqgslabelspritecache.cpp
+     --------------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPicture>
+
+//header for class being tested
+#include <qgslabelspritecache.h>
+#include <qgsapplication.h>
+#include <qgsfontutils.h>
+
+class TestQgsLabelSpriteCache: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void disabled();
+    void drawText();
+    void rotatedPainter();
+    void vectorDevice();
+    void maxBytes();
+};
+
+//! draws a buffered text at a position with or without the cache
+static QImage renderText( QgsLabelSpriteCache* cache, const QPointF& position, double scale )
+{
+  QImage image( 200, 100, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+  QPainter p( &image );
+  p.setRenderHint( QPainter::Antialiasing );
+  p.translate( position );
+  p.scale( scale, scale );
+
+  QFont font = QgsFontUtils::getStandardTestFont();
+  font.setPixelSize( 20 );
+  QPen pen( Qt::white );
+  pen.setWidthF( 3.0 );
+  pen.setJoinStyle( Qt::RoundJoin );
+  QBrush brush( Qt::white );
+
+  if ( !cache || !cache->drawText( &p, "Main St", font, pen, brush ) )
+  {
+    QPainterPath path;
+    path.setFillRule( Qt::WindingFill );
+    path.addText( 0, 0, font, "Main St" );
+    p.setPen( pen );
+    p.setBrush( brush );
+    p.drawPath( path );
+  }
+  p.end();
+  return image;
+}
+
+//! returns the largest difference of the alpha channels of two images
+static int maxAlphaDifference( const QImage& image1, const QImage& image2 )
+{
+  int difference = 0;
+  for ( int y = 0; y < image1.height(); ++y )
+  {
+    for ( int x = 0; x < image1.width(); ++x )
+    {
+      difference = qMax( difference, qAbs( qAlpha( image1.pixel( x, y ) ) - qAlpha( image2.pixel( x, y ) ) ) );
+    }
+  }
+  return difference;
+}
+
+void TestQgsLabelSpriteCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsLabelSpriteCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsLabelSpriteCache::disabled()
+{
+  QgsLabelSpriteCache cache;
+  QCOMPARE( cache.maxBytes(), 0 );
+
+  QImage image( 10, 10, QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &image );
+  QVERIFY( !cache.drawText( &p, "text", QgsFontUtils::getStandardTestFont(), Qt::NoPen, Qt::black ) );
+  p.end();
+  QCOMPARE( cache.totalBytes(), 0 );
+}
+
+void TestQgsLabelSpriteCache::drawText()
+{
+  QgsLabelSpriteCache cache( 10 * 1024 * 1024 );
+
+  // positions on whole pixels are drawn like the path itself
+  QImage expected = renderText( 0, QPointF( 20, 60 ), 1.0 );
+  QImage first = renderText( &cache, QPointF( 20, 60 ), 1.0 );
+  QVERIFY( cache.totalBytes() > 0 );
+  QVERIFY( maxAlphaDifference( first, expected ) <= 1 );
+
+  // the sprite is reused for other placements of the text
+  int bytes = cache.totalBytes();
+  QImage moved = renderText( &cache, QPointF( 40, 70 ), 1.0 );
+  QCOMPARE( cache.totalBytes(), bytes );
+  QVERIFY( maxAlphaDifference( moved, renderText( 0, QPointF( 40, 70 ), 1.0 ) ) <= 1 );
+
+  // subpixel positions and other scales get their own sprites
+  QImage shifted = renderText( &cache, QPointF( 20.5, 60.25 ), 1.0 );
+  QVERIFY( cache.totalBytes() > bytes );
+  QVERIFY( maxAlphaDifference( shifted, renderText( 0, QPointF( 20.5, 60.25 ), 1.0 ) ) <= 1 );
+  bytes = cache.totalBytes();
+  renderText( &cache, QPointF( 20, 60 ), 1.5 );
+  QVERIFY( cache.totalBytes() > bytes );
+
+  cache.clear();
+  QCOMPARE( cache.totalBytes(), 0 );
+}
+
+void TestQgsLabelSpriteCache::rotatedPainter()
+{
+  QgsLabelSpriteCache cache( 10 * 1024 * 1024 );
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &image );
+  p.translate( 50, 50 );
+  p.rotate( 30 );
+  QVERIFY( !cache.drawText( &p, "text", QgsFontUtils::getStandardTestFont(), Qt::NoPen, Qt::black ) );
+  p.end();
+  QCOMPARE( cache.totalBytes(), 0 );
+}
+
+void TestQgsLabelSpriteCache::vectorDevice()
+{
+  QgsLabelSpriteCache cache( 10 * 1024 * 1024 );
+
+  // a sprite recorded into a picture would be pixelated when the picture is replayed scaled
+  QPicture picture;
+  QPainter p( &picture );
+  p.translate( 20, 60 );
+  QVERIFY( !cache.drawText( &p, "text", QgsFontUtils::getStandardTestFont(), Qt::NoPen, Qt::black ) );
+  p.end();
+  QCOMPARE( cache.totalBytes(), 0 );
+
+  // the same text drawn on an image is cached
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+  QPainter imagePainter( &image );
+  imagePainter.scale( 2, 2 );
+  QVERIFY( cache.drawText( &imagePainter, "text", QgsFontUtils::getStandardTestFont(), Qt::NoPen, Qt::black ) );
+  imagePainter.end();
+  QVERIFY( cache.totalBytes() > 0 );
+}
+
+void TestQgsLabelSpriteCache::maxBytes()
+{
+  QgsLabelSpriteCache cache( 10 * 1024 * 1024 );
+  renderText( &cache, QPointF( 20, 60 ), 1.0 );
+  renderText( &cache, QPointF( 20, 60 ), 2.0 );
+  int bytes = cache.totalBytes();
+  QVERIFY( bytes > 0 );
+
+  // the least recently used sprites are dropped
+  cache.setMaxBytes( bytes - 1 );
+  QVERIFY( cache.totalBytes() < bytes );
+  QCOMPARE( cache.maxBytes(), bytes - 1 );
+
+  // sprites larger than the cache are drawn but not kept
+  cache.setMaxBytes( 1 );
+  QCOMPARE( cache.totalBytes(), 0 );
+  QImage image = renderText( &cache, QPointF( 20, 60 ), 1.0 );
+  QCOMPARE( cache.totalBytes(), 0 );
+  QVERIFY( maxAlphaDifference( image, renderText( 0, QPointF( 20, 60 ), 1.0 ) ) <= 1 );
+}
+
+QTEST_MAIN( TestQgsLabelSpriteCache )
+#include "testqgslabelspritecache.moc"
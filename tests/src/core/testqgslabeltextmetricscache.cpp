@@ -0,0 +1,181 @@
+/***************************************************************************
+     testqgslabeltextmetricscache.cpp
+     --------------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QtConcurrentMap>
+
+//header for class being tested
+#include <qgslabeltextmetricscache.h>
+#include <qgsapplication.h>
+#include <qgsfontutils.h>
+#include <qgspallabeling.h>
+
+class TestQgsLabelTextMetricsCache: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void fontKey();
+    void width();
+    void graphemes();
+    void maxCost();
+    void concurrentUse();
+};
+
+void TestQgsLabelTextMetricsCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsLabelTextMetricsCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsLabelTextMetricsCache::fontKey()
+{
+  QFont font = QgsFontUtils::getStandardTestFont();
+  font.setPixelSize( 20 );
+  QString key = QgsLabelTextMetricsCache::fontKey( font );
+  QCOMPARE( QgsLabelTextMetricsCache::fontKey( QFont( font ) ), key );
+
+  // everything which changes the width of text changes the key
+  QFont spaced( font );
+  spaced.setLetterSpacing( QFont::AbsoluteSpacing, 2.0 );
+  QVERIFY( QgsLabelTextMetricsCache::fontKey( spaced ) != key );
+  QFont wordSpaced( font );
+  wordSpaced.setWordSpacing( 3.0 );
+  QVERIFY( QgsLabelTextMetricsCache::fontKey( wordSpaced ) != key );
+  QFont capitals( font );
+  capitals.setCapitalization( QFont::AllUppercase );
+  QVERIFY( QgsLabelTextMetricsCache::fontKey( capitals ) != key );
+  QFont larger( font );
+  larger.setPixelSize( 21 );
+  QVERIFY( QgsLabelTextMetricsCache::fontKey( larger ) != key );
+}
+
+void TestQgsLabelTextMetricsCache::width()
+{
+  QgsLabelTextMetricsCache cache;
+  QFont font = QgsFontUtils::getStandardTestFont();
+  font.setPixelSize( 20 );
+  QFontMetricsF fm( font );
+
+  QCOMPARE( cache.width( font, fm, "Main Street" ), fm.width( "Main Street" ) );
+  QCOMPARE( cache.totalCost(), 1 );
+  QCOMPARE( cache.width( font, fm, "Main Street" ), fm.width( "Main Street" ) );
+  QCOMPARE( cache.totalCost(), 1 );
+
+  // other fonts are measured separately
+  QFont larger( font );
+  larger.setPixelSize( 40 );
+  QFontMetricsF largerFm( larger );
+  QCOMPARE( cache.width( larger, largerFm, "Main Street" ), largerFm.width( "Main Street" ) );
+  QCOMPARE( cache.totalCost(), 2 );
+
+  cache.clear();
+  QCOMPARE( cache.totalCost(), 0 );
+}
+
+void TestQgsLabelTextMetricsCache::graphemes()
+{
+  QgsLabelTextMetricsCache cache;
+  QFont font = QgsFontUtils::getStandardTestFont();
+  font.setPixelSize( 20 );
+  font.setWordSpacing( 5.0 );
+  QFontMetricsF fm( font );
+
+  QgsLabelTextMetricsCache::Graphemes straight = cache.graphemes( font, fm, "Main St", false );
+  QCOMPARE( straight.clusters, QgsPalLabeling::splitToGraphemes( "Main St" ) );
+  QCOMPARE( straight.widths.count(), straight.clusters.count() );
+  for ( int i = 0; i < straight.clusters.count(); ++i )
+  {
+    QCOMPARE( straight.widths.at( i ), fm.width( straight.clusters.at( i ) ) );
+  }
+  QCOMPARE( cache.totalCost(), 1 + straight.clusters.count() );
+
+  // advances of curved labels are corrected for word spacing and cached separately
+  QgsLabelTextMetricsCache::Graphemes curved = cache.graphemes( font, fm, "Main St", true );
+  QCOMPARE( curved.clusters, straight.clusters );
+  QCOMPARE( cache.totalCost(), 2 * ( 1 + straight.clusters.count() ) );
+
+  QgsLabelTextMetricsCache::Graphemes cached = cache.graphemes( font, fm, "Main St", true );
+  QCOMPARE( cached.widths, curved.widths );
+  QCOMPARE( cache.totalCost(), 2 * ( 1 + straight.clusters.count() ) );
+}
+
+void TestQgsLabelTextMetricsCache::maxCost()
+{
+  QgsLabelTextMetricsCache cache( 3 );
+  QFont font = QgsFontUtils::getStandardTestFont();
+  QFontMetricsF fm( font );
+
+  cache.width( font, fm, "a" );
+  cache.width( font, fm, "b" );
+  cache.width( font, fm, "c" );
+  cache.width( font, fm, "d" );
+  QCOMPARE( cache.totalCost(), 3 );
+
+  // texts are still measured with the cache disabled
+  cache.setMaxCost( 0 );
+  QCOMPARE( cache.totalCost(), 0 );
+  QCOMPARE( cache.width( font, fm, "e" ), fm.width( "e" ) );
+  QCOMPARE( cache.totalCost(), 0 );
+  QCOMPARE( cache.maxCost(), 0 );
+}
+
+struct MeasureText
+{
+  typedef qreal result_type;
+
+  MeasureText( QgsLabelTextMetricsCache* cache ) : mCache( cache ) {}
+
+  qreal operator()( const QString& text ) const
+  {
+    QFont font = QgsFontUtils::getStandardTestFont();
+    font.setPixelSize( 20 );
+    QFontMetricsF fm( font );
+    return mCache->width( font, fm, text );
+  }
+
+  QgsLabelTextMetricsCache* mCache;
+};
+
+void TestQgsLabelTextMetricsCache::concurrentUse()
+{
+  QgsLabelTextMetricsCache cache( 50 );
+  QStringList texts;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    texts << QString( "Street %1" ).arg( i % 100 );
+  }
+
+  QList<qreal> widths = QtConcurrent::blockingMapped< QList<qreal> >( texts, MeasureText( &cache ) );
+
+  QFont font = QgsFontUtils::getStandardTestFont();
+  font.setPixelSize( 20 );
+  QFontMetricsF fm( font );
+  for ( int i = 0; i < texts.count(); ++i )
+  {
+    QCOMPARE( widths.at( i ), fm.width( texts.at( i ) ) );
+  }
+  QVERIFY( cache.totalCost() <= 50 );
+}
+
+QTEST_MAIN( TestQgsLabelTextMetricsCache )
+#include "testqgslabeltextmetricscache.moc"
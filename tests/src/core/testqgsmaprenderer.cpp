@@ -37,6 +37,8 @@
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsmaplayerregistry.h>
+#include <qgsmaprendererjob.h>
+#include <QThreadPool>
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -72,6 +74,9 @@ class TestQgsMapRenderer : public QObject
     /** This method tests render perfomance */
     void performanceTest();
 
+    /** This method tests that rendering in parallel tiles gives the same result */
+    void parallelTileOwnershipTest();
+
   private:
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError;
@@ -211,6 +216,79 @@ void TestQgsMapRenderer::performanceTest()
   QVERIFY( myResultFlag );
 }
 
+void TestQgsMapRenderer::parallelTileOwnershipTest()
+{
+  // features whose geometry misses the strip holding the center of their bounding box
+  // must still be drawn when the layer is rendered in tiles
+  QString myFileName = QDir::tempPath() + "/maprender_tileownership.shp";
+  QgsVectorFileWriter::deleteShapeFile( myFileName );
+  {
+    QgsVectorFileWriter myWriter( myFileName, mEncoding, mFields, QGis::WKBMultiPolygon, &mCRS );
+    QVERIFY( myWriter.hasError() == QgsVectorFileWriter::NoError );
+
+    // enough small squares along the bottom to render the layer in tiles
+    for ( int i = 0; i < 50000; ++i )
+    {
+      double x = ( i % 500 ) * 0.2;
+      double y = ( i / 500 ) * 0.05;
+      QgsFeature myFeature;
+      myFeature.setGeometry( QgsGeometry::fromRect( QgsRectangle( x, y, x + 0.1, y + 0.025 ) ) );
+      myFeature.initAttributes( 1 );
+      myFeature.setAttribute( 0, i );
+      QVERIFY( myWriter.addFeature( myFeature ) );
+    }
+
+    // multipart feature with parts in the first and the last strip only
+    QgsFeature myMultiFeature;
+    myMultiFeature.setGeometry( QgsGeometry::fromWkt( "MULTIPOLYGON(((1 40,4 40,4 60,1 60,1 40)),((96 40,99 40,99 60,96 60,96 40)))" ) );
+    myMultiFeature.initAttributes( 1 );
+    myMultiFeature.setAttribute( 0, -1 );
+    QVERIFY( myWriter.addFeature( myMultiFeature ) );
+
+    // concave feature whose arms reach into the extent, joined outside of it
+    QgsFeature myConcaveFeature;
+    myConcaveFeature.setGeometry( QgsGeometry::fromWkt( "MULTIPOLYGON(((6 90,10 90,10 -40,90 -40,90 90,94 90,94 -50,6 -50,6 90)))" ) );
+    myConcaveFeature.initAttributes( 1 );
+    myConcaveFeature.setAttribute( 0, -2 );
+    QVERIFY( myWriter.addFeature( myConcaveFeature ) );
+  }
+
+  QgsVectorLayer* myLayer = new QgsVectorLayer( myFileName, "tileownership", "ogr" );
+  QVERIFY( myLayer->isValid() );
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer *>() << myLayer );
+
+  int myMaxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+
+  QgsMapSettings mySettings;
+  mySettings.setLayers( QStringList() << myLayer->id() );
+  mySettings.setOutputSize( QSize( 400, 400 ) );
+  mySettings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  mySettings.setFlag( QgsMapSettings::Antialiasing, false );
+
+  QgsMapRendererSequentialJob mySerialJob( mySettings );
+  mySerialJob.start();
+  mySerialJob.waitForFinished();
+  QImage mySerialImage = mySerialJob.renderedImage();
+
+  mySettings.setFlag( QgsMapSettings::ParallelTileRendering );
+  QgsMapRendererSequentialJob myTiledJob( mySettings );
+  myTiledJob.start();
+  myTiledJob.waitForFinished();
+  QImage myTiledImage = myTiledJob.renderedImage();
+
+  QThreadPool::globalInstance()->setMaxThreadCount( myMaxThreadCount );
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << myLayer->id() );
+
+  // the parts and the arms are drawn...
+  QPoint myMultiPartPixel = mySettings.mapToPixel().transform( 2.5, 50 ).toQPointF().toPoint();
+  QPoint myConcaveArmPixel = mySettings.mapToPixel().transform( 92, 50 ).toQPointF().toPoint();
+  QVERIFY( myTiledImage.pixel( myMultiPartPixel ) != mySettings.backgroundColor().rgb() );
+  QVERIFY( myTiledImage.pixel( myConcaveArmPixel ) != mySettings.backgroundColor().rgb() );
+  // ...exactly like on a single thread
+  QCOMPARE( myTiledImage, mySerialImage );
+}
+
 QTEST_MAIN( TestQgsMapRenderer )
 #include "testqgsmaprenderer.moc"
 
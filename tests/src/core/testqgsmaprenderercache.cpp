@@ -0,0 +1,364 @@
+/***************************************************************************
+     testqgsmaprenderercache.cpp
+     --------------------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QDir>
+#include <QImage>
+
+//qgis includes...
+#include <qgsapplication.h>
+#include <qgsfeature.h>
+#include <qgsmaplayerregistry.h>
+#include <qgsmaprenderercache.h>
+#include <qgsvectorlayer.h>
+
+/** \ingroup UnitTests
+ * This is a unit test for the QgsMapRendererCache class.
+ */
+class TestQgsMapRendererCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestQgsMapRendererCache()
+        : mpLayer( 0 )
+        , mpFileLayer( 0 )
+    {}
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void currentView();
+    void previousViews();
+    void memoryLimit();
+    void invalidateOnRepaint();
+    void rotationAndCrs();
+    void diskCache();
+    void diskCacheDataChanged();
+    void diskCacheSelection();
+    void diskCacheLimit();
+
+  private:
+    QImage image( QRgb color ) const;
+    //! returns an image that does not compress, so that it takes about 3-4 bytes per pixel on disk
+    QImage noiseImage( QSize size ) const;
+
+    QgsVectorLayer* mpLayer;
+    QgsVectorLayer* mpFileLayer;
+    QString mDataDir;
+};
+
+void TestQgsMapRendererCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mpLayer = new QgsVectorLayer( "Point", "cached", "memory" );
+  QgsMapLayerRegistry::instance()->addMapLayer( mpLayer );
+
+  // images are only stored on disk for layers with a known modification time of their data
+  mDataDir = QDir::tempPath() + "/qgis_test_render_cache_data";
+  QDir().mkpath( mDataDir );
+  Q_FOREACH ( const QString& ext, QStringList() << "shp" << "shx" << "dbf" << "prj" )
+  {
+    QFile::remove( mDataDir + "/points." + ext );
+    QVERIFY( QFile::copy( QString( TEST_DATA_DIR ) + "/points." + ext, mDataDir + "/points." + ext ) );
+  }
+  mpFileLayer = new QgsVectorLayer( mDataDir + "/points.shp", "cached_file", "ogr" );
+  QVERIFY( mpFileLayer->isValid() );
+  QgsMapLayerRegistry::instance()->addMapLayer( mpFileLayer );
+}
+
+void TestQgsMapRendererCache::cleanupTestCase()
+{
+  QgsMapLayerRegistry::instance()->removeAllMapLayers();
+  Q_FOREACH ( const QString& ext, QStringList() << "shp" << "shx" << "dbf" << "prj" )
+    QFile::remove( mDataDir + "/points." + ext );
+  QDir().rmdir( mDataDir );
+
+  QgsApplication::exitQgis();
+}
+
+QImage TestQgsMapRendererCache::image( QRgb color ) const
+{
+  QImage img( 100, 50, QImage::Format_ARGB32_Premultiplied );
+  img.fill( color );
+  return img;
+}
+
+QImage TestQgsMapRendererCache::noiseImage( QSize size ) const
+{
+  QImage img( size, QImage::Format_ARGB32_Premultiplied );
+  for ( int y = 0; y < size.height(); ++y )
+  {
+    for ( int x = 0; x < size.width(); ++x )
+      img.setPixel( x, y, qRgb( qrand() % 256, qrand() % 256, qrand() % 256 ) );
+  }
+  return img;
+}
+
+void TestQgsMapRendererCache::currentView()
+{
+  QgsMapRendererCache cache;
+  QVERIFY( !cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 ) );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+  QCOMPARE( cache.cacheImage( mpLayer->id() ), image( qRgb( 255, 0, 0 ) ) );
+
+  // same parameters - cache is still valid
+  QVERIFY( cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 ) );
+  QCOMPARE( cache.cacheImage( mpLayer->id() ), image( qRgb( 255, 0, 0 ) ) );
+
+  cache.clearCacheImage( mpLayer->id() );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+  cache.clear();
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+}
+
+void TestQgsMapRendererCache::previousViews()
+{
+  QgsMapRendererCache cache;
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+
+  // pan - the image of the previous view must not be used for the new one
+  QVERIFY( !cache.init( QgsRectangle( 10, 0, 20, 5 ), 1000, QSize( 100, 50 ), 96 ) );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 0, 255, 0 ) ) );
+
+  // different resolution of the same view
+  QVERIFY( !cache.init( QgsRectangle( 10, 0, 20, 5 ), 1000, QSize( 100, 50 ), 300 ) );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+
+  // pan back - both previous views are restored
+  QVERIFY( !cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 ) );
+  QCOMPARE( cache.cacheImage( mpLayer->id() ), image( qRgb( 255, 0, 0 ) ) );
+  QVERIFY( !cache.init( QgsRectangle( 10, 0, 20, 5 ), 1000, QSize( 100, 50 ), 96 ) );
+  QCOMPARE( cache.cacheImage( mpLayer->id() ), image( qRgb( 0, 255, 0 ) ) );
+}
+
+void TestQgsMapRendererCache::memoryLimit()
+{
+  QgsMapRendererCache cache;
+  cache.setMaximumMemoryUsage( 0 );
+  QCOMPARE( cache.maximumMemoryUsage(), 0 );
+
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+  cache.init( QgsRectangle( 10, 0, 20, 5 ), 1000, QSize( 100, 50 ), 96 );
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+}
+
+void TestQgsMapRendererCache::invalidateOnRepaint()
+{
+  QgsMapRendererCache cache;
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+  cache.init( QgsRectangle( 10, 0, 20, 5 ), 1000, QSize( 100, 50 ), 96 );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 0, 255, 0 ) ) );
+
+  // all views of the layer are invalidated
+  mpLayer->triggerRepaint();
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+  QMetaObject::invokeMethod( mpLayer, "dataChanged" );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+}
+
+void TestQgsMapRendererCache::rotationAndCrs()
+{
+  QgsMapRendererCache cache;
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 255, 0, 0 ) ) );
+
+  // the same extent rotated
+  QVERIFY( !cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96, 45.0 ) );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+  cache.setCacheImage( mpLayer->id(), image( qRgb( 0, 255, 0 ) ) );
+
+  // the same extent in another CRS
+  QVERIFY( !cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96, 0.0, "+proj=longlat +datum=WGS84 +no_defs" ) );
+  QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+
+  QVERIFY( !cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96, 45.0 ) );
+  QCOMPARE( cache.cacheImage( mpLayer->id() ), image( qRgb( 0, 255, 0 ) ) );
+  QVERIFY( !cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 ) );
+  QCOMPARE( cache.cacheImage( mpLayer->id() ), image( qRgb( 255, 0, 0 ) ) );
+}
+
+void TestQgsMapRendererCache::diskCache()
+{
+  QString dirPath = QDir::tempPath() + "/qgis_test_render_cache";
+  QDir().mkpath( dirPath );
+
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    QCOMPARE( cache.cacheDirectory(), dirPath );
+    cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+    cache.setCacheImage( mpFileLayer->id(), image( qRgb( 0, 0, 255 ) ) );
+    // memory layers are lost on restart, their images are not stored
+    cache.setCacheImage( mpLayer->id(), image( qRgb( 0, 0, 255 ) ) );
+  }
+
+  // a new cache picks up the image stored by the previous one
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+    QCOMPARE( cache.cacheImage( mpFileLayer->id() ), image( qRgb( 0, 0, 255 ) ) );
+    QVERIFY( cache.cacheImage( mpLayer->id() ).isNull() );
+
+    // other views are not on disk
+    cache.init( QgsRectangle( 10, 0, 20, 5 ), 1000, QSize( 100, 50 ), 96 );
+    QVERIFY( cache.cacheImage( mpFileLayer->id() ).isNull() );
+    cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96, 45.0 );
+    QVERIFY( cache.cacheImage( mpFileLayer->id() ).isNull() );
+
+    // invalidating the layer removes the images from disk as well
+    mpFileLayer->triggerRepaint();
+  }
+
+  {
+    QgsMapRendererCache cache2;
+    cache2.setCacheDirectory( dirPath );
+    cache2.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+    QVERIFY( cache2.cacheImage( mpFileLayer->id() ).isNull() );
+
+    cache2.setCacheImage( mpFileLayer->id(), image( qRgb( 0, 0, 255 ) ) );
+    cache2.clearDiskCache();
+  }
+  QVERIFY( QDir( dirPath ).entryList( QDir::Dirs | QDir::NoDotAndDotDot ).isEmpty() );
+
+  QDir().rmdir( dirPath );
+}
+
+void TestQgsMapRendererCache::diskCacheDataChanged()
+{
+  QString dirPath = QDir::tempPath() + "/qgis_test_render_cache";
+  QDir().mkpath( dirPath );
+
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+    cache.setCacheImage( mpFileLayer->id(), image( qRgb( 0, 0, 255 ) ) );
+  }
+
+  // the data is changed outside of QGIS
+  QFile prj( mDataDir + "/points.prj" );
+  QVERIFY( prj.open( QIODevice::Append ) );
+  prj.write( "\n" );
+  prj.close();
+
+  QgsMapRendererCache cache;
+  cache.setCacheDirectory( dirPath );
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  QVERIFY( cache.cacheImage( mpFileLayer->id() ).isNull() );
+
+  cache.clearDiskCache();
+  QDir().rmdir( dirPath );
+}
+
+void TestQgsMapRendererCache::diskCacheSelection()
+{
+  QString dirPath = QDir::tempPath() + "/qgis_test_render_cache";
+  QDir().mkpath( dirPath );
+
+  // the selection is drawn into the image, but it is not kept after a restart
+  QgsFeature feature;
+  QVERIFY( mpFileLayer->getFeatures().nextFeature( feature ) );
+  mpFileLayer->select( feature.id() );
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+    cache.setCacheImage( mpFileLayer->id(), image( qRgb( 0, 0, 255 ) ) );
+  }
+  mpFileLayer->removeSelection();
+
+  QgsMapRendererCache cache;
+  cache.setCacheDirectory( dirPath );
+  cache.init( QgsRectangle( 0, 0, 10, 5 ), 1000, QSize( 100, 50 ), 96 );
+  QVERIFY( cache.cacheImage( mpFileLayer->id() ).isNull() );
+
+  cache.clearDiskCache();
+  QDir().rmdir( dirPath );
+}
+
+void TestQgsMapRendererCache::diskCacheLimit()
+{
+  QString dirPath = QDir::tempPath() + "/qgis_test_render_cache";
+  QDir().mkpath( dirPath );
+
+  // two of the images fit within 8 MB, three of them do not
+  QSize size( 1000, 1000 );
+  QgsRectangle view1( 0, 0, 10, 10 ), view2( 10, 0, 20, 10 ), view3( 20, 0, 30, 10 );
+  QImage img1 = noiseImage( size ), img2 = noiseImage( size ), img3 = noiseImage( size );
+
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    cache.setMaximumDiskUsage( 8 );
+    QCOMPARE( cache.maximumDiskUsage(), 8 );
+    cache.init( view1, 1000, size, 96 );
+    cache.setCacheImage( mpFileLayer->id(), img1 );
+    cache.init( view2, 1000, size, 96 );
+    cache.setCacheImage( mpFileLayer->id(), img2 );
+  }
+
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    cache.setMaximumDiskUsage( 8 );
+    cache.setMaximumMemoryUsage( 0 );
+    // using the image of the first view makes it more recent than the image of the second view
+    cache.init( view1, 1000, size, 96 );
+    QCOMPARE( cache.cacheImage( mpFileLayer->id() ), img1 );
+    cache.init( view3, 1000, size, 96 );
+    cache.setCacheImage( mpFileLayer->id(), img3 );
+  }
+
+  {
+    QgsMapRendererCache cache;
+    cache.setCacheDirectory( dirPath );
+    cache.init( view2, 1000, size, 96 );
+    QVERIFY( cache.cacheImage( mpFileLayer->id() ).isNull() );
+    cache.init( view1, 1000, size, 96 );
+    QCOMPARE( cache.cacheImage( mpFileLayer->id() ), img1 );
+    cache.init( view3, 1000, size, 96 );
+    QCOMPARE( cache.cacheImage( mpFileLayer->id() ), img3 );
+
+    // no images are stored without disk space
+    cache.clearDiskCache();
+    cache.setMaximumDiskUsage( 0 );
+    cache.setCacheImage( mpFileLayer->id(), img3 );
+  }
+  QVERIFY( QDir( dirPath ).entryList( QDir::Dirs | QDir::NoDotAndDotDot ).isEmpty() );
+
+  QDir().rmdir( dirPath );
+}
+
+QTEST_MAIN( TestQgsMapRendererCache )
+#include "testqgsmaprenderercache.moc"
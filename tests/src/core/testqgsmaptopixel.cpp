@@ -27,6 +27,7 @@ class TestQgsMapToPixel: public QObject
   private slots:
     void legacy();
     void rotation();
+    void transformArrays();
 };
 
 void TestQgsMapToPixel::legacy()
@@ -108,6 +109,27 @@ void TestQgsMapToPixel::rotation()
 
 }
 
+void TestQgsMapToPixel::transformArrays()
+{
+  // the array transform has to give the same results as transforming point by point
+  QgsMapToPixel m2p( 0.5, 5, 5, 10, 10, 30 );
+
+  double x[] = { 0, 5, 10, -3.5, 7.25 };
+  double y[] = { 0, 5, -2, 11.5, 3.75 };
+  double tx[5], ty[5];
+  memcpy( tx, x, sizeof( x ) );
+  memcpy( ty, y, sizeof( y ) );
+  m2p.transformInPlace( tx, ty, 5 );
+
+  for ( int i = 0; i < 5; ++i )
+  {
+    double px = x[i], py = y[i];
+    m2p.transformInPlace( px, py );
+    QVERIFY( qgsDoubleNear( tx[i], px, 1e-9 ) );
+    QVERIFY( qgsDoubleNear( ty[i], py, 1e-9 ) );
+  }
+}
+
 QTEST_MAIN( TestQgsMapToPixel )
 #include "testqgsmaptopixel.moc"
 
@@ -16,6 +16,7 @@
 
 #include <QtTest/QtTest>
 #include <QSharedPointer>
+#include <QXmlStreamWriter>
 
 //qgis includes...
 #include <qgsgeometry.h>
@@ -47,6 +48,8 @@ class TestQgsOgcUtils : public QObject
 
     void testGeometryFromGML();
     void testGeometryToGML();
+    void testGeometryToGMLStream();
+    void testRectangleToGMLStream();
 
     void testExpressionFromOgcFilter();
     void testExpressionFromOgcFilter_data();
@@ -125,6 +128,72 @@ void TestQgsOgcUtils::testGeometryToGML()
 }
 
 
+//! serializes an element created by QgsOgcUtils
+static QString domToString( const QDomElement& elem, QDomDocument& doc )
+{
+  doc.appendChild( elem );
+  QString str = doc.toString( -1 );
+  doc.removeChild( elem );
+  return str;
+}
+
+void TestQgsOgcUtils::testGeometryToGMLStream()
+{
+  QStringList wkts;
+  wkts << "POINT(111 222)"
+  << "LINESTRING(111 222, 222 222, 222.5 333.25)"
+  << "POLYGON((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 4 2, 4 4, 2 2))"
+  << "MULTIPOINT(1 2, 3 4, 5.5 6.5)"
+  << "MULTILINESTRING((0 0, 1 1),(2 2, 3 3, 4 2))"
+  << "MULTIPOLYGON(((0 0, 10 0, 10 10, 0 0),(1 1, 2 1, 2 2, 1 1)),((20 20, 30 20, 30 30, 20 20)))";
+
+  QDomDocument doc;
+  Q_FOREACH ( const QString& format, QStringList() << "GML2" << "GML3" )
+  {
+    Q_FOREACH ( const QString& wkt, wkts )
+    {
+      QSharedPointer<QgsGeometry> geom( QgsGeometry::fromWkt( wkt ) );
+      QVERIFY( geom );
+
+      // the streamed element is the same as the DOM element
+      QString streamed;
+      QXmlStreamWriter writer( &streamed );
+      QVERIFY( QgsOgcUtils::geometryToGML( geom.data(), writer, format, 3 ) );
+      QCOMPARE( streamed, domToString( QgsOgcUtils::geometryToGML( geom.data(), doc, format, 3 ), doc ) );
+    }
+  }
+
+  QSharedPointer<QgsGeometry> geomPoint( QgsGeometry::fromPoint( QgsPoint( 111, 222 ) ) );
+  QString streamed;
+  QXmlStreamWriter writer( &streamed );
+  QVERIFY( QgsOgcUtils::geometryToGML( geomPoint.data(), writer, "GML3", 17, "EPSG:4326" ) );
+  QCOMPARE( streamed, QString( "<gml:Point srsName=\"EPSG:4326\"><gml:pos srsDimension=\"2\">111 222</gml:pos></gml:Point>" ) );
+
+  // nothing is written for invalid geometries
+  streamed.clear();
+  QVERIFY( !QgsOgcUtils::geometryToGML( 0, writer, "GML2" ) );
+  QVERIFY( streamed.isEmpty() );
+}
+
+void TestQgsOgcUtils::testRectangleToGMLStream()
+{
+  QgsRectangle rect( 135.2239, 34.4879, 135.8578, 34.8471 );
+  QDomDocument doc;
+
+  QString streamed;
+  QXmlStreamWriter writer( &streamed );
+  QgsOgcUtils::rectangleToGMLBox( rect, writer, 3 );
+  QCOMPARE( streamed, domToString( QgsOgcUtils::rectangleToGMLBox( &rect, doc, 3 ), doc ) );
+
+  streamed.clear();
+  QgsOgcUtils::rectangleToGMLEnvelope( rect, writer, 3 );
+  QCOMPARE( streamed, domToString( QgsOgcUtils::rectangleToGMLEnvelope( &rect, doc, 3 ), doc ) );
+
+  streamed.clear();
+  QgsOgcUtils::rectangleToGMLBox( rect, writer, 2, "EPSG:4326" );
+  QCOMPARE( streamed, QString( "<gml:Box srsName=\"EPSG:4326\"><gml:coordinates cs=\",\" ts=\" \">135.22,34.49 135.86,34.85</gml:coordinates></gml:Box>" ) );
+}
+
 void TestQgsOgcUtils::testExpressionFromOgcFilter_data()
 {
   QTest::addColumn<QString>( "xmlText" );
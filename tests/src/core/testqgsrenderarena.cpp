@@ -0,0 +1,180 @@
+/***************************************************************************
+     testqgsrenderarena.cpp
+     --------------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QtConcurrentRun>
+//header for class being tested
+#include <qgsrenderarena.h>
+
+class TestQgsRenderArena: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void allocate();
+    void scope();
+    void shrink();
+    void polygons();
+    void polygonPoolLimits();
+    void threads();
+};
+
+void TestQgsRenderArena::allocate()
+{
+  QgsRenderArena arena;
+  QCOMPARE( arena.capacity(), ( size_t ) 0 );
+
+  char* a = static_cast<char*>( arena.allocate( 3 ) );
+  double* b = arena.allocate<double>( 10 );
+  QVERIFY( a );
+  QVERIFY( b );
+  QCOMPARE(( quintptr ) b % 16, ( quintptr ) 0 );
+  QVERIFY(( char* ) b >= a + 3 );
+
+  // larger than a chunk
+  char* c = static_cast<char*>( arena.allocate( 1024 * 1024 ) );
+  QVERIFY( c );
+  memset( c, 1, 1024 * 1024 );
+  QVERIFY( arena.capacity() >= ( size_t ) 1024 * 1024 );
+
+  // all chunks are merged into one
+  size_t capacity = arena.capacity();
+  arena.reset();
+  QCOMPARE( arena.capacity(), capacity );
+  char* d = static_cast<char*>( arena.allocate( 1024 * 1024 + 512 ) );
+  char* e = static_cast<char*>( arena.allocate( 0 ) );
+  QCOMPARE( e, d + 1024 * 1024 + 512 );
+}
+
+void TestQgsRenderArena::scope()
+{
+  QgsRenderArena arena;
+  char* first = 0;
+  {
+    QgsRenderArena::Scope scope( &arena );
+    first = static_cast<char*>( arena.allocate( 100 ) );
+    {
+      QgsRenderArena::Scope inner( &arena );
+      arena.allocate( 100000 );
+    }
+    // memory of the inner scope is given back
+    char* next = static_cast<char*>( arena.allocate( 16 ) );
+    QCOMPARE( next, first + 112 );
+  }
+  // and the memory of the outer scope too
+  QCOMPARE( static_cast<char*>( arena.allocate( 100 ) ), first );
+}
+
+void TestQgsRenderArena::shrink()
+{
+  QgsRenderArena arena;
+  {
+    QgsRenderArena::Scope scope( &arena );
+    arena.allocate( 8 * 1024 * 1024 );
+  }
+  arena.reset();
+  size_t capacity = arena.capacity();
+  QVERIFY( capacity >= ( size_t ) 8 * 1024 * 1024 );
+
+  // the memory is kept while it is still needed
+  {
+    QgsRenderArena::Scope scope( &arena );
+    arena.allocate( 4 * 1024 * 1024 );
+  }
+  arena.reset();
+  QCOMPARE( arena.capacity(), capacity );
+
+  // but released after a render which used a small part of it
+  {
+    QgsRenderArena::Scope scope( &arena );
+    arena.allocate( 100 );
+  }
+  arena.reset();
+  QVERIFY( arena.capacity() > 0 );
+  QVERIFY( arena.capacity() <= ( size_t ) 64 * 1024 );
+  QVERIFY( arena.allocate( 100 ) );
+}
+
+void TestQgsRenderArena::polygons()
+{
+  QgsRenderArena arena;
+  QPolygonF p = arena.takePolygon();
+  QVERIFY( p.isEmpty() );
+  p.resize( 1000 );
+  const QPointF* data = p.constData();
+  arena.recyclePolygon( p );
+  QVERIFY( p.isEmpty() );
+
+  // the polygon keeps its memory when it is taken again and shrinks
+  QPolygonF q = arena.takePolygon();
+  QVERIFY( q.isEmpty() );
+  QVERIFY( q.capacity() >= 1000 );
+  q.resize( 10 );
+  QCOMPARE( q.constData(), data );
+
+  QList<QPolygonF> holes;
+  holes << q << QPolygonF( 5 );
+  q = QPolygonF();
+  arena.recyclePolygons( holes );
+  QVERIFY( holes.isEmpty() );
+  QVERIFY( arena.takePolygon().capacity() >= 5 );
+  QVERIFY( arena.takePolygon().capacity() >= 10 );
+  QCOMPARE( arena.takePolygon().capacity(), 0 );
+}
+
+void TestQgsRenderArena::polygonPoolLimits()
+{
+  QgsRenderArena arena;
+
+  // the total capacity of the pool is limited
+  QList<QPolygonF> large;
+  large << QPolygonF( 500000 ) << QPolygonF( 500000 ) << QPolygonF( 500000 );
+  arena.recyclePolygons( large );
+  QVERIFY( arena.pooledPoints() > 0 );
+  QVERIFY( arena.pooledPoints() <= 1024 * 1024 );
+
+  // large polygons are kept while they are still used
+  arena.reset();
+  int pooled = arena.pooledPoints();
+  QVERIFY( pooled >= 500000 );
+  QPolygonF p = arena.takePolygon();
+  QVERIFY( p.capacity() >= 500000 );
+  QCOMPARE( arena.pooledPoints(), pooled - p.capacity() );
+  arena.recyclePolygon( p );
+  QCOMPARE( arena.pooledPoints(), pooled );
+
+  // and released after a render which used small polygons only
+  QPolygonF small( 10 );
+  arena.recyclePolygon( small );
+  arena.reset();
+  pooled = arena.pooledPoints();
+  QVERIFY( pooled >= 10 );
+  QVERIFY( pooled < 1000 );
+}
+
+static bool _arenaOfThread( QgsRenderArena* other )
+{
+  QgsRenderArena* arena = QgsRenderArena::instance();
+  return arena && arena != other && arena == QgsRenderArena::instance();
+}
+
+void TestQgsRenderArena::threads()
+{
+  QgsRenderArena* arena = QgsRenderArena::instance();
+  QVERIFY( arena );
+  QCOMPARE( QgsRenderArena::instance(), arena );
+  QVERIFY( QtConcurrent::run( _arenaOfThread, arena ).result() );
+}
+
+QTEST_MAIN( TestQgsRenderArena )
+#include "testqgsrenderarena.moc"
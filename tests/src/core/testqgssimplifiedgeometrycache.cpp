@@ -0,0 +1,291 @@
+/***************************************************************************
+     testqgssimplifiedgeometrycache.cpp
+     --------------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <climits>
+#include <cmath>
+
+//header for class being tested
+#include <qgssimplifiedgeometrycache.h>
+#include <qgsapplication.h>
+#include <qgsfillsymbollayerv2.h>
+#include <qgsgeometry.h>
+#include <qgsmaplayerregistry.h>
+#include <qgsmaptopixelgeometrysimplifier.h>
+#include <qgsmaprendererjob.h>
+#include <qgssinglesymbolrendererv2.h>
+#include <qgssymbolv2.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+
+class TestQgsSimplifiedGeometryCache: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void bands();
+    void insert();
+    void maxVertices();
+    void invalidation();
+    void changedGeometry();
+    void providerChangeRendered();
+    void hitCheaperThanSimplification();
+
+  private:
+    //! returns a geometry set from a copy of the WKB, like a geometry fetched from a provider
+    static QgsGeometry fetchedGeometry( const QByteArray& wkb );
+};
+
+void TestQgsSimplifiedGeometryCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsSimplifiedGeometryCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsSimplifiedGeometryCache::bands()
+{
+  QCOMPARE( QgsSimplifiedGeometryCache::toleranceBand( 1.0 ), 0 );
+  QCOMPARE( QgsSimplifiedGeometryCache::toleranceBand( 1.99 ), 3 );
+  QCOMPARE( QgsSimplifiedGeometryCache::toleranceBand( 2.0 ), 4 );
+  QCOMPARE( QgsSimplifiedGeometryCache::toleranceBand( 0.75 ), -2 );
+  QCOMPARE( QgsSimplifiedGeometryCache::toleranceBand( 0.0 ), INT_MIN );
+  QCOMPARE( QgsSimplifiedGeometryCache::toleranceBand( -1.0 ), INT_MIN );
+
+  // the tolerance of a band is never larger than the tolerances in it and at most 2^(1/4) times smaller
+  double tolerances[] = { 0.001, 0.3, 1.0, 7.5, 1000.0, pow( 2.0, 0.25 ), pow( 2.0, -1.75 ) };
+  for ( int i = 0; i < 7; ++i )
+  {
+    double bandTolerance = QgsSimplifiedGeometryCache::bandTolerance( QgsSimplifiedGeometryCache::toleranceBand( tolerances[i] ) );
+    QVERIFY( bandTolerance <= tolerances[i] );
+    QVERIFY( 1.1893 * bandTolerance > tolerances[i] );
+  }
+}
+
+void TestQgsSimplifiedGeometryCache::insert()
+{
+  QgsVectorLayer layer( "LineString", "test", "memory" );
+  QgsSimplifiedGeometryCache cache( &layer, 100 );
+  QScopedPointer<QgsGeometry> line( QgsGeometry::fromWkt( "LineString (0 0, 1 1, 2 0)" ) );
+  QgsSimplifiedGeometryCache::Source source( *line );
+
+  cache.insert( 1, 3, source, *line, cache.generation() );
+  QCOMPARE( cache.vertexCount(), 3 );
+
+  QgsGeometry geometry;
+  QVERIFY( !cache.geometry( 1, 2, source, geometry ) );
+  QVERIFY( !cache.geometry( 2, 3, source, geometry ) );
+  QVERIFY( cache.geometry( 1, 3, source, geometry ) );
+  QCOMPARE( geometry.exportToWkt(), line->exportToWkt() );
+
+  // geometries simplified before an invalidation are not cached
+  int generation = cache.generation();
+  cache.remove( 5 );
+  cache.insert( 2, 3, source, *line, generation );
+  QVERIFY( !cache.geometry( 2, 3, source, geometry ) );
+
+  // the geometries of all bands of a feature are removed
+  cache.insert( 1, 4, source, *line, cache.generation() );
+  cache.remove( 1 );
+  QVERIFY( !cache.geometry( 1, 3, source, geometry ) );
+  QVERIFY( !cache.geometry( 1, 4, source, geometry ) );
+  QCOMPARE( cache.vertexCount(), 0 );
+}
+
+void TestQgsSimplifiedGeometryCache::maxVertices()
+{
+  QgsVectorLayer layer( "LineString", "test", "memory" );
+  QgsSimplifiedGeometryCache cache( &layer, 5 );
+  QScopedPointer<QgsGeometry> line( QgsGeometry::fromWkt( "LineString (0 0, 1 1, 2 0)" ) );
+  QgsSimplifiedGeometryCache::Source source( *line );
+
+  cache.insert( 1, 0, source, *line, cache.generation() );
+  cache.insert( 2, 0, source, *line, cache.generation() );
+  QVERIFY( cache.vertexCount() <= 5 );
+
+  QgsGeometry geometry;
+  QVERIFY( cache.geometry( 2, 0, source, geometry ) );
+
+  cache.setMaxVertices( 0 );
+  cache.insert( 3, 0, source, *line, cache.generation() );
+  QVERIFY( !cache.geometry( 3, 0, source, geometry ) );
+  QCOMPARE( cache.vertexCount(), 0 );
+}
+
+void TestQgsSimplifiedGeometryCache::invalidation()
+{
+  QgsVectorLayer layer( "LineString", "test", "memory" );
+  QVERIFY( layer.isValid() );
+  QSharedPointer<QgsSimplifiedGeometryCache> cache = layer.simplifiedGeometryCache();
+  QVERIFY( cache );
+
+  QgsFeature feature;
+  feature.setGeometry( QgsGeometry::fromWkt( "LineString (0 0, 1 1, 2 0)" ) );
+  QVERIFY( layer.dataProvider()->addFeatures( QgsFeatureList() << feature ) );
+  QgsFeatureId fid;
+  QgsFeature added;
+  QVERIFY( layer.getFeatures().nextFeature( added ) );
+  fid = added.id();
+  QgsSimplifiedGeometryCache::Source source( *added.constGeometry() );
+
+  QgsGeometry geometry;
+  cache->insert( fid, 0, source, *added.constGeometry(), cache->generation() );
+  QVERIFY( cache->geometry( fid, 0, source, geometry ) );
+
+  // changed geometries are removed
+  QVERIFY( layer.startEditing() );
+  QgsGeometry* changed = QgsGeometry::fromWkt( "LineString (0 0, 2 2)" );
+  QVERIFY( layer.changeGeometry( fid, changed ) );
+  delete changed;
+  QVERIFY( !cache->geometry( fid, 0, source, geometry ) );
+
+  // leaving the edit mode clears the cache
+  cache->insert( fid, 0, source, *added.constGeometry(), cache->generation() );
+  QVERIFY( cache->geometry( fid, 0, source, geometry ) );
+  QVERIFY( layer.rollBack() );
+  QVERIFY( !cache->geometry( fid, 0, source, geometry ) );
+}
+
+void TestQgsSimplifiedGeometryCache::changedGeometry()
+{
+  QgsVectorLayer layer( "LineString", "test", "memory" );
+  QgsSimplifiedGeometryCache cache( &layer, 100 );
+  QScopedPointer<QgsGeometry> line( QgsGeometry::fromWkt( "LineString (0 0, 1 1, 2 0)" ) );
+  QScopedPointer<QgsGeometry> changed( QgsGeometry::fromWkt( "LineString (0 0, 1 2, 2 0)" ) );
+  QgsSimplifiedGeometryCache::Source source( *line );
+  QgsSimplifiedGeometryCache::Source changedSource( *changed );
+  QVERIFY( source != changedSource );
+
+  // a geometry changed without a signal of the layer does not get the old simplified version
+  cache.insert( 1, 0, source, *line, cache.generation() );
+  QgsGeometry geometry;
+  QVERIFY( !cache.geometry( 1, 0, changedSource, geometry ) );
+  QVERIFY( cache.geometry( 1, 0, source, geometry ) );
+}
+
+void TestQgsSimplifiedGeometryCache::providerChangeRendered()
+{
+  QgsVectorLayer* layer = new QgsVectorLayer( "Polygon", "test", "memory" );
+  QVERIFY( layer->isValid() );
+  QgsStringMap props;
+  props.insert( "color", "255,0,0" );
+  props.insert( "outline_style", "no" );
+  layer->setRendererV2( new QgsSingleSymbolRendererV2( QgsFillSymbolV2::createSimple( props ) ) );
+
+  QgsVectorSimplifyMethod simplifyMethod;
+  simplifyMethod.setSimplifyHints( QgsVectorSimplifyMethod::GeometrySimplification );
+  simplifyMethod.setForceLocalOptimization( true );
+  simplifyMethod.setThreshold( 1.0 );
+  layer->setSimplifyMethod( simplifyMethod );
+
+  QgsFeature feature;
+  feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( 1, 1, 9, 9 ) ) );
+  QVERIFY( layer->dataProvider()->addFeatures( QgsFeatureList() << feature ) );
+  QgsFeature added;
+  QVERIFY( layer->getFeatures().nextFeature( added ) );
+  QgsMapLayerRegistry::instance()->addMapLayer( layer );
+
+  QgsMapSettings settings;
+  settings.setLayers( QStringList() << layer->id() );
+  settings.setOutputSize( QSize( 100, 100 ) );
+  settings.setExtent( QgsRectangle( 0, 0, 20, 20 ) );
+  settings.setFlag( QgsMapSettings::UseRenderingOptimization );
+  QPoint oldPosition = settings.mapToPixel().transform( 5, 5 ).toQPointF().toPoint();
+  QPoint newPosition = settings.mapToPixel().transform( 15, 15 ).toQPointF().toPoint();
+
+  QgsMapRendererSequentialJob job( settings );
+  job.start();
+  job.waitForFinished();
+  QCOMPARE( job.renderedImage().pixel( oldPosition ), qRgb( 255, 0, 0 ) );
+  QVERIFY( layer->simplifiedGeometryCache()->vertexCount() > 0 );
+
+  // the memory provider does not emit dataChanged()
+  QgsGeometryMap geometries;
+  QScopedPointer<QgsGeometry> moved( QgsGeometry::fromRect( QgsRectangle( 11, 11, 19, 19 ) ) );
+  geometries.insert( added.id(), *moved );
+  QVERIFY( layer->dataProvider()->changeGeometryValues( geometries ) );
+
+  QgsMapRendererSequentialJob job2( settings );
+  job2.start();
+  job2.waitForFinished();
+  QCOMPARE( job2.renderedImage().pixel( newPosition ), qRgb( 255, 0, 0 ) );
+  QCOMPARE( job2.renderedImage().pixel( oldPosition ), settings.backgroundColor().rgb() );
+
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << layer->id() );
+}
+
+QgsGeometry TestQgsSimplifiedGeometryCache::fetchedGeometry( const QByteArray& wkb )
+{
+  unsigned char* copy = new unsigned char[wkb.size()];
+  memcpy( copy, wkb.constData(), wkb.size() );
+  QgsGeometry geometry;
+  geometry.fromWkb( copy, wkb.size() );
+  return geometry;
+}
+
+void TestQgsSimplifiedGeometryCache::hitCheaperThanSimplification()
+{
+  // a circle with many more vertices than pixels
+  QgsPolyline ring;
+  for ( int i = 0; i < 100000; ++i )
+    ring << QgsPoint( 1000 * cos( 2 * M_PI * i / 100000 ), 1000 * sin( 2 * M_PI * i / 100000 ) );
+  ring << ring.first();
+  QScopedPointer<QgsGeometry> circle( QgsGeometry::fromPolygon( QgsPolygon() << ring ) );
+  QByteArray wkb( reinterpret_cast<const char*>( circle->asWkb() ), circle->wkbSize() );
+
+  QgsVectorLayer layer( "Polygon", "test", "memory" );
+  QgsSimplifiedGeometryCache cache( &layer, 1000000 );
+  int flags = QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope;
+  double tolerance = QgsSimplifiedGeometryCache::bandTolerance( 0 );
+  {
+    QgsGeometry geometry = fetchedGeometry( wkb );
+    QgsSimplifiedGeometryCache::Source source( geometry );
+    QVERIFY( QgsMapToPixelSimplifier::simplifyGeometry( &geometry, flags, tolerance ) );
+    cache.insert( 1, 0, source, geometry, cache.generation() );
+  }
+
+  // both paths start with a freshly fetched geometry, as the renderer does
+  const int runs = 20;
+  QElapsedTimer timer;
+  timer.start();
+  for ( int i = 0; i < runs; ++i )
+  {
+    QgsGeometry geometry = fetchedGeometry( wkb );
+    QgsSimplifiedGeometryCache::Source source( geometry );
+    QgsMapToPixelSimplifier::simplifyGeometry( &geometry, flags, tolerance );
+  }
+  qint64 simplifyTime = timer.nsecsElapsed();
+
+  timer.restart();
+  for ( int i = 0; i < runs; ++i )
+  {
+    QgsGeometry geometry = fetchedGeometry( wkb );
+    QgsSimplifiedGeometryCache::Source source( geometry );
+    QVERIFY( cache.geometry( 1, 0, source, geometry ) );
+  }
+  qint64 hitTime = timer.nsecsElapsed();
+
+  qDebug( "simplification: %lld ns, cache hit: %lld ns", simplifyTime / runs, hitTime / runs );
+  QVERIFY( hitTime < simplifyTime );
+}
+
+QTEST_MAIN( TestQgsSimplifiedGeometryCache )
+#include "testqgssimplifiedgeometrycache.moc"
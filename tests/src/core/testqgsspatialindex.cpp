@@ -19,6 +19,7 @@
 
 #include <qgsapplication.h>
 #include <qgsgeometry.h>
+#include <qgspackedspatialindex.h>
 #include <qgsspatialindex.h>
 #include <qgsvectordataprovider.h>
 #include <qgsvectorlayer.h>
@@ -48,6 +49,24 @@ static QList<QgsFeature> _pointFeatures()
   return feats;
 }
 
+static QgsVectorLayer* _gridLayer()
+{
+  // 50K points, 500 features at each of the 100 grid positions
+  QgsVectorLayer* vl = new QgsVectorLayer( "Point", "x", "memory" );
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeatureList flist;
+    for ( int k = 0; k < 500; ++k )
+    {
+      QgsFeature f( i*1000 + k );
+      f.setGeometry( QgsGeometry::fromPoint( QgsPoint( i / 10, i % 10 ) ) );
+      flist << f;
+    }
+    vl->dataProvider()->addFeatures( flist );
+  }
+  return vl;
+}
+
 class TestQgsSpatialIndex : public QObject
 {
     Q_OBJECT
@@ -199,6 +218,125 @@ class TestQgsSpatialIndex : public QObject
       delete indexInsert;
     }
 
+    void testPackedQuery()
+    {
+      QgsVectorLayer* vl = new QgsVectorLayer( "Point", "x", "memory" );
+      QgsFeatureList flist = _pointFeatures();
+      vl->dataProvider()->addFeatures( flist );
+
+      QgsPackedSpatialIndex index( vl->getFeatures(), 2 );
+      QVERIFY( index.isValid() );
+      QCOMPARE( index.count(), 4 );
+      QCOMPARE( index.extent(), QgsRectangle( -1, -1, 1, 1 ) );
+
+      QList<QgsFeatureId> fids = index.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      QCOMPARE( fids.count(), 1 );
+      QCOMPARE( fids[0], ( QgsFeatureId ) 1 );
+
+      QList<QgsFeatureId> fids2 = index.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      QCOMPARE( fids2.count(), 2 );
+      QVERIFY( fids2.contains( 2 ) );
+      QVERIFY( fids2.contains( 3 ) );
+
+      QList<QgsFeatureId> nearest = index.nearestNeighbor( QgsPoint( 2, -3 ), 2 );
+      QCOMPARE( nearest.count(), 2 );
+      QCOMPARE( nearest[0], ( QgsFeatureId ) 4 );
+      QCOMPARE( nearest[1], ( QgsFeatureId ) 3 );
+
+      QVERIFY( !QgsPackedSpatialIndex().isValid() );
+      delete vl;
+    }
+
+    void testPackedFile()
+    {
+      QgsVectorLayer* vl = _gridLayer();
+      QgsPackedSpatialIndex index( vl->getFeatures() );
+      QString path = QDir::tempPath() + "/testqgspackedspatialindex.qix";
+      QString signature = QgsPackedSpatialIndex::sourceSignature( vl->dataProvider() );
+      QVERIFY( !signature.isEmpty() );
+      QVERIFY( index.writeToFile( path, signature ) );
+
+      QgsPackedSpatialIndex mapped;
+      QVERIFY( mapped.readFromFile( path, signature ) );
+      QCOMPARE( mapped.count(), 50000 );
+      QCOMPARE( mapped.extent(), index.extent() );
+
+      // results have to match the libspatialindex R-tree
+      QgsSpatialIndex rtree( vl->getFeatures() );
+      QgsRectangle rect( 4.9, 4.9, 5.1, 5.1 );
+      QList<QgsFeatureId> resMapped = mapped.intersects( rect );
+      QList<QgsFeatureId> resRTree = rtree.intersects( rect );
+      QCOMPARE( resMapped.count(), 500 );
+      qSort( resMapped );
+      qSort( resRTree );
+      QCOMPARE( resMapped, resRTree );
+
+      // copies share the mapping
+      QgsPackedSpatialIndex copy( mapped );
+      mapped = QgsPackedSpatialIndex();
+      QCOMPARE( copy.intersects( rect ).count(), 500 );
+
+      // the index is outdated when the data source changes
+      QgsFeatureList flist = _pointFeatures();
+      vl->dataProvider()->addFeatures( flist );
+      QString changedSignature = QgsPackedSpatialIndex::sourceSignature( vl->dataProvider() );
+      QVERIFY( changedSignature != signature );
+      QgsPackedSpatialIndex outdated;
+      QVERIFY( !outdated.readFromFile( path, changedSignature ) );
+      QVERIFY( !outdated.isValid() );
+
+      // truncated file
+      QFile file( path );
+      QVERIFY( file.resize( file.size() - 8 ) );
+      QgsPackedSpatialIndex truncated;
+      QVERIFY( !truncated.readFromFile( path, signature ) );
+      QVERIFY( !truncated.isValid() );
+
+      QFile::remove( path );
+      delete vl;
+    }
+
+    void benchmarkPackedIndex()
+    {
+      QgsVectorLayer* vl = _gridLayer();
+      QString path = QDir::tempPath() + "/benchqgspackedspatialindex.qix";
+
+      QTime t;
+      t.start();
+      QgsSpatialIndex* rtree = new QgsSpatialIndex( vl->getFeatures() );
+      qDebug( "R-tree bulk load:  %d ms", t.elapsed() );
+
+      t.start();
+      QgsPackedSpatialIndex packed( vl->getFeatures() );
+      qDebug( "packed build:      %d ms", t.elapsed() );
+
+      QString signature = QgsPackedSpatialIndex::sourceSignature( vl->dataProvider() );
+      QVERIFY( packed.writeToFile( path, signature ) );
+
+      t.start();
+      QgsPackedSpatialIndex mapped;
+      QVERIFY( mapped.readFromFile( path, signature ) );
+      qDebug( "packed mmap open:  %d ms", t.elapsed() );
+
+      int results = 0;
+      t.start();
+      for ( int i = 0; i < 1000; ++i )
+        results += rtree->intersects( QgsRectangle( i % 10, i / 100, i % 10 + 0.5, i / 100 + 0.5 ) ).count();
+      qDebug( "R-tree 1000 queries: %d ms", t.elapsed() );
+
+      int mappedResults = 0;
+      t.start();
+      for ( int i = 0; i < 1000; ++i )
+        mappedResults += mapped.intersects( QgsRectangle( i % 10, i / 100, i % 10 + 0.5, i / 100 + 0.5 ) ).count();
+      qDebug( "packed 1000 queries: %d ms", t.elapsed() );
+
+      QCOMPARE( mappedResults, results );
+
+      delete rtree;
+      QFile::remove( path );
+      delete vl;
+    }
+
 };
 
 QTEST_MAIN( TestQgsSpatialIndex )
@@ -18,6 +18,7 @@ import tempfile
 import sys
 
 from qgis.core import QgsVectorLayer, QgsPoint, QgsFeature
+from PyQt4.QtCore import QSettings
 
 from utilities import (unitTestDataPath,
                        getQgisTestApp,
@@ -122,6 +123,12 @@ class TestQgsSpatialiteProvider(TestCase, ProviderTestCase):
         """Run after each test."""
         pass
 
+    def enableCompiler(self):
+        QSettings().setValue(u'/qgis/compileExpressions', True)
+
+    def disableCompiler(self):
+        QSettings().setValue(u'/qgis/compileExpressions', False)
+
     def test_SplitFeature(self):
         """Create spatialite database"""
         layer = QgsVectorLayer("dbname=%s table=test_pg (geometry)" % self.dbname, "test_pg", "spatialite")
@@ -0,0 +1,147 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsWMSTileCache.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'the QGIS Development Team'
+__date__ = '17/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import shutil
+import tempfile
+import time
+import unittest
+import urllib
+
+# the tile cache of the server reads its settings when it is used first
+os.environ['QGIS_SERVER_METATILE_SIZE'] = '2'
+os.environ['QGIS_SERVER_METATILE_MAX_SIZE'] = '512'
+
+from PyQt4.QtCore import QRect
+from PyQt4.QtGui import QImage, QColor
+from qgis.server import QgsServer, QgsWMSTileCache
+from utilities import unitTestDataPath
+
+
+class TestQgsWMSTileCache(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp_dir = tempfile.mkdtemp()
+        self.project = os.path.join(self.tmp_dir, 'project.qgs')
+        with open(self.project, 'w') as f:
+            f.write('<qgis/>')
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp_dir, True)
+
+    def tile(self, color):
+        image = QImage(16, 16, QImage.Format_ARGB32_Premultiplied)
+        image.fill(QColor(color).rgba())
+        return image
+
+    def touchProject(self):
+        """Changes the modification time of the project file"""
+        modified = os.path.getmtime(self.project) + 10
+        os.utime(self.project, (modified, modified))
+
+    def testHitAndMiss(self):
+        cache = QgsWMSTileCache(4, 16)
+        self.assertEqual(cache.metaTileSize(), 4)
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=a', 0, 0).isNull())
+
+        cache.insertTile(self.project, 'LAYERS=a', 0, 0, self.tile('red'))
+        self.assertEqual(cache.searchTile(self.project, 'LAYERS=a', 0, 0), self.tile('red'))
+
+        # other positions and requests are not hit
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=a', 1, 0).isNull())
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=a', 0, -1).isNull())
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=b', 0, 0).isNull())
+        self.assertTrue(cache.searchTile(self.project + '2', 'LAYERS=a', 0, 0).isNull())
+
+    def testMetaTileSettings(self):
+        self.assertEqual(QgsWMSTileCache(1, 16).metaTileSize(), 0)
+        cache = QgsWMSTileCache(4, 16, '', 60, 2048)
+        self.assertEqual(cache.timeToLive(), 60)
+        self.assertEqual(cache.maxMetaTileSize(), 2048)
+
+    def testProjectChange(self):
+        cache = QgsWMSTileCache(4, 16)
+        cache.insertTile(self.project, 'LAYERS=a', 0, 0, self.tile('red'))
+        self.touchProject()
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=a', 0, 0).isNull())
+
+        cache.insertTile(self.project, 'LAYERS=a', 0, 0, self.tile('green'))
+        self.assertEqual(cache.searchTile(self.project, 'LAYERS=a', 0, 0), self.tile('green'))
+        cache.removeProjectFileTiles(self.project)
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=a', 0, 0).isNull())
+
+    def testTimeToLive(self):
+        cache = QgsWMSTileCache(4, 16, '', 1)
+        cache.insertTile(self.project, 'LAYERS=a', 0, 0, self.tile('red'))
+        self.assertFalse(cache.searchTile(self.project, 'LAYERS=a', 0, 0).isNull())
+        time.sleep(2)
+        self.assertTrue(cache.searchTile(self.project, 'LAYERS=a', 0, 0).isNull())
+
+    def testDiskCache(self):
+        directory = os.path.join(self.tmp_dir, 'tiles')
+        cache = QgsWMSTileCache(4, 16, directory)
+        cache.insertTile(self.project, 'LAYERS=a', 2, 3, self.tile('blue'))
+
+        # another cache (e.g. after a restart) finds the tile on disk
+        cache2 = QgsWMSTileCache(4, 16, directory)
+        self.assertEqual(cache2.searchTile(self.project, 'LAYERS=a', 2, 3), self.tile('blue'))
+        self.assertTrue(cache2.searchTile(self.project, 'LAYERS=a', 3, 2).isNull())
+
+        # tiles on disk are removed with the project's tiles
+        self.touchProject()
+        self.assertTrue(cache2.searchTile(self.project, 'LAYERS=a', 2, 3).isNull())
+        cache3 = QgsWMSTileCache(4, 16, directory)
+        self.assertTrue(cache3.searchTile(self.project, 'LAYERS=a', 2, 3).isNull())
+
+    def testDiskCacheTemporaryFiles(self):
+        directory = os.path.join(self.tmp_dir, 'tiles')
+        cache = QgsWMSTileCache(4, 16, directory)
+        cache.insertTile(self.project, 'LAYERS=a', 2, 3, self.tile('blue'))
+        cache.insertTile(self.project, 'LAYERS=a', 2, 3, self.tile('red'))
+
+        # the tiles are written to temporary files, which are renamed once complete
+        files = [f for d in os.listdir(directory) for f in os.listdir(os.path.join(directory, d))]
+        self.assertEqual(len(files), 1)
+        self.assertTrue(files[0].endswith('_2_3.png'))
+        cache2 = QgsWMSTileCache(4, 16, directory)
+        self.assertEqual(cache2.searchTile(self.project, 'LAYERS=a', 2, 3), self.tile('red'))
+
+    def getMap(self, server, bbox, size):
+        project = unitTestDataPath('qgis_server') + '/test+project.qgs'
+        query_string = 'MAP=%s&SERVICE=WMS&VERSION=1.1.1&REQUEST=GetMap&LAYERS=%s&STYLES=&SRS=EPSG:4326&BBOX=%s&WIDTH=%d&HEIGHT=%d&FORMAT=image/png' % (
+            urllib.quote(project), urllib.quote('testlayer èé'), ','.join(repr(c) for c in bbox), size, size)
+        header, body = server.handleRequest(query_string)
+        self.assertTrue('image/png' in str(header), str(header) + str(body))
+        image = QImage.fromData(body, 'PNG')
+        self.assertFalse(image.isNull())
+        return image.convertToFormat(QImage.Format_ARGB32)
+
+    def testGetMapMetaTile(self):
+        server = QgsServer()
+
+        # a tile aligned to the tile grid is sliced from the metatile of 2x2 tiles
+        tile_bbox = (8.203, 44.901, 8.2035, 44.9015)
+        tile = self.getMap(server, tile_bbox, 256)
+        self.assertEqual(tile.size().width(), 256)
+
+        # the same area rendered directly, as the image is larger than the maximum metatile
+        metatile = self.getMap(server, (8.203, 44.901, 8.204, 44.902), 512)
+        self.assertEqual(tile, metatile.copy(QRect(0, 256, 256, 256)))
+
+        # the second request is served from the tile cache
+        self.assertEqual(self.getMap(server, tile_bbox, 256), tile)
+
+
+if __name__ == '__main__':
+    unittest.main()